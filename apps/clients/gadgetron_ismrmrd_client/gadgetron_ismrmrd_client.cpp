@@ -1321,9 +1321,7 @@ public:
 
 
         if (data_elements) {
-            std::vector<float> input_data((float*)&acq.getDataPtr()[0], (float*)&acq.getDataPtr()[0] + acq.getHead().active_channels*acq.getHead().number_of_samples*2);
-
-            CompressedBuffer<float> comp_buffer(input_data, -1.0, compression_precision);
+            CompressedBuffer<float> comp_buffer((const float*)&acq.getDataPtr()[0], data_elements*2, -1.0, compression_precision);
             std::vector<uint8_t> serialized_buffer = comp_buffer.serialize();
  
             compressed_bytes_sent_ += serialized_buffer.size();
@@ -1361,15 +1359,13 @@ public:
 
 
         if (data_elements) {
-            std::vector<float> input_data((float*)&acq.getDataPtr()[0], (float*)&acq.getDataPtr()[0] + acq.getHead().active_channels* acq.getHead().number_of_samples*2);
-
             float local_tolerance = compression_tolerance;
             float sigma = stat.sigma_min; //We use the minimum sigma of all channels to "cap" the error
             if (stat.status && sigma > 0 && stat.noise_dwell_time_us && acq.getHead().sample_time_us) {
                 local_tolerance = local_tolerance*stat.sigma_min*acq.getHead().sample_time_us*std::sqrt(stat.noise_dwell_time_us/acq.getHead().sample_time_us);
             }
 
-            CompressedBuffer<float> comp_buffer(input_data, local_tolerance);
+            CompressedBuffer<float> comp_buffer((const float*)&acq.getDataPtr()[0], data_elements*2, local_tolerance);
             std::vector<uint8_t> serialized_buffer = comp_buffer.serialize();
 
             compressed_bytes_sent_ += serialized_buffer.size();
@@ -20,9 +20,17 @@ namespace Gadgetron::Server::Connection {
     void handle(
             const Gadgetron::Core::StreamContext::Paths& paths,
             const Gadgetron::Core::StreamContext::Args& args,
-            std::unique_ptr<std::iostream> stream
+            std::unique_ptr<std::iostream> stream,
+            std::shared_ptr<MemoryUsage> usage,
+            std::function<void()> on_finished
     ) {
-        auto thread = std::thread(handle_connection, std::move(stream), paths, args);
+        auto thread = std::thread(
+                [=](auto stream) mutable {
+                    handle_connection(std::move(stream), paths, args, std::move(usage));
+                    on_finished();
+                },
+                std::move(stream)
+        );
         thread.detach();
     }
 
@@ -31,14 +39,17 @@ namespace Gadgetron::Server::Connection {
     void handle(
             const Gadgetron::Core::StreamContext::Paths& paths,
             const Gadgetron::Core::StreamContext::Args& args,
-            std::unique_ptr<std::iostream> stream
+            std::unique_ptr<std::iostream> stream,
+            std::shared_ptr<MemoryUsage> usage,
+            std::function<void()> on_finished
     ) {
         auto pid = fork();
         if (pid == 0) {
-            handle_connection(std::move(stream), paths, args);
+            handle_connection(std::move(stream), paths, args, usage);
             std::exit(0);
         }
-        auto listen_for_close = [](auto pid) {int status; waitpid(pid,&status,0);};
+        // The account of the connection is held until the child has exited, so its slot is not reused before then.
+        auto listen_for_close = [=](auto pid) mutable {int status; waitpid(pid,&status,0); usage.reset(); on_finished();};
         std::thread t(listen_for_close,pid);
         t.detach();
     }
@@ -1,14 +1,22 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <iostream>
 
 #include "Context.h"
+#include "connection/MemoryUsage.h"
 
 namespace Gadgetron::Server::Connection {
+    /**
+     * Handles a connection in the background. on_finished is called, on an unspecified thread, once the connection
+     * has been processed. The memory the connection allocates is charged to usage.
+     */
     void handle(
             const Gadgetron::Core::StreamContext::Paths &paths,
             const Gadgetron::Core::StreamContext::Args &args,
-            std::unique_ptr<std::iostream> stream
+            std::unique_ptr<std::iostream> stream,
+            std::shared_ptr<MemoryUsage> usage,
+            std::function<void()> on_finished
     );
 }
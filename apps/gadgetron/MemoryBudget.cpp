@@ -0,0 +1,119 @@
+#include "MemoryBudget.h"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Gadgetron::Server {
+
+    namespace {
+        int process_id() {
+#if defined(_WIN32)
+            return 0;
+#else
+            return int(getpid());
+#endif
+        }
+    }
+
+    /**
+     * The ledgers behind the accounts are shared with forked connections, which charge them. Which of them are in
+     * use is only known to the server process; it is the only one to open and release them.
+     */
+    struct MemoryBudget::Slots {
+        explicit Slots(size_t count) : count(count), in_use(count, false), owner(process_id()) {
+            auto bytes = count * sizeof(hoMemoryAccount::Ledger);
+#if defined(_WIN32)
+            void *storage = ::operator new(bytes);
+#else
+            void *storage = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (storage == MAP_FAILED)
+                throw std::system_error(errno, std::generic_category(), "Failed to map memory for connection accounts");
+#endif
+            ledgers = static_cast<hoMemoryAccount::Ledger *>(storage);
+            accounts = static_cast<hoMemoryAccount *>(::operator new(count * sizeof(hoMemoryAccount)));
+            for (size_t i = 0; i < count; i++) {
+                new(ledgers + i) hoMemoryAccount::Ledger();
+                new(accounts + i) hoMemoryAccount(ledgers[i]);
+            }
+        }
+
+        ~Slots() {
+            // Forked connections leave the accounts to the server. The ledgers are never unmapped, as memory charged
+            // to them may still be freed later on.
+            if (process_id() != owner) return;
+            for (size_t i = 0; i < count; i++) accounts[i].~hoMemoryAccount();
+            ::operator delete(accounts);
+        }
+
+        void release(size_t slot) {
+            // A forked connection drops its copies of the account when it exits; that does not free the slot.
+            if (process_id() != owner) return;
+
+            std::lock_guard<std::mutex> guard(mutex);
+            // Forked connections exit without crediting back what they held, and memory a connection left behind
+            // in the server (e.g. in a cache) is no longer charged to the slot once the account is gone.
+            accounts[slot].~hoMemoryAccount();
+            new(accounts + slot) hoMemoryAccount(ledgers[slot]);
+            in_use[slot] = false;
+        }
+
+        const size_t count;
+        hoMemoryAccount::Ledger *ledgers;
+        hoMemoryAccount *accounts;
+
+        std::mutex mutex;
+        std::vector<bool> in_use;
+        const int owner;
+    };
+
+    MemoryBudget::MemoryBudget(size_t budget_bytes, size_t reserve_bytes, size_t slots)
+        : budget(budget_bytes), reserve(reserve_bytes), slots(std::make_shared<Slots>(std::max<size_t>(slots, 1))) {}
+
+    bool MemoryBudget::admits() const {
+        if (!budget) return true;
+
+        std::lock_guard<std::mutex> guard(slots->mutex);
+        size_t committed = 0;
+        bool free_slot = false;
+        for (size_t i = 0; i < slots->count; i++) {
+            if (slots->in_use[i]) {
+                committed += std::max(slots->accounts[i].live_bytes(), reserve);
+            } else {
+                free_slot = true;
+            }
+        }
+        return free_slot && committed < budget && committed + reserve <= budget;
+    }
+
+    std::shared_ptr<hoMemoryAccount> MemoryBudget::open() {
+        std::lock_guard<std::mutex> guard(slots->mutex);
+
+        auto slot = std::find(slots->in_use.begin(), slots->in_use.end(), false);
+        // Only happens without a budget; admits() requires a free slot otherwise.
+        if (slot == slots->in_use.end()) return std::make_shared<hoMemoryAccount>();
+
+        *slot = true;
+        auto index = size_t(std::distance(slots->in_use.begin(), slot));
+        auto owner = slots;
+        return std::shared_ptr<hoMemoryAccount>(
+                slots->accounts + index,
+                [owner, index](hoMemoryAccount *) { owner->release(index); }
+        );
+    }
+
+    size_t MemoryBudget::live_bytes() const {
+        // Not locked; forked connections read this, and may have inherited the mutex locked.
+        size_t live = 0;
+        for (size_t i = 0; i < slots->count; i++) live += slots->accounts[i].live_bytes();
+        return live;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "hoMemoryPool.h"
+
+namespace Gadgetron::Server {
+
+    /**
+     * Memory accounts for the connections being processed, and a budget for the bytes they hold together.
+     *
+     * The accounts live in memory shared with the processes connections are forked into, so the server sees what
+     * each connection holds while it runs. There is a fixed number of accounts; a connection opened while all of
+     * them are in use gets an account of its own, which the budget does not see.
+     */
+    class MemoryBudget {
+    public:
+        /**
+         * @param budget_bytes Bytes the connections may hold together. 0 means no limit.
+         * @param reserve_bytes Bytes counted for each connection, until it actually holds more; keeps a burst of
+         *                      new connections from being admitted before any of them has allocated anything.
+         * @param slots Number of connections accounted for at the same time.
+         */
+        MemoryBudget(size_t budget_bytes, size_t reserve_bytes, size_t slots);
+
+        /// Whether another connection fits within the budget.
+        bool admits() const;
+
+        /// An account for a new connection. It is released once the last reference to it is gone.
+        std::shared_ptr<hoMemoryAccount> open();
+
+        /// Bytes held by the connections being processed.
+        size_t live_bytes() const;
+
+        size_t budget_bytes() const { return budget; }
+
+    private:
+        struct Slots;
+
+        const size_t budget;
+        const size_t reserve;
+        std::shared_ptr<Slots> slots;
+    };
+}
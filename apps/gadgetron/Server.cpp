@@ -1,6 +1,9 @@
 
 #include <boost/asio.hpp>
 
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
 
 #include <Context.h>
@@ -9,11 +12,133 @@
 
 #include "Server.h"
 #include "Connection.h"
+#include "MemoryBudget.h"
 #include "connection/SocketStreamBuf.h"
 
 using namespace boost::filesystem;
 using namespace Gadgetron::Server;
 
+namespace {
+
+    using boost::asio::ip::tcp;
+
+#if(BOOST_VERSION >= 107000)
+    using Executor = boost::asio::io_context;
+#else
+    using Executor = boost::asio::io_service;
+#endif
+
+    std::string describe(const tcp::socket &socket) {
+        boost::system::error_code error;
+        auto endpoint = socket.remote_endpoint(error);
+        return error ? "unknown peer" : endpoint.address().to_string();
+    }
+
+    /**
+     * Accepts connections asynchronously and keeps the number of connections processed at the same time below
+     * max_connections, and the memory they hold within the budget. Connections arriving while the server is
+     * saturated wait in a queue of at most queue_size entries; connections arriving while the queue is full are
+     * refused.
+     *
+     * Memory is freed without notice, so the queue is checked periodically while connections wait.
+     *
+     * All admission state is only touched from the executor thread.
+     */
+    class Acceptor {
+    public:
+        Acceptor(
+                Executor &executor,
+                const tcp::endpoint &local,
+                size_t max_connections,
+                size_t queue_size,
+                const MemoryBudget &budget,
+                std::function<void(std::unique_ptr<tcp::socket>, std::function<void()>)> handle
+        ) : executor(executor), acceptor(executor, local), timer(executor), max_connections(max_connections),
+            queue_size(queue_size), budget(budget), handle(std::move(handle)) {
+            acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+        }
+
+        void start() {
+            auto socket = std::make_shared<tcp::socket>(executor);
+            acceptor.async_accept(*socket, [this, socket](const boost::system::error_code &error) {
+                if (error) {
+                    GERROR_STREAM("Failed to accept connection: " << error.message());
+                } else {
+                    admit(std::make_unique<tcp::socket>(std::move(*socket)));
+                }
+                start();
+            });
+        }
+
+    private:
+        bool saturated() const {
+            return (max_connections && active >= max_connections) || !budget.admits();
+        }
+
+        void admit(std::unique_ptr<tcp::socket> socket) {
+            GINFO_STREAM("Accepted connection from: " << describe(*socket));
+
+            if (!saturated()) return start_connection(std::move(socket));
+
+            if (waiting.size() < queue_size) {
+                GINFO_STREAM("Server is processing " << active << " connections holding " << budget.live_bytes()
+                                                     << " bytes; connection queued (" << waiting.size() + 1
+                                                     << " waiting).");
+                waiting.push_back(std::move(socket));
+                if (waiting.size() == 1) recheck();
+                return;
+            }
+
+            GWARN_STREAM("Server is saturated; refusing connection from " << describe(*socket));
+            boost::system::error_code ignored;
+            socket->shutdown(tcp::socket::shutdown_both, ignored);
+            socket->close(ignored);
+        }
+
+        void start_connection(std::unique_ptr<tcp::socket> socket) {
+            active++;
+            handle(std::move(socket), [this]() { executor.post([this]() { this->finished(); }); });
+        }
+
+        void finished() {
+            active--;
+            drain();
+        }
+
+        void drain() {
+            while (!waiting.empty() && !saturated()) {
+                auto socket = std::move(waiting.front());
+                waiting.pop_front();
+                start_connection(std::move(socket));
+            }
+        }
+
+        void recheck() {
+#if(BOOST_VERSION >= 106600)
+            timer.expires_after(std::chrono::milliseconds(100));
+#else
+            timer.expires_from_now(std::chrono::milliseconds(100));
+#endif
+            timer.async_wait([this](const boost::system::error_code &error) {
+                if (error) return;
+                drain();
+                if (!waiting.empty()) recheck();
+            });
+        }
+
+        Executor &executor;
+        tcp::acceptor acceptor;
+        boost::asio::steady_timer timer;
+
+        const size_t max_connections;
+        const size_t queue_size;
+        const MemoryBudget &budget;
+        const std::function<void(std::unique_ptr<tcp::socket>, std::function<void()>)> handle;
+
+        size_t active = 0;
+        std::deque<std::unique_ptr<tcp::socket>> waiting;
+    };
+}
 
 Server::Server(
         const boost::program_options::variables_map &args
@@ -23,22 +148,34 @@ void Server::serve() {
 
     Gadgetron::Core::Context::Paths paths{args["home"].as<path>(), args["dir"].as<path>()};
 
-#if(BOOST_VERSION >= 107000)
-    boost::asio::io_context executor;
-#else
-    boost::asio::io_service executor;
-#endif
-    boost::asio::ip::tcp::endpoint local(boost::asio::ip::tcp::v6(), args["port"].as<unsigned short>());
-    boost::asio::ip::tcp::acceptor acceptor(executor, local);
-
-    acceptor.set_option(boost::asio::socket_base::reuse_address(true));
+    Executor executor;
+    tcp::endpoint local(tcp::v6(), args["port"].as<unsigned short>());
 
-    while(true) {
-        auto socket = std::make_unique<boost::asio::ip::tcp::socket>(executor);
-        acceptor.accept(*socket);
+    const size_t mebibyte = 1024 * 1024;
+    auto max_connections = args["max_connections"].as<unsigned int>();
+    auto budget = std::make_shared<MemoryBudget>(
+            args["memory_budget"].as<unsigned int>() * mebibyte,
+            args["connection_memory"].as<unsigned int>() * mebibyte,
+            max_connections ? max_connections : 256
+    );
 
-        GINFO_STREAM("Accepted connection from: " << socket->remote_endpoint().address());
+    Acceptor acceptor(
+            executor,
+            local,
+            max_connections,
+            args["connection_queue"].as<unsigned int>(),
+            *budget,
+            [&](auto socket, auto on_finished) {
+                Connection::handle(
+                        paths,
+                        args,
+                        Gadgetron::Connection::stream_from_socket(std::move(socket)),
+                        std::make_shared<Connection::MemoryUsage>(budget->open(), budget),
+                        std::move(on_finished)
+                );
+            }
+    );
 
-        Connection::handle(paths, args, Gadgetron::Connection::stream_from_socket(std::move(socket)));
-    }
+    acceptor.start();
+    executor.run();
 }
@@ -1,6 +1,7 @@
 #include <pugixml.hpp>
 
 #include <set>
+#include <algorithm>
 #include <map>
 #include <list>
 #include <memory>
@@ -161,6 +162,10 @@ namespace {
         static pugi::xml_node add_node(const Config::Stream &stream, pugi::xml_node &node) {
             auto stream_node = node.append_child("stream");
             stream_node.append_attribute("key").set_value(stream.key.c_str());
+            if (stream.capacity)
+                stream_node.append_attribute("capacity").set_value((long long unsigned int)*stream.capacity);
+            if (stream.fuse)
+                stream_node.append_attribute("fuse").set_value(true);
             for (auto node : stream.nodes) {
                 visit([&stream_node](auto &typed_node) { add_node(typed_node, stream_node); }, node);
             }
@@ -187,6 +192,7 @@ namespace {
             add_readers(distributed.readers,puredistributed_node);
             add_writers(distributed.writers,puredistributed_node);
             add_node(distributed.stream,puredistributed_node);
+            puredistributed_node.append_attribute("window").set_value((long long unsigned int)distributed.window);
             return puredistributed_node;
         }
     };
@@ -523,7 +529,18 @@ namespace {
             for (auto &node : stream_node.children()) {
                 nodes.push_back(node_parsers.at(node.name())(node));
             }
-            return Config::Stream{stream_node.attribute("key").value(), nodes};
+            return Config::Stream{
+                stream_node.attribute("key").value(),
+                nodes,
+                parse_capacity(stream_node),
+                stream_node.attribute("fuse").as_bool(false)
+            };
+        }
+
+        static optional<size_t> parse_capacity(const pugi::xml_node &stream_node) {
+            std::string capacity_str = stream_node.attribute("capacity").value();
+            if (capacity_str.empty()) return none;
+            return size_t(std::stoul(capacity_str));
         }
 
         Config::PureStream parse_purestream(const pugi::xml_node &purestream_node){
@@ -544,7 +561,8 @@ namespace {
             auto purestream = parse_purestream(puredistributedprocess_node.child("purestream"));
             auto readers = parse_readers(puredistributedprocess_node.child("readers"));
             auto writers = parse_writers(puredistributedprocess_node.child("writers"));
-            return {readers,writers,purestream};
+            auto window = std::max<size_t>(puredistributedprocess_node.attribute("window").as_uint(4), 1);
+            return {readers,writers,purestream,window};
         }
 
         static optional<std::string> parse_target(std::string s) {
@@ -34,6 +34,10 @@ namespace Gadgetron::Server::Connection {
         struct Stream {
             std::string key;
             std::vector<Node> nodes;
+            // If set, nodes in the stream are connected by bounded channels of this capacity.
+            boost::optional<size_t> capacity = boost::none;
+            // If set, adjacent gadgets which support it are called directly on a shared thread.
+            bool fuse = false;
         };
 
         struct PureStream{
@@ -84,6 +88,8 @@ namespace Gadgetron::Server::Connection {
             std::vector<Reader> readers;
             std::vector<Writer> writers;
             PureStream stream;
+            // Jobs each worker may have in flight at once.
+            size_t window = 4;
         };
 
         struct ParallelProcess {
@@ -1,6 +1,16 @@
 
 #include "Core.h"
 
+#include <atomic>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "ConfigConnection.h"
 #include "Writers.h"
 
@@ -44,6 +54,37 @@ namespace {
         stream.write(reinterpret_cast<char *>(&close), sizeof(close));
     }
 
+    // Connections are traced when GADGETRON_TRACE_DIRECTORY is set. Each connection writes a file there when it closes.
+    const char *trace_directory() {
+        return std::getenv("GADGETRON_TRACE_DIRECTORY");
+    }
+
+    std::shared_ptr<Gadgetron::Tracing::Trace> start_trace() {
+        if (!trace_directory()) return nullptr;
+
+        static std::atomic<int> connections{0};
+#if defined(_WIN32)
+        auto pid = _getpid();
+#else
+        auto pid = getpid();
+#endif
+        return std::make_shared<Gadgetron::Tracing::Trace>(
+                "connection-" + std::to_string(pid) + "-" + std::to_string(connections++)
+        );
+    }
+
+    void write_trace(const Gadgetron::Tracing::Trace &trace) {
+        auto filename = boost::filesystem::path(trace_directory()) / (trace.connection() + ".json");
+        std::ofstream file(filename.string());
+        trace.write_chrome_trace(file);
+        if (!file) {
+            GERROR_STREAM("Failed to write trace to " << filename);
+            return;
+        }
+        if (trace.dropped()) GWARN_STREAM("Trace buffers were full; " << trace.dropped() << " spans were dropped.");
+        GINFO_STREAM("Trace written to " << filename);
+    }
+
 }
 
 
@@ -52,7 +93,8 @@ namespace Gadgetron::Server::Connection {
     void handle_connection(
             std::unique_ptr<std::iostream> stream,
             Gadgetron::Core::StreamContext::Paths paths,
-            Gadgetron::Core::StreamContext::Args args
+            Gadgetron::Core::StreamContext::Args args,
+            std::shared_ptr<MemoryUsage> usage
     ) {
 
         stream->exceptions(std::istream::failbit | std::istream::badbit | std::istream::eofbit);
@@ -60,19 +102,28 @@ namespace Gadgetron::Server::Connection {
 
         ErrorHandler error_handler(sender,"Connection Main Thread");
 
-        error_handler.handle([&]() {
-            ConfigConnection::process(*stream, paths, args, error_handler);
-        });
+        auto trace = start_trace();
+        {
+            Tracing::ScopedTrace scoped_trace(trace, "Connection Main Thread");
+            MemoryUsage::Scope scoped_memory(usage, usage ? usage->account() : nullptr);
+            error_handler.handle([&]() {
+                ConfigConnection::process(*stream, paths, args, error_handler);
+            });
+        }
 
         try {
             sender.send_error_to_client(*stream);
             send_close(*stream);
+            stream->flush();
         }
         catch (std::runtime_error &e) {
             GERROR_STREAM("Finalizing connection to client failed with the following error: " << e.what());
         }
         catch (...) {}
 
+        if (trace) write_trace(*trace);
+        if (usage) GINFO_STREAM("Connection memory peaked at " << usage->account()->peak_bytes() << " bytes.");
+
         GINFO_STREAM("Connection state: [FINISHED]");
     }
 
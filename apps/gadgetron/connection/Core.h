@@ -9,6 +9,8 @@
 #include "Writer.h"
 #include "Channel.h"
 #include "Context.h"
+#include "trace.h"
+#include "MemoryUsage.h"
 
 namespace Gadgetron::Server::Connection {
 
@@ -66,13 +68,22 @@ namespace Gadgetron::Server::Connection {
 
 #endif
 
+        /**
+         * Runs fn on a new thread, which records its spans in the trace of the calling thread, and charges its
+         * allocations to the memory account of the calling thread.
+         */
         template<class F, class... ARGS>
         std::thread run(F fn, ARGS &&... args) {
             return std::thread(
-                    []( auto handler, auto fn, auto &&... iargs) {
+                    []( auto handler, auto trace, auto usage, auto account, auto fn, auto &&... iargs) {
+                        Tracing::ScopedTrace scoped_trace(std::move(trace), handler.location);
+                        MemoryUsage::Scope scoped_memory(std::move(usage), std::move(account));
                         handler.handle(fn, std::forward<ARGS>(iargs)...);
                     },
                     *this,
+                    Tracing::current(),
+                    MemoryUsage::current(),
+                    hoMemory::current_account(),
                     std::forward<F>(fn),
                     std::forward<ARGS>(args)...
             );
@@ -105,7 +116,18 @@ namespace Gadgetron::Server::Connection {
 
         auto writers = writer_factory();
 
-        for (auto message : messages) {
+        while (true) {
+            // Only flush the stream when no further output is ready; messages produced in bursts are sent together.
+            auto next = messages.try_pop();
+            if (!next) {
+                stream.flush();
+                try {
+                    next = messages.pop();
+                } catch (const Core::ChannelClosed &) {
+                    return;
+                }
+            }
+            auto message = std::move(*next);
 
             auto writer = std::find_if(writers.begin(), writers.end(),
                                        [&](auto &writer) { return writer->accepts(message); }
@@ -145,5 +167,10 @@ namespace Gadgetron::Server::Connection {
         );
     }
 
-    void handle_connection(std::unique_ptr<std::iostream> stream, Core::StreamContext::Paths paths, Core::StreamContext::Args args);
+    void handle_connection(
+            std::unique_ptr<std::iostream> stream,
+            Core::StreamContext::Paths paths,
+            Core::StreamContext::Args args,
+            std::shared_ptr<MemoryUsage> usage
+    );
 }
\ No newline at end of file
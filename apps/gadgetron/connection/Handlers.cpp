@@ -6,6 +6,7 @@
 
 #include "io/primitives.h"
 #include "Response.h"
+#include "MemoryUsage.h"
 
 namespace {
 
@@ -55,6 +56,14 @@ namespace {
         answers["gadgetron::cuda::memory"]       = cuda_memory;
         answers["gadgetron::cuda::capabilities"] = cuda_capabilities;
     }
+
+    void initialize_with_memory_queries(std::map<std::string, std::function<std::string()>> &answers) {
+        auto usage = Connection::MemoryUsage::current();
+        if (!usage) return;
+
+        answers["gadgetron::memory"]             = [=]() { return usage->report(); };
+        answers["gadgetron::memory::connection"] = [=]() { return std::to_string(usage->account()->live_bytes()); };
+    }
 }
 
 namespace Gadgetron::Server::Connection::Handlers {
@@ -64,6 +73,7 @@ namespace Gadgetron::Server::Connection::Handlers {
 
     QueryHandler::QueryHandler() {
         initialize_with_default_queries(answers);
+        initialize_with_memory_queries(answers);
     }
 
     void QueryHandler::handle(std::istream &stream, Gadgetron::Core::OutputChannel& channel) {
@@ -0,0 +1,82 @@
+#include "MemoryUsage.h"
+
+#include <cstdio>
+#include <sstream>
+
+namespace {
+
+    thread_local std::shared_ptr<Gadgetron::Server::Connection::MemoryUsage> current_usage;
+
+    std::string quoted(const std::string &text) {
+        std::string result = "\"";
+        for (auto c : text) {
+            switch (c) {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        result += escaped;
+                    } else {
+                        result += c;
+                    }
+            }
+        }
+        return result + "\"";
+    }
+}
+
+namespace Gadgetron::Server::Connection {
+
+    MemoryUsage::MemoryUsage(std::shared_ptr<hoMemoryAccount> account, std::shared_ptr<const MemoryBudget> budget)
+        : account_(std::move(account)), budget(std::move(budget)) {}
+
+    std::shared_ptr<hoMemoryAccount> MemoryUsage::add_gadget(const std::string &name, std::function<size_t()> queued) {
+        auto account = std::make_shared<hoMemoryAccount>(account_);
+
+        std::lock_guard<std::mutex> guard(mutex);
+        gadgets.push_back(Gadget{name, account, std::move(queued)});
+        return account;
+    }
+
+    std::string MemoryUsage::report() const {
+        std::stringstream stream;
+        stream << "{\"connection\":{\"live_bytes\":" << account_->live_bytes()
+               << ",\"peak_bytes\":" << account_->peak_bytes() << "},\"gadgets\":[";
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            for (size_t i = 0; i < gadgets.size(); i++) {
+                auto &gadget = gadgets[i];
+                stream << (i ? "," : "") << "{\"name\":" << quoted(gadget.name)
+                       << ",\"live_bytes\":" << gadget.account->live_bytes()
+                       << ",\"peak_bytes\":" << gadget.account->peak_bytes()
+                       << ",\"queued_messages\":" << (gadget.queued ? gadget.queued() : 0) << "}";
+            }
+        }
+        stream << "]";
+        if (budget) {
+            stream << ",\"server\":{\"live_bytes\":" << budget->live_bytes()
+                   << ",\"budget_bytes\":" << budget->budget_bytes() << "}";
+        }
+        stream << "}";
+        return stream.str();
+    }
+
+    std::shared_ptr<MemoryUsage> MemoryUsage::current() {
+        return current_usage;
+    }
+
+    MemoryUsage::Scope::Scope(std::shared_ptr<MemoryUsage> usage, std::shared_ptr<hoMemoryAccount> account)
+        : previous(std::move(current_usage)), scoped_account(std::move(account)) {
+        current_usage = std::move(usage);
+    }
+
+    MemoryUsage::Scope::~Scope() {
+        current_usage = std::move(previous);
+    }
+
+    MemoryUsage::GadgetScope::GadgetScope(const std::string &name, std::function<size_t()> queued) {
+        if (auto usage = current_usage) scoped_account.emplace(usage->add_gadget(name, std::move(queued)));
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MemoryBudget.h"
+#include "Types.h"
+#include "hoMemoryPool.h"
+
+namespace Gadgetron::Server::Connection {
+
+    /**
+     * The memory held by a connection: the bytes of hoNDArray storage charged to it, by the gadget which allocated
+     * them, and the number of messages waiting in front of each gadget.
+     *
+     * Memory allocated by a gadget stays charged to it until it is freed, wherever the data has gone in the meantime.
+     * Work a gadget submits to a Core::ThreadPool is charged to it as well; OpenMP worker threads are not.
+     * Memory allocated outside any gadget, e.g. by the readers, is charged to the connection only.
+     */
+    class MemoryUsage {
+    public:
+        MemoryUsage(std::shared_ptr<hoMemoryAccount> account, std::shared_ptr<const MemoryBudget> budget);
+
+        const std::shared_ptr<hoMemoryAccount> &account() const { return account_; }
+
+        /// An account for the gadget name, charged to the connection as well. queued reports the messages waiting.
+        std::shared_ptr<hoMemoryAccount> add_gadget(const std::string &name, std::function<size_t()> queued);
+
+        /// The live figures for the connection, its gadgets and the server, as JSON.
+        std::string report() const;
+
+        /// The usage installed on this thread, if any.
+        static std::shared_ptr<MemoryUsage> current();
+
+        /**
+         * Installs usage on this thread, and charges the allocations of the thread to account, for the lifetime of
+         * the Scope.
+         */
+        class Scope {
+        public:
+            Scope(std::shared_ptr<MemoryUsage> usage, std::shared_ptr<hoMemoryAccount> account);
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            std::shared_ptr<MemoryUsage> previous;
+            hoMemory::ScopedAccount scoped_account;
+        };
+
+        /// Charges the allocations of this thread to a new gadget of the current usage, if there is one.
+        class GadgetScope {
+        public:
+            GadgetScope(const std::string &name, std::function<size_t()> queued);
+
+        private:
+            Core::optional<hoMemory::ScopedAccount> scoped_account;
+        };
+
+    private:
+        struct Gadget {
+            std::string name;
+            std::shared_ptr<hoMemoryAccount> account;
+            std::function<size_t()> queued;
+        };
+
+        const std::shared_ptr<hoMemoryAccount> account_;
+        const std::shared_ptr<const MemoryBudget> budget;
+
+        mutable std::mutex mutex;
+        std::vector<Gadget> gadgets;
+    };
+}
@@ -6,6 +6,9 @@
 
 #include "Types.h"
 
+#include <array>
+#include <cstring>
+
 #include <boost/asio.hpp>
 namespace {
     using boost::asio::ip::tcp;
@@ -19,18 +22,27 @@ namespace {
         return std::move(socket);
     }
 
+    /**
+     * Buffered socket stream. Small reads and writes go through a buffer. Large reads are read straight into the
+     * caller's memory, and large writes are sent together with any buffered bytes in a single gathered write.
+     * Written data is only guaranteed to be sent once the stream is flushed.
+     */
     class SocketStreamBuf : public std::streambuf {
     public:
-        explicit SocketStreamBuf(std::unique_ptr<boost::asio::ip::tcp::socket> socket, size_t buffer_size = 1024);
+        explicit SocketStreamBuf(std::unique_ptr<boost::asio::ip::tcp::socket> socket, size_t buffer_size = 1 << 16);
+        ~SocketStreamBuf() override;
 
     protected:
         std::streamsize xsputn(const char_type* data, std::streamsize length) override;
+        std::streamsize xsgetn(char_type* data, std::streamsize length) override;
 
         int sync() override;
         int underflow() override;
         int overflow(int ch = traits_type::eof()) override;
 
     private:
+        void send_buffered();
+
         std::unique_ptr<boost::asio::ip::tcp::socket> socket;
         std::vector<char> input_buffer;
         std::vector<char> output_buffer;
@@ -38,32 +50,87 @@ namespace {
         /* Other members */
     };
 
+    SocketStreamBuf::~SocketStreamBuf() {
+        try {
+            send_buffered();
+        } catch (...) {
+        }
+    }
+
     int SocketStreamBuf::sync() {
-        return this->overflow() != traits_type::eof() ? 0 : -1;
+        send_buffered();
+        return 0;
     }
+
     int SocketStreamBuf::underflow() {
+        if (this->gptr() < this->egptr())
+            return traits_type::to_int_type(*this->gptr());
 
-        auto elements_read = socket->read_some(boost::asio::buffer(this->eback(), input_buffer.size()));
+        auto elements_read = socket->read_some(boost::asio::buffer(input_buffer.data(), input_buffer.size()));
 
-        this->setg(this->eback(), this->eback(), this->eback() + elements_read);
+        this->setg(input_buffer.data(), input_buffer.data(), input_buffer.data() + elements_read);
         return traits_type::to_int_type(*this->gptr());
     }
-    int SocketStreamBuf::overflow(int ch) {
+
+    std::streamsize SocketStreamBuf::xsgetn(char_type* data, std::streamsize length) {
+        std::streamsize total = 0;
+
+        while (total < length) {
+            auto buffered = std::min<std::streamsize>(this->egptr() - this->gptr(), length - total);
+            if (buffered > 0) {
+                std::memcpy(data + total, this->gptr(), buffered);
+                this->gbump(static_cast<int>(buffered));
+                total += buffered;
+                continue;
+            }
+
+            auto remaining = length - total;
+            if (remaining >= std::streamsize(input_buffer.size())) {
+                // Large payloads (acquisition samples, image data) skip the buffer entirely.
+                total += boost::asio::read(*socket, boost::asio::buffer(data + total, remaining));
+                continue;
+            }
+
+            underflow();
+        }
+
+        return total;
+    }
+
+    void SocketStreamBuf::send_buffered() {
         if (this->pptr() != this->pbase()) {
             boost::asio::write(*socket, boost::asio::buffer(this->pbase(), std::distance(this->pbase(), this->pptr())));
-            this->setp(this->pbase(), this->epptr());
+            this->setp(output_buffer.data(), output_buffer.data() + output_buffer.size());
         }
+    }
+
+    int SocketStreamBuf::overflow(int ch) {
+        send_buffered();
         if (ch != traits_type::eof()) {
-            this->sputc(ch);
+            *this->pptr() = traits_type::to_char_type(ch);
+            this->pbump(1);
         }
 
-        return 0;
+        return traits_type::not_eof(ch);
     }
 
     std::streamsize SocketStreamBuf::xsputn(const char* data, std::streamsize length) {
-        this->overflow();
-        return boost::asio::write(*socket, boost::asio::buffer(data, length));
+        if (length <= this->epptr() - this->pptr()) {
+            std::memcpy(this->pptr(), data, length);
+            this->pbump(static_cast<int>(length));
+            return length;
+        }
+
+        // Send whatever is buffered (typically a message header) and the payload in one gathered write.
+        std::array<boost::asio::const_buffer, 2> buffers{
+            boost::asio::buffer(this->pbase(), std::distance(this->pbase(), this->pptr())),
+            boost::asio::buffer(data, length)
+        };
+        boost::asio::write(*socket, buffers);
+        this->setp(output_buffer.data(), output_buffer.data() + output_buffer.size());
+        return length;
     }
+
     SocketStreamBuf::SocketStreamBuf(std::unique_ptr<boost::asio::ip::tcp::socket> socket, size_t buffer_size)
         : socket(std::move(socket)), input_buffer(buffer_size), output_buffer(buffer_size) {
         this->setg(input_buffer.data(), input_buffer.data() + buffer_size, input_buffer.data() + buffer_size);
@@ -7,6 +7,7 @@
 #include "connection/stream/common/Closer.h"
 #include "connection/stream/common/Discovery.h"
 #include "connection/stream/common/ExternalChannel.h"
+#include "connection/stream/common/TracedChannel.h"
 #include "io/iostream_operators.h"
 
 namespace {
@@ -46,7 +47,9 @@ namespace {
 
     void ChannelWrapper::process_input(GenericInputChannel input) {
         auto closer = make_closer(external);
+        int64_t count = 0;
         for (auto message : input) {
+            Tracing::Span span("send", "distributed", count++);
             external->push_message(std::move(message));
         }
     }
@@ -157,7 +160,7 @@ namespace Gadgetron::Server::Connection::Stream {
             error_handler
         };
 
-        distributor->process(std::move(input), channel_creator, std::move(output));
+        distributor->process(trace_input(std::move(input)), channel_creator, std::move(output));
         channel_creator.join();
     }
 
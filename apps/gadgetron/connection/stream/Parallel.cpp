@@ -8,6 +8,8 @@
 #include "Channel.h"
 #include "Context.h"
 
+#include "connection/stream/common/TracedChannel.h"
+
 namespace {
     using namespace Gadgetron::Core;
     using namespace Gadgetron::Core::Parallel;
@@ -97,7 +99,8 @@ namespace Gadgetron::Server::Connection::Stream {
 
         threads.emplace_back(nested_handler.run(
                 [&](auto input, auto output, auto bypass) {
-                    branch->process(std::move(input), std::move(output), std::move(bypass));
+                    Tracing::ScopedTrace scoped_trace(Tracing::current(), branch->key);
+                    branch->process(trace_input(std::move(input)), std::move(output), std::move(bypass));
                 },
                 std::move(input),
                 transform_map(input_channels, [](auto& val) { return std::move(val.output); }),
@@ -106,6 +109,7 @@ namespace Gadgetron::Server::Connection::Stream {
 
         threads.emplace_back(nested_handler.run(
                 [&](auto input, auto output) {
+                    Tracing::ScopedTrace scoped_trace(Tracing::current(), merge->key);
                     merge->process(std::move(input), std::move(output));
                 },
                 transform_map(output_channels, [](auto &val) { return std::move(val.input); }),
@@ -8,18 +8,25 @@ namespace Gadgetron::Server::Connection::Stream {
 
     void ParallelProcess::process_input(GenericInputChannel input, Queue &queue) {
 
-        ThreadPool pool(workers ? workers : std::thread::hardware_concurrency());
+        // An explicit worker count gets a dedicated pool; otherwise share the process wide pool with everyone else.
+        std::unique_ptr<ThreadPool> dedicated_pool = workers ? std::make_unique<ThreadPool>(workers) : nullptr;
+        ThreadPool& pool = dedicated_pool ? *dedicated_pool : ThreadPool::shared();
+
+        // Nothing else waits for work on the shared pool; the tasks refer to this stream, so every one of them must
+        // finish before we return, even if the output side has already given up on their results.
+        TaskGroup tasks{ pool };
 
         for (auto message : input) {
             queue.push(
-                pool.async(
+                tasks.async(
                         [&](auto message) { return pureStream.process_function(std::move(message)); },
                         std::move(message)
                 )
             );
         }
 
-        pool.join(); queue.close();
+        tasks.wait();
+        queue.close();
     }
 
     void ParallelProcess::process_output(OutputChannel output, Queue &queue) {
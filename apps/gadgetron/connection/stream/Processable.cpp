@@ -8,9 +8,12 @@ std::thread Gadgetron::Server::Connection::Stream::Processable::process_async(
         const ErrorHandler &error_handler
 ) {
         ErrorHandler nested_handler{error_handler, processable->name()};
+        auto queued = Core::queue_size(input);
 
         return nested_handler.run(
             [=](auto input, auto output, auto error_handler) {
+                Tracing::ScopedTrace scoped_trace(Tracing::current(), processable->name());
+                MemoryUsage::GadgetScope scoped_memory(processable->name(), queued);
                 processable->process(std::move(input), std::move(output), error_handler);
             },
             std::move(input),
@@ -2,6 +2,7 @@
 #include "PureDistributed.h"
 
 #include "connection/stream/common/Discovery.h"
+#include "connection/stream/common/TracedChannel.h"
 
 #include "distributed/Worker.h"
 #include "distributed/Pool.h"
@@ -51,9 +52,17 @@ namespace Gadgetron::Server::Connection::Stream {
 
 
     void PureDistributed::process_outbound(GenericInputChannel input, Queue &jobs) {
-        auto workers = Pool(finish_connecting_to_peers(std::move(pending_workers)));
+        Pool::Settings settings;
+        settings.window = window;
 
-        for (auto message : input) {
+        Pool workers(
+                finish_connecting_to_peers(std::move(pending_workers)),
+                [=](const Address &address) { return connect_to_peer(address, serialization, configuration); },
+                settings
+        );
+
+        auto traced_input = trace_input(std::move(input));
+        for (auto message : traced_input) {
             jobs.push(workers.push(std::move(message)));
         }
 
@@ -96,7 +105,8 @@ namespace Gadgetron::Server::Connection::Stream {
         configuration(std::make_shared<Configuration>(
                 context,
                 config
-        )) {
+        )),
+        window(config.window) {
         pending_workers = begin_connecting_to_peers(std::async(discover_peers), serialization, configuration);
     }
 
@@ -45,6 +45,7 @@ namespace Gadgetron::Server::Connection::Stream {
 
         std::shared_ptr<Serialization> serialization;
         std::shared_ptr<Configuration> configuration;
+        const size_t window;
 
         std::list<std::future<std::unique_ptr<Worker>>> pending_workers;
     };
@@ -7,6 +7,7 @@
 #include "connection/stream/ParallelProcess.h"
 #include "connection/stream/PureDistributed.h"
 #include "connection/Loader.h"
+#include "connection/stream/common/TracedChannel.h"
 
 #include "Node.h"
 
@@ -36,18 +37,122 @@ namespace {
                 OutputChannel output,
                 ErrorHandler &
         ) override {
-             node->process(input, output);
+             auto traced_input = trace_input(std::move(input));
+             node->process(traced_input, output);
         }
 
         const std::string& name() override {
             return name_;
         }
 
+        PushNode *push_node() {
+            return dynamic_cast<PushNode *>(node.get());
+        }
+
     private:
         std::unique_ptr<Node> node;
         const std::string name_;
     };
 
+    class DirectChannel : public Channel {
+    public:
+        DirectChannel(PushNode &node, OutputChannel &out, const char *name) : node(node), out(out), name(name) {}
+
+    protected:
+        Message pop() override { throw ChannelClosed(); }
+
+        optional<Message> try_pop() override { return none; }
+
+        void close() override {}
+
+        void push_message(Message message) override {
+            Tracing::Span span(name, "process", count++);
+            node.consume(std::move(message), out);
+        }
+
+    private:
+        PushNode &node;
+        OutputChannel &out;
+        const char *name;
+        int64_t count = 0;
+    };
+
+    class FusedProcessable : public Processable {
+    public:
+        explicit FusedProcessable(std::vector<std::shared_ptr<NodeProcessable>> nodes)
+            : nodes(std::move(nodes)), name_(fused_name(this->nodes)) {}
+
+        void process(GenericInputChannel input,
+                OutputChannel output,
+                ErrorHandler &
+        ) override {
+            std::vector<PushNode *> push_nodes;
+            for (auto &node : nodes) push_nodes.push_back(node->push_node());
+
+            // Each node gets a span per message, named after the node rather than the fused run.
+            auto trace = Tracing::current();
+            std::vector<const char *> names;
+            for (auto &node : nodes) names.push_back(trace ? trace->intern(node->name()) : "");
+
+            // Node i pushes into outputs[i], which calls node i+1 directly. The last node pushes into the stream output.
+            std::vector<std::unique_ptr<OutputChannel>> outputs(nodes.size());
+            outputs.back() = std::make_unique<OutputChannel>(std::move(output));
+            for (auto i = int(nodes.size()) - 2; i >= 0; i--) {
+                auto channel = make_channel<DirectChannel>(*push_nodes[i + 1], *outputs[i + 1], names[i + 1]);
+                outputs[i] = std::make_unique<OutputChannel>(std::move(channel.output));
+            }
+
+            for (auto i = 0; i < nodes.size(); i++) push_nodes[i]->start(*outputs[i]);
+
+            int64_t count = 0;
+            auto traced_input = trace_input(std::move(input));
+            for (auto message : traced_input) {
+                Tracing::Span span(names.front(), "process", count++);
+                push_nodes.front()->consume(std::move(message), *outputs.front());
+            }
+
+            for (auto i = 0; i < nodes.size(); i++) push_nodes[i]->finish(*outputs[i]);
+        }
+
+        const std::string& name() override {
+            return name_;
+        }
+
+    private:
+        static std::string fused_name(const std::vector<std::shared_ptr<NodeProcessable>> &nodes) {
+            std::string name;
+            for (auto &node : nodes) name += (name.empty() ? "" : "+") + node->name();
+            return name;
+        }
+
+        const std::vector<std::shared_ptr<NodeProcessable>> nodes;
+        const std::string name_;
+    };
+
+    std::vector<std::shared_ptr<Processable>> fuse_nodes(const std::vector<std::shared_ptr<Processable>> &nodes) {
+        std::vector<std::shared_ptr<Processable>> fused{};
+        std::vector<std::shared_ptr<NodeProcessable>> run{};
+
+        auto flush = [&]() {
+            if (run.size() == 1) fused.push_back(run.front());
+            if (run.size() > 1) fused.push_back(std::make_shared<FusedProcessable>(run));
+            run.clear();
+        };
+
+        for (auto &node : nodes) {
+            auto node_processable = std::dynamic_pointer_cast<NodeProcessable>(node);
+            if (node_processable && node_processable->push_node()) {
+                run.push_back(node_processable);
+                continue;
+            }
+            flush();
+            fused.push_back(node);
+        }
+        flush();
+
+        return fused;
+    }
+
     std::shared_ptr<Processable> load_node(const Config::Gadget &conf, const StreamContext &context, Loader &loader) {
         GDEBUG("Loading Gadget %s of class %s from \n",conf.name.c_str(),conf.classname.c_str(),conf.dll.c_str());
         auto factory = loader.load_factory<Loader::generic_factory<Node>>("gadget_factory_export_", conf.classname,
@@ -83,12 +188,15 @@ namespace {
 
 namespace Gadgetron::Server::Connection::Stream {
 
-    Stream::Stream(const Config::Stream &config, const Core::StreamContext &context, Loader &loader) : key(config.key) {
+    Stream::Stream(const Config::Stream &config, const Core::StreamContext &context, Loader &loader)
+        : key(config.key), capacity(config.capacity) {
         for (auto &node_config : config.nodes) {
             nodes.emplace_back(
                     Core::visit([&](auto n) { return load_node(n, context, loader); }, node_config)
             );
         }
+
+        if (config.fuse) nodes = fuse_nodes(nodes);
     }
 
     void Stream::process(GenericInputChannel input,
@@ -102,7 +210,7 @@ namespace Gadgetron::Server::Connection::Stream {
         std::vector<OutputChannel> output_channels{};
 
         for (auto i = 0; i < nodes.size()-1; i++) {
-            auto channel = make_channel<MessageChannel>();
+            auto channel = capacity ? make_channel<BoundedMessageChannel>(*capacity) : make_channel<MessageChannel>();
             input_channels.emplace_back(std::move(channel.input));
             output_channels.emplace_back(std::move(channel.output));
         }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Channel.h"
+#include "trace.h"
+
+namespace Gadgetron::Server::Connection::Stream {
+
+    /**
+     * Passes on the messages of an input channel, recording how long the reader waits for each message ("wait"),
+     * and how long it works on it before asking for the next one ("process").
+     */
+    class TracedChannel : public Core::Channel {
+    public:
+        explicit TracedChannel(Core::GenericInputChannel input) : input(std::move(input)) {}
+
+    protected:
+        Core::Message pop() override {
+            processing.reset();
+            auto message = [&]() {
+                Tracing::Span span("wait", "queue", count);
+                return input.pop();
+            }();
+            start_processing();
+            return message;
+        }
+
+        Core::optional<Core::Message> try_pop() override {
+            auto message = input.try_pop();
+            if (message) {
+                processing.reset();
+                start_processing();
+            }
+            return message;
+        }
+
+        void push_message(Core::Message) override { throw Core::ChannelClosed(); }
+
+        // The wrapped input closes its channel when it is destroyed.
+        void close() override {}
+
+    private:
+        void start_processing() { processing.emplace(Tracing::current_gadget(), "process", count++); }
+
+        Core::GenericInputChannel input;
+        Core::optional<Tracing::Span> processing;
+        int64_t count = 0;
+    };
+
+    /// Returns input with wait and process spans recorded, if a trace is installed on this thread.
+    inline Core::GenericInputChannel trace_input(Core::GenericInputChannel input) {
+        if (!Tracing::current()) return input;
+        return std::move(Core::make_channel<TracedChannel>(std::move(input)).input);
+    }
+}
@@ -1,62 +1,246 @@
-
 #include "Pool.h"
 
 #include "connection/stream/common/Discovery.h"
 
+#include <sstream>
+
 #include "log.h"
 #include "io/iostream_operators.h"
 
 using namespace Gadgetron::Core;
 using namespace Gadgetron::Server::Connection::Stream;
 
-namespace {
+namespace Gadgetron::Server::Connection::Stream {
+
+    struct Pool::Job {
+        Message message;
+        std::promise<Message> response;
+        size_t attempts_left;
+        int64_t id;
+        uint64_t dispatched;
+    };
+
+    struct Pool::Slot {
+        const Address address;
+        std::unique_ptr<Worker> worker;
+        size_t in_flight = 0;
+        bool healthy = true;
+        std::chrono::milliseconds probe_delay;
+        std::chrono::steady_clock::time_point next_probe;
+        const char *span_name;
+    };
+
+    Pool::Pool(
+            std::list<std::unique_ptr<Worker>> workers,
+            WorkerFactory factory,
+            Settings settings
+    ) : factory(std::move(factory)), settings(settings), trace(Tracing::current()), trace_gadget(Tracing::current_gadget()) {
+        for (auto &worker : workers) {
+            auto address = worker->address;
+            std::stringstream span_name;
+            span_name << "worker " << address;
+            slots.push_back(std::unique_ptr<Slot>(
+                    new Slot{address, std::move(worker), 0, true, settings.initial_probe_delay, {},
+                             trace ? trace->intern(span_name.str()) : ""}
+            ));
+        }
+        prober = std::thread([=]() { probe_failed_workers(); });
+    }
+
+    Pool::~Pool() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&]() { return outstanding == 0; });
+        closing = true;
+        lock.unlock();
+
+        changed.notify_all();
+        prober.join();
+
+        // Workers are destroyed without the lock held, as their inbound threads may still call into the pool.
+        slots.clear();
+    }
+
+    std::future<Message> Pool::push(Message message) {
+        auto job = std::make_shared<Job>(Job{std::move(message), {}, std::max<size_t>(settings.retries, 1), 0, 0});
+        auto future = job->response.get_future();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        job->id = jobs_pushed++;
+        const size_t capacity = std::max<size_t>(settings.window * slots.size(), 1);
+        changed.wait(lock, [&]() { return pending.size() < capacity; });
+
+        pending.push_back(std::move(job));
+        outstanding++;
+        dispatch(lock);
 
-    bool compare_load(const std::unique_ptr<Worker> &a, const std::unique_ptr<Worker> &b) {
-        return a->current_load() < b->current_load();
+        return future;
     }
 
-    std::unique_ptr<Worker> &select_best_worker(std::list<std::unique_ptr<Worker>> &workers) {
-        return *std::min_element(workers.begin(), workers.end(), compare_load);
+    void Pool::dispatch(std::unique_lock<std::mutex> &lock) {
+        while (!pending.empty()) {
+            auto slot = select_slot();
+            if (!slot) {
+                if (!any_healthy()) fail_pending("No workers available to process job.");
+                break;
+            }
+
+            auto job = pending.front();
+            pending.pop_front();
+
+            // The reservation keeps the prober from replacing the worker while we send without the lock held.
+            slot->in_flight++;
+            job->dispatched = Tracing::now();
+            auto worker = slot->worker.get();
+            auto message = job->message.clone(); // Shares the payload; no data is copied.
+
+            lock.unlock();
+            try {
+                worker->push(
+                        std::move(message),
+                        [=](Message response) { complete(slot, job, std::move(response)); },
+                        [=](std::exception_ptr e) { fail(slot, worker, job, e); }
+                );
+                GDEBUG_STREAM("Pushed message to worker " << worker->address);
+                lock.lock();
+            }
+            catch (const std::exception &e) {
+                GWARN_STREAM("Failed to push job to worker " << worker->address << ". The job will be retried. [" << e.what() << "]");
+                lock.lock();
+                slot->in_flight--;
+                take_out_of_rotation(*slot, worker);
+                pending.push_front(job);
+            }
+        }
+        changed.notify_all();
     }
 
-    Message send_to_best_worker(
-            Message message,
-            std::shared_ptr<std::list<std::unique_ptr<Worker>>> workers,
-            size_t retries
-    ) {
+    Pool::Slot *Pool::select_slot() {
+        Slot *best = nullptr;
+        long long best_load = 0;
+
+        for (auto &slot : slots) {
+            if (!slot->healthy || slot->in_flight >= settings.window) continue;
+
+            auto load = slot->worker->current_load();
+            if (!best || load < best_load) {
+                best = slot.get();
+                best_load = load;
+            }
+        }
 
-        if (!retries) throw std::runtime_error("Multiple workers failed processing job; aborting.");
+        return best;
+    }
 
-        auto &worker = select_best_worker(*workers);
+    bool Pool::any_healthy() const {
+        return std::any_of(slots.begin(), slots.end(), [](auto &slot) { return slot->healthy; });
+    }
 
+    void Pool::complete(Slot *slot, std::shared_ptr<Job> job, Message response) {
+        GDEBUG_STREAM("Response gotten from worker " << slot->address);
+        if (trace) trace->record({slot->span_name, "distributed", trace_gadget, job->dispatched, Tracing::now(), job->id});
+        job->response.set_value(std::move(response));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        slot->in_flight--;
+        outstanding--;
+        dispatch(lock);
+    }
+
+    void Pool::fail(Slot *slot, Worker *worker, std::shared_ptr<Job> job, std::exception_ptr e) {
         try {
-            auto response = worker->push(message.clone());
-            GDEBUG_STREAM("Pushed message; waiting for response from worker " << worker->address);
-            auto response_message = response.get();
-            GDEBUG_STREAM("Response gotten from worker " << worker->address);
-            return std::move(response_message);
+            std::rethrow_exception(e);
         }
         catch (const std::exception &e) {
-            GWARN_STREAM("Worker " << worker->address << " failed processing job. The job will be retried. [" << e.what() << "]");
-            return send_to_best_worker(std::move(message), std::move(workers), retries - 1);
+            GWARN_STREAM("Worker " << slot->address << " failed processing job. The job will be retried. [" << e.what() << "]");
         }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        slot->in_flight--;
+        take_out_of_rotation(*slot, worker);
+        retry(std::move(job));
+        dispatch(lock);
     }
-}
 
-namespace Gadgetron::Server::Connection::Stream {
+    void Pool::retry(std::shared_ptr<Job> job) {
+        if (--job->attempts_left) {
+            pending.push_front(std::move(job));
+            return;
+        }
 
-    Pool::Pool(
-            std::list<std::unique_ptr<Worker>> workers
-    ) : workers(std::make_shared<std::list<std::unique_ptr<Worker>>>(std::move(workers))) {}
+        job->response.set_exception(std::make_exception_ptr(
+                std::runtime_error("Multiple workers failed processing job; aborting.")
+        ));
+        outstanding--;
+    }
 
-    std::future<Message> Pool::push(Message message) {
-        return std::async(
-                std::launch::async,
-                send_to_best_worker,
-                std::move(message),
-                workers,
-                3
-        );
+    void Pool::fail_pending(const std::string &reason) {
+        for (auto &job : pending) {
+            job->response.set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+            outstanding--;
+        }
+        pending.clear();
     }
-}
 
+    void Pool::take_out_of_rotation(Slot &slot, Worker *worker) {
+        // Late failures from a worker that has already been replaced say nothing about the replacement.
+        if (!slot.healthy || slot.worker.get() != worker) return;
+
+        GWARN_STREAM("Taking worker " << slot.address << " out of rotation; it will be probed in " << slot.probe_delay.count() << " ms.");
+        slot.healthy = false;
+        slot.next_probe = std::chrono::steady_clock::now() + slot.probe_delay;
+        changed.notify_all();
+    }
+
+    void Pool::probe_failed_workers() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!closing) {
+            // Only workers with nothing in flight are replaced, so no handler ever refers to a destroyed worker.
+            Slot *due = nullptr;
+            for (auto &slot : slots) {
+                if (slot->healthy || slot->in_flight) continue;
+                if (!due || slot->next_probe < due->next_probe) due = slot.get();
+            }
+
+            if (!due) {
+                changed.wait(lock);
+                continue;
+            }
+
+            if (std::chrono::steady_clock::now() < due->next_probe) {
+                changed.wait_until(lock, due->next_probe);
+                continue;
+            }
+
+            auto address = due->address;
+            due->next_probe = std::chrono::steady_clock::now() + due->probe_delay;
+            lock.unlock();
+
+            std::unique_ptr<Worker> worker;
+            try {
+                worker = factory(address);
+            }
+            catch (const std::exception &e) {
+                GDEBUG_STREAM("Probing worker " << address << " failed: " << e.what());
+            }
+
+            lock.lock();
+            if (worker && !closing) {
+                GINFO_STREAM("Worker " << address << " responded to probe; re-admitting it.");
+                std::swap(due->worker, worker);
+                due->healthy = true;
+                due->probe_delay = settings.initial_probe_delay;
+                dispatch(lock);
+            }
+            else if (!worker) {
+                due->probe_delay = std::min(due->probe_delay * 2, settings.max_probe_delay);
+                due->next_probe = std::chrono::steady_clock::now() + due->probe_delay;
+            }
+
+            // Whichever worker we are left with (the failed one, or an unused replacement) is destroyed unlocked.
+            lock.unlock();
+            worker.reset();
+            lock.lock();
+        }
+    }
+}
@@ -1,26 +1,92 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <functional>
 #include <mutex>
 #include <vector>
 #include <memory>
 #include <future>
 #include <algorithm>
+#include <thread>
 
 #include "connection/stream/common/External.h"
 
 #include "Worker.h"
 
 #include "Message.h"
+#include "trace.h"
 
 
 namespace Gadgetron::Server::Connection::Stream {
 
+    /**
+     * Distributes jobs over a set of workers.
+     *
+     * Jobs are dispatched as workers have room for them: each worker has at most `window` jobs in flight, and each
+     * job goes to the worker with the lowest estimated completion time (smoothed service time times queue depth).
+     * Responses are handled on the workers' inbound threads, so no thread is kept per job.
+     *
+     * A job that fails is retried on another worker. A worker that fails is taken out of rotation and probed (by
+     * reconnecting) with exponential backoff until it responds again, after which it is re-admitted.
+     *
+     * If the thread creating the pool has a trace installed, each job records a span from dispatch to response.
+     */
     class Pool {
     public:
-        explicit Pool(std::list<std::unique_ptr<Worker>> workers);
+        using WorkerFactory = std::function<std::unique_ptr<Worker>(const Address &)>;
+
+        struct Settings {
+            size_t window = 4;
+            size_t retries = 3;
+            std::chrono::milliseconds initial_probe_delay = std::chrono::seconds(1);
+            std::chrono::milliseconds max_probe_delay = std::chrono::seconds(30);
+        };
+
+        Pool(std::list<std::unique_ptr<Worker>> workers, WorkerFactory factory, Settings settings);
+
+        /// Waits for all jobs pushed to complete.
+        ~Pool();
+
+        Pool(const Pool &) = delete;
+        Pool &operator=(const Pool &) = delete;
+
+        /// Blocks while enough jobs are waiting to fill every worker's window.
         std::future<Core::Message> push(Core::Message message);
 
     private:
-        std::shared_ptr<std::list<std::unique_ptr<Worker>>> workers;
+        struct Job;
+        struct Slot;
+
+        void dispatch(std::unique_lock<std::mutex> &lock);
+        Slot *select_slot();
+        bool any_healthy() const;
+
+        void complete(Slot *slot, std::shared_ptr<Job> job, Core::Message response);
+        void fail(Slot *slot, Worker *worker, std::shared_ptr<Job> job, std::exception_ptr e);
+        void retry(std::shared_ptr<Job> job);
+        void fail_pending(const std::string &reason);
+        void take_out_of_rotation(Slot &slot, Worker *worker);
+
+        void probe_failed_workers();
+
+        const WorkerFactory factory;
+        const Settings settings;
+
+        const std::shared_ptr<Tracing::Trace> trace;
+        const char *const trace_gadget;
+        int64_t jobs_pushed = 0;
+
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        std::vector<std::unique_ptr<Slot>> slots;
+        std::deque<std::shared_ptr<Job>> pending;
+        size_t outstanding = 0;
+        bool closing = false;
+
+        std::thread prober;
     };
-}
\ No newline at end of file
+}
@@ -1,4 +1,3 @@
-
 #include "Worker.h"
 
 #include <chrono>
@@ -19,13 +18,18 @@ namespace {
                 std::chrono::steady_clock::now() - instance
         );
     }
+
+    // Weight of the most recent job in the service time estimate.
+    constexpr double smoothing = 0.2;
 }
 
 namespace Gadgetron::Server::Connection::Stream {
 
     struct Worker::Job {
+        size_t id;
         std::chrono::time_point<std::chrono::steady_clock> start;
-        std::promise<Core::Message> response;
+        ResponseHandler on_response;
+        FailureHandler on_failure;
     };
 
     struct Module {
@@ -37,39 +41,42 @@ namespace Gadgetron::Server::Connection::Stream {
     struct Worker::PushModule : public Module {
         using Module::Module;
 
-        virtual std::future<Message> push(Message message) {
+        virtual size_t push(ResponseHandler on_response, FailureHandler on_failure) {
             GDEBUG_STREAM("Pushing message to remote worker " << worker.address);
 
-            Job job {
+            worker.jobs.push_back(Job{
+                    worker.next_job_id++,
                     std::chrono::steady_clock::now(),
-                    std::promise<Message>()
-            };
-
-            auto future = job.response.get_future();
-            worker.channel->push_message(std::move(message));
-            worker.jobs.push_back(std::move(job));
-            return future;
+                    std::move(on_response),
+                    std::move(on_failure)
+            });
+            return worker.jobs.back().id;
         };
+
+        virtual bool closed() { return false; }
     };
 
     struct Worker::LoadModule : public Module {
         using Module::Module;
 
         virtual long long current_load() {
-            auto current_job_duration_estimate = std::max(
-                    worker.timing.latest.count(),
-                    time_since(worker.jobs.front().start).count()
-            );
+            auto service = worker.timing.service.count();
+            if (worker.jobs.empty()) return service;
+
+            // The job at the front may already have taken longer than we expected.
+            auto front_started = std::max(worker.jobs.front().start, worker.timing.latest_completion);
+            auto front_remaining = std::max<long long>(service - time_since(front_started).count(), 0);
 
-            return current_job_duration_estimate * worker.jobs.size();
+            return front_remaining + service * static_cast<long long>(worker.jobs.size());
         };
     };
 
     struct Worker::ClosedPushModule : public Worker::PushModule {
         using Worker::PushModule::PushModule;
-        std::future<Message> push(Message message) override {
+        size_t push(ResponseHandler, FailureHandler) override {
             throw std::runtime_error("Cannot push message to closed/failed worker.");
         }
+        bool closed() override { return true; }
     };
 
     struct Worker::ClosedLoadModule : public Worker::LoadModule {
@@ -110,9 +117,33 @@ namespace Gadgetron::Server::Connection::Stream {
         return load_module->current_load();
     }
 
-    std::future<Message> Worker::push(Message message) {
+    bool Worker::failed() const {
         std::lock_guard<std::mutex> guard(mutex);
-        return push_module->push(std::move(message));
+        return push_module->closed();
+    }
+
+    void Worker::push(Message message, ResponseHandler on_response, FailureHandler on_failure) {
+        // The message is written without the worker lock held, so the load can be read while it is being sent.
+        // Writes are serialized on their own; jobs are registered in the order they are written, which is the
+        // order the worker responds in.
+        std::lock_guard<std::mutex> writing(write_mutex);
+
+        size_t id;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            id = push_module->push(std::move(on_response), std::move(on_failure));
+        }
+
+        try {
+            channel->push_message(std::move(message));
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(mutex);
+            // If the job is no longer pending, the inbound thread has failed it already.
+            if (jobs.empty() || jobs.back().id != id) return;
+            jobs.pop_back();
+            throw;
+        }
     }
 
     void Worker::close() {
@@ -121,32 +152,53 @@ namespace Gadgetron::Server::Connection::Stream {
     }
 
     void Worker::handle_inbound_messages() {
+        std::exception_ptr failure;
         try {
             while(true) process_inbound_message(channel->pop());
         }
-        catch (const ChannelClosed &) {}
+        catch (const ChannelClosed &) {
+            failure = std::make_exception_ptr(std::runtime_error("Connection to worker closed with jobs pending."));
+        }
         catch (const std::exception &e) {
             GWARN_STREAM("Worker " << address << " failed: " << e.what());
-            fail_pending_messages(std::current_exception());
+            failure = std::current_exception();
         }
         switch_to_closed_modules();
+        fail_pending_messages(failure);
     }
 
     void Worker::process_inbound_message(Core::Message message) {
         GDEBUG_STREAM("Received message from remote worker " << address);
 
-        std::lock_guard<std::mutex> guard(mutex);
+        Job job;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            if (jobs.empty()) throw std::runtime_error("Received a response from a worker with no pending jobs.");
+            job = std::move(jobs.front()); jobs.pop_front();
+
+            auto now = std::chrono::steady_clock::now();
+            auto service = time_since(std::max(job.start, timing.latest_completion));
+            timing.service = timing.measured ?
+                std::chrono::milliseconds(static_cast<long long>(
+                        smoothing * service.count() + (1.0 - smoothing) * timing.service.count())) :
+                service;
+            timing.measured = true;
+            timing.latest_completion = now;
+        }
 
-        auto job = std::move(jobs.front()); jobs.pop_front();
-        timing.latest = time_since(job.start);
-        job.response.set_value(std::move(message));
+        job.on_response(std::move(message));
     }
 
     void Worker::fail_pending_messages(const std::exception_ptr &e) {
-        std::lock_guard<std::mutex> guard(mutex);
+        std::list<Job> failed_jobs;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            failed_jobs.swap(jobs);
+        }
 
-        for (auto &job : jobs) {
-            job.response.set_exception(e);
+        for (auto &job : failed_jobs) {
+            job.on_failure(e);
         }
     }
 
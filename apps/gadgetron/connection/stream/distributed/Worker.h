@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <future>
 
@@ -17,6 +18,9 @@ namespace Gadgetron::Server::Connection::Stream {
 
     class Worker {
     public:
+        using ResponseHandler = std::function<void(Core::Message)>;
+        using FailureHandler = std::function<void(std::exception_ptr)>;
+
         const Address address;
 
         ~Worker();
@@ -26,21 +30,36 @@ namespace Gadgetron::Server::Connection::Stream {
                 std::shared_ptr<Configuration> configuration
         );
 
-        std::future<Core::Message> push(Core::Message message);
+        /**
+         * Sends a job to the worker. Exactly one of the handlers is called once the job completes or fails; they are
+         * called from the worker's inbound thread, with no locks held. Throws if the worker is closed or has failed.
+         */
+        void push(Core::Message message, ResponseHandler on_response, FailureHandler on_failure);
+
+        /// Estimated time (in milliseconds) until a job pushed now would complete.
         long long current_load() const;
+
+        bool failed() const;
+
         void close();
 
     private:
         mutable std::mutex mutex;
+        std::mutex write_mutex;
 
         std::thread inbound_thread;
 
+        // Service time is measured from when the worker could have started the job (the later of the job being
+        // pushed and the previous job completing), so that queueing at the worker is not counted as latency.
         struct Timing {
-            std::chrono::milliseconds latest = std::chrono::seconds(5);
+            std::chrono::milliseconds service = std::chrono::seconds(5);
+            std::chrono::time_point<std::chrono::steady_clock> latest_completion;
+            bool measured = false;
         } timing;
 
         struct Job;
         std::list<Job> jobs;
+        size_t next_job_id = 0;
         std::unique_ptr<ExternalChannel> channel;
 
         struct PushModule; struct LoadModule; struct ClosedPushModule; struct ClosedLoadModule;
@@ -30,7 +30,19 @@ int main(int argc, char *argv[]) {
              "Set the Gadgetron home directory.")
             ("port,p",
              value<unsigned short>()->default_value(9002),
-             "Listen for incoming connections on this port.");
+             "Listen for incoming connections on this port.")
+            ("max_connections",
+             value<unsigned int>()->default_value(0),
+             "Maximum number of connections processed at the same time. 0 means no limit.")
+            ("connection_queue",
+             value<unsigned int>()->default_value(16),
+             "Number of connections allowed to wait when max_connections is reached. Further connections are refused.")
+            ("memory_budget",
+             value<unsigned int>()->default_value(0),
+             "Memory (MiB) connections may hold together before new connections wait. 0 means no limit.")
+            ("connection_memory",
+             value<unsigned int>()->default_value(0),
+             "Memory (MiB) counted against the budget for each connection, until it actually holds more.");
 
     variables_map args;
     store(parse_command_line(argc, argv, desc), args);
@@ -0,0 +1,100 @@
+#include "../MemoryBudget.h"
+#include <gtest/gtest.h>
+
+#include "hoContentCache.h"
+#include "hoNDArray.h"
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Gadgetron;
+using namespace Gadgetron::Server;
+
+TEST(MemoryBudget, admits_everything_without_a_budget) {
+    MemoryBudget budget(0, 1024, 1);
+
+    auto first = budget.open();
+    auto second = budget.open();
+    second->add(4096);
+
+    EXPECT_TRUE(budget.admits());
+    EXPECT_EQ(budget.live_bytes(), 0u);
+}
+
+TEST(MemoryBudget, counts_the_reserve_until_a_connection_holds_more) {
+    MemoryBudget budget(3000, 1000, 8);
+
+    auto first = budget.open();
+    auto second = budget.open();
+    EXPECT_TRUE(budget.admits());
+
+    first->add(1500);
+    EXPECT_FALSE(budget.admits());
+    EXPECT_EQ(budget.live_bytes(), 1500u);
+
+    first->remove(1000);
+    EXPECT_TRUE(budget.admits());
+}
+
+TEST(MemoryBudget, releases_accounts_with_the_last_reference) {
+    MemoryBudget budget(1000, 0, 1);
+
+    auto account = budget.open();
+    account->add(100);
+    EXPECT_FALSE(budget.admits());
+
+    account.reset();
+    EXPECT_TRUE(budget.admits());
+    EXPECT_EQ(budget.live_bytes(), 0u);
+
+    auto next = budget.open();
+    EXPECT_EQ(next->peak_bytes(), 0u);
+}
+
+TEST(MemoryBudget, releases_accounts_of_connections_leaving_memory_in_a_cache) {
+    MemoryBudget budget(1000, 0, 1);
+    ContentCache cache(size_t(1) << 20);
+
+    // A connection in the server process, with a gadget filling a process wide cache.
+    auto connection = budget.open();
+    auto gadget = std::make_shared<hoMemoryAccount>(connection);
+    {
+        hoMemory::ScopedAccount scope(gadget);
+        auto array = std::make_shared<hoNDArray<float>>(256);
+        cache.insert(ContentKey().add(1), std::shared_ptr<const hoNDArray<float>>(array), array->get_number_of_bytes());
+    }
+    EXPECT_EQ(connection->live_bytes(), 1024u);
+    EXPECT_FALSE(budget.admits());
+
+    gadget.reset();
+    connection.reset();
+    EXPECT_TRUE(budget.admits());
+    EXPECT_EQ(budget.live_bytes(), 0u);
+
+    // The next connection in the slot is not credited for what the previous one left behind.
+    auto next = budget.open();
+    cache.clear();
+    EXPECT_EQ(next->live_bytes(), 0u);
+    EXPECT_EQ(budget.live_bytes(), 0u);
+}
+
+#if !defined(_WIN32)
+TEST(MemoryBudget, sees_memory_held_by_forked_processes) {
+    MemoryBudget budget(1000, 0, 1);
+
+    auto account = budget.open();
+    auto pid = fork();
+    if (pid == 0) {
+        account->add(2000);
+        account.reset();
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+
+    EXPECT_EQ(budget.live_bytes(), 2000u);
+    EXPECT_FALSE(budget.admits());
+}
+#endif
@@ -54,7 +54,7 @@ TEST_F(SocketTest, write_test) {
 
     auto data = std::vector<char>(1u << 22,42);
 
-    auto thread = std::thread([&](){socketstream->write(data.data(),data.size());});
+    auto thread = std::thread([&](){socketstream->write(data.data(),data.size()); socketstream->flush();});
 
     auto data2 = std::vector<char>(data.size());
     ba::read(*server_socket,ba::buffer(data2.data(),data2.size()));
@@ -69,6 +69,7 @@ TEST_F(SocketTest, stringstream_test) {
     std::stringstream sstream;
     sstream << name;
     *socketstream << sstream.rdbuf();
+    socketstream->flush();
 
 
 
@@ -91,7 +92,7 @@ TEST_F(SocketTest, nulltest) {
     std::stringstream sstream;
     sstream.write(data.data(),data.size());
 
-    auto thread = std::thread([&](){   *socketstream << sstream.rdbuf(); *socketstream << sstream.rdbuf();});
+    auto thread = std::thread([&](){   *socketstream << sstream.rdbuf(); *socketstream << sstream.rdbuf(); socketstream->flush();});
 
 
 
@@ -102,3 +103,47 @@ TEST_F(SocketTest, nulltest) {
     thread.join();
 }
 
+
+
+TEST_F(SocketTest, mixed_read_test) {
+    std::vector<char> data(1u << 20);
+    std::mt19937_64 engine;
+    std::uniform_int_distribution<int> distribution(0, 255);
+    for (auto& d : data) d = static_cast<char>(distribution(engine));
+
+    auto thread = std::thread([&](){ ba::write(*server_socket, ba::buffer(data.data(), data.size())); });
+
+    // Small reads are served from the buffer; large ones go straight into the destination.
+    std::vector<char> received(data.size());
+    size_t offset = 0;
+    for (size_t chunk : std::vector<size_t>{3, 100, 70000, 5, 1u << 17, 1}) {
+        socketstream->read(received.data() + offset, chunk);
+        offset += chunk;
+    }
+    socketstream->read(received.data() + offset, received.size() - offset);
+
+    ASSERT_EQ(data, received);
+    thread.join();
+}
+
+TEST_F(SocketTest, mixed_write_test) {
+    std::vector<char> header(40, 1);
+    std::vector<char> payload(1u << 20, 2);
+
+    auto thread = std::thread([&](){
+        socketstream->write(header.data(), header.size());
+        socketstream->write(payload.data(), payload.size());
+        socketstream->write(header.data(), header.size());
+        socketstream->flush();
+    });
+
+    std::vector<char> expected(header);
+    expected.insert(expected.end(), payload.begin(), payload.end());
+    expected.insert(expected.end(), header.begin(), header.end());
+
+    std::vector<char> received(expected.size());
+    ba::read(*server_socket, ba::buffer(received.data(), received.size()));
+
+    ASSERT_EQ(expected, received);
+    thread.join();
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "MPMCChannel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Gadgetron::Core {
+
+    /**
+     * A bounded multi-producer, multi-consumer channel backed by a pre-sized ring buffer.
+     *
+     * Push and pop are lock-free on the fast path (one CAS per operation, in the style of Vyukov's bounded queue).
+     * When the ring is full, push blocks until a consumer makes room (backpressure). When it is empty, pop blocks
+     * until a producer delivers. The mutex and condition variables are only touched when a thread actually has
+     * to sleep.
+     */
+    template <class T> class BoundedMPMCChannel {
+    public:
+        /// Capacity is rounded up to the nearest power of two.
+        explicit BoundedMPMCChannel(size_t capacity);
+        ~BoundedMPMCChannel();
+
+        BoundedMPMCChannel(const BoundedMPMCChannel&) = delete;
+        BoundedMPMCChannel& operator=(const BoundedMPMCChannel&) = delete;
+
+        /// Blocks while the channel is full. Throws ChannelClosed if the channel is closed.
+        void push(T);
+
+        template <class... ARGS> void emplace(ARGS&&... args);
+
+        /// Blocks while the channel is empty. Throws ChannelClosed once the channel is closed and drained.
+        T pop();
+        optional<T> try_pop();
+
+        void close();
+
+        size_t capacity() const { return mask + 1; }
+
+        /// Number of messages waiting; approximate while other threads push or pop.
+        size_t size() const {
+            auto dequeued = dequeue_position.load(std::memory_order_relaxed);
+            auto enqueued = enqueue_position.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? std::min(enqueued - dequeued, capacity()) : 0;
+        }
+
+    private:
+        struct alignas(64) Cell {
+            std::atomic<size_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* value() { return reinterpret_cast<T*>(storage); }
+        };
+
+        template <class... ARGS> bool try_emplace(ARGS&&... args);
+        bool try_pop_into(optional<T>& out);
+
+        template <class F> void wait_on(std::condition_variable& cv, std::atomic<int>& waiters, F&& attempt);
+        void wake(std::condition_variable& cv, std::atomic<int>& waiters);
+
+        static size_t round_up_to_power_of_two(size_t value) {
+            size_t result = 1;
+            while (result < value)
+                result <<= 1;
+            return result;
+        }
+
+        static constexpr int spin_iterations = 64;
+
+        const size_t mask;
+        std::unique_ptr<Cell[]> cells;
+
+        alignas(64) std::atomic<size_t> enqueue_position{ 0 };
+        alignas(64) std::atomic<size_t> dequeue_position{ 0 };
+
+        alignas(64) std::atomic<bool> is_closed{ false };
+        std::atomic<int> push_waiters{ 0 };
+        std::atomic<int> pop_waiters{ 0 };
+        std::mutex m;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+    };
+
+    /** Implementation **/
+
+    template <class T>
+    BoundedMPMCChannel<T>::BoundedMPMCChannel(size_t capacity)
+        : mask{ round_up_to_power_of_two(std::max<size_t>(capacity, 2)) - 1 }, cells{ new Cell[mask + 1] } {
+        for (size_t i = 0; i <= mask; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    template <class T> BoundedMPMCChannel<T>::~BoundedMPMCChannel() {
+        optional<T> discard;
+        while (try_pop_into(discard))
+            discard = none;
+    }
+
+    template <class T> template <class... ARGS> bool BoundedMPMCChannel<T>::try_emplace(ARGS&&... args) {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell        = cells[position & mask];
+            size_t sequence   = cell.sequence.load(std::memory_order_acquire);
+            auto difference   = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    new (cell.value()) T(std::forward<ARGS>(args)...);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <class T> bool BoundedMPMCChannel<T>::try_pop_into(optional<T>& out) {
+        size_t position = dequeue_position.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell        = cells[position & mask];
+            size_t sequence   = cell.sequence.load(std::memory_order_acquire);
+            auto difference   = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    out.emplace(std::move(*cell.value()));
+                    cell.value()->~T();
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <class T>
+    template <class F>
+    void BoundedMPMCChannel<T>::wait_on(std::condition_variable& cv, std::atomic<int>& waiters, F&& attempt) {
+        for (int i = 0; i < spin_iterations; i++) {
+            if (attempt())
+                return;
+            std::this_thread::yield();
+        }
+
+        struct WaiterGuard {
+            explicit WaiterGuard(std::atomic<int>& waiters) : waiters{ waiters } { waiters.fetch_add(1); }
+            ~WaiterGuard() { waiters.fetch_sub(1); }
+            std::atomic<int>& waiters;
+        };
+
+        std::unique_lock<std::mutex> lock(m);
+        WaiterGuard guard{ waiters };
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!attempt()) {
+            cv.wait(lock);
+        }
+    }
+
+    template <class T> void BoundedMPMCChannel<T>::wake(std::condition_variable& cv, std::atomic<int>& waiters) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load() == 0)
+            return;
+        { std::lock_guard<std::mutex> lock(m); }
+        cv.notify_one();
+    }
+
+    template <class T> template <class... ARGS> void BoundedMPMCChannel<T>::emplace(ARGS&&... args) {
+        push(T(std::forward<ARGS>(args)...));
+    }
+
+    template <class T> void BoundedMPMCChannel<T>::push(T message) {
+        wait_on(not_full, push_waiters, [&]() {
+            if (is_closed.load(std::memory_order_acquire))
+                throw ChannelClosed();
+            return try_emplace(std::move(message));
+        });
+        wake(not_empty, pop_waiters);
+    }
+
+    template <class T> T BoundedMPMCChannel<T>::pop() {
+        optional<T> message;
+        wait_on(not_empty, pop_waiters, [&]() {
+            if (try_pop_into(message))
+                return true;
+            if (is_closed.load(std::memory_order_acquire) && !try_pop_into(message))
+                throw ChannelClosed();
+            return bool(message);
+        });
+        wake(not_full, push_waiters);
+        return std::move(*message);
+    }
+
+    template <class T> optional<T> BoundedMPMCChannel<T>::try_pop() {
+        optional<T> message;
+        if (try_pop_into(message))
+            wake(not_full, push_waiters);
+        return message;
+    }
+
+    template <class T> void BoundedMPMCChannel<T>::close() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            is_closed.store(true, std::memory_order_release);
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+}
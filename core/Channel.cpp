@@ -29,6 +29,32 @@ namespace Gadgetron::Core {
        channel.close();
     }
 
+    size_t MessageChannel::size() {
+        return channel.size();
+    }
+
+    BoundedMessageChannel::BoundedMessageChannel(size_t capacity) : channel{capacity} {}
+
+    Message BoundedMessageChannel::pop() {
+        return channel.pop();
+    }
+
+    optional<Message> BoundedMessageChannel::try_pop() {
+        return channel.try_pop();
+    }
+
+    void BoundedMessageChannel::push_message(Message message) {
+        channel.push(std::move(message));
+    }
+
+    void BoundedMessageChannel::close() {
+        channel.close();
+    }
+
+    size_t BoundedMessageChannel::size() {
+        return channel.size();
+    }
+
     Message GenericInputChannel::pop() {
         return channel->pop();
     }
@@ -58,3 +84,11 @@ Gadgetron::Core::GenericInputChannel Gadgetron::Core::split(const GenericInputCh
 Gadgetron::Core::OutputChannel Gadgetron::Core::split(const OutputChannel &channel) {
     return OutputChannel{channel};
 }
+
+std::function<size_t()> Gadgetron::Core::queue_size(const GenericInputChannel &input) {
+    std::weak_ptr<Channel> channel = input.channel;
+    return [channel]() {
+        auto locked = channel.lock();
+        return locked ? locked->size() : size_t(0);
+    };
+}
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <condition_variable>
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
 
+#include "BoundedMPMCChannel.h"
 #include "MPMCChannel.h"
 #include "Message.h"
 #include "Types.h"
@@ -19,6 +21,9 @@ namespace Gadgetron { namespace Core {
     public:
         virtual ~Channel() = default;
 
+        /// Number of messages waiting to be popped. Channels which do not keep count report 0.
+        virtual size_t size() { return 0; }
+
         friend GenericInputChannel;
         friend OutputChannel;
 
@@ -70,6 +75,10 @@ namespace Gadgetron { namespace Core {
     GenericInputChannel split(const GenericInputChannel& channel);
     OutputChannel split(const OutputChannel& channel);
 
+    /// Reports the number of messages waiting in the channel of input, or 0 once the channel is gone.
+    /// Unlike a split input, the function does not keep the channel open.
+    std::function<size_t()> queue_size(const GenericInputChannel& input);
+
     /**
      * The end of a channel which provides input
      */
@@ -90,6 +99,7 @@ namespace Gadgetron { namespace Core {
         template <class ChannelType, class... ARGS> friend ChannelPair make_channel(ARGS&&... args);
 
         friend GenericInputChannel split(const GenericInputChannel& channel);
+        friend std::function<size_t()> queue_size(const GenericInputChannel& input);
 
         explicit GenericInputChannel(std::shared_ptr<Channel>);
 
@@ -108,6 +118,8 @@ namespace Gadgetron { namespace Core {
         OutputChannel output;
     };
     class MessageChannel : public Channel {
+    public:
+        size_t size() override;
 
     protected:
         Message pop() override;
@@ -121,6 +133,28 @@ namespace Gadgetron { namespace Core {
         MPMCChannel<Message> channel;
     };
 
+    /**
+     * A MessageChannel with a fixed capacity. Pushing to a full channel blocks until the reader catches up,
+     * which keeps a fast producer from buffering an unbounded amount of data in front of a slow consumer.
+     */
+    class BoundedMessageChannel : public Channel {
+    public:
+        explicit BoundedMessageChannel(size_t capacity);
+
+        size_t size() override;
+
+    protected:
+        Message pop() override;
+
+        optional<Message> try_pop() override;
+
+        void close() override;
+
+        void push_message(Message) override;
+
+        BoundedMPMCChannel<Message> channel;
+    };
+
     /***
      * Creates a ChannelPair
      * @tparam ChannelType Type of Channel, typically MessageChannel
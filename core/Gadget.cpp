@@ -31,11 +31,23 @@ namespace Gadgetron {
             Core::GenericInputChannel& in,
             Core::OutputChannel& out) {
 
-        gadget->next(std::make_shared<ChannelAdaptor>(out));
+        start(out);
 
         for (auto message : in) {
-            gadget->process(message.to_container_message());
+            consume(std::move(message), out);
         }
+        finish(out);
+    }
+
+    void LegacyGadgetNode::start(Core::OutputChannel& out) {
+        gadget->next(std::make_shared<ChannelAdaptor>(out));
+    }
+
+    void LegacyGadgetNode::consume(Core::Message message, Core::OutputChannel&) {
+        gadget->process(message.to_container_message());
+    }
+
+    void LegacyGadgetNode::finish(Core::OutputChannel&) {
         gadget->close();
     }
 }  // namespace Gadgetron
@@ -21,7 +21,7 @@ namespace Gadgetron {
         class MessageChunk {
         public:
             virtual ~MessageChunk() = default;
-            virtual std::unique_ptr<MessageChunk> clone() const = 0;
+            virtual std::unique_ptr<MessageChunk> clone() = 0;
         protected:
             virtual GadgetContainerMessageBase *to_container_message() = 0;
 
@@ -73,29 +73,59 @@ namespace Gadgetron {
         optional<T> unpack(Message &&message);
 
 
+        /**
+         * Holds the payload of a message chunk. A chunk either owns its payload outright, or holds a read-only payload
+         * shared with other chunks (clones). Cloning turns the payload read-only for every chunk holding it; a chunk
+         * holding a read-only payload copies it the first time it is taken or mutated.
+         */
         template<class T>
         class TypedMessageChunk : public MessageChunk {
         public:
 
-            template<class... ARGS>
-            explicit TypedMessageChunk(ARGS &&... xs) : data(std::forward<ARGS>(xs)...) {}
+            template<class... ARGS, class = std::enable_if_t<
+                    !(sizeof...(ARGS) == 1 && all_of_v<std::is_same<std::decay_t<ARGS>, TypedMessageChunk>::value...>)>>
+            explicit TypedMessageChunk(ARGS &&... xs) : owned(std::make_unique<T>(std::forward<ARGS>(xs)...)) {}
 
-            TypedMessageChunk(TypedMessageChunk &&other) = default;
-
-            TypedMessageChunk(const TypedMessageChunk &other) = default;
+            explicit TypedMessageChunk(std::shared_ptr<const T> payload) : shared(std::move(payload)) {}
 
-            TypedMessageChunk &operator=(const TypedMessageChunk &other) = default;
+            TypedMessageChunk(TypedMessageChunk &&other) = default;
 
             TypedMessageChunk &operator=(TypedMessageChunk &&other) = default;
 
             GadgetContainerMessageBase *to_container_message() override;
 
-            std::unique_ptr<MessageChunk> clone() const override;
+            /// Shares the payload with the clone; no data is copied. The payload is read-only for both from now on.
+            std::unique_ptr<MessageChunk> clone() override;
 
             ~TypedMessageChunk() override = default;
 
-            T data;
+            /// Read-only access to the payload. Never copies.
+            const T &data() const { return owned ? *owned : *shared; }
+
+            /// Read-only handle to the payload, which stays valid after the chunk is gone. Never copies.
+            std::shared_ptr<const T> share() {
+                if (owned) shared = std::move(owned);
+                return shared;
+            }
+
+            /// Mutable access to the payload. Copies it first if it is read-only.
+            T &mutable_data() {
+                if (!owned) {
+                    owned = std::make_unique<T>(*shared);
+                    shared.reset();
+                }
+                return *owned;
+            }
+
+            /// Takes the payload out of the chunk. Moves if the chunk owns it, copies if it is read-only.
+            T take() {
+                if (owned) return std::move(*owned);
+                return *shared;
+            }
 
+        private:
+            std::unique_ptr<T> owned;
+            std::shared_ptr<const T> shared;
         };
     }
 }
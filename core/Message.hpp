@@ -13,13 +13,13 @@ namespace Gadgetron::Core {
 
     template<class T>
     GadgetContainerMessageBase* TypedMessageChunk<T>::to_container_message() {
-        return new GadgetContainerMessage<T>(std::move(data));
+        return new GadgetContainerMessage<T>(take());
     }
 
 
     template<class T>
-    std::unique_ptr<MessageChunk> TypedMessageChunk<T>::clone() const {
-        return std::make_unique<TypedMessageChunk<T>>(data);
+    std::unique_ptr<MessageChunk> TypedMessageChunk<T>::clone() {
+        return std::make_unique<TypedMessageChunk<T>>(share());
     }
 
     namespace {
@@ -122,6 +122,14 @@ namespace Gadgetron::Core {
                     return convertible(it, it_end, xs...);
                 }
 
+                // A std::shared_ptr<const T> is a read-only handle to the payload of a T chunk.
+                template<class Iterator, class T, class ...TYPES>
+                static bool convertible(Iterator it, const Iterator &it_end,
+                                        const hana::basic_type<std::shared_ptr<const T>> &,
+                                        const hana::basic_type<TYPES> &... xs) {
+                    return convertible(it, it_end, hana::type_c<T>, xs...);
+                }
+
                 template<class Iterator, class... TTYPES>
                 static bool
                 convertible(Iterator it, const Iterator &it_end, const hana::basic_type<tuple < TTYPES...>>&) {
@@ -146,25 +154,39 @@ namespace Gadgetron::Core {
 
                 template<class Iterator, class T>
                 static T convert(Iterator &it, const Iterator &it_end, const hana::basic_type<T>&) {
-                    return std::move(reinterpret_message<T>(**it).data);
+                    return reinterpret_message<T>(**it).take();
                 }
 
                 template<class Iterator, class T>
                 static optional <T> convert(Iterator &it, const Iterator &it_end, const hana::basic_type<optional < T>>
 
                 ) {
-                    if (convertible(it, it_end, hana::type_c<T>)) return reinterpret_message<T>(**it).data;
+                    if (convertible(it, it_end, hana::type_c<T>)) return reinterpret_message<T>(**it).take();
                     return optional<T>();
                 }
 
                 template<class Iterator, class T, class... TYPES>
                 static hana::tuple<T, TYPES...> convert(Iterator &it, const Iterator &it_end, const hana::basic_type<T>&,
                                                         const hana::basic_type<TYPES> &...xs) {
-                    auto &value = reinterpret_message<T>(**it).data;
+                    auto value = reinterpret_message<T>(**it).take();
                     return combine(std::move(value), convert(++it, it_end, xs...));
                 }
 
 
+                template<class Iterator, class T>
+                static std::shared_ptr<const T>
+                convert(Iterator &it, const Iterator &it_end, const hana::basic_type<std::shared_ptr<const T>> &) {
+                    return reinterpret_message<T>(**it).share();
+                }
+
+                template<class Iterator, class T, class... TYPES>
+                static hana::tuple<std::shared_ptr<const T>, TYPES...>
+                convert(Iterator &it, const Iterator &it_end, const hana::basic_type<std::shared_ptr<const T>> &,
+                        const hana::basic_type<TYPES> &...xs) {
+                    auto value = reinterpret_message<T>(**it).share();
+                    return combine(std::move(value), convert(++it, it_end, xs...));
+                }
+
                 template<class Iterator, class T, class... TYPES>
                 static hana::tuple<optional < T>, TYPES...>
                 convert(Iterator & it,  const Iterator &it_end, const hana::basic_type<boost::optional<T>> &,
@@ -172,7 +194,7 @@ namespace Gadgetron::Core {
                 ) {
 
                     if (convertible(it, it_end, hana::basic_type<T>(), xs...)) {
-                        auto &val = reinterpret_message<T>(**it).data;
+                        auto val = reinterpret_message<T>(**it).take();
                         return combine(optional<T>(std::move(val)), convert(++it, it_end, xs...));
                     }
                     return combine(optional<T>(), convert(it, it_end, xs...));
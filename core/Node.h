@@ -22,6 +22,24 @@ namespace Gadgetron::Core {
         virtual void process(GenericInputChannel& in, OutputChannel& out) = 0;
     };
 
+    /**
+     * A Node which can also be driven one message at a time. Streams may fuse adjacent PushNodes, calling them
+     * directly on the thread of the upstream Node instead of giving each its own thread and channel.
+     */
+    class PushNode {
+    public:
+        virtual ~PushNode() = default;
+
+        /// Called once, before the first message. The OutputChannel stays valid until finish returns.
+        virtual void start(OutputChannel& out) {}
+
+        /// Processes a single message, pushing any results to out.
+        virtual void consume(Message message, OutputChannel& out) = 0;
+
+        /// Called once, after the input has been closed.
+        virtual void finish(OutputChannel& out) {}
+    };
+
     class GenericChannelGadget : public Node, public PropertyMixin {
     public:
         using PropertyMixin::PropertyMixin;
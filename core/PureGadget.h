@@ -2,7 +2,7 @@
 #include "Node.h"
 
 namespace Gadgetron::Core {
-class GenericPureGadget : public GenericChannelGadget {
+class GenericPureGadget : public GenericChannelGadget, public PushNode {
 public:
     using GenericChannelGadget::GenericChannelGadget;
 
@@ -11,6 +11,10 @@ public:
                 out.push(this->process_function(std::move(message)));
         }
 
+        void consume(Message message, OutputChannel& out) final {
+            out.push(this->process_function(std::move(message)));
+        }
+
         /***
          * Takes in a single Message, and produces another message as output
          * @return The processed Message
@@ -0,0 +1,125 @@
+#include "ThreadPool.h"
+#include "hoMemoryPool.h"
+
+#include <algorithm>
+
+namespace Gadgetron::Core {
+
+    namespace {
+        thread_local const ThreadPool* current_pool = nullptr;
+        thread_local size_t current_worker          = 0;
+    }
+
+    ThreadPool::ThreadPool(unsigned int n_workers) {
+        n_workers = std::max(n_workers, 1u);
+        for (auto i = 0u; i < n_workers; i++)
+            workers.emplace_back(std::make_unique<Worker>());
+
+        for (auto i = 0u; i < n_workers; i++)
+            threads.emplace_back([this, i]() { this->run_worker(i); });
+    }
+
+    ThreadPool::~ThreadPool() {
+        if (!stopping) join();
+    }
+
+    ThreadPool& ThreadPool::shared() {
+        static ThreadPool pool(std::thread::hardware_concurrency());
+        return pool;
+    }
+
+    void ThreadPool::submit(Task task, Priority priority) {
+        auto index   = current_pool == this ? current_worker : next_worker++ % workers.size();
+        task.account = hoMemory::current_account();
+        pending++;
+        {
+            std::lock_guard<std::mutex> guard(workers[index]->m);
+            workers[index]->lanes[static_cast<size_t>(priority)].push_back(std::move(task));
+        }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load() > 0) {
+            { std::lock_guard<std::mutex> guard(sleep_mutex); }
+            wakeup.notify_one();
+        }
+    }
+
+    bool ThreadPool::try_pop_local(size_t index, size_t lane, Task& task) {
+        auto& worker = *workers[index];
+        std::lock_guard<std::mutex> guard(worker.m);
+        auto& queue = worker.lanes[lane];
+        if (queue.empty()) return false;
+        task = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+    bool ThreadPool::try_steal(size_t thief, size_t lane, Task& task) {
+        for (size_t offset = 1; offset < workers.size(); offset++) {
+            auto& victim = *workers[(thief + offset) % workers.size()];
+            std::unique_lock<std::mutex> lock(victim.m, std::try_to_lock);
+            if (!lock.owns_lock() || victim.lanes[lane].empty()) continue;
+            task = std::move(victim.lanes[lane].back());
+            victim.lanes[lane].pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    bool ThreadPool::try_acquire(size_t index, Task& task) {
+        if (pending.load() == 0) return false;
+        for (size_t lane = 0; lane < n_priorities; lane++) {
+            if (try_pop_local(index, lane, task) || try_steal(index, lane, task)) {
+                pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThreadPool::run_worker(size_t index) {
+        current_pool   = this;
+        current_worker = index;
+
+        Task task;
+        while (true) {
+            if (try_acquire(index, task)) {
+                hoMemory::ScopedAccount scope(std::move(task.account));
+                task();
+                task = Task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleepers++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wakeup.wait(lock, [&]() { return pending.load() > 0 || stopping.load(); });
+            sleepers--;
+
+            if (stopping && pending.load() == 0) return;
+        }
+    }
+
+    void ThreadPool::join() {
+        {
+            std::lock_guard<std::mutex> guard(sleep_mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (auto& thread : threads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    void TaskGroup::finished() {
+        // Notify under the lock; the group may be destroyed as soon as wait() sees the count reach zero.
+        std::lock_guard<std::mutex> guard(m);
+        in_flight--;
+        done.notify_all();
+    }
+
+    void TaskGroup::wait() {
+        std::unique_lock<std::mutex> lock(m);
+        done.wait(lock, [&]() { return in_flight == 0; });
+    }
+}
@@ -3,103 +3,261 @@
 //
 
 #pragma once
-#include "MPMCChannel.h"
-#include <boost/hana.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
-namespace Gadgetron::Core {
+namespace Gadgetron {
+    class hoMemoryAccount;
+}
 
+namespace Gadgetron::Core {
 
+    /**
+     * A work-stealing thread pool.
+     *
+     * Every worker owns one deque per priority lane. Work submitted from a worker goes to that worker's own deque;
+     * work submitted from outside the pool is spread round-robin across the workers. Idle workers steal from the
+     * other workers before going to sleep. Higher priority lanes are always drained before lower ones.
+     *
+     * Callables that fit in a small inline buffer are stored without a separate heap allocation.
+     *
+     * Work runs under the hoMemory account of the thread that submitted it, so allocations made on the pool are
+     * charged to the connection the work belongs to.
+     *
+     * ThreadPool::shared() is a single pool per process, sized to the number of hardware threads, meant to be shared
+     * by all connections so that concurrent reconstructions do not oversubscribe the cores.
+     */
     class ThreadPool {
-    private:
-        class Work {
-        public:
-            virtual void execute() = 0;
-            virtual ~Work()        = default;
-        };
+    public:
+        enum class Priority { high = 0, normal = 1, low = 2 };
 
-        template <class F, class... ARGS> class Storage{
-        public:
-            explicit Storage(F&& f, ARGS&&... args)
-                : f{ std::forward<F>(f) }, args{ std::forward<ARGS>(args)... } {}
-        protected:
-            F f;
-            boost::hana::tuple<std::decay_t<ARGS>...> args;
-        public:
-            using R = decltype(boost::hana::unpack(std::move(args),f));
-        protected:
-            std::promise<R> promise;
+        explicit ThreadPool(unsigned int workers);
+        ~ThreadPool();
 
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
 
-        public:
-            std::future<R> get_future() {
-                return promise.get_future();
-            }
-        };
-        template<class F, bool IS_VOID, class... ARGS> class ConcreteWorkImpl{};
+        /// Process wide pool, sized to std::thread::hardware_concurrency().
+        static ThreadPool& shared();
+
+        template <class F, class... ARGS> auto async(F&& f, ARGS&&... args) {
+            return async(Priority::normal, std::forward<F>(f), std::forward<ARGS>(args)...);
+        }
+
+        template <class F, class... ARGS> auto async(Priority priority, F&& f, ARGS&&... args);
+
+        /// Fire and forget. Exceptions escaping f are swallowed.
+        template <class F> void post(F&& f, Priority priority = Priority::normal);
 
-        template<class F, class... ARGS> class ConcreteWorkImpl<F,false,ARGS...> : public Work, public Storage<F,ARGS...> {
+        /// Finishes all submitted work and stops the workers.
+        void join();
+
+        size_t size() const { return workers.size(); }
+
+    private:
+        /**
+         * A move-only void() callable with small buffer storage.
+         */
+        class Task {
         public:
-            using Storage<F,ARGS...>::Storage;
-
-            void execute() override {
-                try {
-                    auto val = boost::hana::unpack(std::move(this->args),this->f);
-                    this->promise.set_value(std::move(val));
-                } catch (...){
-                    this->promise.set_exception(std::current_exception());
+            Task() = default;
+
+            template <class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+            explicit Task(F&& f) {
+                using Fn = std::decay_t<F>;
+                if constexpr (fits_inline<Fn>()) {
+                    new (&storage) Fn(std::forward<F>(f));
+                    vtable = &inline_vtable<Fn>;
+                } else {
+                    new (&storage) Fn*(new Fn(std::forward<F>(f)));
+                    vtable = &heap_vtable<Fn>;
                 }
             }
-        };
-        template<class F, class... ARGS> class ConcreteWorkImpl<F,true,ARGS...> : public Work, public Storage<F,ARGS...> {
-        public:
-            using Storage<F,ARGS...>::Storage;
-
-            void execute() override {
-                try {
-                    boost::hana::unpack(std::move(this->args),this->f);
-                    this->promise.set_value();
-                } catch (...){
-                    this->promise.set_exception(std::current_exception());
+
+            Task(Task&& other) noexcept : account{ std::move(other.account) }, vtable{ other.vtable } {
+                if (vtable) vtable->move(&other.storage, &storage);
+                other.vtable = nullptr;
+            }
+
+            Task& operator=(Task&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    account = std::move(other.account);
+                    vtable  = other.vtable;
+                    if (vtable) vtable->move(&other.storage, &storage);
+                    other.vtable = nullptr;
                 }
+                return *this;
+            }
+
+            ~Task() { reset(); }
+
+            void operator()() { vtable->invoke(&storage); }
+
+            explicit operator bool() const { return vtable != nullptr; }
+
+            /// The memory account of the submitting thread, installed while the task runs.
+            std::shared_ptr<hoMemoryAccount> account;
+
+        private:
+            static constexpr size_t inline_size = 64;
+            using Storage = std::aligned_storage_t<inline_size, alignof(std::max_align_t)>;
+
+            struct VTable {
+                void (*invoke)(void*);
+                void (*move)(void* from, void* to);
+                void (*destroy)(void*);
+            };
+
+            template <class Fn> static constexpr bool fits_inline() {
+                return sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(std::max_align_t)
+                       && std::is_nothrow_move_constructible<Fn>::value;
             }
+
+            template <class Fn>
+            static constexpr VTable inline_vtable = {
+                [](void* s) { (*static_cast<Fn*>(s))(); },
+                [](void* from, void* to) {
+                    new (to) Fn(std::move(*static_cast<Fn*>(from)));
+                    static_cast<Fn*>(from)->~Fn();
+                },
+                [](void* s) { static_cast<Fn*>(s)->~Fn(); }
+            };
+
+            template <class Fn>
+            static constexpr VTable heap_vtable = {
+                [](void* s) { (**static_cast<Fn**>(s))(); },
+                [](void* from, void* to) { new (to) Fn*(*static_cast<Fn**>(from)); },
+                [](void* s) { delete *static_cast<Fn**>(s); }
+            };
+
+            void reset() {
+                if (vtable) vtable->destroy(&storage);
+                vtable = nullptr;
+            }
+
+            Storage storage;
+            const VTable* vtable = nullptr;
         };
 
-    template<class F, class... ARGS> class ConcreteWork : public ConcreteWorkImpl<F, std::is_same<typename Storage<F,ARGS...>::R,void>::value,ARGS...> {
-        public:
-            using ConcreteWorkImpl<F, std::is_same<typename Storage<F,ARGS...>::R,void>::value,ARGS...>::ConcreteWorkImpl;
+        static constexpr size_t n_priorities = 3;
+
+        struct alignas(64) Worker {
+            std::mutex m;
+            std::array<std::deque<Task>, n_priorities> lanes;
         };
 
+        void submit(Task task, Priority priority);
+        bool try_pop_local(size_t index, size_t lane, Task& task);
+        bool try_steal(size_t thief, size_t lane, Task& task);
+        bool try_acquire(size_t index, Task& task);
+        void run_worker(size_t index);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+
+        std::atomic<size_t> pending{ 0 };
+        std::atomic<size_t> next_worker{ 0 };
+        std::atomic<int> sleepers{ 0 };
+        std::atomic<bool> stopping{ false };
+        std::mutex sleep_mutex;
+        std::condition_variable wakeup;
+    };
+
+    /**
+     * The work one caller submitted to a pool.
+     *
+     * wait() blocks until every task submitted through the group has finished, whether it returned or threw, so that
+     * state the tasks refer to can safely go away afterwards. The destructor waits as well.
+     */
+    class TaskGroup {
     public:
-        explicit ThreadPool(unsigned int workers) {
-            for (auto i = 0u; i < workers; i++) {
-                threads.emplace_back([this]() {
-                    try {
-                        while (true)
-                            this->work_queue.pop()->execute();
-                    } catch (const ChannelClosed&) {
-                    }
-                });
-            }
-        }
+        explicit TaskGroup(ThreadPool& pool) : pool{ pool } {}
+        ~TaskGroup() { wait(); }
 
-        template <class F, class... ARGS> auto async(F&& f, ARGS&&... args) {
-            auto work = std::make_unique<ConcreteWork<F, ARGS...>>(std::forward<F>(f), std::forward<ARGS>(args)...);
-            auto future_result = work->get_future();
-            work_queue.push(std::move(work));
-            return std::move(future_result);
-        }
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
 
-        void join(){
-            work_queue.close();
-            for (auto& thread : threads){
-                thread.join();
-            }
-        }
+        template <class F, class... ARGS> auto async(F&& f, ARGS&&... args);
+
+        void wait();
 
     private:
-        MPMCChannel<std::unique_ptr<Work>> work_queue;
-        std::vector<std::thread> threads;
+        struct Finish {
+            TaskGroup& group;
+            ~Finish() { group.finished(); }
+        };
+
+        void finished();
+
+        ThreadPool& pool;
+        size_t in_flight = 0;
+        std::mutex m;
+        std::condition_variable done;
     };
 
+    /** Implementation **/
+
+    template <class F, class... ARGS> auto ThreadPool::async(Priority priority, F&& f, ARGS&&... args) {
+        using R = std::invoke_result_t<std::decay_t<F>&, std::decay_t<ARGS>...>;
+
+        std::promise<R> promise;
+        auto future_result = promise.get_future();
+
+        submit(Task([promise = std::move(promise), f = std::forward<F>(f),
+                        args = std::tuple<std::decay_t<ARGS>...>(std::forward<ARGS>(args)...)]() mutable {
+            try {
+                if constexpr (std::is_void<R>::value) {
+                    std::apply(f, std::move(args));
+                    promise.set_value();
+                } else {
+                    promise.set_value(std::apply(f, std::move(args)));
+                }
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }),
+            priority);
+
+        return future_result;
+    }
+
+    template <class F> void ThreadPool::post(F&& f, Priority priority) {
+        submit(Task([f = std::forward<F>(f)]() mutable {
+            try {
+                f();
+            } catch (...) {
+            }
+        }),
+            priority);
+    }
+
+    template <class F, class... ARGS> auto TaskGroup::async(F&& f, ARGS&&... args) {
+        {
+            std::lock_guard<std::mutex> guard(m);
+            in_flight++;
+        }
+        try {
+            return pool.async(
+                [this, f = std::forward<F>(f)](auto&&... args) mutable {
+                    Finish finish{ *this };
+                    return f(std::forward<decltype(args)>(args)...);
+                },
+                std::forward<ARGS>(args)...);
+        } catch (...) {
+            finished();
+            throw;
+        }
+    }
 }
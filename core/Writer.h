@@ -55,6 +55,11 @@ namespace Gadgetron::Core {
             constexpr auto index_apply(F f) {
                 return index_apply_impl(f, std::make_index_sequence<N>{});
             }
+
+            template<class T> struct is_plain_chunk : std::true_type {};
+            template<class T> struct is_plain_chunk<optional<T>> : std::false_type {};
+            template<class... TYPES> struct is_plain_chunk<variant<TYPES...>> : std::false_type {};
+            template<class... TYPES> struct is_plain_chunk<std::tuple<TYPES...>> : std::false_type {};
         }
     }
 }
@@ -64,10 +69,19 @@ namespace Gadgetron::Core {
     template<class ...ARGS>
     void Gadgetron::Core::TypedWriter<ARGS...>::write(std::ostream &stream,  Message message) {
 
-        std::tuple<ARGS...> arg_tuple = force_unpack<ARGS...>(std::move(message));
-
-        gadgetron_detail::index_apply<sizeof...(ARGS)>(
-                [&](auto... Is) { this->serialize(stream, std::move(std::get<Is>(arg_tuple))...); });
+        if constexpr (all_of_v<gadgetron_detail::is_plain_chunk<ARGS>::value...>) {
+            // One chunk per argument; serialize straight from the payloads, which may be shared with other messages.
+            auto &chunks = message.messages();
+            gadgetron_detail::index_apply<sizeof...(ARGS)>(
+                    [&](auto... Is) {
+                        this->serialize(stream, static_cast<const TypedMessageChunk<ARGS> &>(*chunks[Is]).data()...);
+                    });
+        } else {
+            std::tuple<ARGS...> arg_tuple = force_unpack<ARGS...>(std::move(message));
+
+            gadgetron_detail::index_apply<sizeof...(ARGS)>(
+                    [&](auto... Is) { this->serialize(stream, std::move(std::get<Is>(arg_tuple))...); });
+        }
     }
 
 
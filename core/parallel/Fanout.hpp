@@ -12,9 +12,10 @@ namespace Gadgetron::Core::Parallel {
     template<class... ARGS>
     void Fanout<ARGS...>::process(InputChannel<ARGS...> &input, std::map<std::string, OutputChannel> output) {
         for (auto thing : input) {
-            for (auto &pair : output) {
-                auto copy_of_thing = thing;
-                pair.second.push(copy_of_thing);
+            // Branches share the payload of the message; it is only copied if a branch needs to modify it.
+            auto message = Message(std::move(thing));
+            for (auto it = output.begin(); it != output.end(); ++it) {
+                it->second.push_message(std::next(it) == output.end() ? std::move(message) : message.clone());
             }
         }
     }
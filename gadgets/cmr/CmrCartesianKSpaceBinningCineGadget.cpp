@@ -10,6 +10,8 @@ namespace Gadgetron {
 
     CmrCartesianKSpaceBinningCineGadget::~CmrCartesianKSpaceBinningCineGadget()
     {
+        // close is not called if the stream fails; the slices in flight still use this gadget
+        slices_.wait();
     }
 
     int CmrCartesianKSpaceBinningCineGadget::process_config(ACE_Message_Block* mb)
@@ -75,6 +77,7 @@ namespace Gadgetron {
 
         binning_reconer_.kspace_binning_max_temporal_window_             = this->kspace_binning_max_temporal_window.value();
         binning_reconer_.kspace_binning_minimal_cardiac_phase_width_     = this->kspace_binning_minimal_cardiac_phase_width.value();
+        binning_reconer_.kspace_binning_max_concurrent_bins_             = this->kspace_binning_max_concurrent_bins.value();
         binning_reconer_.kspace_binning_kSize_RO_                        = this->kspace_binning_kSize_RO.value();
         binning_reconer_.kspace_binning_kSize_E1_                        = this->kspace_binning_kSize_E1.value();
         binning_reconer_.kspace_binning_reg_lamda_                       = this->kspace_binning_reg_lamda.value();
@@ -135,99 +138,103 @@ namespace Gadgetron {
             }
         }
 
+        size_t max_in_flight = (this->max_concurrent_slices.value() > 1) ? (size_t)this->max_concurrent_slices.value() : 1;
+
         // for every encoding space
         for (size_t e = 0; e < recon_bit_->rbit_.size(); e++)
         {
-            std::stringstream os;
-            os << "_encoding_" << e;
-
             GDEBUG_CONDITION_STREAM(verbose.value(), "Calling " << process_called_times_ << " , encoding space : " << e);
             GDEBUG_CONDITION_STREAM(verbose.value(), "======================================================================");
 
-            // ---------------------------------------------------------------
-            // export incoming data
-
-            /*if (!debug_folder_full_path_.empty())
+            if (recon_bit_->rbit_[e].data_.data_.get_number_of_elements() > 0)
             {
-                gt_exporter_.export_array_complex(recon_bit_->rbit_[e].data_.data_, debug_folder_full_path_ + "data" + os.str());
+                // a slice is reconstructed on the thread pool while the next ones are coming in;
+                // wait here if too many of them already hold their buffers
+                auto recon_bit = std::make_shared<IsmrmrdReconBit>(std::move(recon_bit_->rbit_[e]));
+
+                slices_.post([this, recon_bit, e]() {
+                    try
+                    {
+                        this->process_slice(*recon_bit, e);
+                    }
+                    catch (...)
+                    {
+                        GERROR_STREAM("Exceptions happened in CmrCartesianKSpaceBinningCineGadget::process_slice(...) for encoding space " << e);
+                        throw;
+                    }
+                }, max_in_flight);
             }
+        }
 
-            if (!debug_folder_full_path_.empty() && recon_bit_->rbit_[e].data_.trajectory_)
-            {
-                if (recon_bit_->rbit_[e].ref_->trajectory_->get_number_of_elements() > 0)
-                {
-                    gt_exporter_.export_array(*(recon_bit_->rbit_[e].data_.trajectory_), debug_folder_full_path_ + "data_traj" + os.str());
-                }
-            }*/
+        m1->release();
 
-            // ---------------------------------------------------------------
+        if (perform_timing.value()) { gt_timer_local_.stop(); }
 
-            if (recon_bit_->rbit_[e].data_.data_.get_number_of_elements() > 0)
-            {
-                /*if (!debug_folder_full_path_.empty())
-                {
-                    gt_exporter_.export_array_complex(recon_bit_->rbit_[e].data_.data_, debug_folder_full_path_ + "data_before_unwrapping" + os.str());
-                }
+        return GADGET_OK;
+    }
 
-                if (!debug_folder_full_path_.empty() && recon_bit_->rbit_[e].data_.trajectory_)
-                {
-                    if (recon_bit_->rbit_[e].data_.trajectory_->get_number_of_elements() > 0)
-                    {
-                        gt_exporter_.export_array(*(recon_bit_->rbit_[e].data_.trajectory_), debug_folder_full_path_ + "data_before_unwrapping_traj" + os.str());
-                    }
-                }*/
+    int CmrCartesianKSpaceBinningCineGadget::close(unsigned long flags)
+    {
+        slices_.wait();
+        slices_.rethrow_failure();
 
-                // ---------------------------------------------------------------
+        return BaseClass::close(flags);
+    }
 
-                if (perform_timing.value()) { gt_timer_.start("CmrCartesianKSpaceBinningCineGadget::perform_binning"); }
-                this->perform_binning(recon_bit_->rbit_[e], e);
-                if (perform_timing.value()) { gt_timer_.stop(); }
+    void CmrCartesianKSpaceBinningCineGadget::process_slice(IsmrmrdReconBit& recon_bit, size_t e)
+    {
+        std::stringstream os;
+        os << "_encoding_" << e;
 
-                // ---------------------------------------------------------------
+        // slices run concurrently, so every one gets its own binning object and results
+        Gadgetron::CmrKSpaceBinning<float> binning_reconer(binning_reconer_);
+        BinningResults res;
 
-                if (perform_timing.value()) { gt_timer_.start("CmrCartesianKSpaceBinningCineGadget::compute_image_header, raw images"); }
-                this->compute_image_header(recon_bit_->rbit_[e], res_raw_, e);
-                if (perform_timing.value()) { gt_timer_.stop(); }
+        Gadgetron::GadgetronTimer timer(false);
 
-                this->set_time_stamps(res_raw_, acq_time_raw_, cpt_time_raw_);
+        // ---------------------------------------------------------------
 
-                // ---------------------------------------------------------------
+        if (perform_timing.value()) { timer.start("CmrCartesianKSpaceBinningCineGadget::perform_binning"); }
+        this->perform_binning(recon_bit, e, binning_reconer, res);
+        if (perform_timing.value()) { timer.stop(); }
 
-                if (!debug_folder_full_path_.empty())
-                {
-                    this->gt_exporter_.export_array_complex(res_raw_.data_, debug_folder_full_path_ + "recon_res_raw" + os.str());
-                }
+        // ---------------------------------------------------------------
 
-                if(this->send_out_raw.value())
-                {
-                    if (perform_timing.value()) { gt_timer_.start("CmrCartesianKSpaceBinningCineGadget::send_out_image_array, raw"); }
-                    this->send_out_image_array(res_raw_, e, image_series.value() + ((int)e + 1), GADGETRON_IMAGE_REGULAR);
-                    if (perform_timing.value()) { gt_timer_.stop(); }
-                }
+        if (perform_timing.value()) { timer.start("CmrCartesianKSpaceBinningCineGadget::compute_image_header, raw images"); }
+        this->compute_image_header(recon_bit, res.res_raw_, e);
+        if (perform_timing.value()) { timer.stop(); }
 
-                // ---------------------------------------------------------------
-                this->create_binning_image_headers_from_raw();
-                this->set_time_stamps(res_binning_, acq_time_binning_, cpt_time_binning_);
+        this->set_time_stamps(res.res_raw_, res.acq_time_raw_, res.cpt_time_raw_);
 
-                if (!debug_folder_full_path_.empty())
-                {
-                    this->gt_exporter_.export_array_complex(res_binning_.data_, debug_folder_full_path_ + "recon_res_binning" + os.str());
-                }
+        // ---------------------------------------------------------------
 
-                if (perform_timing.value()) { gt_timer_.start("CmrCartesianKSpaceBinningCineGadget::send_out_image_array, binning"); }
-                this->send_out_image_array(res_binning_, e, image_series.value() + (int)e + 2, GADGETRON_IMAGE_RETRO);
-                if (perform_timing.value()) { gt_timer_.stop(); }
-            }
+        if (!debug_folder_full_path_.empty())
+        {
+            this->gt_exporter_.export_array_complex(res.res_raw_.data_, debug_folder_full_path_ + "recon_res_raw" + os.str());
         }
 
-        m1->release();
+        if(this->send_out_raw.value())
+        {
+            if (perform_timing.value()) { timer.start("CmrCartesianKSpaceBinningCineGadget::send_out_image_array, raw"); }
+            this->send_out_image_array(res.res_raw_, e, image_series.value() + ((int)e + 1), GADGETRON_IMAGE_REGULAR);
+            if (perform_timing.value()) { timer.stop(); }
+        }
 
-        if (perform_timing.value()) { gt_timer_local_.stop(); }
+        // ---------------------------------------------------------------
+        this->create_binning_image_headers_from_raw(res);
+        this->set_time_stamps(res.res_binning_, res.acq_time_binning_, res.cpt_time_binning_);
 
-        return GADGET_OK;
+        if (!debug_folder_full_path_.empty())
+        {
+            this->gt_exporter_.export_array_complex(res.res_binning_.data_, debug_folder_full_path_ + "recon_res_binning" + os.str());
+        }
+
+        if (perform_timing.value()) { timer.start("CmrCartesianKSpaceBinningCineGadget::send_out_image_array, binning"); }
+        this->send_out_image_array(res.res_binning_, e, image_series.value() + (int)e + 2, GADGETRON_IMAGE_RETRO);
+        if (perform_timing.value()) { timer.stop(); }
     }
 
-    void CmrCartesianKSpaceBinningCineGadget::perform_binning(IsmrmrdReconBit& recon_bit, size_t encoding)
+    void CmrCartesianKSpaceBinningCineGadget::perform_binning(IsmrmrdReconBit& recon_bit, size_t encoding, Gadgetron::CmrKSpaceBinning<float>& binning_reconer, BinningResults& res)
     {
         try
         {
@@ -246,13 +253,13 @@ namespace Gadgetron {
 
             Gadgetron::GadgetronTimer timer(false);
 
-            res_raw_.data_.create(RO, E1, E2, 1, N, S, SLC);
-            acq_time_raw_.create(N, S, SLC);
-            cpt_time_raw_.create(N, S, SLC);
+            res.res_raw_.data_.create(RO, E1, E2, 1, N, S, SLC);
+            res.acq_time_raw_.create(N, S, SLC);
+            res.cpt_time_raw_.create(N, S, SLC);
 
-            res_binning_.data_.create(RO, E1, E2, 1, binned_N, S, SLC);
-            acq_time_binning_.create(binned_N, S, SLC);
-            cpt_time_binning_.create(binned_N, S, SLC);
+            res.res_binning_.data_.create(RO, E1, E2, 1, binned_N, S, SLC);
+            res.acq_time_binning_.create(binned_N, S, SLC);
+            res.cpt_time_binning_.create(binned_N, S, SLC);
 
             size_t n, s, slc;
             for (slc=0; slc<SLC; slc++)
@@ -274,26 +281,26 @@ namespace Gadgetron {
                 GDEBUG_STREAM("Processing binning on SLC : " << slc << " - " << curr_slc << " , encoding space : " << encoding << " " << suffix);
 
                 // set up the binning object
-                binning_reconer_.binning_obj_.data_.create(RO, E1, CHA, N, S, recon_bit.data_.data_.begin()+slc*RO*E1*CHA*N*S);
-                binning_reconer_.binning_obj_.sampling_ = recon_bit.data_.sampling_;
-                binning_reconer_.binning_obj_.headers_.create(E1, N, S, recon_bit.data_.headers_.begin()+slc*E1*N*S);
+                binning_reconer.binning_obj_.data_.create(RO, E1, CHA, N, S, recon_bit.data_.data_.begin()+slc*RO*E1*CHA*N*S);
+                binning_reconer.binning_obj_.sampling_ = recon_bit.data_.sampling_;
+                binning_reconer.binning_obj_.headers_.create(E1, N, S, recon_bit.data_.headers_.begin()+slc*E1*N*S);
 
-                binning_reconer_.binning_obj_.output_N_ = binned_N;
-                binning_reconer_.binning_obj_.accel_factor_E1_ = acceFactorE1_[encoding];
-                binning_reconer_.binning_obj_.random_sampling_ = (calib_mode_[encoding]!=ISMRMRD_embedded 
+                binning_reconer.binning_obj_.output_N_ = binned_N;
+                binning_reconer.binning_obj_.accel_factor_E1_ = acceFactorE1_[encoding];
+                binning_reconer.binning_obj_.random_sampling_ = (calib_mode_[encoding]!=ISMRMRD_embedded 
                                                                 && calib_mode_[encoding]!=ISMRMRD_interleaved 
                                                                 && calib_mode_[encoding]!=ISMRMRD_separate 
                                                                 && calib_mode_[encoding]!=ISMRMRD_noacceleration);
 
-                binning_reconer_.suffix_ = suffix;
+                binning_reconer.suffix_ = suffix;
 
-                // if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(binning_reconer_.binning_obj_.data_, debug_folder_full_path_ + "binning_obj_data" + os.str()); }
+                // if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(binning_reconer.binning_obj_.data_, debug_folder_full_path_ + "binning_obj_data" + os.str()); }
 
                 // compute the binning
                 if (perform_timing.value()) { timer.start("compute binning ... "); }
                 try
                 {
-                    binning_reconer_.process_binning_recon();
+                    binning_reconer.process_binning_recon();
                 }
                 catch(...)
                 {
@@ -302,30 +309,30 @@ namespace Gadgetron {
                 }
                 if (perform_timing.value()) { timer.stop(); }
 
-                if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(binning_reconer_.binning_obj_.complex_image_raw_, debug_folder_full_path_ + "binning_obj_complex_image_raw" + os.str()); }
-                if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(binning_reconer_.binning_obj_.complex_image_binning_, debug_folder_full_path_ + "binning_obj_complex_image_binning" + os.str()); }
+                if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(binning_reconer.binning_obj_.complex_image_raw_, debug_folder_full_path_ + "binning_obj_complex_image_raw" + os.str()); }
+                if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(binning_reconer.binning_obj_.complex_image_binning_, debug_folder_full_path_ + "binning_obj_complex_image_binning" + os.str()); }
 
                 // get the binnig results
-                memcpy(this->res_raw_.data_.begin()+slc*RO*E1*N*S*SLC, 
-                        binning_reconer_.binning_obj_.complex_image_raw_.begin(), 
-                        binning_reconer_.binning_obj_.complex_image_raw_.get_number_of_bytes());
+                memcpy(res.res_raw_.data_.begin()+slc*RO*E1*N*S, 
+                        binning_reconer.binning_obj_.complex_image_raw_.begin(), 
+                        binning_reconer.binning_obj_.complex_image_raw_.get_number_of_bytes());
 
-                memcpy(this->res_binning_.data_.begin()+slc*RO*E1*binned_N*S*SLC, 
-                        binning_reconer_.binning_obj_.complex_image_binning_.begin(), 
-                        binning_reconer_.binning_obj_.complex_image_binning_.get_number_of_bytes());
+                memcpy(res.res_binning_.data_.begin()+slc*RO*E1*binned_N*S, 
+                        binning_reconer.binning_obj_.complex_image_binning_.begin(), 
+                        binning_reconer.binning_obj_.complex_image_binning_.get_number_of_bytes());
 
                 for (s=0; s<S; s++)
                 {
                     for (n=0; n<N; n++)
                     {
-                        acq_time_raw_(n, s, slc) = binning_reconer_.binning_obj_.phs_time_stamp_(n, s);
-                        cpt_time_raw_(n, s, slc) = binning_reconer_.binning_obj_.phs_cpt_time_stamp_(n, s);
+                        res.acq_time_raw_(n, s, slc) = binning_reconer.binning_obj_.phs_time_stamp_(n, s);
+                        res.cpt_time_raw_(n, s, slc) = binning_reconer.binning_obj_.phs_cpt_time_stamp_(n, s);
                     }
 
                     for (n=0; n<binned_N; n++)
                     {
-                        acq_time_binning_(n, s, slc) = binning_reconer_.binning_obj_.phs_time_stamp_(n, s);
-                        cpt_time_binning_(n, s, slc) = binning_reconer_.binning_obj_.mean_RR_ * binning_reconer_.binning_obj_.desired_cpt_[n];
+                        res.acq_time_binning_(n, s, slc) = binning_reconer.binning_obj_.phs_time_stamp_(n, s);
+                        res.cpt_time_binning_(n, s, slc) = binning_reconer.binning_obj_.mean_RR_ * binning_reconer.binning_obj_.desired_cpt_[n];
                     }
                 }
             }
@@ -333,14 +340,14 @@ namespace Gadgetron {
             std::stringstream os;
             os << "_encoding_" << encoding;
 
-            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(res_raw_.data_, debug_folder_full_path_ + "binning_complex_image_raw" + os.str()); }
-            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(res_binning_.data_, debug_folder_full_path_ + "binning_complex_image_binning_" + os.str()); }
+            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(res.res_raw_.data_, debug_folder_full_path_ + "binning_complex_image_raw" + os.str()); }
+            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array_complex(res.res_binning_.data_, debug_folder_full_path_ + "binning_complex_image_binning_" + os.str()); }
 
-            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(acq_time_raw_, debug_folder_full_path_ + "binning_acq_time_raw" + os.str()); }
-            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(cpt_time_raw_, debug_folder_full_path_ + "binning_cpt_time_raw" + os.str()); }
+            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(res.acq_time_raw_, debug_folder_full_path_ + "binning_acq_time_raw" + os.str()); }
+            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(res.cpt_time_raw_, debug_folder_full_path_ + "binning_cpt_time_raw" + os.str()); }
 
-            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(acq_time_binning_, debug_folder_full_path_ + "binning_acq_time_binning" + os.str()); }
-            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(cpt_time_binning_, debug_folder_full_path_ + "binning_cpt_time_binning" + os.str()); }
+            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(res.acq_time_binning_, debug_folder_full_path_ + "binning_acq_time_binning" + os.str()); }
+            if (!debug_folder_full_path_.empty()) { gt_exporter_.export_array(res.cpt_time_binning_, debug_folder_full_path_ + "binning_cpt_time_binning" + os.str()); }
         }
         catch (...)
         {
@@ -348,18 +355,18 @@ namespace Gadgetron {
         }
     }
 
-    void CmrCartesianKSpaceBinningCineGadget::create_binning_image_headers_from_raw()
+    void CmrCartesianKSpaceBinningCineGadget::create_binning_image_headers_from_raw(BinningResults& res)
     {
         try
         {
-            size_t N = res_raw_.headers_.get_size(0);
-            size_t S = res_raw_.headers_.get_size(1);
-            size_t SLC = res_raw_.headers_.get_size(2);
+            size_t N = res.res_raw_.headers_.get_size(0);
+            size_t S = res.res_raw_.headers_.get_size(1);
+            size_t SLC = res.res_raw_.headers_.get_size(2);
 
             size_t binned_N = this->number_of_output_phases.value();
 
-            res_binning_.headers_.create(binned_N, S, SLC);
-            res_binning_.meta_.resize(binned_N*S*SLC);
+            res.res_binning_.headers_.create(binned_N, S, SLC);
+            res.res_binning_.meta_.resize(binned_N*S*SLC);
 
             size_t n, s, slc;
             for (slc=0; slc<SLC; slc++)
@@ -368,8 +375,8 @@ namespace Gadgetron {
                 {
                     for (n=0; n<binned_N; n++)
                     {
-                        res_binning_.headers_(n, s, slc) = res_raw_.headers_(n, s, slc);
-                        res_binning_.meta_[n + s*binned_N + slc*binned_N*S] = res_raw_.meta_[n + s*N + slc*N*S];
+                        res.res_binning_.headers_(n, s, slc) = res.res_raw_.headers_(n, s, slc);
+                        res.res_binning_.meta_[n + s*binned_N + slc*binned_N*S] = res.res_raw_.meta_[n + s*N + slc*N*S];
                     }
                 }
             }
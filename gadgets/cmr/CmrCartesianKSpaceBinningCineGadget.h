@@ -22,6 +22,7 @@
 
 #include "gadgetron_cmr_export.h"
 #include "GenericReconGadget.h"
+#include "CmrSliceScheduler.h"
 #include "cmr_kspace_binning.h"
 
 namespace Gadgetron {
@@ -44,6 +45,8 @@ namespace Gadgetron {
         GADGET_PROPERTY(send_out_raw, bool, "Whether to set out raw images", false);
         GADGET_PROPERTY(send_out_multiple_series_by_slice, bool, "Whether to set out binning images as multiple seires", false);
 
+        GADGET_PROPERTY(max_concurrent_slices, int, "Maximal number of slices reconstructed at the same time; every slice in flight holds its own binning buffers and they share the OpenMP threads", 2);
+
         /// parameters for raw image reconstruction
         GADGET_PROPERTY(arrhythmia_rejector_factor, float, "If a heart beat RR is not in the range of [ (1-arrhythmiaRejectorFactor)*meanRR (1+arrhythmiaRejectorFactor)*meanRR], it will be rejected", 0.25);
 
@@ -67,6 +70,7 @@ namespace Gadgetron {
         GADGET_PROPERTY(kspace_binning_navigator_acceptance_window, double, "Respiratory navigator acceptance window", 0.65);
         GADGET_PROPERTY(kspace_binning_max_temporal_window, double, "Maximally allowed temporal window ratio for binned kspace", 2.0);
         GADGET_PROPERTY(kspace_binning_minimal_cardiac_phase_width, double, "Allowed  minimal temporal window for binned kspace, in ms", 25.0);
+        GADGET_PROPERTY(kspace_binning_max_concurrent_bins, size_t, "Maximal number of output bins filled at the same time, 0 means as many as there are threads", 0);
 
         GADGET_PROPERTY(kspace_binning_moco_reg_strength, double, "Regularization strength of binning moco", 12.0);
         GadgetProperty<std::vector<unsigned int>, GadgetPropertyLimitsNoLimits<std::vector<unsigned int> > > kspace_binning_moco_iters{"kspace_binning_moco_iters", 
@@ -108,24 +112,31 @@ namespace Gadgetron {
         // variable for recon
         // --------------------------------------------------
 
-        // binning object
+        // binning object, configured once and copied for every slice being reconstructed
         Gadgetron::CmrKSpaceBinning<float> binning_reconer_;
 
-        // the raw recon results
-        // [RO E1 E2 1 N S SLC]
-        IsmrmrdImageArray res_raw_;
-        // acqusition time  and trigger time in ms
-        // [N S SLC]
-        hoNDArray< float > acq_time_raw_;
-        hoNDArray< float > cpt_time_raw_;
-
-        // the binning recon results
-        // [RO E1 E2 1 binned_N S SLC]
-        IsmrmrdImageArray res_binning_;
-        // acqusition time  and trigger time in ms for binned images
-        // [binned_N S SLC]
-        hoNDArray< float > acq_time_binning_;
-        hoNDArray< float > cpt_time_binning_;
+        // the results of one incoming recon bit
+        struct BinningResults
+        {
+            // the raw recon results
+            // [RO E1 E2 1 N S SLC]
+            IsmrmrdImageArray res_raw_;
+            // acqusition time  and trigger time in ms
+            // [N S SLC]
+            hoNDArray< float > acq_time_raw_;
+            hoNDArray< float > cpt_time_raw_;
+
+            // the binning recon results
+            // [RO E1 E2 1 binned_N S SLC]
+            IsmrmrdImageArray res_binning_;
+            // acqusition time  and trigger time in ms for binned images
+            // [binned_N S SLC]
+            hoNDArray< float > acq_time_binning_;
+            hoNDArray< float > cpt_time_binning_;
+        };
+
+        // slices handed to the thread pool and not yet sent out; the first failure of a slice is rethrown by the next process or close
+        CmrSliceScheduler slices_;
 
         // if ture, every slice will be sent out as a separate series
         bool send_out_multiple_series_by_slice_;
@@ -136,14 +147,19 @@ namespace Gadgetron {
         // default interface function
         virtual int process_config(ACE_Message_Block* mb);
         virtual int process(Gadgetron::GadgetContainerMessage< IsmrmrdReconData >* m1);
+        // wait for the slices in flight before closing
+        virtual int close(unsigned long flags);
 
         // --------------------------------------------------
         // recon step functions
         // --------------------------------------------------
-        virtual void perform_binning(IsmrmrdReconBit& recon_bit, size_t encoding);
+        // reconstruct one recon bit and send out its images; runs on the thread pool
+        void process_slice(IsmrmrdReconBit& recon_bit, size_t encoding);
+
+        virtual void perform_binning(IsmrmrdReconBit& recon_bit, size_t encoding, Gadgetron::CmrKSpaceBinning<float>& binning_reconer, BinningResults& res);
 
         // create binning image header
-        void create_binning_image_headers_from_raw();
+        void create_binning_image_headers_from_raw(BinningResults& res);
 
         // set the time stamps
         void set_time_stamps(IsmrmrdImageArray& res, hoNDArray< float >& acq_time, hoNDArray< float >& cpt_time);
@@ -55,6 +55,7 @@ namespace Gadgetron {
 
         GADGET_PROPERTY(std_thres_masking, double, "Number of noise std for masking", 3.0);
         GADGET_PROPERTY(mapping_with_masking, bool, "Whether to compute and apply a mask for mapping", true);
+        GADGET_PROPERTY(batched_fitting, bool, "Whether to fit all pixels together with the batched Levenberg-Marquardt solver, rather than one by one with the simplex solver", false);
 
         // ------------------------------------------------------------------------------------
 
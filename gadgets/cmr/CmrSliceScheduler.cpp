@@ -0,0 +1,116 @@
+
+#include "CmrSliceScheduler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef USE_OMP
+    #include <omp.h>
+#endif // USE_OMP
+
+namespace Gadgetron {
+
+    namespace {
+
+        // sets the OpenMP threads of the calling pool thread for one slice; the pool threads are shared with
+        // other work, so the previous setting is restored afterwards
+        struct SliceOpenMPThreads
+        {
+            explicit SliceOpenMPThreads(int num_threads)
+            {
+#ifdef USE_OMP
+                previous_num_threads = omp_get_max_threads();
+                omp_set_num_threads(num_threads);
+#endif // USE_OMP
+            }
+
+            ~SliceOpenMPThreads()
+            {
+#ifdef USE_OMP
+                omp_set_num_threads(previous_num_threads);
+#endif // USE_OMP
+            }
+
+            int previous_num_threads = 1;
+        };
+    }
+
+    CmrSliceScheduler::CmrSliceScheduler() : slices_in_flight_(0)
+    {
+    }
+
+    CmrSliceScheduler::~CmrSliceScheduler()
+    {
+        this->wait();
+    }
+
+    int CmrSliceScheduler::openmp_threads_per_slice(size_t max_in_flight)
+    {
+        int num_threads = 1;
+#ifdef USE_OMP
+        num_threads = omp_get_max_threads() / (int)std::max(max_in_flight, (size_t)1);
+#endif // USE_OMP
+        return std::max(num_threads, 1);
+    }
+
+    void CmrSliceScheduler::post(std::function<void()> slice, size_t max_in_flight)
+    {
+        max_in_flight = std::max(max_in_flight, (size_t)1);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            this->wait_for_slices(max_in_flight, lock);
+            if (slice_failure_) std::rethrow_exception(std::exchange(slice_failure_, nullptr));
+            slices_in_flight_++;
+        }
+
+        // computed on the posting thread, whose OpenMP setting the pool threads do not share
+        int num_threads = openmp_threads_per_slice(max_in_flight);
+
+        try
+        {
+            Core::ThreadPool::shared().post([this, slice = std::move(slice), num_threads]() {
+                std::exception_ptr failure;
+                try
+                {
+                    SliceOpenMPThreads threads(num_threads);
+                    slice();
+                }
+                catch (...)
+                {
+                    failure = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> guard(mutex_);
+                if (failure && !slice_failure_) slice_failure_ = failure;
+                slices_in_flight_--;
+                slice_done_.notify_all();
+            });
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            slices_in_flight_--;
+            slice_done_.notify_all();
+            throw;
+        }
+    }
+
+    void CmrSliceScheduler::wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        this->wait_for_slices(1, lock);
+    }
+
+    void CmrSliceScheduler::rethrow_failure()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (slice_failure_) std::rethrow_exception(std::exchange(slice_failure_, nullptr));
+    }
+
+    void CmrSliceScheduler::wait_for_slices(size_t max_in_flight, std::unique_lock<std::mutex>& lock)
+    {
+        slice_done_.wait(lock, [&]() { return slices_in_flight_ < max_in_flight; });
+    }
+}
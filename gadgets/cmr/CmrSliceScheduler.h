@@ -0,0 +1,56 @@
+/** \file   CmrSliceScheduler.h
+    \brief  Runs the slices of a cmr gadget on the shared thread pool, a limited number of them at a time.
+
+            Every slice still uses OpenMP inside its recon. A slice run alone gets all OpenMP threads; slices running
+            concurrently split them, so that the pool threads times the OpenMP threads of each slice do not exceed
+            the OpenMP threads of one slice run alone.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include "gadgetron_cmr_export.h"
+
+namespace Gadgetron {
+
+    class EXPORTGADGETSCMR CmrSliceScheduler
+    {
+    public:
+
+        CmrSliceScheduler();
+        // waits for the slices in flight, which still refer to their gadget
+        ~CmrSliceScheduler();
+
+        CmrSliceScheduler(const CmrSliceScheduler&) = delete;
+        CmrSliceScheduler& operator=(const CmrSliceScheduler&) = delete;
+
+        // block until fewer than max_in_flight slices are running, then hand the slice to the thread pool;
+        // rethrows the first failure of an earlier slice instead
+        void post(std::function<void()> slice, size_t max_in_flight);
+
+        // block until every slice has finished
+        void wait();
+
+        // rethrow the first failure of a slice, if any
+        void rethrow_failure();
+
+        // number of OpenMP threads a slice gets if max_in_flight slices run at the same time
+        static int openmp_threads_per_slice(size_t max_in_flight);
+
+    protected:
+
+        // block until fewer than max_in_flight slices are running
+        void wait_for_slices(size_t max_in_flight, std::unique_lock<std::mutex>& lock);
+
+        // number of slices handed to the thread pool and not yet finished
+        size_t slices_in_flight_;
+        std::mutex mutex_;
+        std::condition_variable slice_done_;
+        // the first failure of a slice, rethrown by the next post or rethrow_failure
+        std::exception_ptr slice_failure_;
+    };
+}
@@ -72,6 +72,7 @@ CmrKSpaceBinning<float> PureCmrCartesianKSpaceBinningCineGadget::create_binner()
 
     binner.kspace_binning_max_temporal_window_             = this->kspace_binning_max_temporal_window;
     binner.kspace_binning_minimal_cardiac_phase_width_     = this->kspace_binning_minimal_cardiac_phase_width;
+    binner.kspace_binning_max_concurrent_bins_             = this->kspace_binning_max_concurrent_bins;
     binner.kspace_binning_kSize_RO_                        = this->kspace_binning_kSize_RO;
     binner.kspace_binning_kSize_E1_                        = this->kspace_binning_kSize_E1;
     binner.kspace_binning_reg_lamda_                       = this->kspace_binning_reg_lamda;
@@ -57,6 +57,8 @@ namespace Gadgetron {
             "Maximally allowed temporal window ratio for binned kspace", 2.0);
         NODE_PROPERTY(kspace_binning_minimal_cardiac_phase_width, double,
             "Allowed  minimal temporal window for binned kspace, in ms", 25.0);
+        NODE_PROPERTY(kspace_binning_max_concurrent_bins, size_t,
+            "Maximal number of output bins filled at the same time, 0 means as many as there are threads", 0);
 
         NODE_PROPERTY(kspace_binning_moco_reg_strength, double, "Regularization strength of binning moco", 12.0);
         NODE_PROPERTY(kspace_binning_moco_iters, std::vector<unsigned int>, "Number of iterations for binning moco",
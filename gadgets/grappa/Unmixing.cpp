@@ -6,6 +6,7 @@
 #include "hoNDArray.h"
 #include "hoNDArray_elemwise.h"
 #include "hoNDArray_reductions.h"
+#include "mri_core_grappa.h"
 
 
 namespace {
@@ -13,6 +14,8 @@ namespace {
     using namespace Gadgetron::Core;
     using namespace Gadgetron::Grappa;
 
+    // Serves the most recent weights received for each slice. Images are only held back waiting for weights
+    // for a slice that has none yet; otherwise weights still being calculated never delay unmixing.
     class WeightsProvider {
     public:
         WeightsProvider(
@@ -85,22 +88,20 @@ namespace Gadgetron::Grappa {
             const Weights &weights
     ) {
         hoNDArray<std::complex<float>> unmixed_image(create_unmixed_image_dimensions(weights));
-        clear(unmixed_image);
 
         auto sets = weights.data.get_number_of_elements() / image.data.get_number_of_elements();
         auto image_elements = unmixed_image.get_number_of_elements() / sets;
         auto coils = weights.data.get_number_of_elements() / (sets * image_elements);
 
-        for (unsigned int s = 0; s < sets; s++) {
-            for (unsigned int p = 0; p < image_elements; p++) {
-                for (unsigned int c = 0; c < coils; c++) {
-                    unmixed_image[s * image_elements + p] +=
-                            weights.data[s * image_elements * coils + c * image_elements + p] *
-                            image.data[c * image_elements + p] *
-                            unmixing_scale;
-                }
-            }
-        }
+        // Every set has its own weights, applied to the same image.
+        apply_unmix_coeff(
+                image.data.get_data_ptr(), 0,
+                weights.data.get_data_ptr(), coils * image_elements,
+                image_elements, coils, sets,
+                unmixed_image.get_data_ptr()
+        );
+
+        if (unmixing_scale != 1.0f) unmixed_image *= std::complex<float>(unmixing_scale);
 
         return std::move(unmixed_image);
     }
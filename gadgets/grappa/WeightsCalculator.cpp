@@ -1,6 +1,10 @@
 #include "WeightsCalculator.h"
 
 #include <set>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
 
 #include "common/AcquisitionBuffer.h"
 #include "common/grappa_common.h"
@@ -15,6 +19,7 @@
 #include "Unmixing.h"
 
 #include "Gadget.h"
+#include "ThreadPool.h"
 
 namespace {
     using namespace Gadgetron;
@@ -156,32 +161,161 @@ namespace {
 
 namespace Gadgetron::Grappa {
 
-    template<class WeightsCore>
-    Grappa::Weights create_weights(
+    // Everything needed to calculate the weights of a slice, copied out of the buffer so that the calculation
+    // can run while the buffer keeps being updated.
+    struct WeightsJob {
+        uint16_t index;
+        uint16_t n_combined_channels, n_uncombined_channels;
+        std::array<uint16_t, 4> region_of_support;
+        uint16_t acceleration_factor;
+        hoNDArray<std::complex<float>> data;
+    };
+
+    WeightsJob create_job(
             uint16_t index,
             const AcquisitionBuffer &buffer,
             uint16_t n_combined_channels,
             uint16_t n_uncombined_channels,
             const SupportMonitor &support_monitor,
-            const AccelerationMonitor &acceleration_monitor,
-            WeightsCore &core
+            const AccelerationMonitor &acceleration_monitor
     ) {
+        return WeightsJob{
+                index,
+                n_combined_channels,
+                n_uncombined_channels,
+                support_monitor.region_of_support(index),
+                uint16_t(acceleration_monitor.acceleration_factor(index)),
+                buffer.view(index)
+        };
+    }
+
+    template<class WeightsCore>
+    Grappa::Weights create_weights(const WeightsJob &job, WeightsCore &core) {
         return Grappa::Weights{
                 {
-                        index,
-                        n_combined_channels,
-                        n_uncombined_channels
+                        job.index,
+                        job.n_combined_channels,
+                        job.n_uncombined_channels
                 },
                 core.calculate_weights(
-                        buffer.view(index),
-                        support_monitor.region_of_support(index),
-                        acceleration_monitor.acceleration_factor(index),
-                        n_combined_channels,
-                        n_uncombined_channels
+                        job.data,
+                        job.region_of_support,
+                        job.acceleration_factor,
+                        job.n_combined_channels,
+                        job.n_uncombined_channels
                 )
         };
     }
 
+    /**
+     * Calculates weights for different slices at the same time on the shared thread pool.
+     *
+     * At most one calculation runs per slice. Jobs submitted for a slice while its weights are being calculated
+     * replace each other; once the calculation finishes, only the most recent job is run. Each running calculation
+     * has its own WeightsCore, as the cores keep scratch buffers between calculations.
+     */
+    template<class WeightsCore>
+    class WeightsScheduler {
+    public:
+        WeightsScheduler(std::function<std::unique_ptr<WeightsCore>()> create_core, OutputChannel &out)
+        : create_core(std::move(create_core)), out(out) {}
+
+        ~WeightsScheduler() {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [&]() { return busy.empty(); });
+        }
+
+        void submit(WeightsJob job) {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            auto slice = busy.find(job.index);
+            if (slice != busy.end()) {
+                if (slice->second) GDEBUG_STREAM("Coalescing weights update for slice " << job.index);
+                slice->second = std::move(job);
+                return;
+            }
+
+            busy.emplace(job.index, none);
+            ThreadPool::shared().post([this, job = std::move(job)]() mutable { run(std::move(job)); });
+        }
+
+        void rethrow_failure() {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (failure) std::rethrow_exception(std::exchange(failure, nullptr));
+        }
+
+    private:
+        void run(WeightsJob job) {
+            std::unique_ptr<WeightsCore> core;
+
+            // The slice must leave busy on every path, or the destructor waits for it forever.
+            struct Release {
+                WeightsScheduler &scheduler;
+                const WeightsJob &job;
+                std::unique_ptr<WeightsCore> &core;
+
+                ~Release() {
+                    std::lock_guard<std::mutex> guard(scheduler.mutex);
+                    scheduler.busy.erase(job.index);
+                    try {
+                        if (core) scheduler.cores.push_back(std::move(core));
+                    }
+                    catch (...) {}
+                    scheduler.idle.notify_all();
+                }
+            } release{*this, job, core};
+
+            while (true) {
+                try {
+                    if (!core) core = acquire_core();
+                    out.push(create_weights(job, *core));
+                }
+                catch (const std::exception &e) {
+                    GERROR_STREAM("Failed to calculate weights for slice " << job.index << ": " << e.what());
+                    record_failure(std::current_exception());
+                }
+                catch (...) {
+                    GERROR_STREAM("Failed to calculate weights for slice " << job.index);
+                    record_failure(std::current_exception());
+                }
+
+                std::lock_guard<std::mutex> guard(mutex);
+                auto &next = busy.at(job.index);
+                if (!next) return;
+
+                job = std::move(*next);
+                next = none;
+            }
+        }
+
+        void record_failure(std::exception_ptr exception) {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (!failure) failure = std::move(exception);
+        }
+
+        std::unique_ptr<WeightsCore> acquire_core() {
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (!cores.empty()) {
+                    auto core = std::move(cores.back());
+                    cores.pop_back();
+                    return core;
+                }
+            }
+            return create_core();
+        }
+
+        const std::function<std::unique_ptr<WeightsCore>()> create_core;
+        OutputChannel &out;
+
+        std::mutex mutex;
+        std::condition_variable idle;
+
+        std::map<uint16_t, optional<WeightsJob>> busy;
+        std::vector<std::unique_ptr<WeightsCore>> cores;
+        std::exception_ptr failure;
+    };
+
     template<class WeightsCore>
     WeightsCalculator<WeightsCore>::WeightsCalculator(
             const Context &context,
@@ -207,27 +341,33 @@ namespace Gadgetron::Grappa {
             n_uncombined_channels = uncombined_channels(acq);
         });
 
-        WeightsCore core{
-                {coil_map_estimation_ks, coil_map_estimation_power},
-                {block_size_samples, block_size_lines, convolution_kernel_threshold}
+        WeightsScheduler<WeightsCore> scheduler{
+                [&]() {
+                    return std::unique_ptr<WeightsCore>(new WeightsCore{
+                            {coil_map_estimation_ks, coil_map_estimation_power},
+                            {block_size_samples, block_size_lines, convolution_kernel_threshold}
+                    });
+                },
+                out
         };
 
         while (true) {
             auto slices = take_available_slices(in);
             buffer.add(slices);
 
+            scheduler.rethrow_failure();
+
             for (auto index : updated_slices) {
 
                 if (!buffer.is_fully_sampled(index)) continue;
 
-                out.push(create_weights(
+                scheduler.submit(create_job(
                         index,
                         buffer,
                         n_combined_channels,
                         n_uncombined_channels,
                         support_monitor,
-                        acceleration_monitor,
-                        core
+                        acceleration_monitor
                 ));
             }
             updated_slices.clear();
@@ -35,40 +35,6 @@ namespace Gadgetron {
             throw std::runtime_error("Illegal enum");
         }
 
-        void add_stats(AcquisitionBucketStats& stats, const ISMRMRD::AcquisitionHeader& header) {
-            stats.average.insert(header.idx.average);
-            stats.kspace_encode_step_1.insert(header.idx.kspace_encode_step_1);
-            stats.kspace_encode_step_2.insert(header.idx.kspace_encode_step_2);
-            stats.slice.insert(header.idx.slice);
-            stats.contrast.insert(header.idx.contrast);
-            stats.phase.insert(header.idx.phase);
-            stats.repetition.insert(header.idx.repetition);
-            stats.set.insert(header.idx.set);
-            stats.segment.insert(header.idx.segment);
-        }
-
-        void add_acquisition(AcquisitionBucket& bucket, Core::Acquisition acq) {
-            auto& head  = std::get<ISMRMRD::AcquisitionHeader>(acq);
-            auto espace = head.encoding_space_ref;
-
-            if (ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(head.flags)
-                || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION_AND_IMAGING).isSet(head.flags)) {
-                bucket.ref_.push_back(acq);
-                if (bucket.refstats_.size() < (espace + 1)) {
-                    bucket.refstats_.resize(espace + 1);
-                }
-                add_stats(bucket.refstats_[espace], head);
-            }
-            if (!(ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(head.flags)
-                    || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PHASECORR_DATA).isSet(head.flags))) {
-                if (bucket.datastats_.size() < (espace + 1)) {
-                    bucket.datastats_.resize(espace + 1);
-                }
-                add_stats(bucket.datastats_[espace], head);
-                bucket.data_.emplace_back(std::move(acq));
-            }
-        }
-
         struct EqualityTrigger {
             explicit EqualityTrigger(TriggerDimension trig) : trigger{ trig } {}
             const TriggerDimension trigger;
@@ -114,8 +80,9 @@ namespace Gadgetron {
 
         using Trigger = Core::variant<EqualityTrigger, NumAcquisitionsTrigger, NoneTrigger>;
 
-        Trigger get_trigger(const AcquisitionAccumulateTriggerGadget& gadget) {
-            switch (gadget.trigger_dimension) {
+        Trigger get_trigger(TriggerDimension dimension, size_t n_acquisitions_before_trigger,
+                            size_t n_acquisitions_before_ongoing_trigger) {
+            switch (dimension) {
 
             case TriggerDimension::kspace_encode_step_1:
             case TriggerDimension::kspace_encode_step_2:
@@ -133,21 +100,70 @@ namespace Gadgetron {
             case TriggerDimension::user_4:
             case TriggerDimension::user_5:
             case TriggerDimension::user_6:
-            case TriggerDimension::user_7: return EqualityTrigger(gadget.trigger_dimension);
-            case TriggerDimension::n_acquisitions: return NumAcquisitionsTrigger(gadget.n_acquisitions_before_trigger,gadget.n_acquisitions_before_ongoing_trigger);
+            case TriggerDimension::user_7: return EqualityTrigger(dimension);
+            case TriggerDimension::n_acquisitions: return NumAcquisitionsTrigger(n_acquisitions_before_trigger,n_acquisitions_before_ongoing_trigger);
             case TriggerDimension::none: return NoneTrigger();
             default: throw std::runtime_error("ENUM TriggerDimension is in an invalid state.");
             }
         }
 
-        bool trigger_before(Trigger& trigger, const ISMRMRD::AcquisitionHeader& head) {
-            return Core::visit([&](auto& var) { return var.trigger_before(head); }, trigger);
-        }
-        bool trigger_after(Trigger& trigger, const ISMRMRD::AcquisitionHeader& acq) {
-            return Core::visit([&](auto& var) { return var.trigger_after(acq); }, trigger);
-        }
+    }
+
+    struct AcquisitionTrigger::State {
+        Trigger trigger;
+    };
+
+    AcquisitionTrigger::AcquisitionTrigger(TriggerDimension dimension, size_t n_acquisitions_before_trigger,
+                                           size_t n_acquisitions_before_ongoing_trigger)
+        : state{ new State{ get_trigger(dimension, n_acquisitions_before_trigger, n_acquisitions_before_ongoing_trigger) } } {}
+
+    AcquisitionTrigger::AcquisitionTrigger(AcquisitionTrigger&&) noexcept = default;
+    AcquisitionTrigger::~AcquisitionTrigger() = default;
 
+    bool AcquisitionTrigger::trigger_before(const ISMRMRD::AcquisitionHeader& head) {
+        return Core::visit([&](auto& var) { return var.trigger_before(head); }, state->trigger);
+    }
+
+    bool AcquisitionTrigger::trigger_after(const ISMRMRD::AcquisitionHeader& head) {
+        return Core::visit([&](auto& var) { return var.trigger_after(head); }, state->trigger);
+    }
+
+    unsigned short AcquisitionTrigger::index(const ISMRMRD::AcquisitionHeader& head, TriggerDimension dimension) {
+        return get_index(head, dimension);
+    }
+
+    void add_stats(AcquisitionBucketStats& stats, const ISMRMRD::AcquisitionHeader& header) {
+        stats.average.insert(header.idx.average);
+        stats.kspace_encode_step_1.insert(header.idx.kspace_encode_step_1);
+        stats.kspace_encode_step_2.insert(header.idx.kspace_encode_step_2);
+        stats.slice.insert(header.idx.slice);
+        stats.contrast.insert(header.idx.contrast);
+        stats.phase.insert(header.idx.phase);
+        stats.repetition.insert(header.idx.repetition);
+        stats.set.insert(header.idx.set);
+        stats.segment.insert(header.idx.segment);
+    }
+
+    void add_to_bucket(AcquisitionBucket& bucket, Core::Acquisition acq) {
+        auto& head  = std::get<ISMRMRD::AcquisitionHeader>(acq);
+        auto espace = head.encoding_space_ref;
 
+        if (ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(head.flags)
+            || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION_AND_IMAGING).isSet(head.flags)) {
+            bucket.ref_.push_back(acq);
+            if (bucket.refstats_.size() < (espace + 1)) {
+                bucket.refstats_.resize(espace + 1);
+            }
+            add_stats(bucket.refstats_[espace], head);
+        }
+        if (!(ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(head.flags)
+                || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PHASECORR_DATA).isSet(head.flags))) {
+            if (bucket.datastats_.size() < (espace + 1)) {
+                bucket.datastats_.resize(espace + 1);
+            }
+            add_stats(bucket.datastats_[espace], head);
+            bucket.data_.emplace_back(std::move(acq));
+        }
     }
 
     void AcquisitionAccumulateTriggerGadget::send_data(Core::OutputChannel& out, std::map<unsigned short, AcquisitionBucket>& buckets,
@@ -166,7 +182,8 @@ namespace Gadgetron {
 
         auto waveforms = std::vector<Core::Waveform>{};
         auto buckets   = std::map<unsigned short, AcquisitionBucket>{};
-        auto trigger   = get_trigger(*this);
+        auto trigger   = AcquisitionTrigger(trigger_dimension, n_acquisitions_before_trigger,
+                                        n_acquisitions_before_ongoing_trigger);
 
         for (auto message : in) {
             if (Core::holds_alternative<Core::Waveform>(message)) {
@@ -179,15 +196,15 @@ namespace Gadgetron {
                 continue;
             auto head = std::get<ISMRMRD::AcquisitionHeader>(acq);
 
-            if (trigger_before(trigger, head))
+            if (trigger.trigger_before(head))
                 send_data(out, buckets, waveforms);
             // It is enough to put the first one, since they are linked
             unsigned short sorting_index = get_index(head, sorting_dimension);
 
             AcquisitionBucket& bucket = buckets[sorting_index];
-            add_acquisition(bucket, std::move(acq));
+            add_to_bucket(bucket, std::move(acq));
 
-            if (trigger_after(trigger, head))
+            if (trigger.trigger_after(head))
                 send_data(out, buckets, waveforms);
         }
         send_data(out,buckets,waveforms);
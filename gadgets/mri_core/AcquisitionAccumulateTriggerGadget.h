@@ -7,6 +7,7 @@
 #include <complex>
 #include <ismrmrd/ismrmrd.h>
 #include <map>
+#include <memory>
 
 namespace Gadgetron {
 
@@ -54,4 +55,34 @@ namespace Gadgetron {
 
     void from_string(const std::string& str, AcquisitionAccumulateTriggerGadget::TriggerDimension& val);
 
+    /**
+        Decides when accumulated acquisitions are sent on: before an acquisition that changes the trigger dimension,
+        or after a number of acquisitions.
+    */
+    class AcquisitionTrigger {
+    public:
+        using TriggerDimension = AcquisitionAccumulateTriggerGadget::TriggerDimension;
+
+        AcquisitionTrigger(TriggerDimension dimension, size_t n_acquisitions_before_trigger,
+                           size_t n_acquisitions_before_ongoing_trigger);
+        AcquisitionTrigger(AcquisitionTrigger&&) noexcept;
+        ~AcquisitionTrigger();
+
+        bool trigger_before(const ISMRMRD::AcquisitionHeader& head);
+        bool trigger_after(const ISMRMRD::AcquisitionHeader& head);
+
+        /// The index of head along dimension; 0 for n_acquisitions and none.
+        static unsigned short index(const ISMRMRD::AcquisitionHeader& head, TriggerDimension dimension);
+
+    private:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+
+    /// Adds the encoding counters of header to stats.
+    void add_stats(AcquisitionBucketStats& stats, const ISMRMRD::AcquisitionHeader& header);
+
+    /// Adds acq to the reference and/or data part of bucket, according to its flags, and updates the statistics.
+    void add_to_bucket(AcquisitionBucket& bucket, Core::Acquisition acq);
+
 }
@@ -2,6 +2,7 @@
 #include "hoNDArray_elemwise.h"
 #include "hoNDArray_reductions.h"
 #include "mri_core_data.h"
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 
 
@@ -9,23 +10,6 @@ using BufferKey =  Gadgetron::BucketToBufferGadget::BufferKey;
 
 
 
-namespace std {
-    template<>
-    struct less<BufferKey>{
-        bool operator()(const BufferKey& idx1, const BufferKey& idx2) const {
-            return std::tie(idx1.average,idx1.slice,idx1.contrast,idx1.phase,idx1.repetition,idx1.set,idx1.segment) <
-                std::tie(idx2.average,idx2.slice,idx2.contrast,idx2.phase,idx2.repetition,idx2.set,idx2.segment);
-        }
-    };
-
-    template<> struct equal_to<BufferKey>{
-        bool operator()(const BufferKey& idx1, const BufferKey& idx2) const {
-            return idx1.average == idx2.average
-                   && idx1.slice == idx2.slice && idx1.contrast == idx2.contrast && idx1.phase == idx2.phase
-                   && idx1.repetition == idx2.repetition && idx1.set == idx2.set && idx1.segment == idx2.segment;
-        }
-    };
-}
 namespace Gadgetron {
     namespace {
 
@@ -43,59 +27,251 @@ namespace Gadgetron {
 
     }
 
-    void BucketToBufferGadget::process(Core::InputChannel<AcquisitionBucket>& input, Core::OutputChannel& out) {
-
-        for (auto acq_bucket : input) {
-            std::map<BufferKey, IsmrmrdReconData> recon_data_buffers;
-            GDEBUG_STREAM("BUCKET_SIZE " << acq_bucket.data_.size() << " ESPACE " << acq_bucket.refstats_.size());
-            // Iterate over the reference data of the bucket
-            for (auto& acq : acq_bucket.ref_) {
-                // Get a reference to the header for this acquisition
-
-                const auto& acqhdr    = std::get<ISMRMRD::AcquisitionHeader>(acq);
-                auto key              = getKey(acqhdr.idx);
-                uint16_t espace       = acqhdr.encoding_space_ref;
-                IsmrmrdReconBit& rbit = getRBit(recon_data_buffers, key, espace);
-                if (!rbit.ref_) {
-                    rbit.ref_ = makeDataBuffer(acqhdr, header.encoding[espace], acq_bucket.refstats_[espace], true);
-                    rbit.ref_->sampling_ = createSamplingDescription(
-                        header.encoding[espace], acq_bucket.refstats_[espace], acqhdr, true);
+    struct BucketToBufferGadget::StreamedBuffers {
+        std::map<BufferKey, IsmrmrdReconData> recon_data;
+        AcquisitionBucket bucket;
+        // The data lines received per encoding space, streamed or not, as a bucket would count them.
+        std::vector<AcquisitionBucketStats> datastats;
+    };
+
+    void BucketToBufferGadget::process(
+        Core::InputChannel<Core::variant<AcquisitionBucket, Core::Acquisition, Core::Waveform>>& input,
+        Core::OutputChannel& out) {
+
+        auto trigger   = AcquisitionTrigger(
+            trigger_dimension, n_acquisitions_before_trigger, n_acquisitions_before_ongoing_trigger);
+        auto streamed  = std::map<unsigned short, StreamedBuffers>{};
+        auto waveforms = std::vector<Core::Waveform>{};
+
+        for (auto message : input) {
+            if (Core::holds_alternative<AcquisitionBucket>(message)) {
+                auto& acq_bucket = Core::get<AcquisitionBucket>(message);
+                std::map<BufferKey, IsmrmrdReconData> recon_data_buffers;
+                GDEBUG_STREAM("BUCKET_SIZE " << acq_bucket.data_.size() << " ESPACE " << acq_bucket.refstats_.size());
+                add_bucket(recon_data_buffers, acq_bucket);
+
+                // Send all the ReconData messages
+                GDEBUG("End of bucket reached, sending out %d ReconData buffers\n", recon_data_buffers.size());
+
+                for (auto& recon_data_buffer : recon_data_buffers) {
+                    if (acq_bucket.waveform_.empty())
+                        out.push(recon_data_buffer.second);
+                    else
+                        out.push(recon_data_buffer.second, acq_bucket.waveform_);
                 }
+                continue;
+            }
 
-                add_acquisition(*rbit.ref_, acq, header.encoding[espace], acq_bucket.refstats_[espace], true);
+            if (Core::holds_alternative<Core::Waveform>(message)) {
+                waveforms.emplace_back(std::move(Core::get<Core::Waveform>(message)));
+                continue;
+            }
+
+            auto& acq = Core::get<Core::Acquisition>(message);
+            auto head = std::get<ISMRMRD::AcquisitionHeader>(acq);
+            if (ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_NOISE_MEASUREMENT).isSet(head.flags))
+                continue;
+
+            if (trigger.trigger_before(head))
+                send_streamed(out, streamed, waveforms);
 
-                // Stuff the data, header and trajectory into this data buffer
+            auto& buffers = streamed[AcquisitionTrigger::index(head, sorting_dimension)];
+            stream_acquisition(buffers, std::move(acq));
+
+            if (trigger.trigger_after(head))
+                send_streamed(out, streamed, waveforms);
+        }
+        send_streamed(out, streamed, waveforms);
+    }
+
+    void BucketToBufferGadget::add_bucket(
+        std::map<BufferKey, IsmrmrdReconData>& recon_data_buffers, const AcquisitionBucket& acq_bucket) {
+
+        // Iterate over the reference data of the bucket
+        for (auto& acq : acq_bucket.ref_) {
+            // Get a reference to the header for this acquisition
+
+            const auto& acqhdr    = std::get<ISMRMRD::AcquisitionHeader>(acq);
+            auto key              = getKey(acqhdr.idx);
+            uint16_t espace       = acqhdr.encoding_space_ref;
+            IsmrmrdReconBit& rbit = getRBit(recon_data_buffers, key, espace);
+            if (!rbit.ref_) {
+                rbit.ref_ = makeDataBuffer(acqhdr, header.encoding[espace], acq_bucket.refstats_[espace], true);
+                rbit.ref_->sampling_ = createSamplingDescription(
+                    header.encoding[espace], acq_bucket.refstats_[espace], acqhdr, true);
             }
 
-            // Iterate over the reference data of the bucket
-            for (auto& acq : acq_bucket.data_) {
-                // Get a reference to the header for this acquisition
-
-                const auto& acqhdr    = std::get<ISMRMRD::AcquisitionHeader>(acq);
-                auto key              = getKey(acqhdr.idx);
-                uint16_t espace       = acqhdr.encoding_space_ref;
-                IsmrmrdReconBit& rbit = getRBit(recon_data_buffers, key, espace);
-                if (rbit.data_.data_.empty()) {
-                    rbit.data_ = makeDataBuffer(acqhdr, header.encoding[espace], acq_bucket.datastats_[espace], false);
-                    rbit.data_.sampling_ = createSamplingDescription(
-                        header.encoding[espace], acq_bucket.datastats_[espace], acqhdr, false);
-                }
+            add_acquisition(*rbit.ref_, acq, header.encoding[espace], acq_bucket.refstats_[espace], true);
+
+            // Stuff the data, header and trajectory into this data buffer
+        }
+
+        // Iterate over the reference data of the bucket
+        for (auto& acq : acq_bucket.data_) {
+            // Get a reference to the header for this acquisition
+
+            const auto& acqhdr    = std::get<ISMRMRD::AcquisitionHeader>(acq);
+            auto key              = getKey(acqhdr.idx);
+            uint16_t espace       = acqhdr.encoding_space_ref;
+            IsmrmrdReconBit& rbit = getRBit(recon_data_buffers, key, espace);
+            if (rbit.data_.data_.empty()) {
+                rbit.data_ = makeDataBuffer(acqhdr, header.encoding[espace], acq_bucket.datastats_[espace], false);
+                rbit.data_.sampling_ = createSamplingDescription(
+                    header.encoding[espace], acq_bucket.datastats_[espace], acqhdr, false);
+            }
+
+            add_acquisition(rbit.data_, acq, header.encoding[espace], acq_bucket.datastats_[espace], false);
+
+            // Stuff the data, header and trajectory into this data buffer
+        }
+    }
+
+    void BucketToBufferGadget::stream_acquisition(StreamedBuffers& buffers, Core::Acquisition acq) {
+        const auto& acqhdr = std::get<ISMRMRD::AcquisitionHeader>(acq);
+
+        if (!(ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(acqhdr.flags)
+                || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PHASECORR_DATA).isSet(acqhdr.flags))) {
+            if (buffers.datastats.size() < (acqhdr.encoding_space_ref + 1u)) {
+                buffers.datastats.resize(acqhdr.encoding_space_ref + 1);
+            }
+            add_stats(buffers.datastats[acqhdr.encoding_space_ref], acqhdr);
+        }
+
+        // Calibration lines are buffered at the trigger, as their buffers are sized from the lines received.
+        if (ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION).isSet(acqhdr.flags)
+            || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PARALLEL_CALIBRATION_AND_IMAGING).isSet(acqhdr.flags)
+            || ISMRMRD::FlagBit(ISMRMRD::ISMRMRD_ACQ_IS_PHASECORR_DATA).isSet(acqhdr.flags) || !can_stream(acqhdr)) {
+            add_to_bucket(buffers.bucket, std::move(acq));
+            return;
+        }
+
+        auto key              = getKey(acqhdr.idx);
+        uint16_t espace       = acqhdr.encoding_space_ref;
+        const auto& encoding  = header.encoding[espace];
+        IsmrmrdReconBit& rbit = getRBit(buffers.recon_data, key, espace);
+        auto stats            = AcquisitionBucketStats{};
+        if (rbit.data_.data_.empty()) {
+            stats                = limits_to_stats(encoding, acqhdr);
+            rbit.data_           = makeDataBuffer(acqhdr, encoding, stats, false);
+            rbit.data_.sampling_ = createSamplingDescription(encoding, stats, acqhdr, false);
+        }
+
+        // The stats are only used for reference data.
+        add_acquisition(rbit.data_, acq, encoding, stats, false);
+    }
 
-                add_acquisition(rbit.data_, acq, header.encoding[espace], acq_bucket.datastats_[espace], false);
+    bool BucketToBufferGadget::can_stream(const ISMRMRD::AcquisitionHeader& acqhdr) const {
+        if (acqhdr.encoding_space_ref >= header.encoding.size())
+            return false;
 
-                // Stuff the data, header and trajectory into this data buffer
+        const auto& encoding = header.encoding[acqhdr.encoding_space_ref];
+        const auto& limits   = encoding.encodingLimits;
+
+        // The size of the buffer is known up front if the limits cover everything the bucket statistics would give.
+        auto limited = [&](Dimension dimension) {
+            switch (dimension) {
+            case Dimension::phase: return limits.phase.is_present();
+            case Dimension::contrast: return limits.contrast.is_present();
+            case Dimension::repetition: return limits.repetition.is_present();
+            case Dimension::set: return limits.set.is_present();
+            case Dimension::segment:
+            case Dimension::average: return limits.average.is_present();
+            case Dimension::slice: return limits.slice.is_present();
+            default: return true;
+            }
+        };
+        if (!limited(N_dimension) || !limited(S_dimension))
+            return false;
+
+        return limits.kspace_encoding_step_1.is_present() && limits.kspace_encoding_step_2.is_present();
+    }
+
+    namespace {
+        using TriggerDimension = AcquisitionAccumulateTriggerGadget::TriggerDimension;
+
+        std::set<uint16_t>* statistic(AcquisitionBucketStats& stats, TriggerDimension dimension) {
+            switch (dimension) {
+            case TriggerDimension::kspace_encode_step_1: return &stats.kspace_encode_step_1;
+            case TriggerDimension::kspace_encode_step_2: return &stats.kspace_encode_step_2;
+            case TriggerDimension::average: return &stats.average;
+            case TriggerDimension::slice: return &stats.slice;
+            case TriggerDimension::contrast: return &stats.contrast;
+            case TriggerDimension::phase: return &stats.phase;
+            case TriggerDimension::repetition: return &stats.repetition;
+            case TriggerDimension::set: return &stats.set;
+            case TriggerDimension::segment: return &stats.segment;
+            default: return nullptr;
             }
+        }
 
-            // Send all the ReconData messages
-            GDEBUG("End of bucket reached, sending out %d ReconData buffers\n", recon_data_buffers.size());
+        void add_limit(std::set<uint16_t>& stat, const ISMRMRD::Optional<ISMRMRD::Limit>& limit, uint16_t value) {
+            if (limit.is_present()) {
+                stat.insert(limit->minimum);
+                stat.insert(limit->maximum);
+            } else {
+                stat.insert(value);
+            }
+        }
+    }
+
+    AcquisitionBucketStats BucketToBufferGadget::limits_to_stats(
+        const ISMRMRD::Encoding& encoding, const ISMRMRD::AcquisitionHeader& acqhdr) const {
+        const auto& limits = encoding.encodingLimits;
+        const auto& idx    = acqhdr.idx;
+
+        AcquisitionBucketStats stats;
+        add_limit(stats.kspace_encode_step_1, limits.kspace_encoding_step_1, idx.kspace_encode_step_1);
+        add_limit(stats.kspace_encode_step_2, limits.kspace_encoding_step_2, idx.kspace_encode_step_2);
+        add_limit(stats.slice, limits.slice, idx.slice);
+        add_limit(stats.phase, limits.phase, idx.phase);
+        add_limit(stats.contrast, limits.contrast, idx.contrast);
+        add_limit(stats.repetition, limits.repetition, idx.repetition);
+        add_limit(stats.set, limits.set, idx.set);
+        add_limit(stats.segment, limits.segment, idx.segment);
+        add_limit(stats.average, limits.average, idx.average);
+
+        // A trigger or sort along a dimension leaves a single value of it in each buffer.
+        for (auto dimension : { trigger_dimension, sorting_dimension }) {
+            if (auto stat = statistic(stats, dimension)) {
+                *stat = { AcquisitionTrigger::index(acqhdr, dimension) };
+            }
+        }
+        return stats;
+    }
 
+    void BucketToBufferGadget::send_streamed(Core::OutputChannel& out,
+        std::map<unsigned short, StreamedBuffers>& streamed, std::vector<Core::Waveform>& waveforms) {
+
+        // The waveforms go with the first sorting index, as the AcquisitionAccumulateTriggerGadget would send them.
+        bool first = true;
+        for (auto& sorted : streamed) {
+            auto& recon_data_buffers = sorted.second.recon_data;
+            const auto& datastats    = sorted.second.datastats;
             for (auto& recon_data_buffer : recon_data_buffers) {
-                if (acq_bucket.waveform_.empty())
-                    out.push(recon_data_buffer.second);
+                auto& rbits = recon_data_buffer.second.rbit_;
+                for (size_t espace = 0; espace < rbits.size(); espace++) {
+                    if (!rbits[espace].data_.data_.empty())
+                        fit_to_received(rbits[espace].data_, header.encoding[espace], datastats[espace]);
+                }
+            }
+
+            // The bucketed data lines are buffered with the statistics of all data lines, as in a bucket.
+            sorted.second.bucket.datastats_ = datastats;
+            add_bucket(recon_data_buffers, sorted.second.bucket);
+
+            GDEBUG("Trigger reached, sending out %d ReconData buffers\n", recon_data_buffers.size());
+
+            for (auto& recon_data_buffer : recon_data_buffers) {
+                if (!first || waveforms.empty())
+                    out.push(std::move(recon_data_buffer.second));
                 else
-                    out.push(recon_data_buffer.second, acq_bucket.waveform_);
+                    out.push(std::move(recon_data_buffer.second), waveforms);
             }
+            first = false;
         }
+
+        streamed.clear();
+        waveforms.clear();
     }
 
     namespace {
@@ -189,8 +365,9 @@ namespace Gadgetron {
         buffer.data_ = hoNDArray<std::complex<float>>(NE0, NE1, NE2, NCHA, NN, NS, NLOC);
         clear(&buffer.data_);
 
-        // Allocate the array for the headers
+        // Allocate the array for the headers; the lines not received keep an empty header
         buffer.headers_ = hoNDArray<ISMRMRD::AcquisitionHeader>(NE1, NE2, NN, NS, NLOC);
+        std::fill(buffer.headers_.begin(), buffer.headers_.end(), ISMRMRD::AcquisitionHeader());
 
         // Allocate the array for the trajectories
         uint16_t TRAJDIM = acqhdr.trajectory_dimensions;
@@ -201,6 +378,77 @@ namespace Gadgetron {
         return buffer;
     }
 
+    void BucketToBufferGadget::fit_to_received(
+        IsmrmrdDataBuffered& buffer, const ISMRMRD::Encoding& encoding, const AcquisitionBucketStats& stats) const {
+
+        // The sizes a bucket of the same lines would give the buffer
+        const uint16_t NN   = getSizeFromDimension(N_dimension, stats);
+        const uint16_t NS   = getSizeFromDimension(S_dimension, stats);
+        const uint16_t NLOC = getNLOC(encoding, stats);
+
+        const size_t NE0  = buffer.data_.get_size(0);
+        const size_t NE1  = buffer.data_.get_size(1);
+        const size_t NE2  = buffer.data_.get_size(2);
+        const size_t NCHA = buffer.data_.get_size(3);
+        const size_t N    = buffer.data_.get_size(4);
+        const size_t S    = buffer.data_.get_size(5);
+        const size_t LOC  = buffer.data_.get_size(6);
+
+        if (N == NN && S == NS && LOC == NLOC)
+            return;
+
+        IsmrmrdDataBuffered fitted;
+        fitted.data_ = hoNDArray<std::complex<float>>(NE0, NE1, NE2, NCHA, NN, NS, NLOC);
+        clear(&fitted.data_);
+        fitted.headers_ = hoNDArray<ISMRMRD::AcquisitionHeader>(NE1, NE2, NN, NS, NLOC);
+        std::fill(fitted.headers_.begin(), fitted.headers_.end(), ISMRMRD::AcquisitionHeader());
+
+        size_t TRAJDIM = 0;
+        if (buffer.trajectory_) {
+            TRAJDIM            = buffer.trajectory_->get_size(0);
+            fitted.trajectory_ = hoNDArray<float>(TRAJDIM, NE0, NE1, NE2, NN, NS, NLOC);
+            clear(*fitted.trajectory_);
+        }
+        fitted.sampling_ = buffer.sampling_;
+
+        // Every line received moves to the place add_acquisition gives it in a buffer of the fitted size
+        for (size_t loc = 0; loc < LOC; loc++) {
+            for (size_t s = 0; s < S; s++) {
+                for (size_t n = 0; n < N; n++) {
+                    for (size_t e2 = 0; e2 < NE2; e2++) {
+                        for (size_t e1 = 0; e1 < NE1; e1++) {
+                            const auto& acqhdr = buffer.headers_(e1, e2, n, s, loc);
+                            if (acqhdr.number_of_samples == 0)
+                                continue;
+
+                            size_t NUsed     = std::min<size_t>(getDimensionKey(N_dimension, acqhdr.idx), NN - 1);
+                            size_t SUsed     = std::min<size_t>(getDimensionKey(S_dimension, acqhdr.idx), NS - 1);
+                            size_t slice_loc = split_slices || NLOC == 1 ? 0 : acqhdr.idx.slice;
+                            if (slice_loc >= NLOC) {
+                                throw std::runtime_error("Acquired data does not fit into the data buffer.\n");
+                            }
+
+                            for (size_t cha = 0; cha < NCHA; cha++) {
+                                auto fromptr = &buffer.data_(0, e1, e2, cha, n, s, loc);
+                                std::copy(fromptr, fromptr + NE0, &fitted.data_(0, e1, e2, cha, NUsed, SUsed, slice_loc));
+                            }
+
+                            fitted.headers_(e1, e2, NUsed, SUsed, slice_loc) = acqhdr;
+
+                            if (TRAJDIM > 0) {
+                                auto fromptr = &(*buffer.trajectory_)(0, 0, e1, e2, n, s, loc);
+                                std::copy(fromptr, fromptr + TRAJDIM * NE0,
+                                    &(*fitted.trajectory_)(0, 0, e1, e2, NUsed, SUsed, slice_loc));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        buffer = std::move(fitted);
+    }
+
     uint16_t BucketToBufferGadget::getNLOC(
         const ISMRMRD::Encoding& encoding, const AcquisitionBucketStats& stats) const {
         uint16_t NLOC;
@@ -526,6 +774,11 @@ namespace Gadgetron {
             }
         }
 
+        // Buffers sized from the encoding limits only hold the lines within them.
+        if (slice_loc >= NLOC || e1 < 0 || e1 >= (int16_t)NE1 || e2 < 0 || e2 >= (int16_t)NE2) {
+            throw std::runtime_error("Acquired data does not fit into the data buffer.\n");
+        }
+
         std::complex<float>* pData = &dataBuffer.data_(offset, e1, e2, 0, NUsed, SUsed, slice_loc);
 
         for (uint16_t cha = 0; cha < NCHA; cha++) {
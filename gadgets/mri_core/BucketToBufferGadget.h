@@ -1,4 +1,5 @@
 #pragma once
+#include "AcquisitionAccumulateTriggerGadget.h"
 #include "Node.h"
 #include "gadgetron_mricore_export.h"
 #include "hoNDArray.h"
@@ -8,6 +9,8 @@
 #include <complex>
 #include <ismrmrd/ismrmrd.h>
 #include <ismrmrd/xml.h>
+#include <map>
+#include <tuple>
 
 namespace Gadgetron {
 
@@ -22,7 +25,15 @@ namespace Gadgetron {
     // Since the order of data can be changed from its acquried time order, there is no easy way to resort waveform data
     // Therefore, the waveform data was copied and passed with every buffer
 
-    class BucketToBufferGadget : public Core::ChannelGadget<AcquisitionBucket> {
+    // Without an AcquisitionAccumulateTriggerGadget in front, the gadget takes the acquisitions themselves, and
+    // triggers and sorts them as the accumulate gadget would. Imaging lines are then copied into buffers sized from the
+    // encoding limits as they arrive, rather than held in a bucket until the trigger. Reference lines, and data that
+    // cannot be sized from the encoding limits, are still bucketed and buffered at the trigger.
+    // A bucket sizes N, S and the slices from the indices received, not from the limits. At the trigger, a streamed
+    // buffer whose size differs from that is moved into a buffer of the bucket's size, so both give the same buffers.
+
+    class BucketToBufferGadget
+        : public Core::ChannelGadget<Core::variant<AcquisitionBucket, Core::Acquisition, Core::Waveform>> {
     public:
         BucketToBufferGadget(const Core::Context& context, const Core::GadgetProperties& props);
         enum class Dimension { average, contrast, phase, repetition, set, segment, slice, none };
@@ -42,11 +53,33 @@ namespace Gadgetron {
         NODE_PROPERTY(ignore_segment, bool, "Ignore segment", false);
         NODE_PROPERTY(verbose, bool, "Whether to print more information", false);
 
+        using TriggerDimension = AcquisitionAccumulateTriggerGadget::TriggerDimension;
+        NODE_PROPERTY(trigger_dimension, TriggerDimension, "Dimension to trigger on, for unbucketed acquisitions",
+            TriggerDimension::none);
+        NODE_PROPERTY(sorting_dimension, TriggerDimension, "Dimension to sort by, for unbucketed acquisitions",
+            TriggerDimension::none);
+        NODE_PROPERTY(n_acquisitions_before_trigger, unsigned long, "Number of acquisition before first trigger", 40);
+        NODE_PROPERTY(
+            n_acquisitions_before_ongoing_trigger, unsigned long, "Number of acquisition before ongoing triggers", 40);
+
         ISMRMRD::IsmrmrdHeader header;
 
-        void process(Core::InputChannel<AcquisitionBucket>& in, Core::OutputChannel& out) override;
+        void process(Core::InputChannel<Core::variant<AcquisitionBucket, Core::Acquisition, Core::Waveform>>& in,
+            Core::OutputChannel& out) override;
         BufferKey getKey(const ISMRMRD::EncodingCounters& idx) const;
 
+        struct StreamedBuffers;
+
+        void add_bucket(std::map<BufferKey, IsmrmrdReconData>& recon_data_buffers, const AcquisitionBucket& bucket);
+        void stream_acquisition(StreamedBuffers& buffers, Core::Acquisition acq);
+        bool can_stream(const ISMRMRD::AcquisitionHeader& acqhdr) const;
+        AcquisitionBucketStats limits_to_stats(
+            const ISMRMRD::Encoding& encoding, const ISMRMRD::AcquisitionHeader& acqhdr) const;
+        void send_streamed(Core::OutputChannel& out, std::map<unsigned short, StreamedBuffers>& buffers,
+            std::vector<Core::Waveform>& waveforms);
+        void fit_to_received(
+            IsmrmrdDataBuffered& buffer, const ISMRMRD::Encoding& encoding, const AcquisitionBucketStats& stats) const;
+
 
         IsmrmrdDataBuffered makeDataBuffer(const ISMRMRD::AcquisitionHeader& acqhdr, ISMRMRD::Encoding encoding,
             const AcquisitionBucketStats& stats, bool forref) const;
@@ -62,3 +95,24 @@ namespace Gadgetron {
 
     void from_string(const std::string&, BucketToBufferGadget::Dimension&);
 }
+
+namespace std {
+    template <> struct less<Gadgetron::BucketToBufferGadget::BufferKey> {
+        bool operator()(const Gadgetron::BucketToBufferGadget::BufferKey& idx1,
+            const Gadgetron::BucketToBufferGadget::BufferKey& idx2) const {
+            return std::tie(idx1.average, idx1.slice, idx1.contrast, idx1.phase, idx1.repetition, idx1.set,
+                       idx1.segment)
+                   < std::tie(idx2.average, idx2.slice, idx2.contrast, idx2.phase, idx2.repetition, idx2.set,
+                       idx2.segment);
+        }
+    };
+
+    template <> struct equal_to<Gadgetron::BucketToBufferGadget::BufferKey> {
+        bool operator()(const Gadgetron::BucketToBufferGadget::BufferKey& idx1,
+            const Gadgetron::BucketToBufferGadget::BufferKey& idx2) const {
+            return idx1.average == idx2.average && idx1.slice == idx2.slice && idx1.contrast == idx2.contrast
+                   && idx1.phase == idx2.phase && idx1.repetition == idx2.repetition && idx1.set == idx2.set
+                   && idx1.segment == idx2.segment;
+        }
+    };
+}
@@ -3,6 +3,8 @@
 #include "mri_core_grappa.h"
 #include "hoNDArray_reductions.h"
 
+#include <typeinfo>
+
 /*
     The input is IsmrmrdReconData and output is single 2D or 3D ISMRMRD images
 
@@ -39,6 +41,7 @@ namespace Gadgetron {
         GDEBUG_CONDITION_STREAM(verbose.value(), "Number of encoding spaces: " << NE);
 
         recon_obj_.resize(NE);
+        cached_calibration_.resize(NE);
 
         return GADGET_OK;
     }
@@ -106,61 +109,73 @@ namespace Gadgetron {
 
                 // ---------------------------------------------------------------
 
-                // after this step, the recon_obj_[e].ref_calib_ and recon_obj_[e].ref_coil_map_ are set
+                CalibrationKey key;
+                bool calibrated = false;
+                if (use_calibration_cache.value()) {
+                    key = this->calibration_key(recon_bit_->rbit_[e], e);
+                    calibrated = this->restore_calibration(key, recon_obj_[e], e);
+                    GDEBUG_CONDITION_STREAM(verbose.value() && calibrated, "Reusing cached calibration for encoding space " << e);
+                }
 
-                if (perform_timing.value()) { gt_timer_.start("GenericReconCartesianGrappaGadget::make_ref_coil_map"); }
-                this->make_ref_coil_map(*recon_bit_->rbit_[e].ref_, *recon_bit_->rbit_[e].data_.data_.get_dimensions(),
-                                        recon_obj_[e].ref_calib_, recon_obj_[e].ref_coil_map_, e);
-                if (perform_timing.value()) { gt_timer_.stop(); }
+                if (!calibrated) {
+                    // after this step, the recon_obj_[e].ref_calib_ and recon_obj_[e].ref_coil_map_ are set
 
-                // ----------------------------------------------------------
-                // export prepared ref for calibration and coil map
-                if (!debug_folder_full_path_.empty()) {
-                    this->gt_exporter_.export_array_complex(recon_obj_[e].ref_calib_,
-                                                            debug_folder_full_path_ + "ref_calib" + os.str());
-                }
+                    if (perform_timing.value()) { gt_timer_.start("GenericReconCartesianGrappaGadget::make_ref_coil_map"); }
+                    this->make_ref_coil_map(*recon_bit_->rbit_[e].ref_, *recon_bit_->rbit_[e].data_.data_.get_dimensions(),
+                                            recon_obj_[e].ref_calib_, recon_obj_[e].ref_coil_map_, e);
+                    if (perform_timing.value()) { gt_timer_.stop(); }
 
-                if (!debug_folder_full_path_.empty()) {
-                    this->gt_exporter_.export_array_complex(recon_obj_[e].ref_coil_map_,
-                                                            debug_folder_full_path_ + "ref_coil_map" + os.str());
-                }
+                    // ----------------------------------------------------------
+                    // export prepared ref for calibration and coil map
+                    if (!debug_folder_full_path_.empty()) {
+                        this->gt_exporter_.export_array_complex(recon_obj_[e].ref_calib_,
+                                                                debug_folder_full_path_ + "ref_calib" + os.str());
+                    }
 
-                // ---------------------------------------------------------------
-                // after this step, the recon_obj_[e].ref_calib_dst_ and recon_obj_[e].ref_coil_map_ are modified
-                if (perform_timing.value()) {
-                    gt_timer_.start("GenericReconCartesianGrappaGadget::prepare_down_stream_coil_compression_ref_data");
-                }
-                this->prepare_down_stream_coil_compression_ref_data(recon_obj_[e].ref_calib_,
-                                                                    recon_obj_[e].ref_coil_map_,
-                                                                    recon_obj_[e].ref_calib_dst_, e);
-                if (perform_timing.value()) { gt_timer_.stop(); }
+                    if (!debug_folder_full_path_.empty()) {
+                        this->gt_exporter_.export_array_complex(recon_obj_[e].ref_coil_map_,
+                                                                debug_folder_full_path_ + "ref_coil_map" + os.str());
+                    }
 
-                if (!debug_folder_full_path_.empty()) {
-                    this->gt_exporter_.export_array_complex(recon_obj_[e].ref_calib_dst_,
-                        debug_folder_full_path_ + "ref_calib_dst" + os.str());
-                }
+                    // ---------------------------------------------------------------
+                    // after this step, the recon_obj_[e].ref_calib_dst_ and recon_obj_[e].ref_coil_map_ are modified
+                    if (perform_timing.value()) {
+                        gt_timer_.start("GenericReconCartesianGrappaGadget::prepare_down_stream_coil_compression_ref_data");
+                    }
+                    this->prepare_down_stream_coil_compression_ref_data(recon_obj_[e].ref_calib_,
+                                                                        recon_obj_[e].ref_coil_map_,
+                                                                        recon_obj_[e].ref_calib_dst_, e);
+                    if (perform_timing.value()) { gt_timer_.stop(); }
 
-                if (!debug_folder_full_path_.empty()) {
-                    this->gt_exporter_.export_array_complex(recon_obj_[e].ref_coil_map_,
-                        debug_folder_full_path_ + "ref_coil_map_dst" + os.str());
-                }
+                    if (!debug_folder_full_path_.empty()) {
+                        this->gt_exporter_.export_array_complex(recon_obj_[e].ref_calib_dst_,
+                            debug_folder_full_path_ + "ref_calib_dst" + os.str());
+                    }
 
-                // ---------------------------------------------------------------
+                    if (!debug_folder_full_path_.empty()) {
+                        this->gt_exporter_.export_array_complex(recon_obj_[e].ref_coil_map_,
+                            debug_folder_full_path_ + "ref_coil_map_dst" + os.str());
+                    }
 
-                // after this step, coil map is computed and stored in recon_obj_[e].coil_map_
-                if (perform_timing.value()) {
-                    gt_timer_.start("GenericReconCartesianGrappaGadget::perform_coil_map_estimation");
-                }
-                this->perform_coil_map_estimation(recon_obj_[e].ref_coil_map_, recon_obj_[e].coil_map_, e);
-                if (perform_timing.value()) { gt_timer_.stop(); }
+                    // ---------------------------------------------------------------
 
-                // ---------------------------------------------------------------
+                    // after this step, coil map is computed and stored in recon_obj_[e].coil_map_
+                    if (perform_timing.value()) {
+                        gt_timer_.start("GenericReconCartesianGrappaGadget::perform_coil_map_estimation");
+                    }
+                    this->perform_coil_map_estimation(recon_obj_[e].ref_coil_map_, recon_obj_[e].coil_map_, e);
+                    if (perform_timing.value()) { gt_timer_.stop(); }
 
-                // after this step, recon_obj_[e].kernel_, recon_obj_[e].kernelIm_, recon_obj_[e].unmixing_coeff_ are filled
-                // gfactor is computed too
-                if (perform_timing.value()) { gt_timer_.start("GenericReconCartesianGrappaGadget::perform_calib"); }
-                this->perform_calib(recon_bit_->rbit_[e], recon_obj_[e], e);
-                if (perform_timing.value()) { gt_timer_.stop(); }
+                    // ---------------------------------------------------------------
+
+                    // after this step, recon_obj_[e].kernel_, recon_obj_[e].kernelIm_, recon_obj_[e].unmixing_coeff_ are filled
+                    // gfactor is computed too
+                    if (perform_timing.value()) { gt_timer_.start("GenericReconCartesianGrappaGadget::perform_calib"); }
+                    this->perform_calib(recon_bit_->rbit_[e], recon_obj_[e], e);
+                    if (perform_timing.value()) { gt_timer_.stop(); }
+
+                    if (use_calibration_cache.value()) this->cache_calibration(key, recon_obj_[e], e);
+                }
 
                 // ---------------------------------------------------------------
 
@@ -281,6 +296,116 @@ namespace Gadgetron {
         return GADGET_OK;
     }
 
+    namespace {
+        struct CalibrationProducts {
+            hoNDArray<std::complex<float>> ref_calib, ref_calib_dst, ref_coil_map, coil_map, kernel, kernelIm, unmixing_coeff;
+            hoNDArray<float> gfactor;
+
+            size_t bytes() const {
+                return ref_calib.get_number_of_bytes() + ref_calib_dst.get_number_of_bytes()
+                       + ref_coil_map.get_number_of_bytes() + coil_map.get_number_of_bytes()
+                       + kernel.get_number_of_bytes() + kernelIm.get_number_of_bytes()
+                       + unmixing_coeff.get_number_of_bytes() + gfactor.get_number_of_bytes();
+            }
+        };
+    }
+
+    CalibrationKey GenericReconCartesianGrappaGadget::calibration_key(IsmrmrdReconBit &recon_bit, size_t e) {
+
+        const IsmrmrdDataBuffered &ref = *recon_bit.ref_;
+
+        CalibrationKey key;
+        key.add(std::string(typeid(*this).name()));
+
+        key.add(ref.data_);
+        for (size_t d = 0; d < 3; d++) {
+            key.add(ref.sampling_.encoded_FOV_[d]).add(ref.sampling_.recon_FOV_[d]);
+            key.add(ref.sampling_.encoded_matrix_[d]).add(ref.sampling_.recon_matrix_[d]);
+            key.add(ref.sampling_.sampling_limits_[d].min_).add(ref.sampling_.sampling_limits_[d].center_).add(ref.sampling_.sampling_limits_[d].max_);
+        }
+
+        const auto &data = recon_bit.data_.data_;
+        key.add(data.get_number_of_dimensions());
+        for (size_t d = 0; d < data.get_number_of_dimensions(); d++) key.add(data.get_size(d));
+
+        key.add(acceFactorE1_[e]).add(acceFactorE2_[e]).add(calib_mode_[e]);
+        key.add(space_matrix_offset_E1_[e]).add(space_matrix_offset_E2_[e]);
+
+        key.add(coil_map_algorithm.value()).add(coil_map_kernel_size_readout.value()).add(coil_map_kernel_size_phase.value());
+        key.add(coil_map_num_iter.value()).add(coil_map_thres_iter.value());
+
+        key.add(grappa_kSize_RO.value()).add(grappa_kSize_E1.value()).add(grappa_kSize_E2.value());
+        key.add(grappa_reg_lamda.value()).add(grappa_calib_over_determine_ratio.value());
+
+        key.add(downstream_coil_compression.value()).add(downstream_coil_compression_thres.value());
+        key.add(downstream_coil_compression_num_modesKept.value());
+
+        return key;
+    }
+
+    namespace {
+        // gives kernel storage of its own again, if it refers to a cached one
+        void detach(hoNDArray<std::complex<float>> &kernel) {
+            if (kernel.delete_data_on_destruct()) return;
+            hoNDArray<std::complex<float>> own(kernel.get_dimensions());
+            kernel.create(*own.get_dimensions(), own.get_data_ptr(), true);
+            own.delete_data_on_destruct(false);
+        }
+
+        // makes kernel refer to the cached one, which is shared and read only, instead of copying it
+        void refer_to(hoNDArray<std::complex<float>> &kernel, const hoNDArray<std::complex<float>> &cached) {
+            if (cached.get_number_of_elements() == 0) {
+                detach(kernel);
+                kernel.clear();
+                return;
+            }
+            kernel.create(*cached.get_dimensions(), const_cast<std::complex<float> *>(cached.get_data_ptr()));
+        }
+    }
+
+    void GenericReconCartesianGrappaGadget::cache_calibration(const CalibrationKey &key, ReconObjType &recon_obj, size_t e) {
+        auto products = std::make_shared<CalibrationProducts>();
+        products->ref_calib = recon_obj.ref_calib_;
+        products->ref_calib_dst = recon_obj.ref_calib_dst_;
+        products->ref_coil_map = recon_obj.ref_coil_map_;
+        products->coil_map = recon_obj.coil_map_;
+        products->kernel = recon_obj.kernel_;
+        products->kernelIm = std::move(recon_obj.kernelIm_);
+        products->unmixing_coeff = recon_obj.unmixing_coeff_;
+        products->gfactor = recon_obj.gfactor_;
+
+        std::shared_ptr<const CalibrationProducts> cached = std::move(products);
+        refer_to(recon_obj.kernelIm_, cached->kernelIm);
+        cached_calibration_[e] = cached;
+
+        CalibrationCache::instance().insert<CalibrationProducts>(key, cached, cached->bytes());
+    }
+
+    bool GenericReconCartesianGrappaGadget::restore_calibration(const CalibrationKey &key, ReconObjType &recon_obj, size_t e) {
+        auto products = CalibrationCache::instance().find<CalibrationProducts>(key);
+        if (!products) {
+            // the kernel is calibrated next, and must not be calibrated into the cached one it may refer to
+            if (cached_calibration_[e]) {
+                detach(recon_obj.kernelIm_);
+                cached_calibration_[e].reset();
+            }
+            return false;
+        }
+
+        recon_obj.ref_calib_ = products->ref_calib;
+        recon_obj.ref_calib_dst_ = products->ref_calib_dst;
+        recon_obj.ref_coil_map_ = products->ref_coil_map;
+        recon_obj.coil_map_ = products->coil_map;
+        recon_obj.kernel_ = products->kernel;
+        recon_obj.unmixing_coeff_ = products->unmixing_coeff;
+        recon_obj.gfactor_ = products->gfactor;
+
+        refer_to(recon_obj.kernelIm_, products->kernelIm);
+        cached_calibration_[e] = products;
+
+        return true;
+    }
+
     void GenericReconCartesianGrappaGadget::prepare_down_stream_coil_compression_ref_data(
             const hoNDArray<std::complex<float> > &ref_src, hoNDArray<std::complex<float> > &ref_coil_map,
             hoNDArray<std::complex<float> > &ref_dst, size_t e) {
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "GenericReconGadget.h"
+#include "mri_core_calibration_cache.h"
 
 namespace Gadgetron {
 
@@ -105,6 +106,11 @@ namespace Gadgetron {
         GADGET_PROPERTY(downstream_coil_compression_thres, double, "Threadhold for downstream coil compression", 0.002);
         GADGET_PROPERTY(downstream_coil_compression_num_modesKept, size_t, "Number of modes to keep for downstream coil compression", 0);
 
+        /// ------------------------------------------------------------------------------------
+        /// if true, calibration results are looked up in the process wide CalibrationCache, and calibration is skipped
+        /// for reference data that has been calibrated before with the same parameters; off by default
+        GADGET_PROPERTY(use_calibration_cache, bool, "Whether to reuse calibration results for identical reference data", false);
+
     protected:
 
         // --------------------------------------------------
@@ -113,6 +119,9 @@ namespace Gadgetron {
         // record the recon kernel, coil maps etc. for every encoding space
         std::vector< ReconObjType > recon_obj_;
 
+        // cached calibration results the image domain kernels of recon_obj_ refer to, for every encoding space
+        std::vector< std::shared_ptr<const void> > cached_calibration_;
+
         // --------------------------------------------------
         // gadget functions
         // --------------------------------------------------
@@ -136,5 +145,13 @@ namespace Gadgetron {
         // compute snr map
         virtual void compute_snr_map(ReconObjType& recon_obj, hoNDArray< std::complex<float> >& snr_map);
 
+        // everything the calibration of a recon bit depends on: reference data, recon size and parameters
+        virtual CalibrationKey calibration_key(IsmrmrdReconBit& recon_bit, size_t encoding);
+
+        // store or restore the calibration results of recon_obj in the calibration cache
+        // the image domain kernel is not copied; recon_obj refers to the cached one, which must not be modified
+        void cache_calibration(const CalibrationKey& key, ReconObjType& recon_obj, size_t encoding);
+        bool restore_calibration(const CalibrationKey& key, ReconObjType& recon_obj, size_t encoding);
+
     };
 }
@@ -1,11 +1,14 @@
 #ifndef NHLBICOMPRESSION_H
 #define NHLBICOMPRESSION_H
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <stdexcept>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -19,6 +22,16 @@ struct CompressionHeader
 };
 #pragma pack(pop)
 
+/**
+ * Fixed point compression of floating point samples.
+ *
+ * Every sample is scaled, rounded and stored as a two's complement integer of bits_ bits. The integers are packed
+ * back to back, least significant bit first, with no padding except at the very end of the buffer.
+ *
+ * Packing and unpacking run over blocks of samples: the scaling and rounding of a block is a plain loop over
+ * contiguous memory (which the compiler vectorizes), and the bits are streamed through a 64 bit accumulator that is
+ * flushed 32 bits at a time, rather than read-modify-writing the output for every sample.
+ */
 template <typename T> class CompressedBuffer
 {
 
@@ -31,11 +44,16 @@ public:
         max_val_ = 0.0;
         scale_ = 0.0;
     }
-    
+
     CompressedBuffer(std::vector<T>& d, T tolerance = -1.0, uint8_t precision_bits = 32)
+        : CompressedBuffer(d.data(), d.size(), tolerance, precision_bits)
+    {
+    }
+
+    CompressedBuffer(const T* d, size_t elements, T tolerance = -1.0, uint8_t precision_bits = 32)
     {
         auto comp_func = [](T a, T b) { return std::abs(a) < std::abs(b); };
-        max_val_ = *std::max_element(d.begin(), d.end(), comp_func);
+        max_val_ = elements ? *std::max_element(d, d + elements, comp_func) : T(0);
 
         if (tolerance > 0) {
             tolerance_ = tolerance;
@@ -49,18 +67,19 @@ public:
             bits_++; //Signed
         } else {
             bits_ = precision_bits;
-            uint64_t max_int = (1<<(bits_-1))-1;
+            uint64_t max_int = (uint64_t(1)<<(bits_-1))-1;
             scale_ = (max_int-1)/max_val_;
             tolerance_ = 0.5/scale_;
         }
 
-        elements_ = d.size();
-        size_t bytes_needed = static_cast<size_t>(std::ceil((bits_*elements_)/8.0f));
-        comp_.resize(bytes_needed, 0);
-
-        for (size_t i = 0; i < d.size(); i++) {
-            setValue(i,d[i]);
+        if (bits_ < 1 || bits_ > max_bits) {
+            throw std::runtime_error("NHLBI compression supports between 1 and 32 bits per sample");
         }
+
+        elements_ = elements;
+        comp_.resize(bytes_needed(bits_, elements_), 0);
+
+        pack(d);
     }
 
     float operator[](size_t idx)
@@ -91,21 +110,30 @@ public:
         h.scale_ = this->scale_;
         h.bits_ = static_cast<uint8_t>(this->bits_);
         memcpy(&out[0],&h, sizeof(CompressionHeader));
-        memcpy(&out[sizeof(CompressionHeader)], &comp_[0], comp_.size());
+        memcpy(&out[sizeof(CompressionHeader)], comp_.data(), comp_.size());
         return out;
     }
 
     void deserialize(std::vector<uint8_t>& buffer)
     {
-        if (buffer.size() <= sizeof(CompressionHeader)) {
+        deserialize(buffer.data(), buffer.size());
+    }
+
+    void deserialize(const uint8_t* buffer, size_t size)
+    {
+        if (size <= sizeof(CompressionHeader)) {
             throw std::runtime_error("Invalid buffer size");
         }
 
         CompressionHeader h;
-        memcpy(&h, &buffer[0], sizeof(CompressionHeader));
-        
-        size_t bytes_needed = static_cast<size_t>(std::ceil((h.bits_*h.elements_)/8.0f));
-        if (bytes_needed != (buffer.size()-sizeof(CompressionHeader))) {
+        memcpy(&h, buffer, sizeof(CompressionHeader));
+
+        if (h.bits_ < 1 || h.bits_ > max_bits) {
+            throw std::runtime_error("Invalid number of bits per sample in buffer");
+        }
+
+        size_t needed = bytes_needed(h.bits_, h.elements_);
+        if (needed != (size-sizeof(CompressionHeader))) {
             throw std::runtime_error("Incorrect number of bytes in buffer");
         }
 
@@ -113,12 +141,59 @@ public:
         this->elements_ = h.elements_;
         this->scale_ = h.scale_;
         this->tolerance_ = 0.5/h.scale_;
-        this->comp_.resize(bytes_needed,0);
+        this->comp_.assign(buffer + sizeof(CompressionHeader), buffer + size);
+    }
 
-        memcpy(&comp_[0], &buffer[sizeof(CompressionHeader)], bytes_needed);
+    /**
+     * Unpacks all samples into out, which must have room for size() elements.
+     * This is what the readers should use; operator[] is for random access only.
+     */
+    void decompress(T* out) const
+    {
+        const uint8_t* in = comp_.data();
+        const uint8_t* const end = in + comp_.size();
+        const unsigned int bits = static_cast<unsigned int>(bits_);
+        const unsigned int sign_shift = 64 - bits;
+
+        uint64_t acc = 0;
+        unsigned int available = 0;
+        int32_t block[block_size];
+
+        for (size_t start = 0; start < elements_; start += block_size) {
+            const size_t n = std::min(block_size, elements_ - start);
+
+            for (size_t i = 0; i < n; i++) {
+                if (available < bits) {
+                    if (end - in >= 4) {
+                        uint32_t word;
+                        memcpy(&word, in, sizeof(word));
+                        acc |= uint64_t(word) << available;
+                        available += 32;
+                        in += 4;
+                    } else {
+                        while (available < bits && in < end) {
+                            acc |= uint64_t(*in++) << available;
+                            available += 8;
+                        }
+                    }
+                }
+                //Sign extend the lowest bits of the accumulator
+                block[i] = static_cast<int32_t>(static_cast<int64_t>(acc << sign_shift) >> sign_shift);
+                acc >>= bits;
+                available -= bits;
+            }
+
+            T* dst = out + start;
+            for (size_t i = 0; i < n; i++) {
+                dst[i] = block[i] / scale_;
+            }
+        }
     }
 
 private:
+    static constexpr size_t block_size = 256;
+    static constexpr size_t max_bits = 32;
+
     size_t bits_;
     size_t elements_;
     T tolerance_;
@@ -126,61 +201,87 @@ private:
     T scale_;
     std::vector<uint8_t> comp_;
 
-    void setValue(size_t idx, T v)
+    static size_t bytes_needed(size_t bits, size_t elements)
     {
-        size_t sb = (idx*bits_)/8;
+        return (bits*elements + 7)/8;
+    }
 
-        uint64_t* bptr = reinterpret_cast<uint64_t*>(&comp_[sb]);
-        
-        size_t upshift = idx*bits_-sb*8;
+    uint64_t bitmask() const
+    {
+        return (uint64_t(1) << bits_) - 1;
+    }
 
-        //Create mask with ones corresponding to current bits
-        const uint64_t bitmask = ((1<<bits_)-1)<<upshift;
+    void pack(const T* d)
+    {
+        const uint64_t mask = bitmask();
+        const unsigned int bits = static_cast<unsigned int>(bits_);
+        uint8_t* out = comp_.data();
+
+        //Rounding in T can overshoot the largest representable integer when bits_ approaches the mantissa width
+        const int64_t max_int = static_cast<int64_t>(mask >> 1);
+
+        uint64_t acc = 0;
+        unsigned int pending = 0;
+        int64_t block[block_size];
+
+        for (size_t start = 0; start < elements_; start += block_size) {
+            const size_t n = std::min(block_size, elements_ - start);
+
+            //Same as std::round (halfway cases away from zero), but branch free and without a libm call
+            const T* src = d + start;
+            for (size_t i = 0; i < n; i++) {
+                T scaled = src[i]*scale_;
+                int64_t truncated = static_cast<int64_t>(scaled);
+                T remainder = scaled - static_cast<T>(truncated);
+                int64_t rounded = truncated + int64_t(remainder >= T(0.5)) - int64_t(remainder <= T(-0.5));
+                block[i] = std::min(std::max(rounded, -max_int), max_int);
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                //Two's complement truncated to bits_ is the compact representation
+                acc |= (static_cast<uint64_t>(block[i]) & mask) << pending;
+                pending += bits;
+                if (pending >= 32) {
+                    uint32_t word = static_cast<uint32_t>(acc);
+                    memcpy(out, &word, sizeof(word));
+                    out += 4;
+                    acc >>= 32;
+                    pending -= 32;
+                }
+            }
+        }
 
-        //Convert number to compact integeter representation
-        int64_t int_val = static_cast<int64_t>(std::round(v*scale_));
-        uint64_t compact_val = compact_int(int_val);
-        *bptr = ((*bptr) & (~bitmask)) | (compact_val << upshift);         
+        while (pending > 0) {
+            *out++ = static_cast<uint8_t>(acc);
+            acc >>= 8;
+            pending = pending > 8 ? pending - 8 : 0;
+        }
     }
 
     float getValue(size_t idx)
     {
-        size_t sb = (idx*bits_)/8;
-        uint64_t* bptr = reinterpret_cast<uint64_t*>(&comp_[sb]);
-        
-        size_t upshift = idx*bits_-sb*8;
+        size_t bit = idx*bits_;
+        size_t sb = bit/8;
+        size_t upshift = bit-sb*8;
 
-        //Create mask with ones corresponding to current bits
-        const uint64_t bitmask = ((1<<bits_)-1)<<upshift;
+        //Never read past the end of the buffer
+        uint64_t word = 0;
+        memcpy(&word, &comp_[sb], std::min<size_t>(sizeof(word), comp_.size()-sb));
 
         //Mask other bits and shift back down
-        uint64_t compact_val =  (*bptr & bitmask)>>upshift;
+        uint64_t compact_val = (word >> upshift) & bitmask();
 
         //Convert back to binary
         int64_t int_val = uncompact_int(compact_val);
-        
+
         //Scale back and return
         return int_val / scale_;
     }
 
-    uint64_t compact_int(int64_t bin)
-    {
-
-        uint64_t abs_val = static_cast<uint64_t>(std::abs(bin));
-        
-        if (bin < 0) {
-            const uint64_t bitmask = ((1<<bits_)-1);
-            abs_val ^= bitmask;
-            abs_val += 1;
-        }
-        return abs_val;
-    }
-
     int64_t uncompact_int(uint64_t cbin)
     {
-        if (cbin & (1<<(bits_-1))) {
-            const uint64_t bitmask = ((1<<bits_)-1);
-            int64_t out = static_cast<int64_t>((cbin ^ bitmask)+1);
+        if (cbin & (uint64_t(1)<<(bits_-1))) {
+            int64_t out = static_cast<int64_t>((cbin ^ bitmask())+1);
             out = -out;
             return out;
         }
@@ -191,5 +292,3 @@ private:
 
 
 #endif //NHLBICOMPRESSION
-
-
@@ -19,6 +19,7 @@ namespace Gadgetron {
 		GADGET_PROPERTY(iterate,bool,"Iterate instead of using weights", false);
 		GADGET_PROPERTY(iteration_max,int,"Maximum number of iterations", 5);
 		GADGET_PROPERTY(iteration_tol,float,"Iteration tolerance", 1e-5);
+		GADGET_PROPERTY(toeplitz,bool,"Apply the normal operator with a Toeplitz embedded kernel when iterating (CPU); faster, and within about 1e-4 of gridding and degridding", false);
 		GADGET_PROPERTY(replicas, int,"Number of pseudo replicas", 0);
 		GADGET_PROPERTY(snr_frame, int,"Frame number for SNR measurement", 20);
 		GADGET_PROPERTY(perform_timing, bool,"Perform timing", false);
@@ -11,9 +11,26 @@
 #include <random>
 #include "NonCartesianTools.h"
 #include "NFFTOperator.h"
+#include "hoNFFTOperator.h"
 
 namespace Gadgetron {
 
+	namespace {
+		template<template<class> class ARRAY> struct EncodingOperator {
+			static boost::shared_ptr<NFFTOperator<ARRAY,float,2>> make(bool toeplitz) {
+				return boost::make_shared<NFFTOperator<ARRAY,float,2>>();
+			}
+		};
+
+		template<> struct EncodingOperator<hoNDArray> {
+			static boost::shared_ptr<NFFTOperator<hoNDArray,float,2>> make(bool toeplitz) {
+				auto E = boost::make_shared<hoNFFTOperator<float,2>>();
+				E->set_toeplitz(toeplitz);
+				return E;
+			}
+		};
+	}
+
 template<template<class> class ARRAY> 	GriddingReconGadgetBase<ARRAY>::GriddingReconGadgetBase() : Gadget1() {}
 template<template<class> class ARRAY> 	GriddingReconGadgetBase<ARRAY>::~GriddingReconGadgetBase() {}
 template<template<class> class ARRAY> 	int GriddingReconGadgetBase<ARRAY>::process_config(ACE_Message_Block* mb)
@@ -179,7 +196,7 @@ template<template<class> class ARRAY> 	boost::shared_ptr<ARRAY<float_complext> >
 			std::vector<size_t> recon_dims = image_dims_;
 			recon_dims.push_back(ncoils);
 
-			auto E = boost::make_shared<NFFTOperator<ARRAY,float,2>>();
+			auto E = EncodingOperator<ARRAY>::make(toeplitz.value());
 
 			E->setup(from_std_vector<size_t,2>(image_dims_),image_dims_os_,kernel_width_);
 			if (dcw){
@@ -9,7 +9,7 @@
 namespace Gadgetron {
 
     SpiralToGenericGadget::SpiralToGenericGadget()
-            : samples_to_skip_start_(0), samples_to_skip_end_(0), prepared_(false) {
+            : samples_to_skip_start_(0), samples_to_skip_end_(0) {
     }
 
     SpiralToGenericGadget::~SpiralToGenericGadget() {}
@@ -50,13 +50,12 @@ namespace Gadgetron {
             m2->cont()->release();
         }
 
-        // Compute hoNDArray of trajectory and weights at first pass
+        // Trajectory and weights are computed once for each number of samples and, with GIRF correction, each
+        // slice orientation, and shared between all acquisitions (and connections) that use them.
         //
 
-        if (!prepared_) {
-            prepare_trajectory(*m1->getObjectPtr());
-            prepared_ = true;
-        }
+        auto trajectory = trajectory_parameters.trajectory(*m1->getObjectPtr());
+        const hoNDArray<float>& trajectory_and_weights = trajectory->trajectory_and_weights;
 
         auto samples_per_interleave = trajectory_and_weights.get_size(1);
         // Adjustments based in the incoming data
@@ -70,20 +69,15 @@ namespace Gadgetron {
         // Define some utility variables
         //
 
-        unsigned int samples_to_copy = m1->getObjectPtr()->number_of_samples - samples_to_skip_end_;
         unsigned int interleave = m1->getObjectPtr()->idx.kspace_encode_step_1;
 
-        // Prepare for a new array continuation for the trajectory/weights of the incoming profile
+        // The continuation is a copy of the interleave, as downstream gadgets may modify it; the shared trajectory
+        // is never written to.
         std::vector<size_t> trajectory_dimensions = {trajectory_and_weights.get_size(0),trajectory_and_weights.get_size(1)};
+        const float* traj_source = trajectory_and_weights.get_data_ptr() + 3 * samples_per_interleave * interleave;
 
-        hoNDArray<float> *traj_source = new hoNDArray<float>
-                (&trajectory_dimensions, trajectory_and_weights.get_data_ptr() + 3 * samples_per_interleave * interleave);
-
-        // Make a new array as continuation of m1, and pass along
-        //
-
-        GadgetContainerMessage<hoNDArray<float> > *cont = new GadgetContainerMessage<hoNDArray<float> >();
-        *(cont->getObjectPtr()) = *traj_source;
+        auto cont = new GadgetContainerMessage<hoNDArray<float> >(trajectory_dimensions);
+        std::copy(traj_source, traj_source + 3 * samples_per_interleave, cont->getObjectPtr()->get_data_ptr());
         m2->cont(cont);
 
         //We need to make sure that the trajectory dimensions are attached.
@@ -97,26 +91,5 @@ namespace Gadgetron {
         return GADGET_OK;
     }
 
-    void SpiralToGenericGadget::prepare_trajectory(const ISMRMRD::AcquisitionHeader &acq_header) {
-
-        hoNDArray<floatd2> trajectory;
-        hoNDArray<float> weights;
-        std::tie(trajectory,weights) = trajectory_parameters.calculate_trajectories_and_weight(acq_header);
-
-        auto traj_dims = *trajectory.get_dimensions();
-        std::vector<size_t> dims = {3};
-        dims.insert(dims.end(),traj_dims.begin(),traj_dims.end());
-
-        trajectory_and_weights = hoNDArray<float>(dims);
-
-        size_t elements = weights.get_number_of_elements();
-        for (size_t i = 0; i < elements; i++){
-            trajectory_and_weights[i*3] = trajectory[i][0];
-            trajectory_and_weights[i*3+1] = trajectory[i][1];
-            trajectory_and_weights[i*3+2] = weights[i];
-        }
-
-    }
-
     GADGET_FACTORY_DECLARE(SpiralToGenericGadget)
 }
@@ -35,13 +35,9 @@ namespace Gadgetron {
 
     private:
 
-        bool prepared_;
-
         int samples_to_skip_start_;
         int samples_to_skip_end_;
-        hoNDArray<float> trajectory_and_weights;
         Spiral::TrajectoryParameters trajectory_parameters;
-        void prepare_trajectory(const ISMRMRD::AcquisitionHeader &acq_header);
 
     };
 }
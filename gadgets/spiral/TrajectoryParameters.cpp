@@ -7,35 +7,139 @@
 #include "TrajectoryParameters.h"
 #include "vector_td_utilities.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace Gadgetron {
     namespace Spiral {
 
-        std::pair<hoNDArray<floatd2>, hoNDArray<float>>
-        TrajectoryParameters::calculate_trajectories_and_weight(const ISMRMRD::AcquisitionHeader &acq_header) {
+        struct TrajectoryParameters::VDS {
+            hoNDArray<floatd2> gradients;
+            std::shared_ptr<const SpiralTrajectory> trajectory;
+        };
+
+        namespace {
+            std::shared_ptr<const SpiralTrajectory>
+            make_trajectory(hoNDArray<floatd2> trajectories, hoNDArray<float> weights) {
+                auto result = std::make_shared<SpiralTrajectory>();
+
+                std::vector<size_t> dims = {3};
+                auto traj_dims = trajectories.dimensions();
+                dims.insert(dims.end(), traj_dims.begin(), traj_dims.end());
+                result->trajectory_and_weights = hoNDArray<float>(dims);
+
+                const floatd2* traj_ptr = trajectories.get_data_ptr();
+                const float* weights_ptr = weights.get_data_ptr();
+                float* out = result->trajectory_and_weights.get_data_ptr();
+
+                size_t elements = weights.get_number_of_elements();
+                for (size_t i = 0; i < elements; i++) {
+                    out[i * 3] = traj_ptr[i][0];
+                    out[i * 3 + 1] = traj_ptr[i][1];
+                    out[i * 3 + 2] = weights_ptr[i];
+                }
+
+                result->trajectories = std::move(trajectories);
+                result->weights = std::move(weights);
+                return result;
+            }
+
+            size_t memory_size(const SpiralTrajectory& trajectory) {
+                return trajectory.trajectories.get_number_of_bytes() + trajectory.weights.get_number_of_bytes() +
+                       trajectory.trajectory_and_weights.get_number_of_bytes();
+            }
+        }
+
+        size_t trajectory_cache_budget() {
+            const char* megabytes = std::getenv("GADGETRON_SPIRAL_CACHE_MB");
+            if (megabytes) return size_t(std::strtoull(megabytes, nullptr, 10)) << 20;
+            return size_t(64) << 20;
+        }
+
+        ContentCache& trajectory_cache() {
+            static ContentCache cache(trajectory_cache_budget());
+            return cache;
+        }
+
+        std::shared_ptr<const TrajectoryParameters::VDS>
+        TrajectoryParameters::calculate_vds_trajectory(const ISMRMRD::AcquisitionHeader &acq_header) {
+
+            ContentKey key = vds_key_;
+            key.add(acq_header.number_of_samples);
+
+            auto cached = trajectory_cache().find<VDS>(key);
+            if (cached) return cached;
+
             int nfov = 1;         /*  number of fov coefficients.             */
             int ngmax = 1e5;       /*  maximum number of gradient samples      */
             double sample_time = (1.0 * Tsamp_ns_) * 1e-9;
 
-
             auto base_gradients = calculate_vds(smax_,gmax_,sample_time,sample_time,Nints_,&fov_,nfov,krmax_,ngmax,acq_header.number_of_samples);
             int samples_per_interleave_ = base_gradients.get_number_of_elements();
 
             GDEBUG("Using %d samples per interleave\n", samples_per_interleave_);
 
-            base_gradients = create_rotations(base_gradients,Nints_);
+            auto vds = std::make_shared<VDS>();
+            vds->gradients = create_rotations(base_gradients,Nints_);
+
+            auto trajectories = calculate_trajectories(vds->gradients,sample_time,krmax_);
+            auto weights = calculate_weights_Hoge(vds->gradients,trajectories);
+            vds->trajectory = make_trajectory(std::move(trajectories), std::move(weights));
+
+            trajectory_cache().insert<VDS>(key, vds, vds->gradients.get_number_of_bytes() + memory_size(*vds->trajectory));
+            return vds;
+        }
 
-            auto trajectories = calculate_trajectories(base_gradients,sample_time,krmax_);
+        std::shared_ptr<const SpiralTrajectory>
+        TrajectoryParameters::trajectory(const ISMRMRD::AcquisitionHeader &acq_header) {
+
+            // GIRF correction depends on the orientation of the slice; the uncorrected trajectory does not.
+            ContentKey key = vds_key_;
+            key.add(acq_header.number_of_samples);
+            if (this->girf_kernel) {
+                key.add(&girf_key_, sizeof(girf_key_));
+                key.add(acq_header.read_dir, sizeof(acq_header.read_dir));
+                key.add(acq_header.phase_dir, sizeof(acq_header.phase_dir));
+                key.add(acq_header.slice_dir, sizeof(acq_header.slice_dir));
+            }
+
+            for (auto entry = trajectories_.begin(); entry != trajectories_.end(); ++entry) {
+                if (entry->first == key) {
+                    std::rotate(trajectories_.begin(), entry, entry + 1);
+                    return trajectories_.front().second;
+                }
+            }
 
-            auto weights = calculate_weights_Hoge(base_gradients,trajectories);
+            std::shared_ptr<const SpiralTrajectory> result;
 
-            if (this->girf_kernel){
-                base_gradients = correct_gradients(base_gradients,Tsamp_ns_*1e-3,this->girf_sampling_time_us,acq_header.read_dir,acq_header.phase_dir,acq_header.slice_dir);
-                //Weights should be calculated without GIRF corrections according to Hoge et al 2005
-                trajectories = calculate_trajectories(base_gradients,sample_time,krmax_);
+            if (!this->girf_kernel) {
+                result = calculate_vds_trajectory(acq_header)->trajectory;
+            } else {
+                result = trajectory_cache().find<SpiralTrajectory>(key);
+                if (!result) {
+                    auto vds = calculate_vds_trajectory(acq_header);
+
+                    double sample_time = (1.0 * Tsamp_ns_) * 1e-9;
+                    auto corrected_gradients = correct_gradients(vds->gradients,Tsamp_ns_*1e-3,this->girf_sampling_time_us,acq_header.read_dir,acq_header.phase_dir,acq_header.slice_dir);
+                    //Weights should be calculated without GIRF corrections according to Hoge et al 2005
+                    auto trajectories = calculate_trajectories(corrected_gradients,sample_time,krmax_);
+                    result = make_trajectory(std::move(trajectories), vds->trajectory->weights);
+
+                    trajectory_cache().insert<SpiralTrajectory>(key, result, memory_size(*result));
+                }
             }
 
-            return std::make_pair(std::move(trajectories), std::move(weights));
+            // Orientations may change every TR (e.g. with prospective motion correction); only the most recent ones
+            // are kept here, the others stay in the budgeted trajectory_cache.
+            trajectories_.emplace(trajectories_.begin(), key, result);
+            if (trajectories_.size() > max_recent_trajectories) trajectories_.pop_back();
+            return result;
+        }
 
+        std::pair<hoNDArray<floatd2>, hoNDArray<float>>
+        TrajectoryParameters::calculate_trajectories_and_weight(const ISMRMRD::AcquisitionHeader &acq_header) {
+            auto result = trajectory(acq_header);
+            return std::make_pair(result->trajectories, result->weights);
         }
 
 
@@ -87,6 +191,13 @@ namespace Gadgetron {
                 } catch (std::out_of_range exception) { }
             }
 
+            vds_key_.add(std::string("HargreavesVDS2000")).add(Tsamp_ns_).add(Nints_);
+            vds_key_.add(gmax_).add(smax_).add(krmax_).add(fov_);
+
+            if (this->girf_kernel) {
+                girf_key_.add(*this->girf_kernel).add(girf_sampling_time_us).add(TE_);
+            }
+
             GDEBUG("smax:                    %f\n", smax_);
             GDEBUG("gmax:                    %f\n", gmax_);
             GDEBUG("Tsamp_ns:                %d\n", Tsamp_ns_);
@@ -7,15 +7,47 @@
 #include "vds.h"
 #include "armadillo"
 #include <mri_core_girf_correction.h>
+#include "hoContentCache.h"
+
+#include <memory>
+#include <vector>
 
 namespace Gadgetron {
 namespace Spiral {
 
+    /**
+        Trajectory and density compensation weights of all interleaves. Shared between gadgets and never modified.
+    */
+    struct SpiralTrajectory {
+        hoNDArray<floatd2> trajectories;         // [samples, interleaves]
+        hoNDArray<float> weights;                // [samples, interleaves]
+        hoNDArray<float> trajectory_and_weights; // [3, samples, interleaves]: kx, ky and weight of each sample
+    };
+
+    /**
+        Spiral trajectories of all TrajectoryParameters in the process, keyed by the VDS parameters and the number of
+        samples. With GIRF correction, the key also includes the GIRF kernel and the slice orientation, and the
+        uncorrected trajectory is shared by all orientations.
+
+        The memory budget is GADGETRON_SPIRAL_CACHE_MB megabytes (64 if not set; 0 disables the cache).
+    */
+    ContentCache& trajectory_cache();
+
+    /// The budget trajectory_cache starts out with, from GADGETRON_SPIRAL_CACHE_MB.
+    size_t trajectory_cache_budget();
+
     class TrajectoryParameters {
     public:
         TrajectoryParameters() = default;
         TrajectoryParameters(const ISMRMRD::IsmrmrdHeader &h);
 
+        /**
+            The trajectory for the number of samples and, with GIRF correction, the slice orientation of acq_header.
+            The few most recently used trajectories are kept by this object; others are found in trajectory_cache or
+            computed again. The result stays valid for as long as it is held.
+        */
+        std::shared_ptr<const SpiralTrajectory> trajectory(const ISMRMRD::AcquisitionHeader &acq_header);
+
         std::pair<hoNDArray<floatd2>, hoNDArray<float>>
         calculate_trajectories_and_weight(const ISMRMRD::AcquisitionHeader &acq_header);
 
@@ -30,6 +62,16 @@ namespace Spiral {
         double fov_;
         float TE_;
 
+        ContentKey vds_key_;
+        ContentKey girf_key_;
+        // Most recently used first
+        std::vector<std::pair<ContentKey, std::shared_ptr<const SpiralTrajectory>>> trajectories_;
+        static constexpr size_t max_recent_trajectories = 4;
+
+        /// Rotated VDS gradients, and the trajectory without GIRF correction.
+        struct VDS;
+        std::shared_ptr<const VDS> calculate_vds_trajectory(const ISMRMRD::AcquisitionHeader &acq_header);
+
         hoNDArray<floatd2> correct_gradients(const hoNDArray<floatd2> &gradients, float grad_samp_us,
                                              float girf_samp_us, const float *read_dir, const float *phase_dir,
                                              const float *slice_dir);
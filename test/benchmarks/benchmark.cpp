@@ -0,0 +1,498 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+#ifndef GADGETRON_BENCHMARK_VERSION
+#define GADGETRON_BENCHMARK_VERSION "unknown"
+#endif
+
+#ifndef GADGETRON_BENCHMARK_GIT_SHA1
+#define GADGETRON_BENCHMARK_GIT_SHA1 "NA"
+#endif
+
+namespace Gadgetron { namespace Benchmark {
+
+    namespace {
+
+        double real_seconds() {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Process time, so work handed to OpenMP or worker threads is included.
+        double cpu_seconds() {
+            return double(std::clock()) / CLOCKS_PER_SEC;
+        }
+
+        std::vector<std::unique_ptr<Definition>> &registry() {
+            static std::vector<std::unique_ptr<Definition>> definitions;
+            return definitions;
+        }
+
+        struct Options {
+            std::string filter = ".*";
+            std::string format = "console";
+            std::string out;
+            double min_time = 0.5;
+            size_t repetitions = 1;
+            bool list = false;
+        };
+
+        struct Run {
+            std::string name;
+            std::string run_name;
+            std::string aggregate_name; ///< Empty for iterations.
+            size_t repetition_index = 0;
+            size_t repetitions = 1;
+            int64_t iterations = 0;
+            double real_time = 0; ///< Per iteration, in time_unit.
+            double cpu_time = 0;
+            TimeUnit time_unit = TimeUnit::microsecond;
+            double items_per_second = 0;
+            double bytes_per_second = 0;
+            std::string label;
+            std::string error;
+        };
+
+        const char *unit_name(TimeUnit unit) {
+            switch (unit) {
+                case TimeUnit::nanosecond: return "ns";
+                case TimeUnit::millisecond: return "ms";
+                default: return "us";
+            }
+        }
+
+        double unit_multiplier(TimeUnit unit) {
+            switch (unit) {
+                case TimeUnit::nanosecond: return 1e9;
+                case TimeUnit::millisecond: return 1e3;
+                default: return 1e6;
+            }
+        }
+
+        std::string run_name(const Definition &definition, const std::vector<int64_t> &arguments) {
+            std::string name = definition.name;
+            for (auto argument : arguments) name += "/" + std::to_string(argument);
+            return name;
+        }
+
+        bool parse_flag(const char *argument, const char *flag, std::string &value) {
+            auto length = std::strlen(flag);
+            if (std::strncmp(argument, flag, length) != 0 || argument[length] != '=') return false;
+            value = argument + length + 1;
+            return true;
+        }
+
+        Options parse_options(int argc, char **argv) {
+            Options options;
+            for (int i = 1; i < argc; i++) {
+                std::string value;
+                if (parse_flag(argv[i], "--benchmark_filter", value)) {
+                    options.filter = value;
+                } else if (parse_flag(argv[i], "--benchmark_format", value)) {
+                    options.format = value;
+                } else if (parse_flag(argv[i], "--benchmark_out", value)) {
+                    options.out = value;
+                } else if (parse_flag(argv[i], "--benchmark_min_time", value)) {
+                    options.min_time = std::stod(value);
+                } else if (parse_flag(argv[i], "--benchmark_repetitions", value)) {
+                    options.repetitions = std::max<size_t>(1, std::stoul(value));
+                } else if (std::strcmp(argv[i], "--benchmark_list_tests") == 0) {
+                    options.list = true;
+                } else {
+                    throw std::invalid_argument(std::string("Unknown argument: ") + argv[i]);
+                }
+            }
+            if (options.format != "console" && options.format != "json")
+                throw std::invalid_argument("Unknown format: " + options.format);
+            return options;
+        }
+
+        void per_iteration(Run &run) {
+            auto multiplier = unit_multiplier(run.time_unit);
+            run.real_time = run.real_time * multiplier / run.iterations;
+            run.cpu_time = run.cpu_time * multiplier / run.iterations;
+        }
+
+        template<class F> double statistic(const std::vector<Run> &runs, F field, const std::string &name) {
+            std::vector<double> values;
+            for (auto &run : runs) values.push_back(field(run));
+
+            auto mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+            if (name == "mean") return mean;
+
+            if (name == "median") {
+                std::sort(values.begin(), values.end());
+                auto middle = values.size() / 2;
+                return values.size() % 2 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+            }
+
+            if (values.size() < 2) return 0;
+            double sum = 0;
+            for (auto value : values) sum += (value - mean) * (value - mean);
+            return std::sqrt(sum / (values.size() - 1));
+        }
+
+        std::vector<Run> aggregates(const std::vector<Run> &runs) {
+            std::vector<Run> result;
+            for (std::string name : { "mean", "median", "stddev" }) {
+                Run aggregate = runs.front();
+                aggregate.name = aggregate.run_name + "_" + name;
+                aggregate.aggregate_name = name;
+                aggregate.iterations = int64_t(runs.size());
+                aggregate.real_time = statistic(runs, [](const Run &run) { return run.real_time; }, name);
+                aggregate.cpu_time = statistic(runs, [](const Run &run) { return run.cpu_time; }, name);
+                aggregate.items_per_second =
+                        statistic(runs, [](const Run &run) { return run.items_per_second; }, name);
+                aggregate.bytes_per_second =
+                        statistic(runs, [](const Run &run) { return run.bytes_per_second; }, name);
+                result.push_back(aggregate);
+            }
+            return result;
+        }
+
+        std::string escape(const std::string &text) {
+            std::string result;
+            for (auto c : text) {
+                switch (c) {
+                    case '"': result += "\\\""; break;
+                    case '\\': result += "\\\\"; break;
+                    case '\n': result += "\\n"; break;
+                    case '\t': result += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char escaped[8];
+                            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                            result += escaped;
+                        } else {
+                            result += c;
+                        }
+                }
+            }
+            return result;
+        }
+
+        std::string date() {
+            auto time = std::time(nullptr);
+            char buffer[64];
+            std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&time));
+            return buffer;
+        }
+
+        class Reporter {
+        public:
+            virtual ~Reporter() = default;
+            virtual void begin(const char *executable) = 0;
+            virtual void report(const Run &run) = 0;
+            virtual void end() = 0;
+        };
+
+        class ConsoleReporter : public Reporter {
+        public:
+            explicit ConsoleReporter(std::ostream &stream) : stream(stream) {}
+
+            void begin(const char *) override {
+                stream << date() << "\nRunning on " << std::thread::hardware_concurrency() << " CPUs, gadgetron "
+                       << GADGETRON_BENCHMARK_VERSION << " (" << GADGETRON_BENCHMARK_GIT_SHA1 << ")\n";
+                stream << std::string(100, '-') << "\n";
+                stream << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(16) << "Time"
+                       << std::setw(16) << "CPU" << std::setw(12) << "Iterations"
+                       << "  Throughput\n";
+                stream << std::string(100, '-') << "\n";
+            }
+
+            void report(const Run &run) override {
+                stream << std::left << std::setw(48) << run.name << std::right;
+                if (!run.error.empty()) {
+                    stream << "ERROR: " << run.error << "\n";
+                    return;
+                }
+                stream << std::fixed << std::setprecision(run.real_time < 10 ? 3 : 1) << std::setw(13)
+                       << run.real_time << " " << unit_name(run.time_unit) << std::setw(13) << run.cpu_time << " "
+                       << unit_name(run.time_unit) << std::setw(12) << run.iterations;
+                if (run.items_per_second > 0) stream << "  " << human_readable(run.items_per_second) << " items/s";
+                if (run.bytes_per_second > 0) stream << "  " << human_readable(run.bytes_per_second) << "B/s";
+                if (!run.label.empty()) stream << "  " << run.label;
+                stream << "\n";
+                stream.unsetf(std::ios::floatfield);
+            }
+
+            void end() override { stream.flush(); }
+
+        private:
+            static std::string human_readable(double value) {
+                const char *prefixes[] = { "", "k", "M", "G", "T" };
+                size_t prefix = 0;
+                while (value >= 1000 && prefix < 4) {
+                    value /= 1000;
+                    prefix++;
+                }
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(2) << value << prefixes[prefix];
+                return text.str();
+            }
+
+            std::ostream &stream;
+        };
+
+        class JsonReporter : public Reporter {
+        public:
+            explicit JsonReporter(std::ostream &stream) : stream(stream) {}
+
+            void begin(const char *executable) override {
+                stream << "{\n  \"context\": {\n";
+                stream << "    \"date\": \"" << escape(date()) << "\",\n";
+                stream << "    \"executable\": \"" << escape(executable) << "\",\n";
+                stream << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+                stream << "    \"gadgetron_version\": \"" << GADGETRON_BENCHMARK_VERSION << "\",\n";
+                stream << "    \"gadgetron_git_sha1\": \"" << GADGETRON_BENCHMARK_GIT_SHA1 << "\",\n";
+#ifdef NDEBUG
+                stream << "    \"library_build_type\": \"release\"\n";
+#else
+                stream << "    \"library_build_type\": \"debug\"\n";
+#endif
+                stream << "  },\n  \"benchmarks\": [";
+            }
+
+            void report(const Run &run) override {
+                stream << (first ? "\n" : ",\n") << "    {\n";
+                first = false;
+
+                stream << "      \"name\": \"" << escape(run.name) << "\",\n";
+                stream << "      \"run_name\": \"" << escape(run.run_name) << "\",\n";
+                if (run.aggregate_name.empty()) {
+                    stream << "      \"run_type\": \"iteration\",\n";
+                } else {
+                    stream << "      \"run_type\": \"aggregate\",\n";
+                    stream << "      \"aggregate_name\": \"" << run.aggregate_name << "\",\n";
+                }
+                stream << "      \"repetitions\": " << run.repetitions << ",\n";
+                stream << "      \"repetition_index\": " << run.repetition_index << ",\n";
+                stream << "      \"threads\": 1,\n";
+                if (!run.error.empty()) {
+                    stream << "      \"error_occurred\": true,\n";
+                    stream << "      \"error_message\": \"" << escape(run.error) << "\"\n    }";
+                    return;
+                }
+                stream << std::setprecision(10);
+                stream << "      \"iterations\": " << run.iterations << ",\n";
+                stream << "      \"real_time\": " << run.real_time << ",\n";
+                stream << "      \"cpu_time\": " << run.cpu_time << ",\n";
+                stream << "      \"time_unit\": \"" << unit_name(run.time_unit) << "\"";
+                if (run.items_per_second > 0) stream << ",\n      \"items_per_second\": " << run.items_per_second;
+                if (run.bytes_per_second > 0) stream << ",\n      \"bytes_per_second\": " << run.bytes_per_second;
+                if (!run.label.empty()) stream << ",\n      \"label\": \"" << escape(run.label) << "\"";
+                stream << "\n    }";
+            }
+
+            void end() override {
+                stream << "\n  ]\n}\n";
+                stream.flush();
+            }
+
+        private:
+            std::ostream &stream;
+            bool first = true;
+        };
+    }
+
+    State::State(int64_t iterations, std::vector<int64_t> ranges)
+        : max_iterations(iterations), ranges(std::move(ranges)) {}
+
+    State::Iterator State::begin() {
+        started = true;
+        resume_timing();
+        return Iterator(this);
+    }
+
+    void State::finish() {
+        if (finished) return;
+        if (running) pause_timing();
+        finished = true;
+    }
+
+    void State::pause_timing() {
+        if (!running) return;
+        real_time += real_seconds() - real_start;
+        cpu_time += cpu_seconds() - cpu_start;
+        running = false;
+    }
+
+    void State::resume_timing() {
+        if (running) return;
+        running = true;
+        cpu_start = cpu_seconds();
+        real_start = real_seconds();
+    }
+
+    void State::skip_with_error(std::string message) {
+        error = std::move(message);
+        pause_timing();
+    }
+
+    Definition *register_benchmark(std::string name, std::function<void(State &)> function) {
+        registry().push_back(std::make_unique<Definition>(std::move(name), std::move(function)));
+        return registry().back().get();
+    }
+
+    class Runner {
+    public:
+        static int run(int argc, char **argv) {
+            Options options;
+            try {
+                options = parse_options(argc, argv);
+            } catch (const std::exception &e) {
+                std::cerr << e.what() << "\n"
+                          << "Usage: " << argv[0]
+                          << " [--benchmark_filter=<regex>] [--benchmark_format=console|json]"
+                             " [--benchmark_out=<file>] [--benchmark_min_time=<seconds>]"
+                             " [--benchmark_repetitions=<n>] [--benchmark_list_tests]\n";
+                return 1;
+            }
+
+            const std::regex filter(options.filter);
+            std::vector<std::pair<const Definition *, std::vector<int64_t>>> selected;
+            for (auto &definition : registry()) {
+                auto argument_sets = definition->argument_sets;
+                if (argument_sets.empty()) argument_sets.emplace_back();
+                for (auto &arguments : argument_sets) {
+                    if (std::regex_search(run_name(*definition, arguments), filter))
+                        selected.emplace_back(definition.get(), arguments);
+                }
+            }
+
+            if (options.list) {
+                for (auto &benchmark : selected) std::cout << run_name(*benchmark.first, benchmark.second) << "\n";
+                return 0;
+            }
+
+            std::vector<std::unique_ptr<Reporter>> reporters;
+            if (options.format == "json") {
+                reporters.push_back(std::make_unique<JsonReporter>(std::cout));
+            } else {
+                reporters.push_back(std::make_unique<ConsoleReporter>(std::cout));
+            }
+
+            std::ofstream out;
+            if (!options.out.empty()) {
+                out.open(options.out);
+                if (!out) {
+                    std::cerr << "Unable to open " << options.out << " for writing\n";
+                    return 1;
+                }
+                reporters.push_back(std::make_unique<JsonReporter>(out));
+            }
+
+            for (auto &reporter : reporters) reporter->begin(argv[0]);
+
+            bool failed = false;
+            for (auto &benchmark : selected) {
+                auto runs = run_benchmark(*benchmark.first, benchmark.second, options);
+                for (auto &run : runs) {
+                    failed = failed || !run.error.empty();
+                    for (auto &reporter : reporters) reporter->report(run);
+                }
+            }
+
+            for (auto &reporter : reporters) reporter->end();
+            return failed ? 1 : 0;
+        }
+
+    private:
+        static Run measure(const Definition &definition, const std::vector<int64_t> &arguments, int64_t iterations) {
+            State state(iterations, arguments);
+            definition.function(state);
+
+            Run run;
+            run.name = run.run_name = run_name(definition, arguments);
+            run.time_unit = definition.time_unit;
+            run.label = state.label;
+            run.error = state.error;
+            if (!run.error.empty()) return run;
+            if (!state.finished) {
+                run.error = "The benchmark did not iterate over its State";
+                return run;
+            }
+
+            run.iterations = iterations;
+            run.real_time = state.real_time;
+            run.cpu_time = state.cpu_time;
+
+            // Throughput is measured on the clock the iterations were chosen from, like Google Benchmark does.
+            auto seconds = definition.real_time_iterations ? state.real_time : state.cpu_time;
+            if (seconds > 0) {
+                run.items_per_second = state.items_processed / seconds;
+                run.bytes_per_second = state.bytes_processed / seconds;
+            }
+            return run;
+        }
+
+        static int64_t find_iterations(const Definition &definition, const std::vector<int64_t> &arguments,
+                                       const Options &options, Run &failure) {
+            const int64_t max_iterations = 1000000000;
+            int64_t iterations = 1;
+            while (true) {
+                auto run = measure(definition, arguments, iterations);
+                if (!run.error.empty()) {
+                    failure = run;
+                    return 0;
+                }
+
+                auto seconds = definition.real_time_iterations ? run.real_time : run.cpu_time;
+                if (seconds >= options.min_time || iterations >= max_iterations) return iterations;
+
+                double multiplier = seconds > 0 ? std::min(10.0, 1.4 * options.min_time / seconds) : 10.0;
+                iterations = std::min(max_iterations, std::max(iterations + 1, int64_t(iterations * multiplier)));
+            }
+        }
+
+        static std::vector<Run> run_benchmark(const Definition &definition, const std::vector<int64_t> &arguments,
+                                              const Options &options) {
+            Run failure;
+            std::vector<Run> runs;
+            try {
+                // The last run of the search is the warm up; it is not reported.
+                auto iterations = find_iterations(definition, arguments, options, failure);
+                if (!iterations) return { failure };
+
+                for (size_t repetition = 0; repetition < options.repetitions; repetition++) {
+                    auto run = measure(definition, arguments, iterations);
+                    if (!run.error.empty()) return { run };
+                    run.repetition_index = repetition;
+                    run.repetitions = options.repetitions;
+                    per_iteration(run);
+                    runs.push_back(run);
+                }
+            } catch (const std::exception &e) {
+                failure.name = failure.run_name = run_name(definition, arguments);
+                failure.error = e.what();
+                return { failure };
+            }
+
+            if (options.repetitions > 1) {
+                auto statistics = aggregates(runs);
+                runs.insert(runs.end(), statistics.begin(), statistics.end());
+            }
+            return runs;
+        }
+    };
+
+    int run(int argc, char **argv) {
+        return Runner::run(argc, argv);
+    }
+
+    // Defined out of line, so the compiler cannot see that the pointer is not used.
+    void use_pointer(const void *) {}
+}}
@@ -0,0 +1,183 @@
+/** \file benchmark.h
+    \brief A small benchmark harness for the gadgetron_benchmarks suite.
+
+    Benchmarks are functions taking a State, registered with GADGETRON_BENCHMARK:
+
+        void fft2c(Benchmark::State& state) {
+            auto data = Benchmark::random_array<std::complex<float>>({ size_t(state.range(0)), 256 });
+            for (auto _ : state) hoNDFFT<float>::instance()->fft2c(data);
+            state.set_items_processed(state.iterations() * data.get_number_of_elements());
+        }
+        GADGETRON_BENCHMARK(fft2c)->arg(128)->arg(256);
+
+    Only the body of the loop is timed. The number of iterations is chosen so each run takes at least --min_time
+    seconds, after a run of the same size that is thrown away as warm up. The JSON output follows the schema of
+    Google Benchmark, so its tools (e.g. compare.py) can be used to compare two releases.
+*/
+
+#pragma once
+
+#include "hoNDArray.h"
+
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__)
+#define GADGETRON_BENCHMARK_UNUSED __attribute__((unused))
+#else
+#define GADGETRON_BENCHMARK_UNUSED
+#endif
+
+namespace Gadgetron { namespace Benchmark {
+
+    class State {
+    public:
+        State(int64_t iterations, std::vector<int64_t> ranges);
+
+        /// The argument at index, as given by Definition::arg or Definition::args.
+        int64_t range(size_t index = 0) const { return ranges.at(index); }
+
+        int64_t iterations() const { return max_iterations; }
+
+        /// Stops the clocks, e.g. to restore input data overwritten by the previous iteration.
+        void pause_timing();
+        void resume_timing();
+
+        void set_items_processed(int64_t items) { items_processed = items; }
+        void set_bytes_processed(int64_t bytes) { bytes_processed = bytes; }
+        void set_label(std::string text) { label = std::move(text); }
+
+        void skip_with_error(std::string message);
+
+        class Iterator {
+        public:
+            explicit Iterator(State *state) : state(state), remaining(state ? state->max_iterations : 0) {}
+
+            // The loop variable of for (auto _ : state) is never used.
+            struct GADGETRON_BENCHMARK_UNUSED Value {};
+            Value operator*() const { return {}; }
+            Iterator &operator++() {
+                remaining--;
+                return *this;
+            }
+            bool operator!=(const Iterator &) {
+                if (remaining > 0) return true;
+                state->finish();
+                return false;
+            }
+
+        private:
+            State *state;
+            int64_t remaining;
+        };
+
+        Iterator begin();
+        Iterator end() { return Iterator(nullptr); }
+
+    private:
+        friend class Runner;
+        void finish();
+
+        const int64_t max_iterations;
+        const std::vector<int64_t> ranges;
+
+        bool running = false;
+        bool started = false;
+        bool finished = false;
+        double real_time = 0, cpu_time = 0;
+        double real_start = 0, cpu_start = 0;
+
+        int64_t items_processed = 0;
+        int64_t bytes_processed = 0;
+        std::string label;
+        std::string error;
+    };
+
+    enum class TimeUnit { nanosecond, microsecond, millisecond };
+
+    class Definition {
+    public:
+        Definition(std::string name, std::function<void(State &)> function)
+            : name(std::move(name)), function(std::move(function)) {}
+
+        /// Runs the benchmark once more, with range(0) == value.
+        Definition *arg(int64_t value) { return args({ value }); }
+
+        /// Runs the benchmark once more, with range(i) == values[i].
+        Definition *args(std::vector<int64_t> values) {
+            argument_sets.push_back(std::move(values));
+            return this;
+        }
+
+        Definition *unit(TimeUnit time_unit) {
+            this->time_unit = time_unit;
+            return this;
+        }
+
+        /// Chooses the number of iterations from the wall clock rather than CPU time, for benchmarks that wait.
+        Definition *use_real_time() {
+            real_time_iterations = true;
+            return this;
+        }
+
+        const std::string name;
+        const std::function<void(State &)> function;
+        std::vector<std::vector<int64_t>> argument_sets;
+        TimeUnit time_unit = TimeUnit::microsecond;
+        bool real_time_iterations = false;
+    };
+
+    Definition *register_benchmark(std::string name, std::function<void(State &)> function);
+
+    /// Runs the registered benchmarks selected by the command line. Returns the exit code of the program.
+    int run(int argc, char **argv);
+
+    void use_pointer(const void *pointer);
+
+    /// Prevents the compiler from optimising away the computation of value.
+    template<class T> inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        use_pointer(&value);
+#endif
+    }
+
+    /// Benchmark data is random, but the same from run to run.
+    constexpr unsigned int seed = 4242;
+
+    template<class T> void fill_random(hoNDArray<T> &array, unsigned int seed = Benchmark::seed) {
+        std::mt19937 engine(seed);
+        std::normal_distribution<float> distribution;
+        for (auto &value : array) {
+            value = T(distribution(engine));
+        }
+    }
+
+    template<class T> void fill_random(hoNDArray<std::complex<T>> &array, unsigned int seed = Benchmark::seed) {
+        std::mt19937 engine(seed);
+        std::normal_distribution<T> distribution;
+        for (auto &value : array) {
+            auto real = distribution(engine);
+            value = std::complex<T>(real, distribution(engine));
+        }
+    }
+
+    template<class T> hoNDArray<T> random_array(const std::vector<size_t> &dimensions,
+                                                unsigned int seed = Benchmark::seed) {
+        hoNDArray<T> array(dimensions);
+        fill_random(array, seed);
+        return array;
+    }
+}}
+
+#define GADGETRON_BENCHMARK_CONCAT_(a, b) a##b
+#define GADGETRON_BENCHMARK_CONCAT(a, b) GADGETRON_BENCHMARK_CONCAT_(a, b)
+
+#define GADGETRON_BENCHMARK(function)                                                                                  \
+    static ::Gadgetron::Benchmark::Definition *GADGETRON_BENCHMARK_CONCAT(benchmark_definition_, __LINE__) =          \
+        ::Gadgetron::Benchmark::register_benchmark(#function, function)
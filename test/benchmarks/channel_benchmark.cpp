@@ -0,0 +1,42 @@
+#include "benchmark.h"
+
+#include "BoundedMPMCChannel.h"
+#include "MPMCChannel.h"
+
+#include <thread>
+
+using namespace Gadgetron;
+using namespace Gadgetron::Core;
+
+namespace {
+
+    // One message per iteration, handed from range(0) producer threads to the benchmark thread.
+    template<class CHANNEL> void throughput(Benchmark::State &state, CHANNEL &channel) {
+        auto producers = state.range(0);
+
+        std::vector<std::thread> threads;
+        for (int64_t p = 0; p < producers; p++) {
+            auto messages = state.iterations() / producers + (p < state.iterations() % producers ? 1 : 0);
+            threads.emplace_back([&channel, messages]() {
+                for (int64_t i = 0; i < messages; i++) channel.push(i);
+            });
+        }
+
+        for (auto _ : state) Benchmark::do_not_optimize(channel.pop());
+        for (auto &thread : threads) thread.join();
+
+        state.set_items_processed(state.iterations());
+    }
+
+    void mpmc_channel(Benchmark::State &state) {
+        MPMCChannel<int64_t> channel;
+        throughput(state, channel);
+    }
+    GADGETRON_BENCHMARK(mpmc_channel)->arg(1)->arg(4)->unit(Benchmark::TimeUnit::nanosecond)->use_real_time();
+
+    void bounded_mpmc_channel(Benchmark::State &state) {
+        BoundedMPMCChannel<int64_t> channel(1024);
+        throughput(state, channel);
+    }
+    GADGETRON_BENCHMARK(bounded_mpmc_channel)->arg(1)->arg(4)->unit(Benchmark::TimeUnit::nanosecond)->use_real_time();
+}
@@ -0,0 +1,22 @@
+#include "benchmark.h"
+
+#include "mri_core_coil_map_estimation.h"
+
+using namespace Gadgetron;
+
+namespace {
+
+    void coil_map_2d_Inati(Benchmark::State &state) {
+        auto size = size_t(state.range(0)), coils = size_t(state.range(1));
+        auto images = Benchmark::random_array<std::complex<float>>({ size, size, coils });
+        hoNDArray<std::complex<float>> coil_map;
+
+        for (auto _ : state) Gadgetron::coil_map_2d_Inati(images, coil_map);
+        state.set_items_processed(state.iterations() * images.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(coil_map_2d_Inati)
+            ->args({ 128, 16 })
+            ->args({ 256, 16 })
+            ->args({ 256, 32 })
+            ->unit(Benchmark::TimeUnit::millisecond);
+}
@@ -0,0 +1,56 @@
+#include "benchmark.h"
+
+#include "hoNDArray_elemwise.h"
+
+using namespace Gadgetron;
+
+namespace {
+
+    template<class F> void binary(Benchmark::State &state, F operation) {
+        auto elements = size_t(state.range(0));
+        auto x = Benchmark::random_array<std::complex<float>>({ elements });
+        auto y = Benchmark::random_array<std::complex<float>>({ elements }, Benchmark::seed + 1);
+        hoNDArray<std::complex<float>> r(elements);
+
+        for (auto _ : state) operation(x, y, r);
+        state.set_items_processed(state.iterations() * elements);
+        state.set_bytes_processed(state.iterations() * 3 * x.get_number_of_bytes());
+    }
+
+    void elemwise_add(Benchmark::State &state) {
+        binary(state, [](const auto &x, const auto &y, auto &r) { Gadgetron::add(x, y, r); });
+    }
+    GADGETRON_BENCHMARK(elemwise_add)->arg(1 << 16)->arg(1 << 22);
+
+    void elemwise_multiply(Benchmark::State &state) {
+        binary(state, [](const auto &x, const auto &y, auto &r) { Gadgetron::multiply(x, y, r); });
+    }
+    GADGETRON_BENCHMARK(elemwise_multiply)->arg(1 << 16)->arg(1 << 22);
+
+    void elemwise_multiplyConj(Benchmark::State &state) {
+        binary(state, [](const auto &x, const auto &y, auto &r) { Gadgetron::multiplyConj(x, y, r); });
+    }
+    GADGETRON_BENCHMARK(elemwise_multiplyConj)->arg(1 << 16)->arg(1 << 22);
+
+    void elemwise_abs(Benchmark::State &state) {
+        auto elements = size_t(state.range(0));
+        auto x = Benchmark::random_array<std::complex<float>>({ elements });
+        hoNDArray<float> r(elements);
+
+        for (auto _ : state) Gadgetron::abs(x, r);
+        state.set_items_processed(state.iterations() * elements);
+        state.set_bytes_processed(state.iterations() * (x.get_number_of_bytes() + r.get_number_of_bytes()));
+    }
+    GADGETRON_BENCHMARK(elemwise_abs)->arg(1 << 16)->arg(1 << 22);
+
+    void elemwise_axpy(Benchmark::State &state) {
+        auto elements = size_t(state.range(0));
+        auto x = Benchmark::random_array<std::complex<float>>({ elements });
+        auto y = Benchmark::random_array<std::complex<float>>({ elements }, Benchmark::seed + 1);
+
+        for (auto _ : state) Gadgetron::axpy(std::complex<float>(1e-3f, 0), x, y);
+        state.set_items_processed(state.iterations() * elements);
+        state.set_bytes_processed(state.iterations() * 3 * x.get_number_of_bytes());
+    }
+    GADGETRON_BENCHMARK(elemwise_axpy)->arg(1 << 16)->arg(1 << 22);
+}
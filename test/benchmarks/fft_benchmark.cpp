@@ -0,0 +1,34 @@
+#include "benchmark.h"
+
+#include "hoNDFFT.h"
+
+using namespace Gadgetron;
+
+namespace {
+
+    // [N 512] transforms along the first dimension, as for readout lines.
+    void fft1c(Benchmark::State &state) {
+        auto data = Benchmark::random_array<std::complex<float>>({ size_t(state.range(0)), 512 });
+        for (auto _ : state) hoNDFFT<float>::instance()->fft1c(data);
+        state.set_items_processed(state.iterations() * data.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(fft1c)->arg(256)->arg(1024);
+
+    // [N N 16], a slice of 16 coils.
+    void fft2c(Benchmark::State &state) {
+        auto size = size_t(state.range(0));
+        auto data = Benchmark::random_array<std::complex<float>>({ size, size, 16 });
+        for (auto _ : state) hoNDFFT<float>::instance()->fft2c(data);
+        state.set_items_processed(state.iterations() * data.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(fft2c)->arg(128)->arg(256);
+
+    // [N N N 4]
+    void fft3c(Benchmark::State &state) {
+        auto size = size_t(state.range(0));
+        auto data = Benchmark::random_array<std::complex<float>>({ size, size, size, 4 });
+        for (auto _ : state) hoNDFFT<float>::instance()->fft3c(data);
+        state.set_items_processed(state.iterations() * data.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(fft3c)->arg(64)->arg(128)->unit(Benchmark::TimeUnit::millisecond);
+}
@@ -0,0 +1,73 @@
+#include "benchmark.h"
+
+#include "mri_core_grappa.h"
+
+using namespace Gadgetron;
+
+namespace {
+
+    const size_t RO = 256, E1 = 256, acs_lines = 32, acceleration = 4;
+    const size_t kRO = 5, kNE1 = 4;
+    const double threshold = 5e-4;
+
+    struct Kernel {
+        std::vector<int> kE1, oE1;
+        size_t convKRO = 0, convKE1 = 0;
+        hoNDArray<std::complex<float>> ker;
+    };
+
+    Kernel calibrate(const hoNDArray<std::complex<float>> &acs) {
+        Kernel kernel;
+        grappa2d_kerPattern(kernel.kE1, kernel.oE1, kernel.convKRO, kernel.convKE1, acceleration, kRO, kNE1, false);
+        Gadgetron::grappa2d_calib(acs, acs, threshold, kRO, kernel.kE1, kernel.oE1, 0, RO - 1, 0, acs_lines - 1, kernel.ker);
+        return kernel;
+    }
+
+    // Fully sampled k-space with every acceleration'th line kept.
+    hoNDArray<std::complex<float>> undersampled_kspace(size_t coils) {
+        auto kspace = Benchmark::random_array<std::complex<float>>({ RO, E1, coils });
+        for (size_t coil = 0; coil < coils; coil++) {
+            for (size_t e1 = 0; e1 < E1; e1++) {
+                if (e1 % acceleration == 0) continue;
+                for (size_t ro = 0; ro < RO; ro++) kspace(ro, e1, coil) = 0;
+            }
+        }
+        return kspace;
+    }
+
+    void grappa2d_calib(Benchmark::State &state) {
+        auto acs = Benchmark::random_array<std::complex<float>>({ RO, acs_lines, size_t(state.range(0)) });
+        for (auto _ : state) Benchmark::do_not_optimize(calibrate(acs));
+    }
+    GADGETRON_BENCHMARK(grappa2d_calib)->arg(16)->arg(32)->unit(Benchmark::TimeUnit::millisecond);
+
+    void grappa2d_recon(Benchmark::State &state) {
+        auto coils = size_t(state.range(0));
+        auto kernel = calibrate(Benchmark::random_array<std::complex<float>>({ RO, acs_lines, coils }));
+        auto undersampled = undersampled_kspace(coils);
+        auto kspace = undersampled;
+
+        for (auto _ : state) {
+            Gadgetron::grappa2d_recon(kspace, kernel.ker, kRO, kernel.kE1, kernel.oE1, true);
+
+            state.pause_timing();
+            kspace = undersampled;
+            state.resume_timing();
+        }
+        state.set_items_processed(state.iterations() * RO * E1 * coils);
+    }
+    GADGETRON_BENCHMARK(grappa2d_recon)->arg(16)->arg(32)->unit(Benchmark::TimeUnit::millisecond);
+
+    // Applying the unmixing coefficients to [RO E1 coils N] aliased images, as the GRAPPA recon gadgets do.
+    void unmixing(Benchmark::State &state) {
+        auto coils = size_t(state.range(0)), images = size_t(state.range(1));
+        auto aliased = Benchmark::random_array<std::complex<float>>({ RO, E1, coils, images });
+        auto coefficients = Benchmark::random_array<std::complex<float>>({ RO, E1, coils }, Benchmark::seed + 1);
+        hoNDArray<std::complex<float>> unmixed;
+
+        for (auto _ : state) apply_unmix_coeff_aliased_image(aliased, coefficients, unmixed);
+        state.set_items_processed(state.iterations() * aliased.get_number_of_elements());
+        state.set_bytes_processed(state.iterations() * (aliased.get_number_of_bytes() + unmixed.get_number_of_bytes()));
+    }
+    GADGETRON_BENCHMARK(unmixing)->args({ 16, 1 })->args({ 32, 1 })->args({ 32, 8 });
+}
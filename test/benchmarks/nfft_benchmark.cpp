@@ -0,0 +1,118 @@
+#include "benchmark.h"
+
+#include "hoNFFT.h"
+#include "hoNFFTOperator.h"
+#include "vector_td_utilities.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Gadgetron;
+
+namespace {
+
+    // A golden angle radial trajectory with N spokes of 2N samples, covering [-0.5, 0.5).
+    hoNDArray<vector_td<float, 2>> radial_trajectory(size_t size) {
+        const size_t spokes = size, samples = 2 * size;
+        const float golden_angle = float(3.14159265358979 * (3.0 - std::sqrt(5.0)));
+
+        hoNDArray<vector_td<float, 2>> trajectory(samples * spokes);
+        for (size_t spoke = 0; spoke < spokes; spoke++) {
+            float angle = spoke * golden_angle;
+            for (size_t sample = 0; sample < samples; sample++) {
+                float radius = (float(sample) - samples / 2) / samples;
+                trajectory(spoke * samples + sample) =
+                        vector_td<float, 2>(radius * std::cos(angle), radius * std::sin(angle));
+            }
+        }
+        return trajectory;
+    }
+
+    hoNDArray<float> radial_density_compensation(const hoNDArray<vector_td<float, 2>> &trajectory) {
+        hoNDArray<float> weights(trajectory.dimensions());
+        for (size_t i = 0; i < trajectory.get_number_of_elements(); i++)
+            weights[i] = std::max(norm(trajectory[i]), 1e-3f);
+        return weights;
+    }
+
+    void nfft_preprocess(Benchmark::State &state) {
+        auto size = size_t(state.range(0));
+        auto trajectory = radial_trajectory(size);
+        hoNFFT_plan<float, 2> plan(vector_td<size_t, 2>(size, size), 2.0f, 3.0f);
+
+        for (auto _ : state) plan.preprocess(trajectory);
+        state.set_items_processed(state.iterations() * trajectory.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(nfft_preprocess)->arg(128)->arg(256)->unit(Benchmark::TimeUnit::millisecond);
+
+    void nfft_compute_backwards(Benchmark::State &state) {
+        auto size = size_t(state.range(0));
+        auto trajectory = radial_trajectory(size);
+        auto weights = radial_density_compensation(trajectory);
+        hoNFFT_plan<float, 2> plan(vector_td<size_t, 2>(size, size), 2.0f, 3.0f);
+        plan.preprocess(trajectory);
+
+        auto data = Benchmark::random_array<std::complex<float>>(trajectory.dimensions());
+        hoNDArray<std::complex<float>> image(size, size);
+
+        for (auto _ : state) plan.compute(data, image, &weights, NFFT_comp_mode::BACKWARDS_NC2C);
+        state.set_items_processed(state.iterations() * data.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(nfft_compute_backwards)->arg(128)->arg(256)->unit(Benchmark::TimeUnit::millisecond);
+
+    void nfft_compute_forwards(Benchmark::State &state) {
+        auto size = size_t(state.range(0));
+        auto trajectory = radial_trajectory(size);
+        hoNFFT_plan<float, 2> plan(vector_td<size_t, 2>(size, size), 2.0f, 3.0f);
+        plan.preprocess(trajectory);
+
+        auto image = Benchmark::random_array<std::complex<float>>({ size, size });
+        hoNDArray<std::complex<float>> data(trajectory.dimensions());
+
+        for (auto _ : state) plan.compute(image, data, nullptr, NFFT_comp_mode::FORWARDS_C2NC);
+        state.set_items_processed(state.iterations() * data.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(nfft_compute_forwards)->arg(128)->arg(256)->unit(Benchmark::TimeUnit::millisecond);
+
+    void nfft_convolve_coils(Benchmark::State &state) {
+        const size_t size = 256;
+        auto coils = size_t(state.range(0));
+        auto trajectory = radial_trajectory(size);
+        hoNFFT_plan<float, 2> plan(vector_td<size_t, 2>(size, size), 2.0f, 3.0f);
+        plan.preprocess(trajectory);
+
+        auto data = Benchmark::random_array<std::complex<float>>({ trajectory.get_number_of_elements(), coils });
+        hoNDArray<std::complex<float>> grid(2 * size, 2 * size, coils);
+
+        for (auto _ : state) plan.convolve(data, grid, NFFT_conv_mode::NC2C);
+        state.set_items_processed(state.iterations() * data.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(nfft_convolve_coils)->arg(1)->arg(8)->arg(32)->unit(Benchmark::TimeUnit::millisecond);
+
+    // The normal operator of the iterative reconstruction, by gridding and degridding, or through the Toeplitz kernel.
+    void nfft_normal_operator(Benchmark::State &state) {
+        const size_t size = 128, coils = 8;
+        auto toeplitz = state.range(0) != 0;
+        auto trajectory = radial_trajectory(size);
+
+        std::vector<size_t> image_dims = { size, size, coils };
+        std::vector<size_t> data_dims = { trajectory.get_number_of_elements(), coils };
+
+        hoNFFTOperator<float, 2> E;
+        E.setup(vector_td<size_t, 2>(size, size), vector_td<size_t, 2>(2 * size, 2 * size), 3.0f);
+        E.set_dcw(boost::make_shared<hoNDArray<float>>(radial_density_compensation(trajectory)));
+        E.set_domain_dimensions(&image_dims);
+        E.set_codomain_dimensions(&data_dims);
+        E.set_toeplitz(toeplitz);
+        E.preprocess(trajectory);
+
+        auto values = Benchmark::random_array<std::complex<float>>(image_dims);
+        auto &image = reinterpret_cast<hoNDArray<float_complext> &>(values);
+        hoNDArray<float_complext> result(image_dims);
+        E.mult_MH_M(&image, &result);
+
+        for (auto _ : state) E.mult_MH_M(&image, &result);
+        state.set_items_processed(state.iterations() * image.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(nfft_normal_operator)->arg(0)->arg(1)->unit(Benchmark::TimeUnit::millisecond);
+}
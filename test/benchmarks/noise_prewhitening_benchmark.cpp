@@ -0,0 +1,27 @@
+#include "benchmark.h"
+
+#include "hoArmadillo.h"
+
+using namespace Gadgetron;
+
+namespace {
+
+    // The prewhitening step of NoiseAdjustGadget: each [samples channels] acquisition is multiplied by the
+    // inverted Cholesky factor of the noise covariance.
+    void noise_prewhitening(Benchmark::State &state) {
+        auto samples = size_t(state.range(0)), channels = size_t(state.range(1));
+        auto acquisition = Benchmark::random_array<std::complex<float>>({ samples, channels });
+
+        auto noise = Benchmark::random_array<std::complex<float>>({ 4 * channels, channels }, Benchmark::seed + 1);
+        arma::cx_fmat noiseM = as_arma_matrix(noise);
+        arma::cx_fmat covariance = noiseM.t() * noiseM / float(noiseM.n_rows);
+        hoNDArray<std::complex<float>> prewhitener(channels, channels);
+        as_arma_matrix(prewhitener) = arma::inv(arma::trimatu(arma::chol(covariance)));
+
+        // Out of place, so repeated iterations do not scale the data towards overflow.
+        hoNDArray<std::complex<float>> whitened(samples, channels);
+        for (auto _ : state) as_arma_matrix(whitened) = as_arma_matrix(acquisition) * as_arma_matrix(prewhitener);
+        state.set_items_processed(state.iterations() * acquisition.get_number_of_elements());
+    }
+    GADGETRON_BENCHMARK(noise_prewhitening)->args({ 256, 16 })->args({ 256, 32 })->args({ 512, 64 });
+}
@@ -0,0 +1,46 @@
+#include "benchmark.h"
+
+#include "Message.h"
+#include "MessageID.h"
+#include "readers/GadgetIsmrmrdReader.h"
+#include "writers/GadgetIsmrmrdWriter.h"
+
+#include <sstream>
+
+using namespace Gadgetron;
+using namespace Gadgetron::Core;
+
+namespace {
+
+    // An acquisition is copied into a message, written to a stream and read back, as it passes between a client
+    // and the server.
+    void acquisition_round_trip(Benchmark::State &state) {
+        ISMRMRD::AcquisitionHeader header{};
+        header.number_of_samples = uint16_t(state.range(0));
+        header.active_channels = header.available_channels = uint16_t(state.range(1));
+        auto data = Benchmark::random_array<std::complex<float>>(
+                { header.number_of_samples, header.active_channels });
+
+        auto reader = GadgetIsmrmrdAcquisitionMessageReader();
+        auto writer = GadgetIsmrmrdAcquisitionMessageWriter();
+
+        std::stringstream stream;
+        size_t bytes = 0;
+        for (auto _ : state) {
+            stream.str(std::string());
+            stream.clear();
+
+            writer.write(stream, Message(Acquisition(header, data, none)));
+            bytes = size_t(stream.tellp());
+
+            if (IO::read<uint16_t>(stream) != GADGET_MESSAGE_ISMRMRD_ACQUISITION) {
+                state.skip_with_error("Unexpected message id");
+                break;
+            }
+            Benchmark::do_not_optimize(reader.read(stream));
+        }
+        state.set_items_processed(state.iterations());
+        state.set_bytes_processed(state.iterations() * int64_t(bytes));
+    }
+    GADGETRON_BENCHMARK(acquisition_round_trip)->args({ 256, 16 })->args({ 512, 32 });
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <numeric>
+#include <thread>
+
+#include "BoundedMPMCChannel.h"
+
+using namespace Gadgetron::Core;
+
+TEST(BoundedMPMCChannelTest, RoundsCapacityToPowerOfTwo) {
+    BoundedMPMCChannel<int> channel{ 5 };
+    EXPECT_EQ(channel.capacity(), 8);
+}
+
+TEST(BoundedMPMCChannelTest, PreservesOrder) {
+    BoundedMPMCChannel<int> channel{ 4 };
+    for (int i = 0; i < 4; i++) channel.push(i);
+    for (int i = 0; i < 4; i++) EXPECT_EQ(channel.pop(), i);
+    EXPECT_FALSE(channel.try_pop());
+}
+
+TEST(BoundedMPMCChannelTest, ReportsSize) {
+    BoundedMPMCChannel<int> channel{ 4 };
+    EXPECT_EQ(channel.size(), 0);
+    channel.push(1);
+    channel.push(2);
+    EXPECT_EQ(channel.size(), 2);
+    channel.pop();
+    EXPECT_EQ(channel.size(), 1);
+}
+
+TEST(BoundedMPMCChannelTest, MoveOnlyTypes) {
+    BoundedMPMCChannel<std::unique_ptr<int>> channel{ 2 };
+    channel.push(std::make_unique<int>(42));
+    EXPECT_EQ(*channel.pop(), 42);
+}
+
+TEST(BoundedMPMCChannelTest, ThrowsWhenClosedAndDrained) {
+    BoundedMPMCChannel<int> channel{ 2 };
+    channel.push(1);
+    channel.close();
+    EXPECT_EQ(channel.pop(), 1);
+    EXPECT_THROW(channel.pop(), ChannelClosed);
+    EXPECT_THROW(channel.push(2), ChannelClosed);
+}
+
+TEST(BoundedMPMCChannelTest, BlocksProducerWhenFull) {
+    BoundedMPMCChannel<int> channel{ 2 };
+    channel.push(0);
+    channel.push(1);
+
+    std::atomic<bool> pushed{ false };
+    std::thread producer([&]() {
+        channel.push(2);
+        pushed = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(pushed);
+    EXPECT_EQ(channel.pop(), 0);
+    producer.join();
+    EXPECT_TRUE(pushed);
+}
+
+TEST(BoundedMPMCChannelTest, ManyProducersManyConsumers) {
+    BoundedMPMCChannel<long> channel{ 16 };
+    const long n_per_producer = 10000;
+    const int n_producers     = 4;
+    const int n_consumers     = 4;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < n_producers; p++) {
+        producers.emplace_back([&]() {
+            for (long i = 1; i <= n_per_producer; i++) channel.push(i);
+        });
+    }
+
+    std::vector<long> sums(n_consumers, 0);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < n_consumers; c++) {
+        consumers.emplace_back([&, c]() {
+            try {
+                while (true) sums[c] += channel.pop();
+            } catch (const ChannelClosed&) {
+            }
+        });
+    }
+
+    for (auto& thread : producers) thread.join();
+    channel.close();
+    for (auto& thread : consumers) thread.join();
+
+    auto total = std::accumulate(sums.begin(), sums.end(), 0L);
+    EXPECT_EQ(total, n_producers * n_per_producer * (n_per_producer + 1) / 2);
+}
@@ -3,6 +3,7 @@
 #include "Message.h"
 #include "Channel.h"
 #include "Types.h"
+#include "parallel/Fanout.h"
 
 TEST(TypeTests, multitype) {
     using namespace Gadgetron::Core;
@@ -227,3 +228,90 @@ TEST(TypeTests, tupletype3) {
 }
 
 
+
+TEST(MessageTests, cloneSharesPayload) {
+    using namespace Gadgetron;
+    using namespace Gadgetron::Core;
+
+    hoNDArray<float> array(64);
+    array.fill(1.0f);
+    auto message = Message(std::move(array));
+    auto clone = message.clone();
+
+    auto& original_chunk = static_cast<const TypedMessageChunk<hoNDArray<float>>&>(*message.messages()[0]);
+    auto& cloned_chunk = static_cast<const TypedMessageChunk<hoNDArray<float>>&>(*clone.messages()[0]);
+    EXPECT_EQ(original_chunk.data().get_data_ptr(), cloned_chunk.data().get_data_ptr());
+}
+
+TEST(MessageTests, unpackMovesOwnedPayload) {
+    using namespace Gadgetron;
+    using namespace Gadgetron::Core;
+
+    hoNDArray<float> array(64);
+    array.fill(1.0f);
+    auto data = array.get_data_ptr();
+
+    auto unpacked = force_unpack<hoNDArray<float>>(Message(std::move(array)));
+    EXPECT_EQ(unpacked.get_data_ptr(), data);
+}
+
+TEST(MessageTests, clonedPayloadIsReadOnly) {
+    using namespace Gadgetron;
+    using namespace Gadgetron::Core;
+
+    hoNDArray<float> array(64);
+    array.fill(1.0f);
+    auto data = array.get_data_ptr();
+    auto message = Message(std::move(array));
+    auto clone = message.clone();
+    auto reader = message.clone();
+
+    // Readers get the shared payload.
+    auto read_only = force_unpack<std::shared_ptr<const hoNDArray<float>>>(std::move(reader));
+    EXPECT_EQ(read_only->get_data_ptr(), data);
+
+    // Taking a read-only payload copies it, even once the other holders are gone.
+    auto modified = force_unpack<hoNDArray<float>>(std::move(clone));
+    EXPECT_NE(modified.get_data_ptr(), data);
+    modified.fill(2.0f);
+
+    read_only.reset();
+    auto taken = force_unpack<hoNDArray<float>>(std::move(message));
+    EXPECT_NE(taken.get_data_ptr(), data);
+    EXPECT_EQ(taken[0], 1.0f);
+}
+
+TEST(MessageTests, fanoutBranchesShareReadOnlyPayload) {
+    using namespace Gadgetron;
+    using namespace Gadgetron::Core;
+
+    Parallel::Fanout<hoNDArray<float>> fanout(Context{}, GadgetProperties{});
+    Parallel::Branch& branch = fanout;
+
+    auto input = make_channel<MessageChannel>();
+    auto bypass = make_channel<MessageChannel>();
+    auto left = make_channel<MessageChannel>();
+    auto right = make_channel<MessageChannel>();
+
+    hoNDArray<float> array(64);
+    array.fill(1.0f);
+    auto data = array.get_data_ptr();
+    {
+        auto output = std::move(input.output);
+        output.push(std::move(array));
+    }
+
+    std::map<std::string, OutputChannel> branches;
+    branches.emplace("left", std::move(left.output));
+    branches.emplace("right", std::move(right.output));
+    branch.process(std::move(input.input), std::move(branches), std::move(bypass.output));
+
+    auto from_left = force_unpack<std::shared_ptr<const hoNDArray<float>>>(left.input.pop());
+    auto from_right = force_unpack<hoNDArray<float>>(right.input.pop());
+
+    // Only the branch that takes the payload pays for a copy.
+    EXPECT_EQ(from_left->get_data_ptr(), data);
+    EXPECT_NE(from_right.get_data_ptr(), data);
+    from_right.fill(2.0f);
+    EXPECT_EQ((*from_left)[0], 1.0f);
+}
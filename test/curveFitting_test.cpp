@@ -10,6 +10,7 @@
 #include "hoNDRedundantWavelet.h"
 #include "hoNDArray_math.h"
 #include "simplexLagariaSolver.h"
+#include "batchedLevenbergMarquardtSolver.h"
 #include "twoParaExpDecayOperator.h"
 #include "twoParaExpRecoveryOperator.h"
 #include "curveFittingCostFunction.h"
@@ -125,6 +126,60 @@ TYPED_TEST(curveFitting_test, T1SR)
     EXPECT_NEAR(b[1], 1122.36963, 0.003);
 }
 
+TYPED_TEST(curveFitting_test, BatchedT2SE)
+{
+    typedef Gadgetron::batched_fitting::twoParaExpDecay<TypeParam> ModelType;
+    Gadgetron::batchedLevenbergMarquardtSolver<TypeParam, ModelType> solver;
+
+    std::vector<TypeParam> x = { 10, 20, 30, 40, 60, 80, 120, 160 };
+    std::vector<TypeParam> y0 = { 606.248226950355, 598.40425531914, 589.368794326241, 580.815602836879, 563.170212765957, 545.893617021277, 512.31914893617, 480.723404255319 };
+
+    // more problems than lanes, so that the last block is only partly used
+    size_t count = solver.lanes + 3;
+    size_t num = x.size();
+
+    std::vector<TypeParam> y(num*count), b(2*count);
+    for (size_t p = 0; p < count; p++)
+    {
+        // every other problem is scaled, which scales A and leaves T2 as it is
+        TypeParam scale = (p % 2) ? 2 : 1;
+        for (size_t n = 0; n < num; n++) y[n*count + p] = scale * y0[n];
+
+        b[p] = scale * y0[0];
+        b[count + p] = 640;
+    }
+
+    std::vector<TypeParam> cost(count);
+    solver.solve(&x[0], num, &y[0], count, &b[0], &cost[0]);
+
+    for (size_t p = 0; p < count; p++)
+    {
+        TypeParam scale = (p % 2) ? 2 : 1;
+        EXPECT_NEAR(b[p], scale*617.2593, scale*0.01);
+        EXPECT_NEAR(b[count + p], 644.4234, 0.01);
+        EXPECT_GE(cost[p], 0);
+    }
+}
+
+TYPED_TEST(curveFitting_test, BatchedThreeParaT1)
+{
+    typedef Gadgetron::batched_fitting::threeParaExpRecovery<TypeParam> ModelType;
+    Gadgetron::batchedLevenbergMarquardtSolver<TypeParam, ModelType> solver;
+
+    std::vector<TypeParam> x = { 100, 200, 400, 800, 1600, 3200, 5000 };
+    size_t num = x.size();
+
+    // y = 500 - 900 * exp(-x/1000), fitted from a poor guess
+    std::vector<TypeParam> y(num), b = { 400, 800, 600 };
+    for (size_t n = 0; n < num; n++) y[n] = 500 - 900 * std::exp(-x[n] / 1000);
+
+    solver.solve(&x[0], num, &y[0], 1, &b[0]);
+
+    EXPECT_NEAR(b[0], 500, 0.05);
+    EXPECT_NEAR(b[1], 900, 0.05);
+    EXPECT_NEAR(b[2], 1000, 0.1);
+}
+
 TYPED_TEST(curveFitting_test, T1SRMapping)
 {
     Gadgetron::ImageIOAnalyze gt_exporter_;
@@ -231,3 +286,57 @@ TYPED_TEST(curveFitting_test, T1SRMapping)
     // test hole filling
     EXPECT_NEAR(t1_sr.map_(12, 23, 0, 0), 1122.36963, 1.0);
 }
+
+TYPED_TEST(curveFitting_test, T1SRMappingBatched)
+{
+    Gadgetron::CmrT1SRMapping<float> t1_sr;
+
+    t1_sr.fill_holes_in_maps_ = true;
+    t1_sr.max_size_of_holes_ = 20;
+    t1_sr.hole_marking_value_ = 0;
+    t1_sr.compute_SD_maps_ = true;
+    t1_sr.use_batched_fitting_ = true;
+
+    t1_sr.ti_.resize(11, 545);
+    t1_sr.ti_[10] = 10000;
+
+    t1_sr.max_iter_ = 150;
+    t1_sr.thres_fun_ = 1e-4;
+    t1_sr.max_map_value_ = 4000;
+
+    size_t RO = 192;
+    size_t E1 = 144;
+    size_t N = t1_sr.ti_.size();
+
+    std::vector<float> y = { 178, 185, 182, 189, 178, 180, 187, 179, 177, 177, 471 };
+
+    t1_sr.data_.create(RO, E1, N, 1, 1);
+
+    size_t n;
+    for (n = 0; n < N; n++)
+    {
+        Gadgetron::hoNDArray<float> data2D;
+        data2D.create(RO, E1, &(t1_sr.data_(0, 0, n, 0, 0)));
+        Gadgetron::fill(data2D, y[n]);
+    }
+
+    t1_sr.mask_for_mapping_.create(RO, E1, 1);
+    Gadgetron::fill(t1_sr.mask_for_mapping_, (float)1);
+
+    t1_sr.mask_for_mapping_(12, 23, 0) = 0;
+    t1_sr.mask_for_mapping_(12, 24, 0) = 0;
+    t1_sr.mask_for_mapping_(13, 23, 0) = 0;
+
+    t1_sr.perform_parametric_mapping();
+
+    // the least squares solution, which the simplex search above only approaches to within its tolerance
+    EXPECT_NEAR(t1_sr.para_(0, 0, 0, 0, 0), 471.0636, 0.01);
+    EXPECT_NEAR(t1_sr.para_(RO / 2, E1 / 2, 0, 0, 0), 471.0636, 0.01);
+
+    EXPECT_NEAR(t1_sr.map_(0, 0, 0, 0), 1122.3631, 0.01);
+    EXPECT_NEAR(t1_sr.map_(RO - 1, E1 - 1, 0, 0), 1122.3631, 0.01);
+    EXPECT_NEAR(t1_sr.map_(37, 86, 0, 0), 1122.3631, 0.01);
+
+    // test hole filling
+    EXPECT_NEAR(t1_sr.map_(12, 23, 0, 0), 1122.3631, 1.0);
+}
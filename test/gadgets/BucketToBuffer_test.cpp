@@ -0,0 +1,129 @@
+#include "../../gadgets/mri_core/BucketToBufferGadget.h"
+#include "setup_gadget.h"
+#include <future>
+#include <gtest/gtest.h>
+using namespace Gadgetron;
+using namespace Gadgetron::Test;
+using namespace std::string_literals;
+using namespace std::chrono_literals;
+
+TEST(BucketToBufferTest, streams_acquisitions_into_buffer) {
+
+    try {
+        auto context   = generate_context();
+        auto& encoding = context.header.encoding[0];
+        encoding.trajectory                             = ISMRMRD::TrajectoryType::CARTESIAN;
+        encoding.encodingLimits.kspace_encoding_step_2 = ISMRMRD::Limit();
+
+        auto channels = setup_gadget<BucketToBufferGadget>({ { "trigger_dimension"s, "slice"s } }, context);
+
+        for (size_t i = 0; i < 11; i++) {
+            auto acq                      = generate_acquisition(192, 4);
+            auto& head                    = std::get<ISMRMRD::AcquisitionHeader>(acq);
+            auto& data                    = std::get<hoNDArray<std::complex<float>>>(acq);
+            head.idx.kspace_encode_step_1 = i;
+            std::fill(data.begin(), data.end(), std::complex<float>(i + 1));
+            channels.input.push(acq);
+        }
+
+        auto acq   = generate_acquisition(192, 4);
+        auto& head = std::get<ISMRMRD::AcquisitionHeader>(acq);
+        head.idx.slice++;
+        channels.input.push(acq);
+
+        auto message_future = std::async([&]() { return channels.output.pop(); });
+
+        auto ec = message_future.wait_for(1000ms);
+        ASSERT_EQ(ec, std::future_status::ready);
+        auto message = message_future.get();
+
+        ASSERT_TRUE(Core::convertible_to<IsmrmrdReconData>(message));
+        auto recon_data = Core::force_unpack<IsmrmrdReconData>(std::move(message));
+        ASSERT_EQ(recon_data.rbit_.size(), 1);
+
+        // The buffer covers the encoding limits, not only the lines received before the trigger.
+        auto& buffer = recon_data.rbit_[0].data_.data_;
+        ASSERT_EQ(buffer.get_size(0), 192);
+        ASSERT_EQ(buffer.get_size(1), 192);
+        ASSERT_EQ(buffer.get_size(3), 4);
+
+        for (size_t i = 0; i < 11; i++) {
+            EXPECT_EQ(buffer(0, i, 0, 3, 0, 0, 0), std::complex<float>(i + 1));
+        }
+        EXPECT_EQ(buffer(0, 11, 0, 0, 0, 0, 0), std::complex<float>(0));
+    } catch (const Core::ChannelClosed&){}
+}
+
+TEST(BucketToBufferTest, streamed_and_bucketed_buffers_have_the_same_shape) {
+
+    try {
+        auto context   = generate_context();
+        auto& encoding = context.header.encoding[0];
+        encoding.trajectory                             = ISMRMRD::TrajectoryType::CARTESIAN;
+        encoding.encodingLimits.kspace_encoding_step_2 = ISMRMRD::Limit();
+        encoding.encodingLimits.phase                  = ISMRMRD::Limit();
+        encoding.encodingLimits.phase->maximum         = 7;
+        encoding.encodingLimits.set                    = ISMRMRD::Limit();
+        encoding.encodingLimits.set->maximum           = 2;
+        encoding.encodingLimits.slice                  = ISMRMRD::Limit();
+        encoding.encodingLimits.slice->maximum         = 1;
+
+        auto properties = Core::GadgetProperties{ { "trigger_dimension"s, "slice"s }, { "N_dimension"s, "phase"s },
+            { "S_dimension"s, "set"s } };
+        auto streamed = setup_gadget<BucketToBufferGadget>(properties, context);
+        auto bucketed = setup_gadget<BucketToBufferGadget>(properties, context);
+
+        // Half of the phases and sets of the encoding limits arrive before the trigger.
+        AcquisitionBucket bucket;
+        for (uint16_t set = 0; set < 2; set++) {
+            for (uint16_t phase = 0; phase < 4; phase++) {
+                for (uint16_t e1 = 0; e1 < 11; e1++) {
+                    auto acq                      = generate_acquisition(192, 4);
+                    auto& head                    = std::get<ISMRMRD::AcquisitionHeader>(acq);
+                    auto& data                    = std::get<hoNDArray<std::complex<float>>>(acq);
+                    head.idx.kspace_encode_step_1 = e1;
+                    head.idx.phase                = phase;
+                    head.idx.set                  = set;
+                    std::fill(data.begin(), data.end(), std::complex<float>(100 * set + 20 * phase + e1 + 1));
+                    streamed.input.push(acq);
+                    add_to_bucket(bucket, acq);
+                }
+            }
+        }
+        bucketed.input.push(std::move(bucket));
+
+        auto acq   = generate_acquisition(192, 4);
+        auto& head = std::get<ISMRMRD::AcquisitionHeader>(acq);
+        head.idx.slice++;
+        streamed.input.push(acq);
+
+        auto pop = [](auto& channels) {
+            auto message_future = std::async([&]() { return channels.output.pop(); });
+            EXPECT_EQ(message_future.wait_for(1000ms), std::future_status::ready);
+            auto message = message_future.get();
+            EXPECT_TRUE(Core::convertible_to<IsmrmrdReconData>(message));
+            return Core::force_unpack<IsmrmrdReconData>(std::move(message));
+        };
+        auto from_stream = pop(streamed);
+        auto from_bucket = pop(bucketed);
+        ASSERT_EQ(from_stream.rbit_.size(), 1);
+        ASSERT_EQ(from_bucket.rbit_.size(), 1);
+
+        auto& stream_buffer = from_stream.rbit_[0].data_;
+        auto& bucket_buffer = from_bucket.rbit_[0].data_;
+        EXPECT_EQ(stream_buffer.data_.dimensions(), bucket_buffer.data_.dimensions());
+        EXPECT_EQ(stream_buffer.headers_.dimensions(), bucket_buffer.headers_.dimensions());
+
+        // N and S hold the phases and sets received, not those of the encoding limits.
+        ASSERT_EQ(stream_buffer.data_.get_size(4), 4);
+        ASSERT_EQ(stream_buffer.data_.get_size(5), 2);
+        ASSERT_EQ(stream_buffer.data_.get_size(6), 1);
+
+        ASSERT_EQ(stream_buffer.data_.get_number_of_elements(), bucket_buffer.data_.get_number_of_elements());
+        for (size_t i = 0; i < stream_buffer.data_.get_number_of_elements(); i++) {
+            ASSERT_EQ(stream_buffer.data_[i], bucket_buffer.data_[i]) << "at element " << i;
+        }
+        EXPECT_EQ(stream_buffer.data_(0, 10, 0, 3, 3, 1, 0), std::complex<float>(100 + 60 + 10 + 1));
+        EXPECT_EQ(stream_buffer.headers_(10, 0, 3, 1, 0).idx.phase, 3);
+    } catch (const Core::ChannelClosed&){}
+}
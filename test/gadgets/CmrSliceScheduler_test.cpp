@@ -0,0 +1,112 @@
+#include "../../gadgets/cmr/CmrSliceScheduler.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+using namespace Gadgetron;
+
+namespace {
+
+    // stands in for the binning recon of one slice: an OpenMP loop over the slice, recording the threads it got
+    struct Slice {
+        explicit Slice(size_t slice) : input(4096), output(4096) {
+            for (size_t i = 0; i < input.size(); i++)
+                input[i] = float(slice + 1) * float(i % 97);
+        }
+
+        void reconstruct(std::atomic<size_t>& running, std::atomic<size_t>& most_running) {
+            auto now = ++running;
+            for (auto most = most_running.load(); now > most && !most_running.compare_exchange_weak(most, now);) { }
+
+#ifdef USE_OMP
+            threads = omp_get_max_threads();
+#endif
+            long long n;
+#pragma omp parallel for
+            for (n = 0; n < (long long)input.size(); n++)
+                output[n] = input[n] * input[n] + 1.0f;
+
+            --running;
+        }
+
+        std::vector<float> input, output;
+        int threads = 1;
+    };
+
+    void reconstruct(std::vector<Slice>& slices, size_t max_in_flight) {
+        std::atomic<size_t> running{ 0 }, most_running{ 0 };
+        {
+            CmrSliceScheduler scheduler;
+            for (auto& slice : slices)
+                scheduler.post([&]() { slice.reconstruct(running, most_running); }, max_in_flight);
+            scheduler.wait();
+            scheduler.rethrow_failure();
+        }
+        EXPECT_LE(most_running.load(), max_in_flight);
+    }
+}
+
+TEST(CmrSliceScheduler, two_slices_match_the_serial_path) {
+    std::vector<Slice> serial{ Slice(0), Slice(1) }, concurrent{ Slice(0), Slice(1) };
+
+    reconstruct(serial, 1);
+    reconstruct(concurrent, 2);
+
+    for (size_t s = 0; s < serial.size(); s++) {
+        EXPECT_EQ(serial[s].output, concurrent[s].output) << "for slice " << s;
+
+        // slices running together split the OpenMP threads of one slice run alone
+        EXPECT_EQ(serial[s].threads, CmrSliceScheduler::openmp_threads_per_slice(1));
+        EXPECT_EQ(concurrent[s].threads, CmrSliceScheduler::openmp_threads_per_slice(2));
+        EXPECT_LE(concurrent[s].threads * 2, std::max(serial[s].threads, 2));
+    }
+
+#ifdef USE_OMP
+    // the pool threads get their OpenMP setting back after every slice
+    std::atomic<int> pool_threads{ 0 };
+    {
+        CmrSliceScheduler scheduler;
+        scheduler.post([&]() { pool_threads = omp_get_max_threads(); }, 1);
+    }
+    EXPECT_EQ(pool_threads.load(), omp_get_max_threads());
+#endif
+}
+
+TEST(CmrSliceScheduler, failure_of_a_slice_reaches_the_next_post) {
+    CmrSliceScheduler scheduler;
+    std::atomic<size_t> finished{ 0 };
+
+    scheduler.post([]() { throw std::runtime_error("slice failed"); }, 1);
+
+    // the gadget hands its next slice over once the failed one is done, and gets the failure instead
+    try {
+        scheduler.post([&]() { finished++; }, 1);
+        FAIL() << "the failure of the first slice was not rethrown";
+    } catch (const std::runtime_error& error) {
+        EXPECT_STREQ(error.what(), "slice failed");
+    }
+    scheduler.wait();
+    EXPECT_EQ(finished.load(), 0u);
+
+    // it is rethrown once; the slices after it run again
+    scheduler.post([&]() { finished++; }, 1);
+    scheduler.wait();
+    EXPECT_EQ(finished.load(), 1u);
+    EXPECT_NO_THROW(scheduler.rethrow_failure());
+}
+
+TEST(CmrSliceScheduler, failure_of_the_last_slice_reaches_close) {
+    CmrSliceScheduler scheduler;
+
+    scheduler.post([]() { throw std::runtime_error("last slice failed"); }, 1);
+    scheduler.wait();
+
+    EXPECT_THROW(scheduler.rethrow_failure(), std::runtime_error);
+    EXPECT_NO_THROW(scheduler.rethrow_failure());
+}
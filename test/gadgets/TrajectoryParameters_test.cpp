@@ -0,0 +1,145 @@
+#include "../../gadgets/spiral/TrajectoryParameters.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <string>
+
+using namespace Gadgetron;
+using namespace Gadgetron::Spiral;
+
+namespace {
+
+    ISMRMRD::IsmrmrdHeader spiral_header(long interleaves = 16) {
+        ISMRMRD::TrajectoryDescription description;
+        description.identifier = "HargreavesVDS2000";
+        description.userParameterLong = { { "SamplingTime_ns", 2000 }, { "interleaves", interleaves } };
+        description.userParameterDouble = { { "MaxGradient_G_per_cm", 2.4 },
+                                            { "MaxSlewRate_G_per_cm_per_s", 14414.4 },
+                                            { "krmax_per_cm", 6.4 },
+                                            { "FOVCoeff_1_cm", 24 } };
+
+        ISMRMRD::IsmrmrdHeader header;
+        header.encoding.resize(1);
+        header.encoding[0].trajectoryDescription = description;
+
+        ISMRMRD::SequenceParameters sequence;
+        sequence.TE = std::vector<float>{ 2.0f };
+        header.sequenceParameters = sequence;
+        return header;
+    }
+
+    ISMRMRD::AcquisitionHeader spiral_acquisition(uint16_t samples) {
+        ISMRMRD::AcquisitionHeader header{};
+        header.number_of_samples = samples;
+        header.read_dir[0] = 1;
+        header.phase_dir[1] = 1;
+        header.slice_dir[2] = 1;
+        return header;
+    }
+
+    void set_cache_megabytes(const char* megabytes) {
+#if defined(_WIN32)
+        _putenv_s("GADGETRON_SPIRAL_CACHE_MB", megabytes ? megabytes : "");
+#else
+        if (megabytes)
+            setenv("GADGETRON_SPIRAL_CACHE_MB", megabytes, 1);
+        else
+            unsetenv("GADGETRON_SPIRAL_CACHE_MB");
+#endif
+    }
+
+    void expect_same_trajectory(const SpiralTrajectory& a, const SpiralTrajectory& b) {
+        ASSERT_EQ(a.trajectory_and_weights.dimensions(), b.trajectory_and_weights.dimensions());
+        for (size_t i = 0; i < a.trajectory_and_weights.get_number_of_elements(); i++)
+            ASSERT_EQ(a.trajectory_and_weights[i], b.trajectory_and_weights[i]) << "at element " << i;
+    }
+}
+
+// The cache is shared by the whole process; every test starts with it empty.
+class TrajectoryParametersTest : public ::testing::Test {
+protected:
+    void SetUp() override { trajectory_cache().clear(); }
+};
+
+TEST_F(TrajectoryParametersTest, cache_hit_returns_the_same_trajectory) {
+    TrajectoryParameters first(spiral_header()), second(spiral_header());
+    auto acquisition = spiral_acquisition(1001);
+
+    auto computed = first.trajectory(acquisition);
+    EXPECT_EQ(computed->trajectory_and_weights.get_size(0), 3u);
+    EXPECT_EQ(computed->trajectory_and_weights.get_size(2), 16u);
+
+    auto hits = trajectory_cache().stats().hits;
+    EXPECT_EQ(first.trajectory(acquisition), computed);
+    EXPECT_EQ(trajectory_cache().stats().hits, hits);
+
+    // Another gadget with the same parameters finds it in the process wide cache.
+    EXPECT_EQ(second.trajectory(acquisition), computed);
+    EXPECT_EQ(trajectory_cache().stats().hits, hits + 1);
+
+    auto pair = second.calculate_trajectories_and_weight(acquisition);
+    EXPECT_EQ(pair.first.get_number_of_elements(), computed->trajectories.get_number_of_elements());
+    EXPECT_EQ(pair.second.get_number_of_elements(), computed->weights.get_number_of_elements());
+}
+
+TEST_F(TrajectoryParametersTest, changed_key_misses) {
+    TrajectoryParameters parameters(spiral_header()), fewer_interleaves(spiral_header(8));
+
+    auto misses = trajectory_cache().stats().misses;
+    auto first = parameters.trajectory(spiral_acquisition(1002));
+    auto more_samples = parameters.trajectory(spiral_acquisition(1003));
+    auto other_parameters = fewer_interleaves.trajectory(spiral_acquisition(1002));
+    EXPECT_EQ(trajectory_cache().stats().misses, misses + 3);
+
+    EXPECT_NE(more_samples, first);
+    EXPECT_NE(other_parameters, first);
+    EXPECT_EQ(other_parameters->trajectory_and_weights.get_size(2), 8u);
+}
+
+TEST_F(TrajectoryParametersTest, evicts_least_recently_used_trajectories) {
+    TrajectoryParameters parameters(spiral_header());
+
+    // Five sample counts; each gadget keeps only the four most recent trajectories itself.
+    for (uint16_t samples = 1010; samples < 1015; samples++)
+        parameters.trajectory(spiral_acquisition(samples));
+
+    auto hits = trajectory_cache().stats().hits;
+    parameters.trajectory(spiral_acquisition(1014));
+    parameters.trajectory(spiral_acquisition(1011));
+    EXPECT_EQ(trajectory_cache().stats().hits, hits);
+
+    // The least recently used one has to be looked up in the process wide cache again.
+    parameters.trajectory(spiral_acquisition(1010));
+    EXPECT_EQ(trajectory_cache().stats().hits, hits + 1);
+
+    // Which pushed out 1012, the least recently used by now.
+    parameters.trajectory(spiral_acquisition(1012));
+    EXPECT_EQ(trajectory_cache().stats().hits, hits + 2);
+}
+
+TEST_F(TrajectoryParametersTest, zero_budget_disables_the_cache) {
+    auto budget = trajectory_cache().budget();
+    const char* configured = std::getenv("GADGETRON_SPIRAL_CACHE_MB");
+    auto original = configured ? std::string(configured) : std::string();
+
+    set_cache_megabytes("0");
+    EXPECT_EQ(trajectory_cache_budget(), 0u);
+    trajectory_cache().set_budget(trajectory_cache_budget());
+
+    TrajectoryParameters first(spiral_header()), second(spiral_header());
+    auto acquisition = spiral_acquisition(1020);
+    auto computed = first.trajectory(acquisition);
+    auto recomputed = second.trajectory(acquisition);
+
+    EXPECT_NE(recomputed, computed);
+    expect_same_trajectory(*computed, *recomputed);
+    EXPECT_EQ(trajectory_cache().stats().entries, 0u);
+
+    // Each gadget still keeps what it computed itself.
+    EXPECT_EQ(first.trajectory(acquisition), computed);
+
+    set_cache_megabytes(nullptr);
+    EXPECT_EQ(trajectory_cache_budget(), size_t(64) << 20);
+
+    set_cache_megabytes(configured ? original.c_str() : nullptr);
+    trajectory_cache().set_budget(budget);
+}
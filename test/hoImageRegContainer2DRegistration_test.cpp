@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include "hoImageRegContainer2DRegistration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace Gadgetron;
+
+namespace {
+
+    typedef hoNDImage<float, 2> ImageType;
+    typedef hoImageRegContainer2DRegistration<ImageType, ImageType, double> RegType;
+
+    const size_t rows = 2;
+    const size_t frames = 4;
+
+    // a blob drifting over a row dependent background, a small 2D+T series per row
+    hoNDImageContainer2D<ImageType> make_series() {
+        size_t sx = 64, sy = 48;
+        std::vector<size_t> dim{sx, sy};
+
+        hoNDImageContainer2D<ImageType> series;
+        series.create(std::vector<size_t>(rows, frames));
+
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t n = 0; n < frames; n++) {
+                ImageType im(dim);
+                double cx = 32 + 2.0 * n + r, cy = 24 + 1.0 * n;
+
+                for (size_t y = 0; y < sy; y++) {
+                    for (size_t x = 0; x < sx; x++) {
+                        im(x + y * sx) = 100 * std::exp(-((x - cx) * (x - cx) + (y - cy) * (y - cy)) / 60.0)
+                                         + 10 * std::sin(0.3 * x + 0.2 * y * (r + 1));
+                    }
+                }
+
+                series(r, n) = im;
+            }
+        }
+
+        return series;
+    }
+
+    void set_parameters(RegType& reg, GT_IMAGE_REG_TRANSFORMATION transformation) {
+        reg.setDefaultParameters(3, false);
+
+        reg.container_reg_transformation_ = transformation;
+        reg.bg_value_ = -1;
+        reg.max_iter_num_pyramid_level_ = {8, 16, 32};
+        reg.boundary_handler_type_warper_.assign(3, GT_BOUNDARY_CONDITION_BORDERVALUE);
+        reg.interp_type_warper_.assign(3, GT_IMAGE_INTERPOLATOR_LINEAR);
+        reg.regularization_hilbert_strength_pyramid_level_.assign(3, std::vector<float>(2, 12.0f));
+        reg.dissimilarity_type_ = GT_IMAGE_DISSIMILARITY_LocalCCR;
+        reg.dissimilarity_thres_pyramid_level_.assign(3, 1e-6);
+        reg.inverse_deform_enforce_iter_pyramid_level_.assign(3, 10);
+        reg.inverse_deform_enforce_weight_pyramid_level_.assign(3, 0.5);
+        reg.div_num_pyramid_level_.assign(3, 2);
+    }
+
+    template<typename T>
+    void expect_images_equal(const T& a, const T& b) {
+        ASSERT_EQ(a.get_number_of_elements(), b.get_number_of_elements());
+        for (size_t i = 0; i < a.get_number_of_elements(); i++) {
+            ASSERT_EQ(a(i), b(i)) << "at element " << i;
+        }
+    }
+
+    // registers every frame to the key frame of its row, once with the key frame pyramids shared across the row
+    // (fixed reference) and once with every pair building its own (pair wise); both use the inline 2D linear warp
+    void test_shared_pyramids(GT_IMAGE_REG_TRANSFORMATION transformation) {
+        auto series = make_series();
+        std::vector<unsigned int> key_frames{1, 2};
+
+        RegType shared(3, false, -1);
+        set_parameters(shared, transformation);
+        ASSERT_TRUE(shared.registerOverContainer2DFixedReference(series, key_frames, true, false));
+
+        hoNDImageContainer2D<ImageType> targets;
+        targets.create(std::vector<size_t>(rows, frames));
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t n = 0; n < frames; n++) targets(r, n) = series(r, key_frames[r]);
+        }
+
+        RegType pair_wise(3, false, -1);
+        set_parameters(pair_wise, transformation);
+        ASSERT_TRUE(pair_wise.registerOverContainer2DPairWise(targets, series, true, false));
+
+        double max_shift = 0;
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t n = 0; n < frames; n++) {
+                // the key frame itself is not registered on the fixed reference path
+                if (n == key_frames[r]) continue;
+
+                for (size_t d = 0; d < 2; d++) {
+                    for (auto shift : shared.deformation_field_[d](r, n)) max_shift = std::max(max_shift, std::abs(shift));
+
+                    expect_images_equal(shared.deformation_field_[d](r, n), pair_wise.deformation_field_[d](r, n));
+                    if (transformation == GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD_BIDIRECTIONAL) {
+                        expect_images_equal(shared.deformation_field_inverse_[d](r, n),
+                                            pair_wise.deformation_field_inverse_[d](r, n));
+                    }
+                }
+
+                expect_images_equal(shared.warped_container_(r, n), pair_wise.warped_container_(r, n));
+            }
+        }
+
+        // the blob moves by up to 4 pixels between frames, the fields must not be trivially equal
+        EXPECT_GT(max_shift, 1.0);
+    }
+}
+
+TEST(hoImageRegContainer2DRegistration, sharedPyramidsDeformationField) {
+    test_shared_pyramids(GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD);
+}
+
+TEST(hoImageRegContainer2DRegistration, sharedPyramidsDeformationFieldBidirectional) {
+    test_shared_pyramids(GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD_BIDIRECTIONAL);
+}
+
+TEST(hoImageRegContainer2DRegistration, inlineLinearWarp) {
+    size_t sx = 37, sy = 29;
+    std::vector<size_t> dim{sx, sy};
+
+    ImageType target(dim), source(dim);
+    hoImageRegDeformationField<double, 2> transform(dim);
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> value(0.0f, 1.0f);
+    std::uniform_real_distribution<double> shift(-3.0, 3.0);
+
+    for (size_t i = 0; i < target.get_number_of_elements(); i++) {
+        target(i) = value(gen) + 0.1f;
+        source(i) = value(gen);
+        transform.getDeformationField(0)(i) = shift(gen);
+        transform.getDeformationField(1)(i) = shift(gen);
+    }
+
+    // background pixels of the target are left untouched
+    target(5) = 0;
+
+    hoNDBoundaryHandlerBorderValue<ImageType> boundary(source);
+    hoNDInterpolatorLinear<ImageType> interp(source, boundary);
+
+    hoImageRegWarper<ImageType, ImageType, double> warper;
+    warper.setTransformation(transform);
+    warper.setInterpolator(interp);
+
+    ImageType warped;
+    ASSERT_TRUE(warper.warp(target, source, false, warped));
+
+    // shifts of up to 3 pixels map part of the grid outside the source, covering the boundary handler as well
+    for (size_t y = 0; y < sy; y++) {
+        for (size_t x = 0; x < sx; x++) {
+            size_t offset = x + y * sx;
+            float expected = target(offset) == 0 ? target(offset)
+                                                 : interp(x + transform.getDeformationField(0)(offset),
+                                                          y + transform.getDeformationField(1)(offset));
+            ASSERT_FLOAT_EQ(expected, warped(offset)) << "at pixel " << x << ", " << y;
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#include "hoMemoryPool.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Gadgetron;
+
+TEST(hoMemoryPool, blocks_are_aligned_and_reused) {
+    hoPooledAllocator pool;
+
+    for (size_t bytes : { size_t(1), size_t(100), size_t(4097), size_t(3) << 20 }) {
+        void* first = pool.allocate(bytes);
+        ASSERT_NE(first, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % 64, 0u);
+        pool.deallocate(first, bytes);
+
+        void* second = pool.allocate(bytes);
+        EXPECT_EQ(first, second);
+        pool.deallocate(second, bytes);
+    }
+}
+
+TEST(hoMemoryPool, huge_blocks_are_page_aligned) {
+    hoSystemAllocator system;
+    void* ptr = system.allocate(size_t(4) << 20);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % (size_t(2) << 20), 0u);
+    system.deallocate(ptr, size_t(4) << 20);
+}
+
+TEST(hoMemoryPool, cache_is_bounded) {
+    hoPooledAllocator pool(size_t(8) << 20);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 16; i++)
+        blocks.push_back(pool.allocate(size_t(2) << 20));
+    for (auto block : blocks)
+        pool.deallocate(block, size_t(2) << 20);
+
+    EXPECT_LE(pool.cached_bytes(), size_t(8) << 20);
+    pool.release();
+    EXPECT_EQ(pool.cached_bytes(), 0u);
+}
+
+TEST(hoMemoryPool, data_is_aligned_behind_its_header) {
+    for (size_t bytes : { size_t(1), size_t(1024), size_t(4097), size_t(2) << 20 }) {
+        auto data = static_cast<unsigned char*>(hoMemory::allocate(bytes));
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % 64, 0u);
+        std::fill(data, data + bytes, 0xff);
+        hoMemory::deallocate(data);
+    }
+}
+
+TEST(hoMemoryPool, foreign_pointers_are_freed) {
+    void* foreign = std::malloc(128);
+    hoMemory::deallocate(foreign);
+}
+
+TEST(hoMemoryPool, accounts_track_live_and_peak_bytes) {
+    auto account = std::make_shared<hoMemoryAccount>();
+    size_t process_before = hoMemory::process_account().live_bytes();
+
+    std::vector<void*> blocks;
+    {
+        hoMemory::ScopedAccount scope(account);
+        for (int i = 0; i < 4; i++)
+            blocks.push_back(hoMemory::allocate(1000));
+    }
+    EXPECT_EQ(account->live_bytes(), 4000u);
+    EXPECT_EQ(hoMemory::process_account().live_bytes(), process_before + 4000);
+
+    // Memory is credited to the account it was charged to, even when freed elsewhere.
+    std::thread([&]() {
+        for (auto block : blocks)
+            hoMemory::deallocate(block);
+    }).join();
+
+    EXPECT_EQ(account->live_bytes(), 0u);
+    EXPECT_EQ(account->peak_bytes(), 4000u);
+    EXPECT_EQ(account->allocations(), 4u);
+    EXPECT_EQ(hoMemory::process_account().live_bytes(), process_before);
+}
+
+TEST(hoMemoryPool, accounts_charge_their_parent) {
+    auto connection = std::make_shared<hoMemoryAccount>();
+    auto first      = std::make_shared<hoMemoryAccount>(connection);
+    auto second     = std::make_shared<hoMemoryAccount>(connection);
+
+    void* a;
+    void* b;
+    {
+        hoMemory::ScopedAccount scope(first);
+        a = hoMemory::allocate(1000);
+    }
+    {
+        hoMemory::ScopedAccount scope(second);
+        b = hoMemory::allocate(3000);
+    }
+    EXPECT_EQ(first->live_bytes(), 1000u);
+    EXPECT_EQ(second->live_bytes(), 3000u);
+    EXPECT_EQ(connection->live_bytes(), 4000u);
+    EXPECT_EQ(connection->allocations(), 2u);
+
+    hoMemory::deallocate(a);
+    EXPECT_EQ(connection->live_bytes(), 3000u);
+    EXPECT_EQ(connection->peak_bytes(), 4000u);
+
+    // Memory does not keep the account it was charged to alive; what an account leaves behind is credited back to
+    // its parent when it goes away, and only to the process account when freed later on.
+    std::weak_ptr<hoMemoryAccount> expired = second;
+    first.reset();
+    second.reset();
+    EXPECT_TRUE(expired.expired());
+    EXPECT_EQ(connection->live_bytes(), 0u);
+
+    auto third = std::make_shared<hoMemoryAccount>(connection);
+    size_t process_before = hoMemory::process_account().live_bytes();
+    hoMemory::deallocate(b);
+    EXPECT_EQ(third->live_bytes(), 0u);
+    EXPECT_EQ(connection->live_bytes(), 0u);
+    EXPECT_EQ(hoMemory::process_account().live_bytes(), process_before - 3000);
+}
+
+TEST(hoMemoryPool, concurrent_allocation) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([t]() {
+            std::vector<void*> blocks;
+            for (int i = 0; i < 2000; i++) {
+                size_t bytes = 64 + ((i * 7919 + t) % 50000);
+                auto block   = static_cast<unsigned char*>(hoMemory::allocate(bytes));
+                block[0] = block[bytes - 1] = static_cast<unsigned char>(i);
+                blocks.push_back(block);
+                if (blocks.size() > 32) {
+                    hoMemory::deallocate(blocks.front());
+                    blocks.erase(blocks.begin());
+                }
+            }
+            for (auto block : blocks)
+                hoMemory::deallocate(block);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+}
@@ -3,6 +3,7 @@
 #include "complext.h"
 #include <gtest/gtest.h>
 #include <boost/random.hpp>
+#include <thread>
 
 using namespace Gadgetron;
 using testing::Types;
@@ -44,3 +45,59 @@ TYPED_TEST(hoNDFFT_test,ifftNrm2Test){
 	EXPECT_NEAR(nrm2(&this->Array2),nrm2(&this->Array),nrm2(&this->Array)*1e-2);
 
 }
+
+TYPED_TEST(hoNDFFT_test,singleDimensionRoundTrip){
+	hoNDArray<std::complex<TypeParam> > data(16,12,10,4);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = std::complex<TypeParam>(std::sin(TypeParam(i)),std::cos(TypeParam(3*i)));
+	auto original = data;
+
+	for (size_t dim = 0; dim < data.get_number_of_dimensions(); dim++){
+		FFT::fft(data,dim);
+		FFT::ifft(data,dim);
+	}
+
+	for (size_t i = 0; i < data.size(); i++)
+		EXPECT_NEAR(std::abs(data[i]-original[i]),0,1e-4);
+}
+
+TYPED_TEST(hoNDFFT_test,separableMatchesContiguous){
+	hoNDArray<std::complex<TypeParam> > data(24,18,5);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = std::complex<TypeParam>(std::sin(TypeParam(i)),std::cos(TypeParam(7*i)));
+	auto separable = data;
+
+	hoNDFFT<TypeParam>::instance()->fft2(data);
+	FFT::fft(separable,0);
+	FFT::fft(separable,1);
+
+	for (size_t i = 0; i < data.size(); i++)
+		EXPECT_NEAR(std::abs(data[i]-separable[i]),0,1e-3);
+}
+
+TYPED_TEST(hoNDFFT_test,concurrentTransforms){
+	hoNDArray<std::complex<TypeParam> > reference(32,32,8);
+	for (size_t i = 0; i < reference.size(); i++)
+		reference[i] = std::complex<TypeParam>(std::sin(TypeParam(i)),0);
+	auto expected = reference;
+	hoNDFFT<TypeParam>::instance()->fft2c(expected);
+
+	std::vector<std::thread> threads;
+	std::vector<bool> matches(8,false);
+	for (size_t t = 0; t < matches.size(); t++){
+		threads.emplace_back([&,t](){
+			bool all = true;
+			for (int repetition = 0; repetition < 10; repetition++){
+				auto data = reference;
+				hoNDFFT<TypeParam>::instance()->fft2c(data);
+				for (size_t i = 0; i < data.size(); i++)
+					all = all && std::abs(data[i]-expected[i]) < 1e-3;
+			}
+			matches[t] = all;
+		});
+	}
+	for (auto& thread : threads) thread.join();
+
+	for (auto match : matches)
+		EXPECT_TRUE(match);
+}
@@ -3,10 +3,13 @@
 #include "hoNDArray_reductions.h"
 #include "hoNDArray_elemwise.h"
 #include "hoNFFT.h"
+#include "hoNFFTOperator.h"
 #include "vector_td_utilities.h"
 #include "ImageIOAnalyze.h"
 #include "GadgetronTimer.h"
 
+#include <random>
+
 using namespace Gadgetron;
 using testing::Types;
 
@@ -136,3 +139,142 @@ TYPED_TEST(hoNFFT_2D_NC2C_BACKWARDS, randomTestOne)
 
     EXPECT_LE(v/norm_ref, 0.00001);
 }
+
+TEST(hoNFFT_convolve, multicoilMatchesSingleCoil)
+{
+    // 13 coils over 2 frames make a pass of 8 coils and a pass of 5, which runs the 8, 4 and single coil kernels.
+    const size_t frames = 2, coils = 13, samples = 600;
+    const vector_td<size_t, 2> dims(32, 32);
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> uniform(-0.5f, 0.5f);
+
+    hoNDArray<vector_td<float, 2>> traj(samples, frames);
+    for (auto &point : traj) point = vector_td<float, 2>(uniform(generator), uniform(generator));
+
+    hoNFFT_plan<float, 2> plan(dims, 2.0f, 3.0f);
+    plan.preprocess(traj);
+
+    const size_t grid = 4 * dims[0] * dims[1];
+    hoNDArray<std::complex<float>> image(grid, frames, coils), data(samples, frames, coils);
+    for (auto &value : image) value = std::complex<float>(uniform(generator), uniform(generator));
+    for (auto &value : data) value = std::complex<float>(uniform(generator), uniform(generator));
+
+    hoNDArray<std::complex<float>> gridded(image.dimensions()), degridded(data.dimensions());
+    plan.convolve(data, gridded, NFFT_conv_mode::NC2C);
+    plan.convolve(image, degridded, NFFT_conv_mode::C2NC);
+
+    // One frame of one coil at a time, through a plan of its own.
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        hoNDArray<vector_td<float, 2>> frame_traj(samples, traj.get_data_ptr() + frame * samples);
+        hoNFFT_plan<float, 2> frame_plan(dims, 2.0f, 3.0f);
+        frame_plan.preprocess(frame_traj);
+
+        for (size_t coil = 0; coil < coils; coil++)
+        {
+            size_t batch = frame + coil * frames;
+            hoNDArray<std::complex<float>> coil_data(samples, data.get_data_ptr() + batch * samples);
+            hoNDArray<std::complex<float>> coil_image(grid, image.get_data_ptr() + batch * grid);
+
+            hoNDArray<std::complex<float>> coil_gridded(grid), coil_degridded(samples);
+            frame_plan.convolve(coil_data, coil_gridded, NFFT_conv_mode::NC2C);
+            frame_plan.convolve(coil_image, coil_degridded, NFFT_conv_mode::C2NC);
+
+            for (size_t i = 0; i < grid; i++) EXPECT_EQ(coil_gridded[i], gridded[batch * grid + i]);
+            for (size_t i = 0; i < samples; i++) EXPECT_EQ(coil_degridded[i], degridded[batch * samples + i]);
+        }
+    }
+}
+
+TEST(hoNFFT_cache, sharesPreprocessingOfTheSameTrajectory)
+{
+    const size_t samples = 500;
+    const vector_td<size_t, 2> dims(32, 32);
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> uniform(-0.5f, 0.5f);
+
+    hoNDArray<vector_td<float, 2>> traj(samples);
+    for (auto &point : traj) point = vector_td<float, 2>(uniform(generator), uniform(generator));
+
+    hoNDArray<std::complex<float>> data(samples);
+    for (auto &value : data) value = std::complex<float>(uniform(generator), uniform(generator));
+
+    hoNFFT_cache().clear();
+    auto before = hoNFFT_cache().stats();
+
+    hoNFFT_plan<float, 2> first(dims, 2.0f, 3.0f);
+    first.preprocess(traj, NFFT_prep_mode::NC2C);
+
+    hoNFFT_plan<float, 2> second(dims, 2.0f, 3.0f);
+    second.preprocess(traj, NFFT_prep_mode::NC2C);
+
+    auto after = hoNFFT_cache().stats();
+    EXPECT_EQ(after.misses - before.misses, 2u);     // deapodization and convolution of the first plan
+    EXPECT_EQ(after.hits - before.hits, 2u);         // the same for the second plan
+    EXPECT_EQ(after.entries, 2u);
+
+    hoNDArray<std::complex<float>> first_image(2 * dims[0], 2 * dims[1]), second_image(2 * dims[0], 2 * dims[1]);
+    first.convolve(data, first_image, NFFT_conv_mode::NC2C);
+    second.convolve(data, second_image, NFFT_conv_mode::NC2C);
+    for (size_t i = 0; i < first_image.get_number_of_elements(); i++) EXPECT_EQ(first_image[i], second_image[i]);
+
+    // Another trajectory, or another mode, is preprocessed again.
+    traj[0] = vector_td<float, 2>(0.25f, -0.25f);
+    second.preprocess(traj, NFFT_prep_mode::NC2C);
+    second.preprocess(traj, NFFT_prep_mode::C2NC);
+    EXPECT_EQ(hoNFFT_cache().stats().entries, 4u);
+}
+
+TEST(hoNFFTOperator, toeplitzMatchesGriddingAndDegridding)
+{
+    const size_t samples = 3000, frames = 2, coils = 3;
+    const vector_td<size_t, 2> dims(32, 32), dims_os(64, 64);
+
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<float> uniform(-0.5f, 0.5f);
+
+    hoNDArray<vector_td<float, 2>> traj(samples, frames);
+    for (auto &point : traj) point = vector_td<float, 2>(uniform(generator), uniform(generator));
+
+    auto dcw = boost::make_shared<hoNDArray<float>>(samples, frames);
+    for (auto &weight : *dcw) weight = 1.0f + uniform(generator);
+
+    std::vector<size_t> image_dims = {dims[0], dims[1], frames, coils}, data_dims = {samples, frames, coils};
+    hoNDArray<float_complext> image(image_dims);
+    for (auto &value : image) value = float_complext(uniform(generator), uniform(generator));
+
+    hoNFFTOperator<float, 2> E;
+    E.setup(dims, dims_os, 5.5f);
+    E.set_dcw(dcw);
+    E.set_domain_dimensions(&image_dims);
+    E.set_codomain_dimensions(&data_dims);
+    E.preprocess(traj);
+
+    hoNDArray<float_complext> data(data_dims), expected(image_dims), gridded(image_dims), result(image_dims);
+    E.mult_M(&image, &data);
+    E.mult_MH(&data, &expected);
+    E.mult_MH_M(&image, &gridded);
+
+    E.set_toeplitz(true);
+    E.mult_MH_M(&image, &result);
+
+    // The Toeplitz kernel is exact up to the accuracy of the NFFT itself, about 5e-5 here.
+    auto error = result;
+    error -= expected;
+    EXPECT_LT(nrm2(&error) / nrm2(&expected), 1e-4f);
+
+    error = gridded;
+    error -= expected;
+    EXPECT_LT(nrm2(&error) / nrm2(&expected), 1e-5f);
+
+    // Accumulation adds to the output, and the kernel is reused.
+    auto misses = hoNFFT_cache().stats().misses;
+    E.mult_MH_M(&image, &result, true);
+    result *= 0.5f;
+    error = result;
+    error -= expected;
+    EXPECT_LT(nrm2(&error) / nrm2(&expected), 1e-4f);
+    EXPECT_EQ(hoNFFT_cache().stats().misses, misses);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+
+using namespace Gadgetron;
+
+namespace {
+    size_t count_lines(const std::string &text, const std::string &marker) {
+        size_t count = 0;
+        for (auto position = text.find(marker); position != std::string::npos; position = text.find(marker, position + 1))
+            count++;
+        return count;
+    }
+}
+
+TEST(LogTest, streamNotBuiltForDisabledLevel) {
+    auto logger = GadgetronLogger::instance();
+    bool enabled = logger->isLevelEnabled(GADGETRON_LOG_LEVEL_DEBUG);
+    logger->disableLogLevel(GADGETRON_LOG_LEVEL_DEBUG);
+
+    int evaluated = 0;
+    auto evaluate = [&]() { return ++evaluated; };
+    GDEBUG_STREAM("Value " << evaluate());
+    EXPECT_EQ(evaluated, 0);
+
+    logger->enableLogLevel(GADGETRON_LOG_LEVEL_DEBUG);
+    testing::internal::CaptureStdout();
+    GDEBUG_STREAM("Value " << evaluate());
+    logger->flush();
+    auto output = testing::internal::GetCapturedStdout();
+    EXPECT_EQ(evaluated, 1);
+    EXPECT_NE(output.find("Value 1"), std::string::npos);
+
+    if (!enabled) logger->disableLogLevel(GADGETRON_LOG_LEVEL_DEBUG);
+}
+
+TEST(LogTest, messagesAreWrittenInOrder) {
+    testing::internal::CaptureStdout();
+    GINFO("first %d\n", 1);
+    GINFO_STREAM("second " << 2 << " at 100%");
+    GWARN("third %s\n", "3");
+    GadgetronLogger::instance()->flush();
+    auto output = testing::internal::GetCapturedStdout();
+
+    auto first = output.find("first 1");
+    auto second = output.find("second 2 at 100%");
+    auto third = output.find("third 3");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    ASSERT_NE(third, std::string::npos);
+    EXPECT_LT(first, second);
+    EXPECT_LT(second, third);
+    EXPECT_NE(output.find("log_test.cpp"), std::string::npos);
+}
+
+TEST(LogTest, longMessagesAreNotTruncated) {
+    std::string message(5000, 'x');
+    testing::internal::CaptureStdout();
+    GINFO("%s|end\n", message.c_str());
+    GadgetronLogger::instance()->flush();
+    auto output = testing::internal::GetCapturedStdout();
+    EXPECT_NE(output.find(message + "|end"), std::string::npos);
+}
+
+TEST(LogTest, messagesAreWrittenOrCounted) {
+    auto logger = GadgetronLogger::instance();
+    const size_t threads = 4, messages = 5000;
+    const size_t dropped_before = logger->droppedMessages(GADGETRON_LOG_LEVEL_INFO);
+
+    testing::internal::CaptureStdout();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = 0; i < messages; i++) GINFO("logged message %zu\n", i);
+            GERROR("logged error\n");
+        });
+    }
+    for (auto &worker : workers) worker.join();
+    logger->flush();
+    auto output = testing::internal::GetCapturedStdout();
+
+    size_t dropped = logger->droppedMessages(GADGETRON_LOG_LEVEL_INFO) - dropped_before;
+    EXPECT_EQ(count_lines(output, "logged message"), threads * messages - dropped);
+    EXPECT_EQ(count_lines(output, "logged error"), threads);
+}
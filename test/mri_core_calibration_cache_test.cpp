@@ -0,0 +1,79 @@
+#include "mri_core_calibration_cache.h"
+
+#include <gtest/gtest.h>
+#include <complex>
+
+using namespace Gadgetron;
+
+namespace {
+    CalibrationKey key_for(const hoNDArray<std::complex<float>>& data, double parameter) {
+        CalibrationKey key;
+        key.add(data).add(parameter);
+        return key;
+    }
+}
+
+TEST(CalibrationKey, depends_on_content_dimensions_and_parameters) {
+    hoNDArray<std::complex<float>> data(16, 8, 4);
+    for (size_t i = 0; i < data.get_number_of_elements(); i++)
+        data[i] = std::complex<float>(float(i), -float(i));
+
+    hoNDArray<std::complex<float>> copy(data);
+    EXPECT_EQ(key_for(data, 1.0), key_for(copy, 1.0));
+    EXPECT_NE(key_for(data, 1.0), key_for(data, 2.0));
+
+    copy[17] += std::complex<float>(1e-3f, 0);
+    EXPECT_NE(key_for(data, 1.0), key_for(copy, 1.0));
+
+    hoNDArray<std::complex<float>> reshaped(8, 16, 4, data.get_data_ptr());
+    EXPECT_NE(key_for(data, 1.0), key_for(reshaped, 1.0));
+}
+
+TEST(CalibrationCache, finds_only_matching_key_and_type) {
+    CalibrationCache cache(1024);
+
+    CalibrationKey key;
+    key.add(42);
+    cache.insert<int>(key, std::make_shared<const int>(7), sizeof(int));
+
+    auto found = cache.find<int>(key);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(*found, 7);
+
+    EXPECT_FALSE(cache.find<double>(key));
+
+    CalibrationKey other;
+    other.add(43);
+    EXPECT_FALSE(cache.find<int>(other));
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST(CalibrationCache, evicts_least_recently_used_within_budget) {
+    CalibrationCache cache(300);
+
+    CalibrationKey a, b, c;
+    a.add(1);
+    b.add(2);
+    c.add(3);
+
+    cache.insert<int>(a, std::make_shared<const int>(1), 100);
+    cache.insert<int>(b, std::make_shared<const int>(2), 100);
+    EXPECT_TRUE(cache.find<int>(a)); // a is now more recently used than b
+
+    cache.insert<int>(c, std::make_shared<const int>(3), 150);
+
+    EXPECT_TRUE(cache.find<int>(a));
+    EXPECT_FALSE(cache.find<int>(b));
+    EXPECT_TRUE(cache.find<int>(c));
+    EXPECT_LE(cache.stats().bytes, 300u);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+
+    // Too large to ever fit.
+    CalibrationKey d;
+    d.add(4);
+    cache.insert<int>(d, std::make_shared<const int>(4), 301);
+    EXPECT_FALSE(cache.find<int>(d));
+}
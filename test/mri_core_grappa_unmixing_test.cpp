@@ -0,0 +1,67 @@
+#include "mri_core_grappa.h"
+
+#include <gtest/gtest.h>
+#include <complex>
+#include <random>
+
+using namespace Gadgetron;
+
+namespace {
+    template <typename T> void fill_random(hoNDArray<T>& array, unsigned int seed) {
+        std::mt19937 engine(seed);
+        std::uniform_real_distribution<typename T::value_type> dist(-1, 1);
+        for (auto& value : array)
+            value = T(dist(engine), dist(engine));
+    }
+}
+
+template <typename T> class mri_core_grappa_unmixing_TypedTest : public ::testing::Test {};
+
+typedef ::testing::Types<std::complex<float>, std::complex<double>> cpxImplementations;
+TYPED_TEST_CASE(mri_core_grappa_unmixing_TypedTest, cpxImplementations);
+
+TYPED_TEST(mri_core_grappa_unmixing_TypedTest, aliased_image_matches_reference) {
+    using T = TypeParam;
+    // Not a multiple of the tile size, so the last tile is partial.
+    const size_t RO = 37, E1 = 29, CHA = 13, N = 3;
+
+    hoNDArray<T> aliased(RO, E1, CHA, N), coeff(RO, E1, CHA), unmixed;
+    fill_random(aliased, 1);
+    fill_random(coeff, 2);
+
+    apply_unmix_coeff_aliased_image(aliased, coeff, unmixed);
+
+    ASSERT_EQ(unmixed.get_size(0), RO);
+    ASSERT_EQ(unmixed.get_size(1), E1);
+    ASSERT_EQ(unmixed.get_size(2), 1u);
+    ASSERT_EQ(unmixed.get_size(3), N);
+
+    for (size_t n = 0; n < N; n++) {
+        for (size_t p = 0; p < RO * E1; p++) {
+            T expected = 0;
+            for (size_t c = 0; c < CHA; c++)
+                expected += coeff[c * RO * E1 + p] * aliased[(n * CHA + c) * RO * E1 + p];
+            EXPECT_NEAR(std::abs(unmixed[n * RO * E1 + p] - expected), 0, 1e-4);
+        }
+    }
+}
+
+TYPED_TEST(mri_core_grappa_unmixing_TypedTest, shared_data_per_batch) {
+    using T = TypeParam;
+    const size_t pixels = 1500, coils = 8, sets = 2;
+
+    hoNDArray<T> data(pixels, coils), coeff(pixels, coils, sets), out(pixels, sets);
+    fill_random(data, 3);
+    fill_random(coeff, 4);
+
+    apply_unmix_coeff(data.begin(), 0, coeff.begin(), pixels * coils, pixels, coils, sets, out.begin());
+
+    for (size_t s = 0; s < sets; s++) {
+        for (size_t p = 0; p < pixels; p++) {
+            T expected = 0;
+            for (size_t c = 0; c < coils; c++)
+                expected += coeff[(s * coils + c) * pixels + p] * data[c * pixels + p];
+            EXPECT_NEAR(std::abs(out[s * pixels + p] - expected), 0, 1e-4);
+        }
+    }
+}
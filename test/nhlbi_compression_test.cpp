@@ -0,0 +1,108 @@
+#include "../gadgets/mri_core/NHLBICompression.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+
+    // Packs samples one at a time, in the way the original implementation did, to pin down the wire format.
+    // Values are clamped to the representable range, which the original did not do for 32 bits.
+    std::vector<uint8_t> reference_pack(const std::vector<float>& data, float scale, size_t bits) {
+        std::vector<uint8_t> out((bits * data.size() + 7) / 8 + sizeof(uint64_t), 0);
+        const uint64_t mask = (uint64_t(1) << bits) - 1;
+        for (size_t i = 0; i < data.size(); i++) {
+            size_t sb       = (i * bits) / 8;
+            size_t upshift  = i * bits - sb * 8;
+            auto int_val    = static_cast<int64_t>(std::round(data[i] * scale));
+            int_val = std::min(std::max(int_val, -int64_t(mask >> 1)), int64_t(mask >> 1));
+            uint64_t compact = static_cast<uint64_t>(int_val) & mask;
+
+            uint64_t word;
+            memcpy(&word, &out[sb], sizeof(word));
+            word = (word & ~(mask << upshift)) | (compact << upshift);
+            memcpy(&out[sb], &word, sizeof(word));
+        }
+        out.resize((bits * data.size() + 7) / 8);
+        return out;
+    }
+
+    std::vector<float> random_samples(size_t n) {
+        std::mt19937 rng(4242);
+        std::normal_distribution<float> dist(0.0f, 100.0f);
+        std::vector<float> data(n);
+        for (auto& d : data)
+            d = dist(rng);
+        return data;
+    }
+}
+
+TEST(NHLBICompression, matches_reference_wire_format) {
+    auto data = random_samples(1031);
+
+    for (uint8_t bits = 4; bits <= 32; bits++) {
+        CompressedBuffer<float> comp(data, -1.0f, bits);
+        auto serialized = comp.serialize();
+
+        CompressionHeader header;
+        memcpy(&header, serialized.data(), sizeof(header));
+        ASSERT_EQ(header.bits_, bits);
+        ASSERT_EQ(header.elements_, data.size());
+
+        auto reference = reference_pack(data, header.scale_, bits);
+        std::vector<uint8_t> payload(serialized.begin() + sizeof(CompressionHeader), serialized.end());
+        EXPECT_EQ(reference, payload) << "bits: " << int(bits);
+    }
+}
+
+TEST(NHLBICompression, decompress_matches_random_access) {
+    auto data = random_samples(777);
+
+    for (uint8_t bits : { 8, 12, 13, 16, 24, 32 }) {
+        CompressedBuffer<float> comp(data, -1.0f, bits);
+        auto serialized = comp.serialize();
+
+        CompressedBuffer<float> received;
+        received.deserialize(serialized);
+        ASSERT_EQ(received.size(), data.size());
+
+        std::vector<float> out(received.size());
+        received.decompress(out.data());
+
+        float max_val = 0;
+        for (auto d : data)
+            max_val = std::max(max_val, std::abs(d));
+        const float tolerance = 0.5f * max_val / ((uint64_t(1) << (bits - 1)) - 2);
+
+        for (size_t i = 0; i < out.size(); i++) {
+            ASSERT_EQ(out[i], received[i]);
+            ASSERT_NEAR(out[i], data[i], tolerance * 1.0001f + std::abs(data[i]) * 1e-6f);
+        }
+    }
+}
+
+TEST(NHLBICompression, tolerance_is_respected) {
+    auto data = random_samples(4096);
+    const float tolerance = 0.25f;
+
+    CompressedBuffer<float> comp(data.data(), data.size(), tolerance);
+    auto serialized = comp.serialize();
+
+    CompressedBuffer<float> received;
+    received.deserialize(serialized.data(), serialized.size());
+
+    std::vector<float> out(received.size());
+    received.decompress(out.data());
+
+    for (size_t i = 0; i < out.size(); i++)
+        EXPECT_LE(std::abs(out[i] - data[i]), tolerance * 1.0001f);
+}
+
+TEST(NHLBICompression, rejects_truncated_buffer) {
+    auto data = random_samples(100);
+    CompressedBuffer<float> comp(data, -1.0f, 16);
+    auto serialized = comp.serialize();
+    serialized.pop_back();
+
+    CompressedBuffer<float> received;
+    EXPECT_THROW(received.deserialize(serialized), std::runtime_error);
+}
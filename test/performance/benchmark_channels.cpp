@@ -0,0 +1,101 @@
+//
+// Compares the unbounded MessageChannel with the ring-buffer backed BoundedMessageChannel.
+// Reports messages per second and the p50/p99 hand-off latency between producer and consumer.
+//
+
+#include "Channel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Gadgetron::Core;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    constexpr size_t MESSAGES = 1000000;
+
+    struct Result {
+        double messages_per_second;
+        double p50_ns;
+        double p99_ns;
+    };
+
+    template <class ChannelType, class... ARGS>
+    Result run(size_t producers, size_t consumers, ARGS&&... args) {
+        auto channel = make_channel<ChannelType>(std::forward<ARGS>(args)...);
+
+        const size_t per_producer = MESSAGES / producers;
+        std::vector<std::vector<long long>> latencies(consumers);
+
+        auto start = Clock::now();
+
+        std::vector<std::thread> consumer_threads;
+        for (size_t c = 0; c < consumers; c++) {
+            consumer_threads.emplace_back([&, c, input = split(channel.input)]() mutable {
+                auto& local = latencies[c];
+                local.reserve(MESSAGES / consumers + 1);
+                try {
+                    while (true) {
+                        auto sent = force_unpack<long long>(input.pop());
+                        local.push_back(Clock::now().time_since_epoch().count() - sent);
+                    }
+                } catch (const ChannelClosed&) {
+                }
+            });
+        }
+
+        {
+            std::vector<std::thread> producer_threads;
+            for (size_t p = 0; p < producers; p++) {
+                producer_threads.emplace_back([&, output = split(channel.output)]() mutable {
+                    for (size_t i = 0; i < per_producer; i++)
+                        output.push(static_cast<long long>(Clock::now().time_since_epoch().count()));
+                });
+            }
+            for (auto& thread : producer_threads) thread.join();
+        }
+
+        { auto closing = std::move(channel.output); }
+        { auto closing = std::move(channel.input); }
+        for (auto& thread : consumer_threads) thread.join();
+
+        auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::vector<long long> all;
+        for (auto& local : latencies) all.insert(all.end(), local.begin(), local.end());
+        std::sort(all.begin(), all.end());
+
+        auto percentile = [&](double p) {
+            return double(all[std::min(all.size() - 1, size_t(p * all.size()))]) * Clock::period::num * 1e9
+                   / Clock::period::den;
+        };
+
+        return { all.size() / elapsed, percentile(0.5), percentile(0.99) };
+    }
+
+    void report(const std::string& name, size_t producers, size_t consumers, const Result& result) {
+        std::cout << std::left << std::setw(28) << name << std::setw(6) << producers << std::setw(6) << consumers
+                  << std::right << std::setw(16) << std::fixed << std::setprecision(0) << result.messages_per_second
+                  << std::setw(12) << result.p50_ns << std::setw(12) << result.p99_ns << std::endl;
+    }
+}
+
+int main() {
+    std::cout << std::left << std::setw(28) << "channel" << std::setw(6) << "prod" << std::setw(6) << "cons"
+              << std::right << std::setw(16) << "msg/s" << std::setw(12) << "p50 [ns]" << std::setw(12)
+              << "p99 [ns]" << std::endl;
+
+    for (auto [producers, consumers] : std::vector<std::pair<size_t, size_t>>{ { 1, 1 }, { 4, 1 }, { 4, 4 } }) {
+        report("MessageChannel", producers, consumers, run<MessageChannel>(producers, consumers));
+        for (size_t capacity : { 16, 256, 4096 }) {
+            report("BoundedMessageChannel(" + std::to_string(capacity) + ")", producers, consumers,
+                run<BoundedMessageChannel>(producers, consumers, capacity));
+        }
+    }
+    return 0;
+}
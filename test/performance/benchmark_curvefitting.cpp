@@ -8,6 +8,7 @@
 #include "hoNDRedundantWavelet.h"
 #include "hoNDArray_math.h"
 #include "simplexLagariaSolver.h"
+#include "batchedLevenbergMarquardtSolver.h"
 #include "twoParaExpDecayOperator.h"
 #include "twoParaExpRecoveryOperator.h"
 #include "curveFittingCostFunction.h"
@@ -247,9 +248,37 @@ void time_gadgetron(){
     std::cout << "Fitting tookz " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << std::endl;
     std::cout << "Best cost " << best_cost << " " << b[0] << " " << b[1] <<  std::endl;
 }
+void time_batched(){
+
+    typedef Gadgetron::batched_fitting::twoParaExpRecovery<float> ModelType;
+
+    std::vector<float> x(11, 545); // echo time, in ms
+    x[10] = 10000;
+    std::vector<float> y0 = {178, 185, 182, 189, 178, 180, 187, 179, 177, 177, 471};
+
+    // the same problem ITERATIONS times, as one batch
+    std::vector<float> y(x.size()*ITERATIONS), b(2*ITERATIONS), cost(ITERATIONS);
+    for (size_t n = 0; n < x.size(); n++) std::fill_n(y.begin() + n*ITERATIONS, ITERATIONS, y0[n]);
+
+    auto start = std::chrono::system_clock::now();
+
+    std::fill_n(b.begin(), ITERATIONS, *std::max_element(y0.begin(), y0.end()));
+    std::fill_n(b.begin() + ITERATIONS, ITERATIONS, x[x.size() / 2]);
+
+    Gadgetron::batchedLevenbergMarquardtSolver<float, ModelType> solver;
+    solver.max_iter_ = 1500;
+    solver.thres_fun_ = 1e-6;
+    solver.solve(x.data(), x.size(), y.data(), ITERATIONS, b.data(), cost.data());
+
+    auto end = std::chrono::system_clock::now();
+
+    std::cout << "Fitting tookz " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << std::endl;
+    std::cout << "Best cost " << cost[0] << " " << b[0] << " " << b[ITERATIONS] <<  std::endl;
+}
 using namespace Gadgetron;
 int main(){
     time_gadgetron();
+    time_batched();
     time_dlib();
     time_ceres();
 }
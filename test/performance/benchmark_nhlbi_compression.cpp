@@ -0,0 +1,73 @@
+//
+// Throughput of the NHLBI fixed point compression used for acquisitions on the wire.
+// Reports GB/s of uncompressed samples for compression, block decompression and the old per sample decompression.
+//
+
+#include "../../gadgets/mri_core/NHLBICompression.h"
+
+#include <chrono>
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    // One acquisition: 32 channels, 512 complex samples.
+    constexpr size_t SAMPLES     = 32 * 512 * 2;
+    constexpr size_t REPETITIONS = 2000;
+
+    template <class F> double gigabytes_per_second(F&& f) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < REPETITIONS; i++)
+            f();
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        return double(REPETITIONS * SAMPLES * sizeof(float)) / elapsed.count() / 1e9;
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> data(SAMPLES);
+    for (auto& d : data)
+        d = dist(rng);
+
+    std::vector<float> out(SAMPLES);
+    volatile float sink = 0;
+
+    std::cout << std::setw(6) << "bits" << std::setw(14) << "compress" << std::setw(14) << "decompress"
+              << std::setw(14) << "per sample" << "   (GB/s)" << std::endl;
+
+    for (uint8_t bits = 8; bits <= 16; bits++) {
+        auto serialized = CompressedBuffer<float>(data, -1.0f, bits).serialize();
+
+        auto compress = gigabytes_per_second([&]() {
+            CompressedBuffer<float> comp(data.data(), data.size(), -1.0f, bits);
+            sink = comp.getCompressionRatio();
+        });
+
+        auto decompress = gigabytes_per_second([&]() {
+            CompressedBuffer<float> comp;
+            comp.deserialize(serialized);
+            comp.decompress(out.data());
+            sink = out[0];
+        });
+
+        auto per_sample = gigabytes_per_second([&]() {
+            CompressedBuffer<float> comp;
+            comp.deserialize(serialized);
+            for (size_t i = 0; i < comp.size(); i++)
+                out[i] = comp[i];
+            sink = out[0];
+        });
+
+        std::cout << std::setw(6) << int(bits) << std::fixed << std::setprecision(2) << std::setw(14) << compress
+                  << std::setw(14) << decompress << std::setw(14) << per_sample << std::endl;
+    }
+
+    return 0;
+}
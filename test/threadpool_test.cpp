@@ -4,6 +4,7 @@
 
 #include <gtest/gtest.h>
 #include "ThreadPool.h"
+#include "hoMemoryPool.h"
 
 using namespace Gadgetron::Core;
 TEST(ThreadPoolTest,VoidTest){
@@ -24,3 +25,102 @@ TEST(ThreadPoolTest,moveTest){
     pool.join();
 
 }
+
+TEST(ThreadPoolTest,exceptionTest){
+    ThreadPool pool{2};
+    auto return_value = pool.async([](){ throw std::runtime_error("fail"); });
+    EXPECT_THROW(return_value.get(),std::runtime_error);
+    pool.join();
+}
+
+TEST(ThreadPoolTest,nestedSubmissionTest){
+    ThreadPool pool{4};
+    std::atomic<int> counter{0};
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < 64; i++){
+        outer.push_back(pool.async([&](){
+            for (int j = 0; j < 16; j++) pool.post([&](){ counter++; });
+        }));
+    }
+    for (auto& f : outer) f.get();
+    pool.join();
+    EXPECT_EQ(counter,64*16);
+}
+
+TEST(ThreadPoolTest,priorityTest){
+    ThreadPool pool{1};
+    std::promise<void> gate;
+    auto blocker = pool.async([&](){ gate.get_future().wait(); });
+
+    std::vector<int> order;
+    std::mutex m;
+    auto low = pool.async(ThreadPool::Priority::low,[&](){ std::lock_guard<std::mutex> g(m); order.push_back(2); });
+    auto high = pool.async(ThreadPool::Priority::high,[&](){ std::lock_guard<std::mutex> g(m); order.push_back(0); });
+    auto normal = pool.async([&](){ std::lock_guard<std::mutex> g(m); order.push_back(1); });
+
+    gate.set_value();
+    blocker.get(); low.get(); high.get(); normal.get();
+    pool.join();
+    EXPECT_EQ(order,(std::vector<int>{0,1,2}));
+}
+
+TEST(ThreadPoolTest,largeCallableTest){
+    ThreadPool pool{2};
+    std::array<double,64> big{};
+    big[63] = 3.0;
+    auto return_value = pool.async([big](){ return big[63]; });
+    EXPECT_EQ(return_value.get(),3.0);
+}
+
+TEST(ThreadPoolTest,accountTest){
+    using namespace Gadgetron;
+    ThreadPool pool{2};
+    auto account = std::make_shared<hoMemoryAccount>();
+
+    void *from_async, *from_post, *nested;
+    {
+        hoMemory::ScopedAccount scope(account);
+        std::promise<void*> posted;
+        pool.post([&](){ posted.set_value(hoMemory::allocate(3000)); });
+        from_async = pool.async([](){ return hoMemory::allocate(1000); }).get();
+        from_post = posted.get_future().get();
+
+        // Work submitted by a task inherits its account.
+        std::promise<std::future<void*>> outer;
+        pool.post([&](){ outer.set_value(ThreadPool::shared().async([](){ return hoMemory::allocate(500); })); });
+        nested = outer.get_future().get().get();
+    }
+    EXPECT_EQ(account->live_bytes(),4500u);
+
+    // Work submitted without the account is not charged to it.
+    auto other = pool.async([](){ return hoMemory::allocate(2000); }).get();
+    EXPECT_EQ(account->live_bytes(),4500u);
+
+    for (auto block : { from_async, from_post, nested, other }) hoMemory::deallocate(block);
+    EXPECT_EQ(account->live_bytes(),0u);
+    pool.join();
+}
+
+TEST(ThreadPoolTest,taskGroupTest){
+    std::atomic<int> finished{0};
+    {
+        TaskGroup tasks{ThreadPool::shared()};
+        auto failed = tasks.async([](){ throw std::runtime_error("fail"); });
+        for (int i = 0; i < 32; i++){
+            tasks.async([&](int delay){
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+                finished++;
+            }, 1 + i % 4);
+        }
+
+        // Give up on the results after the first failure; leaving the scope must still wait for the rest.
+        EXPECT_THROW(failed.get(),std::runtime_error);
+    }
+    EXPECT_EQ(finished,32);
+
+    TaskGroup tasks{ThreadPool::shared()};
+    tasks.wait();
+    auto value = tasks.async([](int x){ return 2*x; }, 21);
+    tasks.wait();
+    EXPECT_EQ(value.get(),42);
+}
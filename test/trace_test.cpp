@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "GadgetronTimer.h"
+#include "trace.h"
+
+using namespace Gadgetron;
+
+TEST(TraceTest, nothingRecordedWithoutTrace) {
+    auto trace = std::make_shared<Tracing::Trace>("connection");
+    {
+        Tracing::Span span("outside", "test");
+    }
+    EXPECT_TRUE(trace->events().empty());
+    EXPECT_FALSE(Tracing::current());
+}
+
+TEST(TraceTest, spansAreTaggedAndNested) {
+    auto trace = std::make_shared<Tracing::Trace>("connection");
+    {
+        Tracing::ScopedTrace scoped_trace(trace, "gadget");
+        Tracing::Span outer("outer", "test");
+        {
+            Tracing::Span inner("inner", "test", 7);
+        }
+    }
+    EXPECT_FALSE(Tracing::current());
+
+    auto events = trace->events();
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_STREQ(events[0].name, "inner");
+    EXPECT_STREQ(events[0].gadget, "gadget");
+    EXPECT_EQ(events[0].message, 7);
+    EXPECT_STREQ(events[1].name, "outer");
+    EXPECT_EQ(events[1].message, -1);
+    EXPECT_LE(events[1].begin, events[0].begin);
+    EXPECT_GE(events[1].end, events[0].end);
+}
+
+TEST(TraceTest, scopedTraceRestoresPrevious) {
+    auto trace = std::make_shared<Tracing::Trace>("connection");
+    Tracing::ScopedTrace outer(trace, "outer");
+    {
+        Tracing::ScopedTrace inner(nullptr, "");
+        Tracing::Span span("ignored", "test");
+    }
+    Tracing::Span span("recorded", "test");
+    EXPECT_STREQ(Tracing::current_gadget(), "outer");
+    EXPECT_EQ(Tracing::current(), trace);
+}
+
+TEST(TraceTest, threadsRecordConcurrently) {
+    auto trace = std::make_shared<Tracing::Trace>("connection");
+    const int spans_per_thread = 5000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            Tracing::ScopedTrace scoped_trace(trace, "thread " + std::to_string(t));
+            for (int i = 0; i < spans_per_thread; i++) Tracing::Span span("work", "test", i);
+        });
+    }
+
+    // Reading while the threads record must be safe.
+    while (trace->events().size() < 4 * spans_per_thread) std::this_thread::yield();
+    for (auto &thread : threads) thread.join();
+
+    EXPECT_EQ(trace->events().size(), 4 * spans_per_thread);
+    EXPECT_EQ(trace->dropped(), 0);
+}
+
+TEST(TraceTest, timerRecordsSpan) {
+    auto trace = std::make_shared<Tracing::Trace>("connection");
+    {
+        Tracing::ScopedTrace scoped_trace(trace, "gadget");
+        GadgetronTimer timer("timed section");
+    }
+
+    auto events = trace->events();
+    ASSERT_EQ(events.size(), 1);
+    EXPECT_STREQ(events[0].name, "timed section");
+    EXPECT_STREQ(events[0].category, "timer");
+}
+
+TEST(TraceTest, chromeTraceFormat) {
+    auto trace = std::make_shared<Tracing::Trace>("connection \"1\"");
+    {
+        Tracing::ScopedTrace scoped_trace(trace, "gadget");
+        Tracing::Span span("span", "test", 3);
+    }
+
+    std::stringstream stream;
+    trace->write_chrome_trace(stream);
+    auto json = stream.str();
+
+    EXPECT_NE(json.find("\"traceEvents\":["), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"thread_name\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"span\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"connection\":\"connection \\\"1\\\"\""), std::string::npos);
+    EXPECT_NE(json.find("\"gadget\":\"gadget\",\"message\":3"), std::string::npos);
+}
@@ -18,6 +18,10 @@
 #include "cmr_spirit_recon.h"
 #include <boost/math/special_functions/sign.hpp>
 
+#ifdef USE_OMP
+    #include <omp.h>
+#endif // USE_OMP
+
 namespace Gadgetron { 
 
 template <typename T> 
@@ -116,6 +120,8 @@ CmrKSpaceBinning<T>::CmrKSpaceBinning()
     kspace_binning_moco_iters_[3] = 100;
     kspace_binning_moco_iters_[4] = 100;
 
+    kspace_binning_max_concurrent_bins_ = 0;
+
     kspace_binning_kSize_RO_ = 7;
     kspace_binning_kSize_E1_ = 7;
     kspace_binning_reg_lamda_ = 0.005;
@@ -1624,100 +1630,125 @@ void CmrKSpaceBinning<T>::compute_kspace_binning(const std::vector<size_t>& best
                 ArrayType coil_map(RO, E1, CHA, coil_map_raw.begin());
                 if ( !debug_folder_.empty() ) gt_exporter_.export_array_complex(coil_map, debug_folder_ + "coil_map" + os.str() + suffix_);
 
-                ArrayType complexIm(RO, E1, CHA);
+                // every output bin only reads the warpped images and writes its own part of the binned kspace,
+                // so the bins are filled concurrently
+                int num_threads = 1;
+#ifdef USE_OMP
+                num_threads = omp_get_max_threads();
+                if ( this->kspace_binning_max_concurrent_bins_ > 0 && (size_t)num_threads > this->kspace_binning_max_concurrent_bins_ ) num_threads = (int)this->kspace_binning_max_concurrent_bins_;
+                if ( (size_t)num_threads > dstN ) num_threads = (int)dstN;
+#endif // USE_OMP
 
-                ArrayType kspace_filled(RO, E1, CHA);
-                hoNDArray< float > hit_count(E1);
+                if ( this->perform_timing_ ) { gt_timer_local_.start("fill the binned kspace ... "); }
 
-                for (n=0; n<dstN; n++)
+                bool bin_failed = false;
+                long long dst_n;
+
+#pragma omp parallel for private(dst_n) schedule(dynamic, 1) num_threads(num_threads) if(num_threads>1)
+                for (dst_n=0; dst_n<(long long)dstN; dst_n++)
                 {
-                    GDEBUG_CONDITION_STREAM(this->verbose_, "Perform binning on step = " << n << " out of " << dstN);
+                    try
+                    {
+                        size_t n = (size_t)dst_n;
 
-                    ArrayType warpped_complex_images_multi_channel_wider;
-                    ArrayType warpped_complex_images_multi_channel_image_domain_average_wider;
+                        GDEBUG_CONDITION_STREAM(this->verbose_, "Perform binning on step = " << n << " out of " << dstN);
 
-                    size_t num_selected_image_wider = selected_images_wider[n].size();
+                        ArrayType complexIm(RO, E1, CHA);
 
-                    if(CHA>1)
-                    {
-                        // go back to multi-channel
-                        if ( this->perform_timing_ ) { gt_timer_local_.start("go back to multi-channel ... "); }
+                        ArrayType kspace_filled(RO, E1, CHA);
+                        hoNDArray< float > hit_count(E1);
+
+                        ArrayType warpped_complex_images_multi_channel_wider;
+                        ArrayType warpped_complex_images_multi_channel_image_domain_average_wider;
 
-                        warpped_complex_images_multi_channel_wider.create(RO, E1, CHA, num_selected_image_wider);
+                        size_t num_selected_image_wider = selected_images_wider[n].size();
 
-                        for (size_t ii=0; ii<num_selected_image_wider; ii++)
+                        if(CHA>1)
                         {
-                            ArrayType complexIm2D(RO, E1, warpped_complex_images_wider[n].begin()+ii*RO*E1);
-                            Gadgetron::multiply(coil_map, complexIm2D, complexIm);
-                            memcpy(warpped_complex_images_multi_channel_wider.begin()+ii*RO*E1*CHA, complexIm.begin(), complexIm.get_number_of_bytes());
+                            // go back to multi-channel
+                            warpped_complex_images_multi_channel_wider.create(RO, E1, CHA, num_selected_image_wider);
+
+                            for (size_t ii=0; ii<num_selected_image_wider; ii++)
+                            {
+                                ArrayType complexIm2D(RO, E1, warpped_complex_images_wider[n].begin()+ii*RO*E1);
+                                Gadgetron::multiply(coil_map, complexIm2D, complexIm);
+                                memcpy(warpped_complex_images_multi_channel_wider.begin()+ii*RO*E1*CHA, complexIm.begin(), complexIm.get_number_of_bytes());
+                            }
                         }
+                        else
+                        {
+                            warpped_complex_images_multi_channel_wider.create(RO, E1, 1, num_selected_image_wider);
 
-                        if ( this->perform_timing_ ) { gt_timer_local_.stop(); }
-                    }
-                    else
-                    {
-                        warpped_complex_images_multi_channel_wider.create(RO, E1, 1, num_selected_image_wider);
+                            for (size_t ii=0; ii<num_selected_image_wider; ii++)
+                            {
+                                memcpy(warpped_complex_images_multi_channel_wider.begin()+ii*RO*E1, complex_image.begin() + selected_images_wider[n][ii]*RO*E1, complexIm.get_number_of_bytes());
+                            }
+                        }
 
-                        for (size_t ii=0; ii<num_selected_image_wider; ii++)
+                        if ( !debug_folder_.empty() )
                         {
-                            memcpy(warpped_complex_images_multi_channel_wider.begin()+ii*RO*E1, complex_image.begin() + selected_images_wider[n][ii]*RO*E1, complexIm.get_number_of_bytes());
+                            std::stringstream os_local;
+                            os_local << "_N_" << n << "_S_" << s;
+
+                            gt_exporter_.export_array_complex(warpped_complex_images_multi_channel_wider, debug_folder_ + "warpped_complex_images_multi_channel" + os_local.str() + suffix_);
                         }
-                    }
 
-                    if ( !debug_folder_.empty() )
-                    {
-                        std::stringstream os_local;
-                        os_local << "_N_" << n << "_S_" << s;
+                        // average across all N
+                        Gadgetron::sum_over_dimension(warpped_complex_images_multi_channel_wider, warpped_complex_images_multi_channel_image_domain_average_wider, 3);
+                        Gadgetron::scal( (T)(1.0/num_selected_image_wider), warpped_complex_images_multi_channel_image_domain_average_wider);
 
-                        gt_exporter_.export_array_complex(warpped_complex_images_multi_channel_wider, debug_folder_ + "warpped_complex_images_multi_channel" + os_local.str() + suffix_);
-                    }
+                        if ( !debug_folder_.empty() )
+                        {
+                            std::stringstream os_local;
+                            os_local << "_N_" << n << "_S_" << s;
 
-                    // average across all N
-                    Gadgetron::sum_over_dimension(warpped_complex_images_multi_channel_wider, warpped_complex_images_multi_channel_image_domain_average_wider, 3);
-                    Gadgetron::scal( (T)(1.0/num_selected_image_wider), warpped_complex_images_multi_channel_image_domain_average_wider);
+                            gt_exporter_.export_array_complex(warpped_complex_images_multi_channel_image_domain_average_wider, debug_folder_ + "warpped_complex_images_multi_channel_image_domain_average" + os_local.str() + suffix_);
+                        }
 
-                    if ( !debug_folder_.empty() )
-                    {
-                        std::stringstream os_local;
-                        os_local << "_N_" << n << "_S_" << s;
+                        // go back to kspace
+                        Gadgetron::hoNDFFT<typename realType<T>::Type>::instance()->fft2c(warpped_complex_images_multi_channel_wider);
 
-                        gt_exporter_.export_array_complex(warpped_complex_images_multi_channel_image_domain_average_wider, debug_folder_ + "warpped_complex_images_multi_channel_image_domain_average" + os_local.str() + suffix_);
-                    }
+                        // fill the binned kspace
+                        this->fill_binned_kspace(s, n, selected_images_wider[n], warpped_complex_images_multi_channel_wider, kspace_filled, hit_count);
 
-                    // go back to kspace
-                    if ( this->perform_timing_ ) { gt_timer_local_.start("go back to kspace ... "); }
-                    Gadgetron::hoNDFFT<typename realType<T>::Type>::instance()->fft2c(warpped_complex_images_multi_channel_wider);
-                    if ( this->perform_timing_ ) { gt_timer_local_.stop(); }
+                        // copy results
+                        memcpy(kspace_binning_wider.begin()+n*RO*E1*CHA, kspace_filled.begin(), kspace_filled.get_number_of_bytes());
+                        memcpy(kspace_binning_image_domain_average.begin()+n*RO*E1*CHA, warpped_complex_images_multi_channel_image_domain_average_wider.begin(), warpped_complex_images_multi_channel_image_domain_average_wider.get_number_of_bytes());
 
-                    // fill the binned kspace
-                    if ( this->perform_timing_ ) { gt_timer_local_.start("fill the binned kspace ... "); }
-                    this->fill_binned_kspace(s, n, selected_images_wider[n], warpped_complex_images_multi_channel_wider, kspace_filled, hit_count);
-                    if ( this->perform_timing_ ) { gt_timer_local_.stop(); }
+                        // ---------------------------------------------
 
-                    // copy results
-                    memcpy(kspace_binning_wider.begin()+n*RO*E1*CHA, kspace_filled.begin(), kspace_filled.get_number_of_bytes());
-                    memcpy(kspace_binning_image_domain_average.begin()+n*RO*E1*CHA, warpped_complex_images_multi_channel_image_domain_average_wider.begin(), warpped_complex_images_multi_channel_image_domain_average_wider.get_number_of_bytes());
+                        size_t num_of_images = selected_images[n].size();
 
-                    // ---------------------------------------------
+                        ArrayType warpped_complex_images_multi_channel;
+                        warpped_complex_images_multi_channel.create(RO, E1, CHA, num_of_images);
 
-                    size_t num_of_images = selected_images[n].size();
+                        for (size_t ii=0; ii<num_of_images; ii++)
+                        {
+                            memcpy(warpped_complex_images_multi_channel.begin()+ii*RO*E1*CHA, 
+                                warpped_complex_images_multi_channel_wider.begin()+loc_in_wider[n][ii]*RO*E1*CHA, 
+                                sizeof(std::complex<T>)*RO*E1*CHA);
+                        }
 
-                    ArrayType warpped_complex_images_multi_channel;
-                    warpped_complex_images_multi_channel.create(RO, E1, CHA, num_of_images);
+                        this->fill_binned_kspace(s, n, selected_images[n], warpped_complex_images_multi_channel, kspace_filled, hit_count);
 
-                    for (ii=0; ii<num_of_images; ii++)
+                        memcpy(kspace_binning.begin()+n*RO*E1*CHA, kspace_filled.begin(), kspace_filled.get_number_of_bytes());
+                        memcpy(kspace_binning_hit_count.begin()+n*E1, hit_count.begin(), hit_count.get_number_of_bytes());
+
+                        GDEBUG_CONDITION_STREAM(this->verbose_, "==================================================================");
+                    }
+                    catch(...)
                     {
-                        memcpy(warpped_complex_images_multi_channel.begin()+ii*RO*E1*CHA, 
-                            warpped_complex_images_multi_channel_wider.begin()+loc_in_wider[n][ii]*RO*E1*CHA, 
-                            sizeof(std::complex<T>)*RO*E1*CHA);
+                        GERROR_STREAM("KSpace binning for S " << s << " failed for output phase " << dst_n);
+#pragma omp critical
+                        bin_failed = true;
                     }
+                }
 
-                    this->fill_binned_kspace(s, n, selected_images[n], warpped_complex_images_multi_channel, kspace_filled, hit_count);
-
-                    memcpy(kspace_binning.begin()+n*RO*E1*CHA, kspace_filled.begin(), kspace_filled.get_number_of_bytes());
-                    memcpy(kspace_binning_hit_count.begin()+n*E1, hit_count.begin(), hit_count.get_number_of_bytes());
+                if ( this->perform_timing_ ) { gt_timer_local_.stop(); }
 
-                    GDEBUG_CONDITION_STREAM(this->verbose_, "==================================================================");
+                if ( bin_failed )
+                {
+                    GADGET_THROW("Exceptions happened when filling the binned kspace ... ");
                 }
 
                 if ( !debug_folder_.empty() ) gt_exporter_.export_array_complex(kspace_binning_image_domain_average, debug_folder_ + "kspace_binning_image_domain_average_IMAGE" + os.str() + suffix_);
@@ -255,6 +255,10 @@ namespace Gadgetron {
         // minimal allowed temporal window in ms
         float kspace_binning_minimal_cardiac_phase_width_;
 
+        // maximal number of output bins filled at the same time; every bin in flight holds its own multi-channel
+        // copy of the selected images. 0 means as many as there are threads
+        size_t kspace_binning_max_concurrent_bins_;
+
         // ======================================================================================
         /// parameter for recon after binning
         // ======================================================================================
@@ -192,6 +192,8 @@ CmrParametricMapping<T>::CmrParametricMapping()
     max_map_value_ = -1;
     min_map_value_ = 0;
 
+    use_batched_fitting_ = false;
+
     verbose_ = false;
     perform_timing_ = false;
 
@@ -285,6 +287,12 @@ void CmrParametricMapping<T>::perform_parametric_mapping()
                     pMaskCurr = pMask + s*RO*E1 + slc*S*RO*E1;
                 }
 
+                if (this->use_batched_fitting_)
+                {
+                    this->perform_batched_mapping(pData, pMaskCurr, RO*E1, pMap, pPara, pMapSD, pParaSD);
+                    continue;
+                }
+
 #pragma omp parallel private(e1, ro, n) shared(RO, E1, pMask, pMaskCurr, pData, pMap, pMapSD, pPara, pParaSD, num_ti, NUM)
                 {
                     std::vector<T> yi(num_ti, 0);
@@ -435,6 +443,116 @@ void CmrParametricMapping<T>::compute_map(const std::vector<T>& ti, const std::v
     map_v = 0;
 }
 
+template <typename T>
+void CmrParametricMapping<T>::perform_batched_mapping(const T* pData, const T* pMask, size_t num_pixels, T* pMap, T* pPara, T* pMapSD, T* pParaSD)
+{
+    size_t num_ti = ti_.size();
+    size_t NUM = this->get_num_of_paras();
+
+    std::vector<size_t> pixels;
+    pixels.reserve(num_pixels);
+
+    size_t pixel;
+    for (pixel = 0; pixel < num_pixels; pixel++)
+    {
+        if (pMask == NULL || pMask[pixel] > 0) pixels.push_back(pixel);
+    }
+
+    // large enough to fill the lanes of the batched solvers, small enough to balance the load between threads
+    const size_t chunk = 256;
+    long long num_chunks = (long long)((pixels.size() + chunk - 1) / chunk);
+
+    long long c;
+
+#pragma omp parallel for schedule(dynamic) private(c) shared(pixels, pData, pMap, pMapSD, pPara, pParaSD, num_pixels, num_ti, NUM, num_chunks)
+    for (c = 0; c < num_chunks; c++)
+    {
+        size_t start = c*chunk;
+        size_t count = std::min(chunk, pixels.size() - start);
+
+        std::vector<T> y(num_ti*count), b(NUM*count), map_v(count);
+
+        size_t n, p;
+        for (n = 0; n < num_ti; n++)
+        {
+            for (p = 0; p < count; p++)
+            {
+                y[n*count + p] = pData[pixels[start + p] + n*num_pixels];
+            }
+        }
+
+        this->compute_map_batch(ti_, y.data(), count, b.data(), map_v.data());
+
+        for (p = 0; p < count; p++)
+        {
+            size_t offset = pixels[start + p];
+
+            pMap[offset] = map_v[p];
+            for (n = 0; n < NUM; n++)
+            {
+                pPara[offset + n*num_pixels] = b[n*count + p];
+            }
+        }
+
+        if (this->compute_SD_maps_)
+        {
+            std::vector<T> yi(num_ti, 0);
+            std::vector<T> bi(NUM, 0);
+            std::vector<T> sd(NUM + 1, 0);
+
+            T map_sd(0);
+
+            for (p = 0; p < count; p++)
+            {
+                size_t offset = pixels[start + p];
+
+                for (n = 0; n < num_ti; n++) yi[n] = y[n*count + p];
+                for (n = 0; n < NUM; n++) bi[n] = b[n*count + p];
+
+                try
+                {
+                    this->compute_sd(ti_, yi, bi, sd, map_sd);
+                }
+                catch (...)
+                {
+                    for (n = 0; n < NUM; n++)
+                    {
+                        sd[n] = 0;
+                    }
+
+                    map_sd = 0;
+                }
+
+                pMapSD[offset] = map_sd;
+                for (n = 0; n < NUM; n++)
+                {
+                    pParaSD[offset + n*num_pixels] = sd[n];
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void CmrParametricMapping<T>::compute_map_batch(const VectorType& ti, const T* yi, size_t count, T* bi, T* map_v)
+{
+    size_t num_ti = ti.size();
+    size_t NUM = this->get_num_of_paras();
+
+    VectorType y(num_ti, 0), guess, b;
+
+    size_t n, p;
+    for (p = 0; p < count; p++)
+    {
+        for (n = 0; n < num_ti; n++) y[n] = yi[n*count + p];
+
+        this->get_initial_guess(ti, y, guess);
+        this->compute_map(ti, y, guess, b, map_v[p]);
+
+        for (n = 0; n < NUM; n++) bi[n*count + p] = (n < b.size()) ? b[n] : 0;
+    }
+}
+
 template <typename T>
 void CmrParametricMapping<T>::compute_sd(const std::vector<T>& ti, const std::vector<T>& yi, const std::vector<T>& bi, std::vector<T>& sd, T& map_sd)
 {
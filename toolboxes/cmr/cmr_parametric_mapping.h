@@ -106,6 +106,10 @@ namespace Gadgetron {
         T max_map_value_;
         T min_map_value_;
 
+        /// if true, the pixels of every image are fitted together with compute_map_batch
+        /// if false, they are fitted one by one with get_initial_guess and compute_map
+        bool use_batched_fitting_;
+
         // ======================================================================================
         /// parameter for debugging
         // ======================================================================================
@@ -134,6 +138,11 @@ namespace Gadgetron {
         /// compute map values for every parameters in bi
         virtual void compute_map(const VectorType& ti, const VectorType& yi, const VectorType& guess, VectorType& bi, T& map_v);
 
+        /// compute map values for count pixels at once
+        /// yi: [num_ti count], signal of every pixel; bi: [NUM count], fitted parameters; map_v: [count]
+        /// the default fits every pixel with get_initial_guess and compute_map
+        virtual void compute_map_batch(const VectorType& ti, const T* yi, size_t count, T* bi, T* map_v);
+
         /// compute SD values for every parameters in bi
         virtual void compute_sd(const VectorType& ti, const VectorType& yi, const VectorType& bi, VectorType& sd, T& map_sd);
 
@@ -142,5 +151,9 @@ namespace Gadgetron {
 
         /// return number of parameters, including the map itself
         virtual size_t get_num_of_paras() const;
+
+        /// fit all pixels of one [RO E1] image with compute_map_batch, and compute their SD if needed
+        /// pData: [RO E1 N], pMask: [RO E1] or NULL, pPara and pParaSD: [RO E1 NUM]
+        void perform_batched_mapping(const T* pData, const T* pMask, size_t num_pixels, T* pMap, T* pPara, T* pMapSD, T* pParaSD);
     };
 }
@@ -11,6 +11,7 @@
 #include "hoNDArray_math.h"
 
 #include "simplexLagariaSolver.h"
+#include "batchedLevenbergMarquardtSolver.h"
 #include "twoParaExpRecoveryOperator.h"
 #include "curveFittingCostFunction.h"
 
@@ -97,6 +98,52 @@ void CmrT1SRMapping<T>::compute_map(const VectorType& ti, const VectorType& yi,
     }
 }
 
+template <typename T>
+void CmrT1SRMapping<T>::compute_map_batch(const VectorType& ti, const T* yi, size_t count, T* bi, T* map_v)
+{
+    try
+    {
+        size_t num = ti.size();
+        GADGET_CHECK_THROW(num > 0);
+
+        size_t n, p;
+
+        // same initial guess as get_initial_guess
+        T* A = bi;
+        T* T1 = bi + count;
+
+        for (p = 0; p < count; p++) A[p] = yi[p];
+        for (n = 1; n < num; n++)
+        {
+            const T* y = yi + n*count;
+            for (p = 0; p < count; p++) A[p] = std::max(A[p], y[p]);
+        }
+
+        for (p = 0; p < count; p++) T1[p] = ti[num / 2];
+
+        Gadgetron::batchedLevenbergMarquardtSolver< T, Gadgetron::batched_fitting::twoParaExpRecovery<T> > solver;
+        solver.max_iter_ = max_iter_;
+        solver.thres_fun_ = thres_fun_;
+
+        solver.solve(&ti[0], num, yi, count, bi);
+
+        for (p = 0; p < count; p++)
+        {
+            map_v[p] = 0;
+            if (A[p] > 0 && T1[p] > 0)
+            {
+                map_v[p] = T1[p];
+                if (map_v[p] >= max_map_value_) map_v[p] = hole_marking_value_;
+                if (map_v[p] <= min_map_value_) map_v[p] = hole_marking_value_;
+            }
+        }
+    }
+    catch (...)
+    {
+        GADGET_THROW("Exceptions happened in CmrT1SRMapping<T>::compute_map_batch(...) ... ");
+    }
+}
+
 template <typename T>
 void CmrT1SRMapping<T>::compute_sd(const VectorType& ti, const VectorType& yi, const VectorType& bi, VectorType& sd, T& map_sd)
 {
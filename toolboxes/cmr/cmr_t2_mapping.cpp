@@ -12,6 +12,7 @@
 #include "hoNDArray_linalg.h"
 
 #include "simplexLagariaSolver.h"
+#include "batchedLevenbergMarquardtSolver.h"
 #include "twoParaExpDecayOperator.h"
 #include "curveFittingCostFunction.h"
 
@@ -134,6 +135,90 @@ void CmrT2Mapping<T>::compute_map(const VectorType& ti, const VectorType& yi, co
     }
 }
 
+template <typename T>
+void CmrT2Mapping<T>::compute_map_batch(const VectorType& ti, const T* yi, size_t count, T* bi, T* map_v)
+{
+    try
+    {
+        size_t num = ti.size();
+        GADGET_CHECK_THROW(num > 0);
+
+        size_t n, p;
+
+        // same initial guess as get_initial_guess, a log linear fit log(y) = a*ti + b
+        // falling back to A = max(yi) and T2 = ti[num/2] where the fit is not possible
+        T* A = bi;
+        T* T2 = bi + count;
+
+        T sx(0), sxx(0);
+        for (n = 0; n < num; n++)
+        {
+            sx += ti[n];
+            sxx += ti[n] * ti[n];
+        }
+        T det = num*sxx - sx*sx;
+
+        for (p = 0; p < count; p++)
+        {
+            T max_y = yi[p];
+            T sy(0), sxy(0);
+            bool positive = true;
+
+            for (n = 0; n < num; n++)
+            {
+                T y = yi[n*count + p];
+                max_y = std::max(max_y, y);
+
+                if (y <= 0)
+                {
+                    positive = false;
+                    continue;
+                }
+
+                T log_y = std::log(y);
+                sy += log_y;
+                sxy += ti[n] * log_y;
+            }
+
+            A[p] = max_y;
+            T2[p] = ti[num / 2];
+
+            if (positive && det != 0)
+            {
+                T a = (num*sxy - sx*sy) / det;
+                T b = (sy - a*sx) / num;
+
+                if (-1.0 / a >= 0)
+                {
+                    A[p] = std::exp(b);
+                    T2[p] = -1.0 / a;
+                }
+            }
+        }
+
+        Gadgetron::batchedLevenbergMarquardtSolver< T, Gadgetron::batched_fitting::twoParaExpDecay<T> > solver;
+        solver.max_iter_ = max_iter_;
+        solver.thres_fun_ = thres_fun_;
+
+        solver.solve(&ti[0], num, yi, count, bi);
+
+        for (p = 0; p < count; p++)
+        {
+            map_v[p] = 0;
+            if (A[p] > 0 && T2[p] > 0)
+            {
+                map_v[p] = T2[p];
+                if (map_v[p] >= max_map_value_) map_v[p] = hole_marking_value_;
+                if (map_v[p] <= min_map_value_) map_v[p] = hole_marking_value_;
+            }
+        }
+    }
+    catch (...)
+    {
+        GADGET_THROW("Exceptions happened in CmrT2Mapping<T>::compute_map_batch(...) ... ");
+    }
+}
+
 template <typename T>
 void CmrT2Mapping<T>::compute_sd(const VectorType& ti, const VectorType& yi, const VectorType& bi, VectorType& sd, T& map_sd)
 {
@@ -46,6 +46,9 @@ public:
     /// compute map values for every parameters in bi
     virtual void compute_map(const VectorType& ti, const VectorType& yi, const VectorType& guess, VectorType& bi, T& map_v);
 
+    /// fit all pixels together with the batched Levenberg-Marquardt solver
+    virtual void compute_map_batch(const VectorType& ti, const T* yi, size_t count, T* bi, T* map_v);
+
     /// compute SD values for every parameters in bi
     virtual void compute_sd(const VectorType& ti, const VectorType& yi, const VectorType& bi, VectorType& sd, T& map_sd);
 
@@ -72,6 +75,7 @@ public:
     using BaseClass::thres_fun_;
     using BaseClass::max_map_value_;
     using BaseClass::min_map_value_;
+    using BaseClass::use_batched_fitting_;
 
     using BaseClass::verbose_;
     using BaseClass::debug_folder_;
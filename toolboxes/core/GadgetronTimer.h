@@ -1,5 +1,7 @@
 /** \file GadgetronTimer.h
     \brief Generic timer class to measure runtime performance.
+
+    When the thread has a trace installed (see trace.h), the time is recorded as a span instead of being logged.
 */
 
 #ifndef __GADGETRONTIMER_H
@@ -15,6 +17,7 @@
 
 #include <string>
 #include "log.h"
+#include "trace.h"
 
 namespace Gadgetron{
 
@@ -60,6 +63,7 @@ namespace Gadgetron{
 
     virtual void start()
     {
+        trace_begin_ = Tracing::now();
 #ifdef WIN32
         QueryPerformanceFrequency(&frequency_);
         QueryPerformanceCounter(&start_);
@@ -84,7 +88,14 @@ namespace Gadgetron{
         gettimeofday(&end_, NULL);
         time_in_us = ((end_.tv_sec * 1e6) + end_.tv_usec) - ((start_.tv_sec * 1e6) + start_.tv_usec);
 #endif
-	GDEBUG("%s:%f ms\n", name_.c_str(), time_in_us/1000.0);
+        if ( Tracing::current_gadget() )
+        {
+            Tracing::record(name_, "timer", trace_begin_, Tracing::now());
+        }
+        else
+        {
+            GDEBUG("%s:%f ms\n", name_.c_str(), time_in_us/1000.0);
+        }
         return time_in_us;
     }
 
@@ -103,6 +114,8 @@ namespace Gadgetron{
 
     std::string name_;
 
+    uint64_t trace_begin_;
+
     bool timing_in_destruction_;
   };
 }
@@ -0,0 +1,186 @@
+/** \file   hoContentCache.cpp
+    \brief  Cache of computed results, keyed by the content they are computed from.
+*/
+
+#include "hoContentCache.h"
+
+#include <cstring>
+
+namespace Gadgetron
+{
+    namespace
+    {
+        // Two independent 64 bit hashes are computed in one pass, each over four lanes (xxHash64 style), so that
+        // hashing runs at close to memory bandwidth.
+        const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+        const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+        const uint64_t prime3 = 0x165667B19E3779F9ULL;
+        const uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+        const uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+        inline uint64_t rotl(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        inline uint64_t lane_round(uint64_t acc, uint64_t word, uint64_t multiplier)
+        {
+            acc += word * prime2;
+            acc = rotl(acc, 31);
+            return acc * multiplier;
+        }
+
+        inline uint64_t avalanche(uint64_t h)
+        {
+            h ^= h >> 33;
+            h *= prime2;
+            h ^= h >> 29;
+            h *= prime3;
+            h ^= h >> 32;
+            return h;
+        }
+
+        inline uint64_t read64(const unsigned char* p)
+        {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            return word;
+        }
+
+        void hash128(const void* data, size_t bytes, uint64_t digest[2])
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            const unsigned char* const end = p + bytes;
+
+            uint64_t a[4] = { digest[0] + prime1 + prime2, digest[0] + prime2, digest[0], digest[0] - prime1 };
+            uint64_t b[4] = { digest[1] + prime3, digest[1] ^ prime4, digest[1] - prime5, digest[1] + prime1 };
+
+            while (end - p >= 32)
+            {
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    uint64_t word = read64(p + 8 * lane);
+                    a[lane] = lane_round(a[lane], word, prime1);
+                    b[lane] = lane_round(b[lane], word, prime4);
+                }
+                p += 32;
+            }
+
+            uint64_t h0 = rotl(a[0], 1) + rotl(a[1], 7) + rotl(a[2], 12) + rotl(a[3], 18) + bytes;
+            uint64_t h1 = rotl(b[0], 3) + rotl(b[1], 11) + rotl(b[2], 19) + rotl(b[3], 27) + bytes * prime5;
+
+            while (end - p >= 8)
+            {
+                uint64_t word = read64(p);
+                h0 = rotl(h0 ^ lane_round(0, word, prime1), 27) * prime1 + prime4;
+                h1 = rotl(h1 ^ lane_round(0, word, prime4), 29) * prime3 + prime2;
+                p += 8;
+            }
+
+            while (p < end)
+            {
+                h0 = rotl(h0 ^ (*p * prime5), 11) * prime1;
+                h1 = rotl(h1 ^ (*p * prime3), 13) * prime4;
+                p++;
+            }
+
+            digest[0] = avalanche(h0);
+            digest[1] = avalanche(h1 ^ h0);
+        }
+    }
+
+    // ------------------------------------------------------------------------
+
+    ContentKey::ContentKey() : digest_{ prime5, prime3 }
+    {
+    }
+
+    ContentKey& ContentKey::add(const void* data, size_t bytes)
+    {
+        hash128(data, bytes, digest_);
+        return *this;
+    }
+
+    // ------------------------------------------------------------------------
+
+    ContentCache::ContentCache(size_t budget_bytes) : budget_(budget_bytes)
+    {
+    }
+
+    std::shared_ptr<const void> ContentCache::find(const ContentKey& key, std::type_index type)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto it = index_.find(key);
+        if (it == index_.end() || it->second->type != type)
+        {
+            stats_.misses++;
+            return nullptr;
+        }
+
+        entries_.splice(entries_.begin(), entries_, it->second);
+        stats_.hits++;
+        return it->second->value;
+    }
+
+    void ContentCache::insert(const ContentKey& key, std::type_index type, std::shared_ptr<const void> value, size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        if (bytes > budget_) return;
+
+        auto it = index_.find(key);
+        if (it != index_.end())
+        {
+            stats_.bytes -= it->second->bytes;
+            entries_.erase(it->second);
+            index_.erase(it);
+        }
+
+        evict_to(budget_ - bytes);
+
+        entries_.push_front(Entry{ key, type, std::move(value), bytes });
+        index_.emplace(key, entries_.begin());
+        stats_.bytes += bytes;
+    }
+
+    void ContentCache::evict_to(size_t budget_bytes)
+    {
+        while (stats_.bytes > budget_bytes && !entries_.empty())
+        {
+            stats_.bytes -= entries_.back().bytes;
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+            stats_.evictions++;
+        }
+    }
+
+    void ContentCache::set_budget(size_t budget_bytes)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        budget_ = budget_bytes;
+        evict_to(budget_);
+    }
+
+    size_t ContentCache::budget() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return budget_;
+    }
+
+    void ContentCache::clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        entries_.clear();
+        index_.clear();
+        stats_.bytes = 0;
+    }
+
+    ContentCache::Stats ContentCache::stats() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        Stats stats = stats_;
+        stats.entries = entries_.size();
+        return stats;
+    }
+}
@@ -0,0 +1,130 @@
+/** \file   hoContentCache.h
+    \brief  Cache of computed results, keyed by the content they are computed from.
+
+    A ContentKey is a 128 bit digest of everything a result depends on: the input data itself, sizes and
+    parameters. Input that is sent again unchanged (repeated measurements, the same trajectory for every frame)
+    hashes to the same key, and the result can be looked up instead of being recomputed.
+
+    Entries are evicted least recently used first to stay within a memory budget.
+*/
+
+#pragma once
+
+#include "cpucore_export.h"
+#include "hoNDArray.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+
+namespace Gadgetron
+{
+    class EXPORTCPUCORE ContentKey
+    {
+    public:
+        ContentKey();
+
+        /// mixes raw bytes into the key
+        ContentKey& add(const void* data, size_t bytes);
+
+        ContentKey& add(const std::string& value)
+        {
+            add(value.size());
+            return add(value.data(), value.size());
+        }
+
+        template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value>>
+        ContentKey& add(T value)
+        {
+            return add(&value, sizeof(value));
+        }
+
+        /// dimensions and content
+        template <typename T>
+        ContentKey& add(const hoNDArray<T>& array)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only arrays of plain data can be hashed");
+            add(array.get_number_of_dimensions());
+            for (size_t d = 0; d < array.get_number_of_dimensions(); d++) add(array.get_size(d));
+            return add(array.get_data_ptr(), array.get_number_of_bytes());
+        }
+
+        bool operator==(const ContentKey& other) const { return digest_[0] == other.digest_[0] && digest_[1] == other.digest_[1]; }
+        bool operator!=(const ContentKey& other) const { return !(*this == other); }
+
+        uint64_t hash() const { return digest_[0]; }
+
+    private:
+        uint64_t digest_[2];
+    };
+
+    class EXPORTCPUCORE ContentCache
+    {
+    public:
+        struct Stats
+        {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t evictions = 0;
+            size_t entries = 0;
+            size_t bytes = 0;
+        };
+
+        explicit ContentCache(size_t budget_bytes);
+
+        ContentCache(const ContentCache&) = delete;
+        ContentCache& operator=(const ContentCache&) = delete;
+
+        /// returns nullptr if the key is not cached, or was cached with a different type
+        template <typename T>
+        std::shared_ptr<const T> find(const ContentKey& key)
+        {
+            return std::static_pointer_cast<const T>(find(key, typeid(T)));
+        }
+
+        /// bytes is the memory held by value; values larger than the budget are not cached
+        template <typename T>
+        void insert(const ContentKey& key, std::shared_ptr<const T> value, size_t bytes)
+        {
+            insert(key, typeid(T), std::move(value), bytes);
+        }
+
+        void set_budget(size_t budget_bytes);
+        size_t budget() const;
+
+        void clear();
+        Stats stats() const;
+
+    private:
+        struct Entry
+        {
+            ContentKey key;
+            std::type_index type;
+            std::shared_ptr<const void> value;
+            size_t bytes;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const ContentKey& key) const { return size_t(key.hash()); }
+        };
+
+        std::shared_ptr<const void> find(const ContentKey& key, std::type_index type);
+        void insert(const ContentKey& key, std::type_index type, std::shared_ptr<const void> value, size_t bytes);
+        void evict_to(size_t budget_bytes);
+
+        mutable std::mutex mutex_;
+        size_t budget_;
+
+        // most recently used at the front
+        std::list<Entry> entries_;
+        std::unordered_map<ContentKey, std::list<Entry>::iterator, KeyHash> index_;
+
+        Stats stats_;
+    };
+}
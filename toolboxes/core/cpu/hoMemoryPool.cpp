@@ -0,0 +1,499 @@
+#include "hoMemoryPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Gadgetron {
+
+    namespace {
+
+        constexpr size_t cache_line = 64;
+        constexpr size_t huge_page  = size_t(2) << 20;
+
+        void* system_allocate(size_t bytes) {
+            const size_t alignment = bytes >= huge_page ? huge_page : cache_line;
+            const size_t size      = (bytes + cache_line - 1) / cache_line * cache_line;
+#if defined(_WIN32)
+            return _aligned_malloc(size, alignment);
+#else
+            void* ptr = nullptr;
+            if (posix_memalign(&ptr, alignment, size))
+                return nullptr;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            // Whole huge pages only; the header hoMemory puts in front of the data makes blocks spill over a little.
+            if (alignment == huge_page)
+                madvise(ptr, size / huge_page * huge_page, MADV_HUGEPAGE);
+#endif
+            return ptr;
+#endif
+        }
+
+        void system_deallocate(void* ptr) {
+#if defined(_WIN32)
+            _aligned_free(ptr);
+#else
+            std::free(ptr);
+#endif
+        }
+
+        // Four size classes per power of two, starting at 64 bytes, each with a cache line to spare for the header
+        // hoMemory puts in front of the data; arrays of a power of two bytes fit a class exactly.
+        constexpr size_t smallest_class_log2 = 6;
+
+        constexpr size_t floor_log2(size_t value) {
+            size_t result = 0;
+            while (value >>= 1)
+                result++;
+            return result;
+        }
+
+        constexpr size_t nominal_index(size_t bytes) {
+            if (bytes <= (size_t(1) << smallest_class_log2))
+                return 0;
+            size_t k    = floor_log2(bytes - 1);
+            size_t step = size_t(1) << (k - 2);
+            size_t j    = (bytes - 1 - (size_t(1) << k)) / step;
+            return (k - smallest_class_log2) * 4 + j + 1;
+        }
+
+        constexpr size_t nominal_size(size_t index) {
+            if (index == 0)
+                return size_t(1) << smallest_class_log2;
+            size_t k = (index - 1) / 4 + smallest_class_log2;
+            size_t j = (index - 1) % 4;
+            return (size_t(1) << k) + (j + 1) * (size_t(1) << (k - 2));
+        }
+
+        constexpr size_t class_index(size_t bytes) {
+            return nominal_index(bytes > cache_line ? bytes - cache_line : 0);
+        }
+
+        constexpr size_t class_size(size_t index) {
+            return nominal_size(index) + cache_line;
+        }
+
+        constexpr size_t number_of_classes = nominal_index(hoPooledAllocator::largest_size_class) + 1;
+        constexpr size_t number_of_thread_classes = nominal_index(hoPooledAllocator::thread_cache_limit) + 1;
+        constexpr size_t largest_class_size = class_size(number_of_classes - 1);
+
+        size_t thread_cache_depth(size_t size) {
+            return std::clamp<size_t>((size_t(2) << 20) / size, 2, 64);
+        }
+    }
+
+    /** hoMemoryAccount **/
+
+    namespace {
+
+        using Ledger = hoMemoryAccount::Ledger;
+
+        // 4 TiB of live bytes per account, and 4M generations per ledger before a stale reference could match.
+        constexpr unsigned live_bits      = 42;
+        constexpr uint64_t live_mask      = (uint64_t(1) << live_bits) - 1;
+        constexpr uint64_t generation_one = uint64_t(1) << live_bits;
+
+        // Ledgers of accounts that have gone away. Reused first in, first out, so that generations go up slowly.
+        struct LedgerPool {
+            std::mutex m;
+            std::deque<Ledger*> ledgers;
+        };
+
+        LedgerPool& ledger_pool() {
+            static LedgerPool* pool = new LedgerPool();
+            return *pool;
+        }
+
+        Ledger& acquire_ledger() {
+            auto& pool = ledger_pool();
+            std::lock_guard<std::mutex> guard(pool.m);
+            if (pool.ledgers.empty())
+                return *new Ledger();
+            Ledger* ledger = pool.ledgers.front();
+            pool.ledgers.pop_front();
+            return *ledger;
+        }
+
+        void release_ledger(Ledger& ledger) {
+            auto& pool = ledger_pool();
+            std::lock_guard<std::mutex> guard(pool.m);
+            pool.ledgers.push_back(&ledger);
+        }
+
+        // Adds bytes to ledger (or takes them off) and walks up its parents, stopping at the first ledger that has
+        // moved on to another account. The parent of a ledger is read before its generation is checked; a new
+        // account only sets it once the generation has changed.
+        void update(Ledger* ledger, uint64_t generation, size_t bytes, bool charge) {
+            while (ledger) {
+                Ledger* parent             = ledger->parent.load();
+                uint64_t parent_generation = ledger->parent_generation.load();
+
+                uint64_t state = ledger->state.load();
+                uint64_t next;
+                do {
+                    if ((state & ~live_mask) != generation)
+                        return;
+                    next = charge ? state + bytes : state - bytes;
+                } while (!ledger->state.compare_exchange_weak(state, next));
+
+                if (charge) {
+                    size_t now     = size_t(next & live_mask);
+                    size_t highest = ledger->peak.load(std::memory_order_relaxed);
+                    while (now > highest && !ledger->peak.compare_exchange_weak(highest, now, std::memory_order_relaxed)) {
+                    }
+                    ledger->count.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                ledger     = parent;
+                generation = parent_generation;
+            }
+        }
+    }
+
+    hoMemoryAccount::hoMemoryAccount(std::shared_ptr<hoMemoryAccount> parent)
+        : hoMemoryAccount(acquire_ledger(), std::move(parent), true) {}
+
+    hoMemoryAccount::hoMemoryAccount(Ledger& ledger, std::shared_ptr<hoMemoryAccount> parent)
+        : hoMemoryAccount(ledger, std::move(parent), false) {}
+
+    hoMemoryAccount::hoMemoryAccount(Ledger& ledger, std::shared_ptr<hoMemoryAccount> parent, bool pooled)
+        : parent_{ std::move(parent) }, ledger_{ &ledger }, pooled_{ pooled },
+          generation_{ ledger.state.load() & ~live_mask } {
+        ledger.parent.store(parent_ ? parent_->ledger_ : nullptr);
+        ledger.parent_generation.store(parent_ ? parent_->generation_ : 0);
+    }
+
+    hoMemoryAccount::~hoMemoryAccount() {
+        // Moving the ledger on to the next generation makes it ignore memory freed from now on; what is still
+        // charged to it is credited back to the parents here instead.
+        uint64_t state = ledger_->state.exchange(generation_ + generation_one);
+        if (state & live_mask)
+            update(ledger_->parent.load(), ledger_->parent_generation.load(), size_t(state & live_mask), false);
+
+        ledger_->peak.store(0, std::memory_order_relaxed);
+        ledger_->count.store(0, std::memory_order_relaxed);
+        if (pooled_)
+            release_ledger(*ledger_);
+    }
+
+    void hoMemoryAccount::add(size_t bytes) {
+        update(ledger_, generation_, bytes, true);
+    }
+
+    void hoMemoryAccount::remove(size_t bytes) {
+        update(ledger_, generation_, bytes, false);
+    }
+
+    void hoMemoryAccount::remove(const Reference& account, size_t bytes) {
+        update(account.ledger, account.generation, bytes, false);
+    }
+
+    size_t hoMemoryAccount::live_bytes() const {
+        return size_t(ledger_->state.load(std::memory_order_relaxed) & live_mask);
+    }
+
+    /** hoSystemAllocator **/
+
+    void* hoSystemAllocator::allocate(size_t bytes) {
+        return system_allocate(bytes);
+    }
+
+    void hoSystemAllocator::deallocate(void* ptr, size_t) {
+        system_deallocate(ptr);
+    }
+
+    /** hoPooledAllocator **/
+
+    struct hoPooledAllocator::Central {
+        struct alignas(cache_line) Bin {
+            std::mutex m;
+            std::vector<void*> blocks;
+        };
+
+        explicit Central(size_t max_cached_bytes) : bins(number_of_classes), max_cached{ max_cached_bytes } {}
+
+        ~Central() { release(); }
+
+        void* pop(size_t index) {
+            auto& bin = bins[index];
+            std::lock_guard<std::mutex> guard(bin.m);
+            if (bin.blocks.empty())
+                return nullptr;
+            void* ptr = bin.blocks.back();
+            bin.blocks.pop_back();
+            cached.fetch_sub(class_size(index), std::memory_order_relaxed);
+            return ptr;
+        }
+
+        void push(size_t index, void* ptr) {
+            const size_t size = class_size(index);
+            if (cached.fetch_add(size, std::memory_order_relaxed) + size > max_cached) {
+                cached.fetch_sub(size, std::memory_order_relaxed);
+                system_deallocate(ptr);
+                return;
+            }
+            auto& bin = bins[index];
+            std::lock_guard<std::mutex> guard(bin.m);
+            bin.blocks.push_back(ptr);
+        }
+
+        void release() {
+            for (size_t index = 0; index < bins.size(); index++) {
+                auto& bin = bins[index];
+                std::lock_guard<std::mutex> guard(bin.m);
+                for (auto ptr : bin.blocks)
+                    system_deallocate(ptr);
+                cached.fetch_sub(bin.blocks.size() * class_size(index), std::memory_order_relaxed);
+                bin.blocks.clear();
+            }
+        }
+
+        std::vector<Bin> bins;
+        std::atomic<size_t> cached{ 0 };
+        const size_t max_cached;
+    };
+
+    namespace {
+
+        // Blocks freed on a thread are kept there, so that the next allocation of the same size class needs no lock.
+        // The cache keeps the pool it belongs to alive, and hands everything back to it when the thread exits.
+        struct ThreadCache {
+            std::shared_ptr<hoPooledAllocator::Central> owner;
+            std::vector<std::vector<void*>> bins;
+
+            ~ThreadCache();
+
+            void bind(const std::shared_ptr<hoPooledAllocator::Central>& central) {
+                if (owner == central)
+                    return;
+                flush();
+                owner = central;
+                bins.resize(number_of_thread_classes);
+            }
+
+            void flush() {
+                if (!owner)
+                    return;
+                for (size_t index = 0; index < bins.size(); index++) {
+                    for (auto ptr : bins[index])
+                        owner->push(index, ptr);
+                    bins[index].clear();
+                }
+            }
+        };
+
+        // Trivially destructible, so it can still be checked while other thread locals are being destroyed.
+        thread_local bool thread_cache_destroyed = false;
+
+        ThreadCache::~ThreadCache() {
+            flush();
+            thread_cache_destroyed = true;
+        }
+
+        ThreadCache* thread_cache() {
+            if (thread_cache_destroyed)
+                return nullptr;
+            thread_local ThreadCache cache;
+            return &cache;
+        }
+    }
+
+    hoPooledAllocator::hoPooledAllocator(size_t max_cached_bytes)
+        : central{ std::make_shared<Central>(max_cached_bytes) } {}
+
+    hoPooledAllocator::~hoPooledAllocator() = default;
+
+    void* hoPooledAllocator::allocate(size_t bytes) {
+        if (bytes > largest_class_size)
+            return system_allocate(bytes);
+
+        const size_t index = class_index(bytes);
+        const size_t size  = class_size(index);
+
+        if (index < number_of_thread_classes) {
+            if (auto cache = thread_cache()) {
+                cache->bind(central);
+                auto& bin = cache->bins[index];
+                if (!bin.empty()) {
+                    void* ptr = bin.back();
+                    bin.pop_back();
+                    return ptr;
+                }
+            }
+        }
+
+        if (void* ptr = central->pop(index))
+            return ptr;
+
+        return system_allocate(size);
+    }
+
+    void hoPooledAllocator::deallocate(void* ptr, size_t bytes) {
+        if (bytes > largest_class_size) {
+            system_deallocate(ptr);
+            return;
+        }
+
+        const size_t index = class_index(bytes);
+        const size_t size  = class_size(index);
+
+        if (index < number_of_thread_classes) {
+            if (auto cache = thread_cache()) {
+                cache->bind(central);
+                auto& bin = cache->bins[index];
+                if (bin.size() < thread_cache_depth(size)) {
+                    bin.push_back(ptr);
+                    return;
+                }
+            }
+        }
+
+        central->push(index, ptr);
+    }
+
+    size_t hoPooledAllocator::cached_bytes() const {
+        return central->cached.load(std::memory_order_relaxed);
+    }
+
+    void hoPooledAllocator::release() {
+        central->release();
+    }
+
+    /** hoMemory **/
+
+    namespace {
+
+        // Every block starts with a cache line telling where it goes when it is freed, followed by the data.
+        struct Header {
+            hoMemoryAllocator* allocator;
+            size_t bytes;
+            hoMemoryAccount::Reference account;
+            char padding[cache_line - sizeof(hoMemoryAllocator*) - sizeof(size_t) - sizeof(hoMemoryAccount::Reference)
+                         - sizeof(uint64_t)];
+            uint64_t cookie;
+        };
+        static_assert(sizeof(Header) == cache_line, "The data must stay aligned to a cache line");
+
+        // hoNDArray can be handed memory it did not allocate, which is assumed to come from malloc. malloc keeps the
+        // size of a block just in front of it; sizes never have the top bit set, so they cannot be taken for this.
+        uint64_t cookie(const void* data) {
+            return (uint64_t(reinterpret_cast<uintptr_t>(data)) ^ 0x5f3c9a1d27e4b86bull) | (uint64_t(1) << 63);
+        }
+
+        // For memory from malloc, this reads malloc's own bookkeeping, which the sanitizers would report.
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((no_sanitize("address", "thread")))
+#endif
+        bool has_header(const void* data) {
+            return *(reinterpret_cast<const uint64_t*>(data) - 1) == cookie(data);
+        }
+
+        // These live until the very end of the process (and are deliberately never destroyed), as arrays may be
+        // freed by static destructors.
+        struct State {
+            State() {
+                const char* choice = std::getenv("GADGETRON_ALLOCATOR");
+                if (choice && std::string(choice) == "system")
+                    install(std::make_unique<hoSystemAllocator>());
+                else
+                    install(std::make_unique<hoPooledAllocator>());
+            }
+
+            void install(std::unique_ptr<hoMemoryAllocator> allocator) {
+                std::lock_guard<std::mutex> guard(m);
+                current.store(allocator.get(), std::memory_order_release);
+                allocators.push_back(std::move(allocator));
+            }
+
+            std::mutex m;
+            std::vector<std::unique_ptr<hoMemoryAllocator>> allocators;
+            std::atomic<hoMemoryAllocator*> current{ nullptr };
+            hoMemoryAccount account;
+        };
+
+        State& state() {
+            static State* state = new State();
+            return *state;
+        }
+
+        thread_local std::shared_ptr<hoMemoryAccount> thread_account;
+    }
+
+    void* hoMemory::allocate(size_t bytes) {
+        auto& s         = state();
+        auto& allocator = *s.current.load(std::memory_order_acquire);
+
+        if (bytes > std::numeric_limits<size_t>::max() - sizeof(Header))
+            return nullptr;
+        auto header = static_cast<Header*>(allocator.allocate(bytes + sizeof(Header)));
+        if (!header)
+            return nullptr;
+
+        s.account.add(bytes);
+        if (thread_account)
+            thread_account->add(bytes);
+
+        header->allocator = &allocator;
+        header->bytes     = bytes;
+        header->account   = thread_account ? thread_account->reference() : hoMemoryAccount::Reference{};
+        header->cookie    = cookie(header + 1);
+        return header + 1;
+    }
+
+    void hoMemory::deallocate(void* ptr) {
+        if (!ptr)
+            return;
+
+        if (!has_header(ptr)) {
+            std::free(ptr);
+            return;
+        }
+
+        auto header     = static_cast<Header*>(ptr) - 1;
+        header->cookie  = 0;
+        const auto bytes   = header->bytes;
+        const auto account = header->account;
+        header->allocator->deallocate(header, bytes + sizeof(Header));
+
+        state().account.remove(bytes);
+        hoMemoryAccount::remove(account, bytes);
+    }
+
+    void hoMemory::set_allocator(std::unique_ptr<hoMemoryAllocator> allocator) {
+        state().install(std::move(allocator));
+    }
+
+    hoMemoryAllocator& hoMemory::allocator() {
+        return *state().current.load(std::memory_order_acquire);
+    }
+
+    hoMemoryAccount& hoMemory::process_account() {
+        return state().account;
+    }
+
+    std::shared_ptr<hoMemoryAccount> hoMemory::current_account() {
+        return thread_account;
+    }
+
+    hoMemory::ScopedAccount::ScopedAccount(std::shared_ptr<hoMemoryAccount> account)
+        : previous{ std::move(thread_account) } {
+        thread_account = std::move(account);
+    }
+
+    hoMemory::ScopedAccount::~ScopedAccount() {
+        thread_account = std::move(previous);
+    }
+}
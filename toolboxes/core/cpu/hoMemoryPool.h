@@ -0,0 +1,184 @@
+/** \file hoMemoryPool.h
+    \brief Allocators and memory accounting for the data of hoNDArray.
+
+    All hoNDArray storage of plain data types goes through hoMemory::allocate and hoMemory::deallocate. By default
+    these use a size class pool which caches freed blocks (per thread for small blocks, process wide for larger ones),
+    so arrays of the same shape that are allocated again and again reuse memory that is already paged in.
+    Data is 64 byte aligned, behind a 64 byte header holding the allocator, size and account of the block; freeing
+    it needs neither a lock nor a lookup. Blocks of 2 MiB and more are aligned to 2 MiB and marked for transparent
+    huge pages.
+
+    Every allocation is counted in the process wide account, and in the account installed on the allocating thread
+    with hoMemory::ScopedAccount, if any.
+*/
+
+#pragma once
+
+#include "cpucore_export.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Gadgetron {
+
+    /**
+     * Byte counters for a group of allocations, e.g. a connection.
+     * An account with a parent charges everything to the parent as well, e.g. a gadget to its connection.
+     *
+     * Allocations refer to the account they were charged to without keeping it alive. When an account goes away,
+     * whatever is still charged to it is credited back to its parents, and freeing that memory later only credits
+     * the process account; so memory that outlives a connection (e.g. in a process wide cache) is not held against
+     * it once it has closed.
+     */
+    class EXPORTCPUCORE hoMemoryAccount {
+    public:
+        /**
+         * The counters behind an account. Ledgers are never freed, so that memory charged to an account can always
+         * be credited back to it, or ignored if the account has gone away in the meantime; each account using a
+         * ledger gets a new generation of it.
+         */
+        struct Ledger {
+            std::atomic<uint64_t> state{ 0 }; // Generation in the upper bits, live bytes in the lower.
+            std::atomic<size_t> peak{ 0 };
+            std::atomic<size_t> count{ 0 };
+            std::atomic<Ledger*> parent{ nullptr };
+            std::atomic<uint64_t> parent_generation{ 0 };
+        };
+
+        /// Refers to an account without keeping it alive.
+        struct Reference {
+            Ledger* ledger = nullptr;
+            uint64_t generation = 0;
+        };
+
+        hoMemoryAccount() : hoMemoryAccount(nullptr) {}
+        explicit hoMemoryAccount(std::shared_ptr<hoMemoryAccount> parent);
+
+        /// An account counting in ledger, which must outlive any memory charged to it (e.g. in shared memory).
+        explicit hoMemoryAccount(Ledger& ledger, std::shared_ptr<hoMemoryAccount> parent = nullptr);
+
+        ~hoMemoryAccount();
+
+        hoMemoryAccount(const hoMemoryAccount&) = delete;
+        hoMemoryAccount& operator=(const hoMemoryAccount&) = delete;
+
+        void add(size_t bytes);
+        void remove(size_t bytes);
+
+        /// Credits bytes back to the account referred to, and its parents, unless they have gone away.
+        static void remove(const Reference& account, size_t bytes);
+
+        Reference reference() const { return { ledger_, generation_ }; }
+
+        /// Bytes currently allocated and not yet freed.
+        size_t live_bytes() const;
+
+        /// Largest value live_bytes has had since construction or the last reset_peak.
+        size_t peak_bytes() const { return ledger_->peak.load(std::memory_order_relaxed); }
+
+        /// Number of allocations made.
+        size_t allocations() const { return ledger_->count.load(std::memory_order_relaxed); }
+
+        void reset_peak() { ledger_->peak.store(live_bytes(), std::memory_order_relaxed); }
+
+        const std::shared_ptr<hoMemoryAccount>& parent() const { return parent_; }
+
+    private:
+        hoMemoryAccount(Ledger& ledger, std::shared_ptr<hoMemoryAccount> parent, bool pooled);
+
+        const std::shared_ptr<hoMemoryAccount> parent_;
+        Ledger* const ledger_;
+        const bool pooled_;
+        const uint64_t generation_;
+    };
+
+    /**
+     * Interface for the memory behind hoNDArray.
+     */
+    class EXPORTCPUCORE hoMemoryAllocator {
+    public:
+        virtual ~hoMemoryAllocator() = default;
+
+        /// Returns at least bytes bytes, aligned to 64 bytes, or nullptr.
+        virtual void* allocate(size_t bytes) = 0;
+
+        /// ptr was returned by allocate with the same number of bytes.
+        virtual void deallocate(void* ptr, size_t bytes) = 0;
+    };
+
+    /**
+     * Aligned allocation straight from the system, no caching.
+     */
+    class EXPORTCPUCORE hoSystemAllocator : public hoMemoryAllocator {
+    public:
+        void* allocate(size_t bytes) override;
+        void deallocate(void* ptr, size_t bytes) override;
+    };
+
+    /**
+     * Size class pool. Requests are rounded up to one of four size classes per power of two (so at most 25% is
+     * wasted), plus a cache line for the header hoMemory puts in front of the data, and freed blocks are kept for
+     * reuse. Blocks up to thread_cache_limit bytes are cached per thread
+     * without locking; larger blocks are cached in a shared pool of at most max_cached_bytes.
+     * Requests larger than the largest size class go straight to the system.
+     */
+    class EXPORTCPUCORE hoPooledAllocator : public hoMemoryAllocator {
+    public:
+        explicit hoPooledAllocator(size_t max_cached_bytes = size_t(512) << 20);
+        ~hoPooledAllocator() override;
+
+        void* allocate(size_t bytes) override;
+        void deallocate(void* ptr, size_t bytes) override;
+
+        /// Bytes held in the shared pool (not counting thread caches).
+        size_t cached_bytes() const;
+
+        /// Returns the memory held in the shared pool to the system.
+        void release();
+
+        static constexpr size_t thread_cache_limit = size_t(1) << 20;
+        static constexpr size_t largest_size_class = size_t(256) << 20;
+
+        struct Central;
+
+    private:
+        std::shared_ptr<Central> central;
+    };
+
+    namespace hoMemory {
+
+        EXPORTCPUCORE void* allocate(size_t bytes);
+
+        /// Frees memory from allocate. Pointers that did not come from allocate are passed to free().
+        EXPORTCPUCORE void deallocate(void* ptr);
+
+        /**
+         * Replaces the allocator used for new allocations. Memory is always returned to the allocator it came from.
+         * The default is a hoPooledAllocator, or a hoSystemAllocator if GADGETRON_ALLOCATOR=system.
+         */
+        EXPORTCPUCORE void set_allocator(std::unique_ptr<hoMemoryAllocator> allocator);
+        EXPORTCPUCORE hoMemoryAllocator& allocator();
+
+        EXPORTCPUCORE hoMemoryAccount& process_account();
+        EXPORTCPUCORE std::shared_ptr<hoMemoryAccount> current_account();
+
+        /**
+         * Charges allocations made on this thread to account (in addition to the process account) for the lifetime
+         * of the ScopedAccount. Memory is credited back to the account it was charged to, whichever thread frees it,
+         * for as long as that account exists.
+         */
+        class EXPORTCPUCORE ScopedAccount {
+        public:
+            explicit ScopedAccount(std::shared_ptr<hoMemoryAccount> account);
+            ~ScopedAccount();
+
+            ScopedAccount(const ScopedAccount&) = delete;
+            ScopedAccount& operator=(const ScopedAccount&) = delete;
+
+        private:
+            std::shared_ptr<hoMemoryAccount> previous;
+        };
+    }
+}
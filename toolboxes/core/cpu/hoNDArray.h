@@ -9,6 +9,7 @@
 #include "vector_td.h"
 
 #include "cpucore_export.h"
+#include "hoMemoryPool.h"
 
 #include <string.h>
 #include <float.h>
@@ -287,12 +288,12 @@ namespace Gadgetron{
 
     template<class TYPE, unsigned int D> void _allocate_memory( size_t size, vector_td<TYPE,D>** data )
     {
-      *data = (vector_td<TYPE,D>*) malloc( size*sizeof(vector_td<TYPE,D>) );
+      *data = (vector_td<TYPE,D>*) hoMemory::allocate( size*sizeof(vector_td<TYPE,D>) );
     }
 
     template<class TYPE, unsigned int D>  void _deallocate_memory( vector_td<TYPE,D>* data )
     {
-      free( data );
+      hoMemory::deallocate( data );
     }
   };
 
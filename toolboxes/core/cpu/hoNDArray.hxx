@@ -831,51 +831,51 @@ namespace Gadgetron {
     }
 
     template <typename T> inline void hoNDArray<T>::_allocate_memory(size_t size, float** data) {
-        *data = (float*)malloc(size * sizeof(float));
+        *data = (float*)hoMemory::allocate(size * sizeof(float));
     }
 
     template <typename T> inline void hoNDArray<T>::_deallocate_memory(float* data) {
-        free(data);
+        hoMemory::deallocate(data);
     }
 
     template <typename T> inline void hoNDArray<T>::_allocate_memory(size_t size, double** data) {
-        *data = (double*)malloc(size * sizeof(double));
+        *data = (double*)hoMemory::allocate(size * sizeof(double));
     }
 
     template <typename T> inline void hoNDArray<T>::_deallocate_memory(double* data) {
-        free(data);
+        hoMemory::deallocate(data);
     }
 
     template <typename T> inline void hoNDArray<T>::_allocate_memory(size_t size, std::complex<float>** data) {
-        *data = (std::complex<float>*)malloc(size * sizeof(std::complex<float>));
+        *data = (std::complex<float>*)hoMemory::allocate(size * sizeof(std::complex<float>));
     }
 
     template <typename T> inline void hoNDArray<T>::_deallocate_memory(std::complex<float>* data) {
-        free(data);
+        hoMemory::deallocate(data);
     }
 
     template <typename T> inline void hoNDArray<T>::_allocate_memory(size_t size, std::complex<double>** data) {
-        *data = (std::complex<double>*)malloc(size * sizeof(std::complex<double>));
+        *data = (std::complex<double>*)hoMemory::allocate(size * sizeof(std::complex<double>));
     }
 
     template <typename T> inline void hoNDArray<T>::_deallocate_memory(std::complex<double>* data) {
-        free(data);
+        hoMemory::deallocate(data);
     }
 
     template <typename T> inline void hoNDArray<T>::_allocate_memory(size_t size, float_complext** data) {
-        *data = (float_complext*)malloc(size * sizeof(float_complext));
+        *data = (float_complext*)hoMemory::allocate(size * sizeof(float_complext));
     }
 
     template <typename T> inline void hoNDArray<T>::_deallocate_memory(float_complext* data) {
-        free(data);
+        hoMemory::deallocate(data);
     }
 
     template <typename T> inline void hoNDArray<T>::_allocate_memory(size_t size, double_complext** data) {
-        *data = (double_complext*)malloc(size * sizeof(double_complext));
+        *data = (double_complext*)hoMemory::allocate(size * sizeof(double_complext));
     }
 
     template <typename T> inline void hoNDArray<T>::_deallocate_memory(double_complext* data) {
-        free(data);
+        hoMemory::deallocate(data);
     }
 
     template <typename T> bool hoNDArray<T>::serialize(char*& buf, size_t& len) const {
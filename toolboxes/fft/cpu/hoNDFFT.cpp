@@ -2,8 +2,13 @@
 // Include for Visual studio, 'cos reasons.
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
 #include <numeric>
 #include <set>
+#include <random>
+#include <shared_mutex>
 
 #include "hoMatrix.h"
 #include "hoNDArray_elemwise.h"
@@ -26,89 +31,243 @@ namespace Gadgetron {
         template <class T> struct fftw_types {};
 
         template <> struct fftw_types<float> {
-            using complex                      = fftwf_complex;
-            using plan                         = fftwf_plan_s;
-            static constexpr auto plan_guru    = fftwf_plan_guru64_dft;
-            static constexpr auto execute_dft  = fftwf_execute_dft;
-            static constexpr auto destroy_plan = fftwf_destroy_plan;
+            using complex                        = fftwf_complex;
+            using plan                           = fftwf_plan_s;
+            static constexpr auto plan_guru      = fftwf_plan_guru64_dft;
+            static constexpr auto execute_dft    = fftwf_execute_dft;
+            static constexpr auto destroy_plan   = fftwf_destroy_plan;
+            static constexpr auto alignment_of   = fftwf_alignment_of;
+            static constexpr auto allocate       = fftwf_malloc;
+            static constexpr auto deallocate     = fftwf_free;
+            static constexpr auto import_wisdom  = fftwf_import_wisdom_from_filename;
+            static constexpr auto export_wisdom  = fftwf_export_wisdom_to_filename;
+            static constexpr const char* wisdom_suffix = ".fftwf";
         };
 
         template <> struct fftw_types<double> {
-            using complex                      = fftw_complex;
-            using plan                         = fftw_plan_s;
-            static constexpr auto plan_guru    = fftw_plan_guru64_dft;
-            static constexpr auto execute_dft  = fftw_execute_dft;
-            static constexpr auto destroy_plan = fftw_destroy_plan;
+            using complex                        = fftw_complex;
+            using plan                           = fftw_plan_s;
+            static constexpr auto plan_guru      = fftw_plan_guru64_dft;
+            static constexpr auto execute_dft    = fftw_execute_dft;
+            static constexpr auto destroy_plan   = fftw_destroy_plan;
+            static constexpr auto alignment_of   = fftw_alignment_of;
+            static constexpr auto allocate       = fftw_malloc;
+            static constexpr auto deallocate     = fftw_free;
+            static constexpr auto import_wisdom  = fftw_import_wisdom_from_filename;
+            static constexpr auto export_wisdom  = fftw_export_wisdom_to_filename;
+            static constexpr const char* wisdom_suffix = ".fftw";
         };
-        class FFTLock {
-        protected:
-            static std::mutex lock;
-        };
-        std::mutex FFTLock::lock;
-        template <class T> class SingleFFTPlan : FFTLock {
+
+        // The FFTW planner (and its wisdom) is not thread safe. Executing plans is.
+        std::mutex& planner_mutex() {
+            static std::mutex m;
+            return m;
+        }
+
+        unsigned int planner_flags() {
+            static const unsigned int flags = []() -> unsigned int {
+                const char* effort = std::getenv("GADGETRON_FFTW_PLANNER");
+                if (!effort)
+                    return FFTW_ESTIMATE;
+                auto value = std::string(effort);
+                if (value == "measure")
+                    return FFTW_MEASURE;
+                if (value == "patient")
+                    return FFTW_PATIENT;
+                if (value == "exhaustive")
+                    return FFTW_EXHAUSTIVE;
+                return FFTW_ESTIMATE;
+            }();
+            return flags;
+        }
+
+        const char* wisdom_prefix() {
+            return std::getenv("GADGETRON_FFTW_WISDOM");
+        }
+
+        template <class T> bool import_wisdom_locked(const std::string& prefix) {
+            auto filename = prefix + fftw_types<T>::wisdom_suffix;
+            return fftw_types<T>::import_wisdom(filename.c_str()) != 0;
+        }
+
+        template <class T> bool export_wisdom_locked(const std::string& prefix) {
+            // Several processes may share the wisdom file, so write it next to the target and rename it into place.
+            auto filename  = prefix + fftw_types<T>::wisdom_suffix;
+            auto temporary = filename + "." + std::to_string(std::random_device{}());
+            if (!fftw_types<T>::export_wisdom(temporary.c_str()))
+                return false;
+            return std::rename(temporary.c_str(), filename.c_str()) == 0;
+        }
+
+        /**
+         * Plans are cached by their full geometry: transform dimensions, batch dimensions, direction, whether the
+         * transform is in place and the SIMD alignment of the arrays (required by fftw_execute_dft).
+         * Lookups only take a shared lock; the planner lock is only taken when a plan has to be made.
+         */
+        template <class T> class PlanCache {
         public:
             using FFTWComplex = typename fftw_types<T>::complex;
+            using Plan        = std::shared_ptr<typename fftw_types<T>::plan>;
 
-            SingleFFTPlan(int dimension, const hoNDArray<std::complex<T>>& input, hoNDArray<std::complex<T>>& output,
-                bool forward) {
-                std::lock_guard<std::mutex> guard(lock);
+            static PlanCache& instance() {
+                static PlanCache cache;
+                return cache;
+            }
+
+            Plan get(const std::vector<fftw_iodim64>& dims, const std::vector<fftw_iodim64>& howmany, bool forward,
+                const std::complex<T>* input, std::complex<T>* output) {
 
-                const auto& dimensions = input.dimensions();
-                size_t stride
-                    = std::accumulate(dimensions.begin(), dimensions.begin() + dimension, 1, std::multiplies<>());
+                auto key = make_key(dims, howmany, forward, input, output);
+                {
+                    std::shared_lock<std::shared_mutex> guard(mutex);
+                    auto it = plans.find(key);
+                    if (it != plans.end())
+                        return it->second;
+                }
 
-                auto fftw_dimensions = fftw_iodim64{ static_cast<ptrdiff_t>(dimensions[dimension]), static_cast<ptrdiff_t>(stride), static_cast<ptrdiff_t>(stride) };
+                auto plan = create(dims, howmany, forward, input, output);
 
-                plan = fftw_types<T>::plan_guru(1, &fftw_dimensions, 0, nullptr, (FFTWComplex*)input.data(),
-                    (FFTWComplex*)output.data(), forward ? FFTW_FORWARD : FFTW_BACKWARD, FFTW_ESTIMATE);
+                std::unique_lock<std::shared_mutex> guard(mutex);
+                if (plans.size() >= max_plans)
+                    plans.clear();
+                return plans.emplace(std::move(key), std::move(plan)).first->second;
             }
 
-            ~SingleFFTPlan() {
-                std::lock_guard<std::mutex> guard(lock);
-                fftw_types<T>::destroy_plan(plan);
+        private:
+            static constexpr size_t max_plans = 4096;
+
+            PlanCache() {
+                std::lock_guard<std::mutex> guard(planner_mutex());
+                if (auto prefix = wisdom_prefix())
+                    import_wisdom_locked<T>(prefix);
             }
 
-            void execute(const std::complex<T>* input, std::complex<T>* output) {
-                fftw_types<T>::execute_dft(plan, (FFTWComplex*)input, (FFTWComplex*)output);
+            ~PlanCache() {
+                std::lock_guard<std::mutex> guard(planner_mutex());
+                if (auto prefix = wisdom_prefix(); prefix && planned)
+                    export_wisdom_locked<T>(prefix);
             }
 
-        private:
-            typename fftw_types<T>::plan* plan;
+            static std::vector<int64_t> make_key(const std::vector<fftw_iodim64>& dims,
+                const std::vector<fftw_iodim64>& howmany, bool forward, const std::complex<T>* input,
+                const std::complex<T>* output) {
+                std::vector<int64_t> key;
+                key.reserve(3 * (dims.size() + howmany.size()) + 6);
+                for (auto& dimensions : { std::cref(dims), std::cref(howmany) }) {
+                    key.push_back(dimensions.get().size());
+                    for (auto& d : dimensions.get()) {
+                        key.push_back(d.n);
+                        key.push_back(d.is);
+                        key.push_back(d.os);
+                    }
+                }
+                key.push_back(forward);
+                key.push_back(input == output);
+                key.push_back(fftw_types<T>::alignment_of((T*)input));
+                key.push_back(fftw_types<T>::alignment_of((T*)output));
+                return key;
+            }
+
+            static size_t extent(const std::vector<fftw_iodim64>& dims, const std::vector<fftw_iodim64>& howmany,
+                bool output) {
+                size_t result = 1;
+                for (auto& dimensions : { std::cref(dims), std::cref(howmany) })
+                    for (auto& d : dimensions.get())
+                        result += (d.n - 1) * (output ? d.os : d.is);
+                return result;
+            }
+
+            struct Scratch {
+                Scratch(size_t elements, int alignment)
+                    : memory{ fftw_types<T>::allocate(elements * sizeof(std::complex<T>) + 64) } {
+                    if (!memory)
+                        throw std::runtime_error("hoNDFFT: unable to allocate memory for planning");
+                    data = reinterpret_cast<std::complex<T>*>(static_cast<char*>(memory) + alignment);
+                }
+                ~Scratch() { fftw_types<T>::deallocate(memory); }
+                void* memory;
+                std::complex<T>* data;
+            };
+
+            Plan create(const std::vector<fftw_iodim64>& dims, const std::vector<fftw_iodim64>& howmany, bool forward,
+                const std::complex<T>* input, std::complex<T>* output) {
+
+                std::lock_guard<std::mutex> guard(planner_mutex());
+                const auto flags = planner_flags();
+
+                // Anything but FFTW_ESTIMATE overwrites the arrays while planning, so plan on scratch arrays with the
+                // same alignment instead.
+                std::unique_ptr<Scratch> scratch_in, scratch_out;
+                auto plan_input  = const_cast<std::complex<T>*>(input);
+                auto plan_output = output;
+                if (flags != FFTW_ESTIMATE) {
+                    scratch_in = std::make_unique<Scratch>(
+                        extent(dims, howmany, false), fftw_types<T>::alignment_of((T*)input));
+                    plan_input = plan_output = scratch_in->data;
+                    if (input != output) {
+                        scratch_out = std::make_unique<Scratch>(
+                            extent(dims, howmany, true), fftw_types<T>::alignment_of((T*)output));
+                        plan_output = scratch_out->data;
+                    }
+                }
+
+                auto plan = fftw_types<T>::plan_guru(int(dims.size()), dims.data(), int(howmany.size()), howmany.data(),
+                    (FFTWComplex*)plan_input, (FFTWComplex*)plan_output, forward ? FFTW_FORWARD : FFTW_BACKWARD,
+                    flags);
+                if (!plan)
+                    throw std::runtime_error("hoNDFFT: FFTW was unable to create a plan");
+
+                planned = true;
+                return Plan(plan, [](auto plan) {
+                    std::lock_guard<std::mutex> guard(planner_mutex());
+                    fftw_types<T>::destroy_plan(plan);
+                });
+            }
+
+            std::shared_mutex mutex;
+            std::map<std::vector<int64_t>, Plan> plans;
+            bool planned = false;
         };
 
-        template <class T> class ContigousFFTPlan : FFTLock {
-        public:
+        /**
+         * Executes the transform described by dims for every combination of the inner and outer batch dimensions.
+         * The larger of the two batch dimensions is split across the OpenMP threads, and each thread runs a single
+         * batched plan over its share.
+         */
+        template <class T>
+        void execute_batched(const std::vector<fftw_iodim64>& dims, fftw_iodim64 inner, fftw_iodim64 outer,
+            const std::complex<T>* input, std::complex<T>* output, bool forward) {
             using FFTWComplex = typename fftw_types<T>::complex;
-            ContigousFFTPlan(
-                int rank, const hoNDArray<std::complex<T>>& input, hoNDArray<std::complex<T>>& output, bool forward) {
-                std::lock_guard<std::mutex> guard(lock);
 
-                const auto& dimensions = input.dimensions();
+            if (inner.n > outer.n)
+                std::swap(inner, outer);
 
-                auto strides = std::vector<size_t>(rank + 1, 1);
-                std::partial_sum(
-                    dimensions.begin(), dimensions.begin() + rank, strides.begin() + 1, std::multiplies<>());
+            auto& cache = PlanCache<T>::instance();
 
-                auto fftw_dimensions = std::vector<fftw_iodim64>(rank);
+            const long long chunks
+                = omp_in_parallel() ? 1 : std::max<long long>(1, std::min<long long>(outer.n, omp_get_max_threads()));
+            const long long per_chunk = (outer.n + chunks - 1) / chunks;
 
-                for (int i = 0; i < rank; i++) {
-                    fftw_dimensions[i] = { (int64_t)dimensions[i], (int64_t)strides[i], (int64_t)strides[i] };
-                }
-                plan = fftw_types<T>::plan_guru(rank, fftw_dimensions.data(), 0, nullptr, (FFTWComplex*)input.data(),
-                    (FFTWComplex*)output.data(), forward ? FFTW_FORWARD : FFTW_BACKWARD, FFTW_ESTIMATE);
-            }
-            ~ContigousFFTPlan() {
-                std::lock_guard<std::mutex> guard(lock);
-                fftw_types<T>::destroy_plan(plan);
-            }
+#pragma omp parallel for default(shared) if (chunks > 1)
+            for (long long chunk = 0; chunk < chunks; chunk++) {
+                const long long begin = chunk * per_chunk;
+                const long long count = std::min<long long>(per_chunk, outer.n - begin);
+                if (count <= 0)
+                    continue;
 
-            void execute(const std::complex<T>* input, std::complex<T>* output) {
-                fftw_types<T>::execute_dft(plan, (FFTWComplex*)input, (FFTWComplex*)output);
-            }
+                std::vector<fftw_iodim64> howmany;
+                if (inner.n > 1)
+                    howmany.push_back(inner);
+                if (count > 1)
+                    howmany.push_back({ count, outer.is, outer.os });
 
-        private:
-            typename fftw_types<T>::plan* plan;
-        };
+                auto chunk_input  = input + begin * outer.is;
+                auto chunk_output = output + begin * outer.os;
+
+                auto plan = cache.get(dims, howmany, forward, chunk_input, chunk_output);
+                fftw_types<T>::execute_dft(plan.get(), (FFTWComplex*)chunk_input, (FFTWComplex*)chunk_output);
+            }
+        }
 
         const int num_max_threads = omp_get_max_threads();
 
@@ -126,17 +285,24 @@ namespace Gadgetron {
         static void contigous_fftn(const hoNDArray<std::complex<T>>& a, hoNDArray<std::complex<T>>& r, int rank,
             bool forward, bool normalize) {
 
-            auto plan = ContigousFFTPlan<T>(rank, a, r, forward);
-            size_t batch_size
-                = std::accumulate(a.dimensions().begin(), a.dimensions().begin() + rank, 1, std::multiplies<>());
-            size_t batches = a.size() / batch_size;
+            const auto& dimensions = a.dimensions();
 
-#pragma omp parallel for default(none) shared(plan,  a, r, batches, batch_size)
-            for (long long i = 0; i < batches; i++) {
+            auto strides = std::vector<size_t>(rank + 1, 1);
+            std::partial_sum(dimensions.begin(), dimensions.begin() + rank, strides.begin() + 1, std::multiplies<>());
 
-                plan.execute(a.data() + i * batch_size, r.data() + i * batch_size);
+            // FFTW expects the slowest varying dimension first
+            auto fftw_dimensions = std::vector<fftw_iodim64>(rank);
+            for (int i = 0; i < rank; i++) {
+                fftw_dimensions[rank - 1 - i]
+                    = { (ptrdiff_t)dimensions[i], (ptrdiff_t)strides[i], (ptrdiff_t)strides[i] };
             }
 
+            size_t batch_size = strides[rank];
+            size_t batches    = a.size() / batch_size;
+
+            execute_batched<T>(fftw_dimensions, { 1, 0, 0 },
+                { (ptrdiff_t)batches, (ptrdiff_t)batch_size, (ptrdiff_t)batch_size }, a.data(), r.data(), forward);
+
             if (normalize)
                 r *= T(1) / std::sqrt<T>(batch_size);
         }
@@ -145,21 +311,19 @@ namespace Gadgetron {
         static void single_fft(int dimension, const hoNDArray<std::complex<T>>& a, hoNDArray<std::complex<T>>& r,
             bool forward, bool normalize) {
             assert(dimension >= 0);
-            auto plan              = SingleFFTPlan<T>(dimension, a, r, forward);
             const auto& dimensions = a.dimensions();
             size_t inner_batches
-                = std::accumulate(dimensions.begin(), dimensions.begin() + dimension, 1, std::multiplies<>());
+                = std::accumulate(dimensions.begin(), dimensions.begin() + dimension, size_t(1), std::multiplies<>());
             size_t outer_batches
-                = std::accumulate(dimensions.begin() + dimension, dimensions.end(), 1, std::multiplies<>());
+                = std::accumulate(dimensions.begin() + dimension + 1, dimensions.end(), size_t(1), std::multiplies<>());
             size_t outer_batchsize = inner_batches * dimensions[dimension];
 
-#pragma omp parallel for default(none) shared(plan, a, r , outer_batches, inner_batches, outer_batchsize ) collapse(2)
-            for (long long outer = 0; outer < outer_batches; outer++) {
-                for (long long inner = 0; inner < inner_batches; inner++) {
-                    plan.execute(
-                        a.data() + inner + outer * outer_batchsize, r.data() + inner + outer * outer_batchsize);
-                }
-            }
+            auto fftw_dimensions = std::vector<fftw_iodim64>{ { (ptrdiff_t)dimensions[dimension],
+                (ptrdiff_t)inner_batches, (ptrdiff_t)inner_batches } };
+
+            execute_batched<T>(fftw_dimensions, { (ptrdiff_t)inner_batches, 1, 1 },
+                { (ptrdiff_t)outer_batches, (ptrdiff_t)outer_batchsize, (ptrdiff_t)outer_batchsize }, a.data(),
+                r.data(), forward);
 
             if (normalize)
                 r *= T(1) / std::sqrt<T>(dimensions[dimension]);
@@ -810,6 +974,20 @@ namespace Gadgetron {
     }
 
 
+    bool FFT::import_wisdom(const std::string& prefix) {
+        std::lock_guard<std::mutex> guard(planner_mutex());
+        bool single_precision = import_wisdom_locked<float>(prefix);
+        bool double_precision = import_wisdom_locked<double>(prefix);
+        return single_precision || double_precision;
+    }
+
+    bool FFT::export_wisdom(const std::string& prefix) {
+        std::lock_guard<std::mutex> guard(planner_mutex());
+        bool single_precision = export_wisdom_locked<float>(prefix);
+        bool double_precision = export_wisdom_locked<double>(prefix);
+        return single_precision && double_precision;
+    }
+
     template <class ComplexType, class ENABLER>
     void FFT::fft(hoNDArray<ComplexType>& data, std::vector<size_t> dimensions) {
         std::sort(dimensions.begin(), dimensions.end());
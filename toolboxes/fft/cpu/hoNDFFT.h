@@ -13,6 +13,7 @@
 #include <fftw3.h>
 #include <iostream>
 #include <mutex>
+#include <string>
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -53,13 +54,28 @@ namespace Gadgetron {
         template <class ComplexType, class ENABLER = std::enable_if_t<is_complex_type_v<ComplexType>>>
         void ifft(hoNDArray<ComplexType>& data, size_t dimensions);
 
+        /**
+         * Loads FFTW wisdom from prefix.fftwf (single precision) and prefix.fftw (double precision).
+         * @return false if neither file could be read
+         */
+        EXPORTCPUFFT bool import_wisdom(const std::string& prefix);
+
+        /**
+         * Saves the FFTW wisdom gathered so far to prefix.fftwf and prefix.fftw.
+         */
+        EXPORTCPUFFT bool export_wisdom(const std::string& prefix);
     }
 
     /**
     Generic class for Fast Fourier Transforms using FFTW on the hoNDArray class.
-    This class is a singleton because the planning and memory allocation routines of FFTW are NOT threadsafe.
     The class' template type is a REAL, ie. float or double.
 
+    FFTW plans are cached per array geometry and shared between threads, so only the first transform of a given
+    geometry pays for planning. All coils and frames beyond the transformed dimensions are handled by batched plans.
+    The planner effort is FFTW_ESTIMATE unless the environment variable GADGETRON_FFTW_PLANNER is set to measure,
+    patient or exhaustive. If GADGETRON_FFTW_WISDOM is set, it is used as prefix for FFT::import_wisdom on first use
+    and FFT::export_wisdom on exit.
+
                 Note that scaling is 1/sqrt(N) fir both FFT and IFFT, where N is the number of elements along the FFT
     dimensions Access using e.g. FFT<float>::instance()
     */
@@ -5,22 +5,245 @@
 #include <string>
 #include <time.h>
 #include <cstring>
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 
 namespace Gadgetron
 {
+  namespace
+  {
+    //A message as logged by the calling thread: the file name and the formatted message, back to back.
+    //Everything else (time stamp, level, location) is formatted when the message is written.
+    struct Record
+    {
+      std::chrono::system_clock::time_point time;
+      GadgetronLogLevel level;
+      int lineno;
+      char* overflow; //Heap copy of file name and message if they do not fit in text
+      char text[512 - 32];
+
+      static constexpr size_t max_file_length = 255;
+
+      const char* filename() const { return overflow ? overflow : text; }
+      const char* message() const { return filename() + strlen(filename()) + 1; }
+
+      void set(GadgetronLogLevel LEVEL, const char* file, int line, const char* cformatting, va_list args)
+      {
+        time = std::chrono::system_clock::now();
+        level = LEVEL;
+        lineno = line;
+        overflow = nullptr;
+
+        size_t file_length = std::min(strlen(file), size_t(max_file_length));
+        memcpy(text, file, file_length);
+        text[file_length] = '\0';
+
+        va_list retry;
+        va_copy(retry, args);
+
+        char* message = text + file_length + 1;
+        size_t room = sizeof(text) - file_length - 1;
+        int length = vsnprintf(message, room, cformatting, args);
+        if (length < 0) {
+          message[0] = '\0';
+        } else if (size_t(length) >= room) {
+          overflow = static_cast<char*>(malloc(file_length + 2 + length));
+          if (overflow) {
+            memcpy(overflow, text, file_length + 1);
+            vsnprintf(overflow + file_length + 1, length + 1, cformatting, retry);
+          }
+        }
+        va_end(retry);
+      }
+
+      void release()
+      {
+        free(overflow);
+        overflow = nullptr;
+      }
+    };
+
+    //Single producer (the owning thread), single consumer (whoever holds the writer lock).
+    struct Ring
+    {
+      static constexpr size_t capacity = 1024;
+
+      Record* try_reserve()
+      {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == capacity) return nullptr;
+        return &records[h % capacity];
+      }
+
+      void publish() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+      template <class F> void drain(F write)
+      {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        for (; t != h; t++) {
+          write(records[t % capacity]);
+          records[t % capacity].release();
+        }
+        tail.store(t, std::memory_order_release);
+      }
+
+      bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+      alignas(64) std::atomic<size_t> head{0};
+      alignas(64) std::atomic<size_t> tail{0};
+      std::atomic<bool> retired{false};
+      Record records[capacity];
+    };
+  }
+
+  struct GadgetronLogger::Backend
+  {
+    std::mutex registry_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+
+    std::mutex wake_mutex;
+    std::unique_ptr<std::condition_variable> wake{new std::condition_variable()};
+    std::atomic<bool> pending{false};
+    std::atomic<bool> running{false};
+
+    std::atomic<size_t> dropped[GADGETRON_LOG_LEVEL_MAX] = {};
+    size_t reported_dropped = 0;
+
+    std::shared_ptr<Ring> register_ring()
+    {
+      auto ring = std::make_shared<Ring>();
+      std::lock_guard<std::mutex> guard(registry_mutex);
+      rings.push_back(ring);
+      return ring;
+    }
+
+    void notify()
+    {
+      if (!pending.load(std::memory_order_relaxed) && !pending.exchange(true)) wake->notify_one();
+    }
+
+    size_t total_dropped()
+    {
+      size_t total = 0;
+      for (auto& count : dropped) total += count.load(std::memory_order_relaxed);
+      return total;
+    }
+  };
+
+  namespace
+  {
+    struct RingHolder
+    {
+      std::shared_ptr<Ring> ring;
+      ~RingHolder();
+    };
+
+    //Trivially destructible, so it can still be checked while other thread locals are being destroyed.
+    thread_local bool ring_destroyed = false;
+    thread_local RingHolder ring_holder;
+
+    RingHolder::~RingHolder()
+    {
+      if (ring) ring->retired = true;
+      ring_destroyed = true;
+    }
+
+    Ring* thread_ring(GadgetronLogger::Backend& backend)
+    {
+      if (ring_destroyed) return nullptr;
+      if (!ring_holder.ring) ring_holder.ring = backend.register_ring();
+      return ring_holder.ring.get();
+    }
+
+    const char* level_name(GadgetronLogLevel LEVEL)
+    {
+      switch (LEVEL) {
+      case GADGETRON_LOG_LEVEL_DEBUG:
+	return "DEBUG ";
+      case GADGETRON_LOG_LEVEL_INFO:
+	return "INFO ";
+      case GADGETRON_LOG_LEVEL_WARNING:
+	return "WARNING ";
+      case GADGETRON_LOG_LEVEL_ERROR:
+	return "ERROR ";
+      default:
+	return "";
+      }
+    }
+
+    //Writes a record; the caller holds the writer lock.
+    void write_record(GadgetronLogger& logger, const Record& record)
+    {
+      std::string prefix;
+
+      if (logger.isOutputOptionEnabled(GADGETRON_LOG_PRINT_DATETIME)) {
+        //Only the writer formats time stamps, so the broken down time of the last second can be kept
+        static time_t last_rawtime = -1;
+        static struct tm timeinfo;
+        time_t rawtime = std::chrono::system_clock::to_time_t(record.time);
+        if (rawtime != last_rawtime) {
+#ifdef _WIN32
+          localtime_s(&timeinfo, &rawtime);
+#else
+          localtime_r(&rawtime, &timeinfo);
+#endif
+          last_rawtime = rawtime;
+        }
+
+        auto duration = record.time.time_since_epoch();
+        int micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() % 1000000;
+
+        //Time the format MM-DD HH:MM:SS.uuu
+        char timestr[32];snprintf(timestr, sizeof(timestr), "%02d-%02d %02d:%02d:%02d.%03d ",
+	  		       timeinfo.tm_mon+1, timeinfo.tm_mday,
+	  		       timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, micros/1000);
+        prefix += timestr;
+      }
+
+      if (logger.isOutputOptionEnabled(GADGETRON_LOG_PRINT_LEVEL)) {
+        prefix += level_name(record.level);
+      }
+
+      if (logger.isOutputOptionEnabled(GADGETRON_LOG_PRINT_FILELOC)) {
+        const char* filename = record.filename();
+        if (!logger.isOutputOptionEnabled(GADGETRON_LOG_PRINT_FOLDER)) {
+	  const char* base_start = strrchr(filename,'/');
+	  if (!base_start) {
+	    base_start = strrchr(filename,'\\'); //Maybe using backslashes
+	  }
+	  if (base_start) filename = base_start + 1;
+        }
+        prefix += std::string("[") + filename + ":" + std::to_string(record.lineno) + "] ";
+      }
+
+      fputs(prefix.c_str(), stdout);
+      fputs(record.message(), stdout);
+    }
+  }
+
   GadgetronLogger* GadgetronLogger::instance()
   {
-    if (!instance_) instance_ = new GadgetronLogger();
-    return instance_;
+    static GadgetronLogger* logger = instance_ = new GadgetronLogger();
+    return logger;
   }
 
   GadgetronLogger* GadgetronLogger::instance_ = NULL;
 
   GadgetronLogger::GadgetronLogger()
-    : level_mask_(GADGETRON_LOG_LEVEL_MAX,false)
-    , print_mask_(GADGETRON_LOG_PRINT_MAX, false)
+    : level_mask_(0)
+    , print_mask_(0)
+    , synchronous_(false)
+    , backend_(new Backend())
   {
     char* log_mask = getenv(GADGETRON_LOG_MASK_ENVIRONMENT);
     if ( log_mask != NULL) {
@@ -74,152 +297,212 @@ namespace Gadgetron
          fflush(stdout);
        }
     }
-  }
 
+    char* synchronous = getenv(GADGETRON_LOG_SYNCHRONOUS_ENVIRONMENT);
+    if (synchronous != NULL && std::string(synchronous) != "0") {
+      synchronous_ = true;
+    }
 
-  void GadgetronLogger::log(GadgetronLogLevel LEVEL, const char* filename, int lineno, const char* cformatting, ...)
+    //The logger is never destroyed; whatever is still queued is written when the process exits.
+    atexit([]() { GadgetronLogger::instance()->flush(); });
+  }
+
+  namespace
   {
-    //Check if we should log this message
-    if (!isLevelEnabled(LEVEL)) return;
+    void drain_all(GadgetronLogger& logger, GadgetronLogger::Backend& backend)
+    {
+      std::vector<std::shared_ptr<Ring>> rings;
+      {
+	std::lock_guard<std::mutex> guard(backend.registry_mutex);
+	//Rings of threads that have exited are dropped once they are empty.
+	auto retired = std::remove_if(backend.rings.begin(), backend.rings.end(),
+				      [](auto& ring) { return ring->retired && ring->empty(); });
+	backend.rings.erase(retired, backend.rings.end());
+	rings = backend.rings;
+      }
 
-    std::unique_lock<std::mutex> lock(m);
-    const char* fmt = cformatting;
-    std::string fmt_str;
-    bool append_cformatting_needed = false; //Will be set to true if we add any additional labels
+      bool written = false;
+      for (auto& ring : rings) {
+	ring->drain([&](const Record& record) { write_record(logger, record); written = true; });
+      }
 
-    if (isOutputOptionEnabled(GADGETRON_LOG_PRINT_DATETIME)) {
-      time_t rawtime;
-      struct tm * timeinfo;
+      size_t dropped = backend.total_dropped();
+      if (dropped != backend.reported_dropped) {
+	fprintf(stdout, "WARNING [log.cpp] %zu log messages were dropped, as the log could not keep up\n",
+		dropped - backend.reported_dropped);
+	backend.reported_dropped = dropped;
+	written = true;
+      }
 
-      auto curtime= std::chrono::system_clock::now();
-      rawtime = std::chrono::system_clock::to_time_t(curtime);
-      timeinfo = localtime ( &rawtime );
+      if (written) fflush(stdout);
+    }
+  }
 
-      auto duration = curtime.time_since_epoch();
-      int micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() % 1000000;
+  void GadgetronLogger::flush()
+  {
+    std::lock_guard<std::mutex> lock(m);
+    drain_all(*this, *backend_);
+  }
 
-      //Time the format MM-DD HH:MM:SS.uuu
-      char timestr[22];sprintf(timestr, "%02d-%02d %02d:%02d:%02d.%03d ",
-			       timeinfo->tm_mon+1, timeinfo->tm_mday,
-			       timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec, micros/1000);
+  size_t GadgetronLogger::droppedMessages(GadgetronLogLevel LEVEL)
+  {
+    if (LEVEL >= GADGETRON_LOG_LEVEL_MAX) return 0;
+    return backend_->dropped[LEVEL].load(std::memory_order_relaxed);
+  }
 
-      fmt_str += std::string(timestr);
-      append_cformatting_needed = true;
+  namespace
+  {
+    void start_writer(GadgetronLogger* logger, GadgetronLogger::Backend* backend, std::mutex* writer_mutex)
+    {
+      std::thread([=]() {
+	while (true) {
+	  {
+	    std::unique_lock<std::mutex> lock(backend->wake_mutex);
+	    //The timeout covers the (rare) notification sent just before we started waiting.
+	    backend->wake->wait_for(lock, std::chrono::milliseconds(50), [&]() { return backend->pending.load(); });
+	    backend->pending = false;
+	  }
+	  std::lock_guard<std::mutex> guard(*writer_mutex);
+	  drain_all(*logger, *backend);
+	}
+      }).detach();
     }
+  }
 
-    if (isOutputOptionEnabled(GADGETRON_LOG_PRINT_LEVEL)) {
-      switch (LEVEL) {
-      case GADGETRON_LOG_LEVEL_DEBUG:
-	fmt_str += "DEBUG ";
-	break;
-      case GADGETRON_LOG_LEVEL_INFO:
-	fmt_str += "INFO ";
-	break;
-      case GADGETRON_LOG_LEVEL_WARNING:
-	fmt_str += "WARNING ";
-	break;
-      case GADGETRON_LOG_LEVEL_ERROR:
-	fmt_str += "ERROR ";
-	break;
-      default:
-	;
-      }
-      append_cformatting_needed = true;
+  void GadgetronLogger::log(GadgetronLogLevel LEVEL, const char* filename, int lineno, const char* cformatting, ...)
+  {
+    //Check if we should log this message
+    if (!isLevelEnabled(LEVEL)) return;
+
+    va_list args;
+    va_start (args, cformatting);
+
+    Ring* ring = synchronous_ ? nullptr : thread_ring(*backend_);
+    if (!ring) {
+      //Synchronous logging, or a thread logging while it exits
+      Record record;
+      record.set(LEVEL, filename, lineno, cformatting, args);
+      va_end (args);
+
+      std::lock_guard<std::mutex> lock(m);
+      drain_all(*this, *backend_);
+      write_record(*this, record);
+      fflush(stdout);
+      record.release();
+      return;
     }
 
-    if (isOutputOptionEnabled(GADGETRON_LOG_PRINT_FILELOC)) {
-      if (!isOutputOptionEnabled(GADGETRON_LOG_PRINT_FOLDER)) {
-	const char* base_start = strrchr(filename,'/');
-	if (!base_start) {
-	  base_start = strrchr(filename,'\\'); //Maybe using backslashes
-	}
-	if (base_start) {
-	  base_start++;
-	  fmt_str += std::string("[") + std::string(base_start);
-	} else {
-	  fmt_str += std::string("[") + std::string(filename);
-	}
-      } else {
-	fmt_str += std::string("[") + std::string(filename);
-      }
-      char linenostr[8];sprintf(linenostr, "%d", lineno);
-      fmt_str += std::string(":") + std::string(linenostr);
-      fmt_str += std::string("] ");
-      append_cformatting_needed = true;
+    if (!backend_->running.load(std::memory_order_relaxed) && !backend_->running.exchange(true)) {
+#ifndef _WIN32
+      //A forked child (the server forks per connection) has no writer thread, and must not inherit locked mutexes
+      //or messages its parent will write.
+      static std::once_flag registered;
+      std::call_once(registered, []() {
+	pthread_atfork(
+	  []() {
+	    auto logger = GadgetronLogger::instance();
+	    logger->m.lock();
+	    drain_all(*logger, *logger->backend_);
+	    logger->backend_->registry_mutex.lock();
+	    logger->backend_->wake_mutex.lock();
+	  },
+	  []() {
+	    auto logger = GadgetronLogger::instance();
+	    logger->backend_->wake_mutex.unlock();
+	    logger->backend_->registry_mutex.unlock();
+	    logger->m.unlock();
+	  },
+	  []() {
+	    auto logger = GadgetronLogger::instance();
+	    auto& backend = *logger->backend_;
+	    //The old condition variable may still count the parent's writer as a waiter.
+	    backend.wake.release();
+	    backend.wake.reset(new std::condition_variable());
+	    backend.rings.erase(std::remove_if(backend.rings.begin(), backend.rings.end(),
+					       [](auto& ring) { return ring != ring_holder.ring; }),
+				backend.rings.end());
+	    backend.running = false;
+	    backend.wake_mutex.unlock();
+	    backend.registry_mutex.unlock();
+	    logger->m.unlock();
+	  });
+      });
+#endif
+      start_writer(this, backend_, &m);
     }
 
-    if (append_cformatting_needed) {
-      fmt_str += std::string(cformatting);
-      fmt = fmt_str.c_str();
+    Record* record = ring->try_reserve();
+    while (!record) {
+      if (LEVEL != GADGETRON_LOG_LEVEL_WARNING && LEVEL != GADGETRON_LOG_LEVEL_ERROR) {
+	backend_->dropped[LEVEL].fetch_add(1, std::memory_order_relaxed);
+	va_end (args);
+	return;
+      }
+      //Warnings and errors are never dropped
+      backend_->notify();
+      std::this_thread::yield();
+      record = ring->try_reserve();
     }
 
-    va_list args;
-    va_start (args, cformatting);
-    vprintf(fmt, args);
+    record->set(LEVEL, filename, lineno, cformatting, args);
     va_end (args);
-    fflush(stdout);
-
+    ring->publish();
+    backend_->notify();
   }
 
   void GadgetronLogger::enableLogLevel(GadgetronLogLevel LEVEL)
   {
-    if (LEVEL < level_mask_.size()) {
-      level_mask_[LEVEL] = true;
+    if (LEVEL < GADGETRON_LOG_LEVEL_MAX) {
+      level_mask_ |= 1u << LEVEL;
     }
   }
 
   void GadgetronLogger::disableLogLevel(GadgetronLogLevel LEVEL)
   {
-    if (LEVEL < level_mask_.size()) {
-      level_mask_[LEVEL] = false;
+    if (LEVEL < GADGETRON_LOG_LEVEL_MAX) {
+      level_mask_ &= ~(1u << LEVEL);
     }
   }
 
-  bool GadgetronLogger::isLevelEnabled(GadgetronLogLevel LEVEL)
-  {
-    if (LEVEL >= level_mask_.size()) return false;
-    return level_mask_[LEVEL];
-  }
-
   void GadgetronLogger::enableAllLogLevels()
   {
-    level_mask_.assign(GADGETRON_LOG_LEVEL_MAX,true);
+    level_mask_ = (1u << GADGETRON_LOG_LEVEL_MAX) - 1;
   }
 
   void GadgetronLogger::disableAllLogLevels()
   {
-    level_mask_.assign(GADGETRON_LOG_LEVEL_MAX,false);
+    level_mask_ = 0;
   }
 
   void GadgetronLogger::enableOutputOption(GadgetronLogOutput OUTPUT)
   {
-    if (OUTPUT < print_mask_.size()) {
-      print_mask_[OUTPUT] = true;
+    if (OUTPUT < GADGETRON_LOG_PRINT_MAX) {
+      print_mask_ |= 1u << OUTPUT;
     }
   }
 
   void GadgetronLogger::disableOutputOption(GadgetronLogOutput OUTPUT)
   {
-    if (OUTPUT < print_mask_.size()) {
-      print_mask_[OUTPUT] = false;
+    if (OUTPUT < GADGETRON_LOG_PRINT_MAX) {
+      print_mask_ &= ~(1u << OUTPUT);
     }
   }
 
   bool GadgetronLogger::isOutputOptionEnabled(GadgetronLogOutput OUTPUT)
   {
-    if (OUTPUT < print_mask_.size()) {
-      return print_mask_[OUTPUT];
+    if (OUTPUT < GADGETRON_LOG_PRINT_MAX) {
+      return (print_mask_.load(std::memory_order_relaxed) >> OUTPUT) & 1u;
     }
     return false;
   }
 
   void GadgetronLogger::enableAllOutputOptions()
   {
-    print_mask_.assign(GADGETRON_LOG_PRINT_MAX, true);
+    print_mask_ = (1u << GADGETRON_LOG_PRINT_MAX) - 1;
   }
 
   void GadgetronLogger::disableAllOutputOptions()
   {
-    print_mask_.assign(GADGETRON_LOG_PRINT_MAX, false);
+    print_mask_ = 0;
   }
 }
@@ -3,13 +3,15 @@
 
 #include "log_export.h"
 
-#include <vector> //For mask fields
+#include <atomic> //For mask fields
+#include <vector>
 
 #include <sstream> //For deprecated macros
 #include <mutex>
 
 #define GADGETRON_LOG_MASK_ENVIRONMENT "GADGETRON_LOG_MASK"
 #define GADGETRON_LOG_FILE_ENVIRONMENT "GADGETRON_LOG_FILE"
+#define GADGETRON_LOG_SYNCHRONOUS_ENVIRONMENT "GADGETRON_LOG_SYNCHRONOUS"
 
 namespace Gadgetron
 {
@@ -86,6 +88,16 @@ namespace Gadgetron
      
      Any (or no) seperator is allowed between the levels and ourput options.
 
+     Messages are written asynchronously. The calling thread only formats the message itself (not the time stamp
+     or the file location) into a ring buffer of its own, without taking any locks; a background thread does the
+     rest of the formatting and the writing. Messages from one thread are written in order. When a thread's ring
+     buffer is full, debug, info and verbose messages are dropped (and counted, see @droppedMessages), while
+     warnings and errors wait for room. Call @flush to wait for everything logged so far to be written.
+     Set GADGETRON_LOG_SYNCHRONOUS=1 to write every message on the calling thread instead, e.g. when debugging
+     a crash.
+
+     The stream macros check the log level before building the message, so disabled levels cost next to nothing.
+
    */
   class EXPORTGADGETRONLOG GadgetronLogger
   {
@@ -96,9 +108,18 @@ namespace Gadgetron
     ///Generic log function. Use the logging macros for easy access to this function
     void log(GadgetronLogLevel LEVEL, const char* filename, int lineno, const char* cformatting, ...);
 
+    ///Blocks until every message logged so far has been written
+    void flush();
+
+    ///Number of messages of the level dropped because the log could not keep up
+    size_t droppedMessages(GadgetronLogLevel LEVEL);
+
     void enableLogLevel(GadgetronLogLevel LEVEL);
     void disableLogLevel(GadgetronLogLevel LEVEL);
-    bool isLevelEnabled(GadgetronLogLevel LEVEL);
+    bool isLevelEnabled(GadgetronLogLevel LEVEL)
+    {
+      return LEVEL < GADGETRON_LOG_LEVEL_MAX && (level_mask_.load(std::memory_order_relaxed) >> LEVEL) & 1u;
+    }
     void enableAllLogLevels();
     void disableAllLogLevels();
 
@@ -108,12 +129,16 @@ namespace Gadgetron
     void enableAllOutputOptions();
     void disableAllOutputOptions();
 
+    struct Backend;
+
   protected:
     GadgetronLogger();
     static GadgetronLogger* instance_;
-    std::vector<bool> level_mask_;
-    std::vector<bool> print_mask_;
+    std::atomic<unsigned int> level_mask_;
+    std::atomic<unsigned int> print_mask_;
     std::mutex m;
+    bool synchronous_;
+    Backend* backend_;
   };
 }
 
@@ -131,43 +156,28 @@ namespace Gadgetron
     GDEBUG(gdb.c_str());		  \
  }
 
-//Stream syntax log level functions
-#define GINFO_STREAM(message)				\
-  {							\
-    std::stringstream gadget_msg_dep_str;		\
-    gadget_msg_dep_str  << message << std::endl;	\
-    GINFO(gadget_msg_dep_str.str().c_str());		\
+//Stream syntax log level functions. The message is only built if the level is enabled.
+#define GADGETRON_LOG_STREAM(LEVEL, message)						\
+  {											\
+    if (Gadgetron::GadgetronLogger::instance()->isLevelEnabled(LEVEL)) {		\
+      std::stringstream gadget_msg_dep_str;						\
+      gadget_msg_dep_str  << message << std::endl;					\
+      Gadgetron::GadgetronLogger::instance()->log(LEVEL, __FILE__, __LINE__, "%s",	\
+                                                  gadget_msg_dep_str.str().c_str());	\
+    }											\
   }
 
-#define GVERBOSE_STREAM(message)					\
-  {								\
-    std::stringstream gadget_msg_dep_str;			\
-    gadget_msg_dep_str  << message << std::endl;		\
-    GVERBOSE(gadget_msg_dep_str.str().c_str());			\
-  }
+#define GINFO_STREAM(message) GADGETRON_LOG_STREAM(Gadgetron::GADGETRON_LOG_LEVEL_INFO, message)
+
+#define GVERBOSE_STREAM(message) GADGETRON_LOG_STREAM(Gadgetron::GADGETRON_LOG_LEVEL_VERBOSE, message)
 
 #ifndef MATLAB_MEX_COMPILE
 
-#define GDEBUG_STREAM(message)				\
-{							\
-    std::stringstream gadget_msg_dep_str;		\
-    gadget_msg_dep_str  << message << std::endl;	\
-    GDEBUG(gadget_msg_dep_str.str().c_str());		\
-}
+#define GDEBUG_STREAM(message) GADGETRON_LOG_STREAM(Gadgetron::GADGETRON_LOG_LEVEL_DEBUG, message)
 
-#define GWARN_STREAM(message)					\
-  {								\
-    std::stringstream gadget_msg_dep_str;			\
-    gadget_msg_dep_str  << message << std::endl;		\
-    GWARN(gadget_msg_dep_str.str().c_str());			\
-  }
+#define GWARN_STREAM(message) GADGETRON_LOG_STREAM(Gadgetron::GADGETRON_LOG_LEVEL_WARNING, message)
 
-#define GERROR_STREAM(message)					\
-  {								\
-    std::stringstream gadget_msg_dep_str;			\
-    gadget_msg_dep_str  << message << std::endl;		\
-    GERROR(gadget_msg_dep_str.str().c_str());			\
-  }
+#define GERROR_STREAM(message) GADGETRON_LOG_STREAM(Gadgetron::GADGETRON_LOG_LEVEL_ERROR, message)
 
 #else
     #pragma message ("Use matlab definition for GDEBUG stream ... ")
@@ -0,0 +1,230 @@
+#include "trace.h"
+
+#include <cstdio>
+#include <ostream>
+
+namespace Gadgetron { namespace Tracing {
+
+    /**
+     * Events of one thread. Only the owning thread appends; readers may walk the buffer at any time, and see every
+     * event published before they loaded the size of a chunk.
+     */
+    class Trace::Buffer {
+    public:
+        Buffer(std::string thread_name, size_t index) : thread_name(std::move(thread_name)), index(index) {}
+
+        ~Buffer() {
+            auto chunk = head.next.load(std::memory_order_relaxed);
+            while (chunk) {
+                auto next = chunk->next.load(std::memory_order_relaxed);
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        void append(const Event &event) {
+            auto size = tail->size.load(std::memory_order_relaxed);
+            if (size == Chunk::capacity) {
+                if (chunks == max_chunks) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                auto chunk = new Chunk();
+                tail->next.store(chunk, std::memory_order_release);
+                tail = chunk;
+                chunks++;
+                size = 0;
+            }
+            tail->events[size] = event;
+            tail->size.store(size + 1, std::memory_order_release);
+        }
+
+        template<class F>
+        void for_each(F f) const {
+            for (auto chunk = &head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+                auto size = chunk->size.load(std::memory_order_acquire);
+                for (size_t i = 0; i < size; i++) f(chunk->events[i]);
+            }
+        }
+
+        const std::string thread_name;
+        const size_t index;
+        std::atomic<size_t> dropped{0};
+
+    private:
+        struct Chunk {
+            static constexpr size_t capacity = 1024;
+
+            std::atomic<size_t> size{0};
+            std::atomic<Chunk *> next{nullptr};
+            Event events[capacity];
+        };
+
+        // About 50 MB of events per thread.
+        static constexpr size_t max_chunks = 1024;
+
+        Chunk head;
+        Chunk *tail = &head;
+        size_t chunks = 1;
+    };
+
+    namespace {
+
+        // Thread ids are reused once a thread exits; tokens are not, so a new thread never shares an old buffer.
+        uint64_t thread_token() {
+            static std::atomic<uint64_t> next{0};
+            thread_local const uint64_t token = next.fetch_add(1, std::memory_order_relaxed);
+            return token;
+        }
+
+        struct ThreadState {
+            std::shared_ptr<Trace> trace;
+            Trace::Buffer *buffer = nullptr;
+            const char *gadget = nullptr;
+        };
+
+        thread_local ThreadState state;
+
+        void write_string(std::ostream &stream, const char *string) {
+            if (!string) string = "";
+            stream << '"';
+            for (auto c = string; *c; c++) {
+                switch (*c) {
+                    case '"': stream << "\\\""; break;
+                    case '\\': stream << "\\\\"; break;
+                    case '\n': stream << "\\n"; break;
+                    case '\t': stream << "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(*c) < 0x20) {
+                            char escaped[8];
+                            std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                            stream << escaped;
+                        } else {
+                            stream << *c;
+                        }
+                }
+            }
+            stream << '"';
+        }
+
+        // Chrome trace timestamps are in microseconds; we keep the nanoseconds as decimals.
+        void write_microseconds(std::ostream &stream, uint64_t nanoseconds) {
+            stream << nanoseconds / 1000 << '.';
+            auto fraction = nanoseconds % 1000;
+            stream << char('0' + fraction / 100) << char('0' + fraction / 10 % 10) << char('0' + fraction % 10);
+        }
+    }
+
+    Trace::Trace(std::string connection) : connection_(std::move(connection)), origin(now()) {}
+
+    Trace::~Trace() = default;
+
+    const char *Trace::intern(const std::string &name) {
+        std::lock_guard<std::mutex> guard(mutex);
+        return names.insert(name).first->c_str();
+    }
+
+    void Trace::record(const Event &event) {
+        buffer("").append(event);
+    }
+
+    Trace::Buffer &Trace::buffer(const std::string &thread_name) {
+        auto token = thread_token();
+
+        std::lock_guard<std::mutex> guard(mutex);
+        auto &buffer = buffer_by_thread[token];
+        if (!buffer) {
+            buffers.push_back(std::make_unique<Buffer>(thread_name, buffers.size() + 1));
+            buffer = buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    std::vector<Event> Trace::events() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::vector<Event> events;
+        for (auto &buffer : buffers) buffer->for_each([&](const Event &event) { events.push_back(event); });
+        return events;
+    }
+
+    size_t Trace::dropped() const {
+        std::lock_guard<std::mutex> guard(mutex);
+        size_t dropped = 0;
+        for (auto &buffer : buffers) dropped += buffer->dropped.load(std::memory_order_relaxed);
+        return dropped;
+    }
+
+    void Trace::write_chrome_trace(std::ostream &stream) const {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":";
+        write_string(stream, connection_.c_str());
+        stream << "}}";
+
+        for (auto &buffer : buffers) {
+            stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->index
+                   << ",\"args\":{\"name\":";
+            write_string(stream, buffer->thread_name.c_str());
+            stream << "}}";
+
+            buffer->for_each([&](const Event &event) {
+                stream << ",\n{\"name\":";
+                write_string(stream, event.name);
+                stream << ",\"cat\":";
+                write_string(stream, event.category);
+                stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->index << ",\"ts\":";
+                write_microseconds(stream, event.begin > origin ? event.begin - origin : 0);
+                stream << ",\"dur\":";
+                write_microseconds(stream, event.end > event.begin ? event.end - event.begin : 0);
+                stream << ",\"args\":{\"connection\":";
+                write_string(stream, connection_.c_str());
+                if (event.gadget) {
+                    stream << ",\"gadget\":";
+                    write_string(stream, event.gadget);
+                }
+                if (event.message >= 0) stream << ",\"message\":" << event.message;
+                stream << "}}";
+            });
+        }
+
+        stream << "\n]}\n";
+    }
+
+    std::shared_ptr<Trace> current() {
+        return state.trace;
+    }
+
+    const char *current_gadget() {
+        return state.gadget;
+    }
+
+    ScopedTrace::ScopedTrace(std::shared_ptr<Trace> trace, const std::string &gadget)
+        : previous_trace(std::move(state.trace)), previous_buffer(state.buffer), previous_gadget(state.gadget) {
+        state.buffer = trace ? &trace->buffer(gadget) : nullptr;
+        state.gadget = trace ? trace->intern(gadget) : nullptr;
+        state.trace = std::move(trace);
+    }
+
+    ScopedTrace::~ScopedTrace() {
+        state.trace = std::move(previous_trace);
+        state.buffer = previous_buffer;
+        state.gadget = previous_gadget;
+    }
+
+    Span::Span(const char *name, const char *category, int64_t message)
+        : buffer(state.buffer), event{name, category, state.gadget, 0, 0, message} {
+        if (buffer) event.begin = now();
+    }
+
+    Span::~Span() {
+        if (!buffer) return;
+        event.end = now();
+        buffer->append(event);
+    }
+
+    void record(const std::string &name, const char *category, uint64_t begin, uint64_t end, int64_t message) {
+        if (!state.buffer) return;
+        state.buffer->append(Event{state.trace->intern(name), category, state.gadget, begin, end, message});
+    }
+}}
@@ -0,0 +1,127 @@
+/** \file trace.h
+    \brief Spans recording where the time of a connection goes, exported in the Chrome trace event format.
+
+    A Trace collects the spans of one connection. Threads working for the connection install it with ScopedTrace,
+    after which every Span on the thread is recorded, tagged with the gadget given to ScopedTrace. Each thread records
+    into a buffer of its own, so recording takes no locks; with no trace installed a Span does nothing but check a
+    thread local.
+
+    The result can be written as JSON and opened in chrome://tracing or https://ui.perfetto.dev.
+*/
+
+#pragma once
+
+#include "log_export.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Gadgetron { namespace Tracing {
+
+    /// Nanoseconds on a steady clock.
+    inline uint64_t now() {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    struct Event {
+        const char *name;
+        const char *category;
+        const char *gadget;
+        uint64_t begin;
+        uint64_t end;
+        int64_t message; ///< -1 if the span is not about a particular message.
+    };
+
+    class EXPORTGADGETRONLOG Trace {
+    public:
+        explicit Trace(std::string connection);
+        ~Trace();
+
+        Trace(const Trace &) = delete;
+        Trace &operator=(const Trace &) = delete;
+
+        const std::string &connection() const { return connection_; }
+
+        /// Returns a copy of name which lives as long as the trace.
+        const char *intern(const std::string &name);
+
+        /// Records an event on behalf of the calling thread. Names must be string literals or interned.
+        void record(const Event &event);
+
+        /// Events recorded so far, thread by thread.
+        std::vector<Event> events() const;
+
+        /// Events dropped because a thread filled its buffer.
+        size_t dropped() const;
+
+        void write_chrome_trace(std::ostream &stream) const;
+
+        class Buffer;
+
+        /// The buffer of the calling thread, created (and named thread_name) on first use.
+        Buffer &buffer(const std::string &thread_name);
+
+    private:
+        const std::string connection_;
+        const uint64_t origin;
+
+        mutable std::mutex mutex;
+        std::unordered_set<std::string> names;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        std::unordered_map<uint64_t, Buffer *> buffer_by_thread;
+    };
+
+    /// The trace installed on this thread, if any.
+    EXPORTGADGETRONLOG std::shared_ptr<Trace> current();
+
+    /// The gadget spans on this thread are tagged with, or nullptr if no trace is installed.
+    EXPORTGADGETRONLOG const char *current_gadget();
+
+    /**
+     * Records the spans of this thread in trace, tagged with gadget, for the lifetime of the ScopedTrace.
+     * A null trace turns recording off.
+     */
+    class EXPORTGADGETRONLOG ScopedTrace {
+    public:
+        ScopedTrace(std::shared_ptr<Trace> trace, const std::string &gadget);
+        ~ScopedTrace();
+
+        ScopedTrace(const ScopedTrace &) = delete;
+        ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+    private:
+        std::shared_ptr<Trace> previous_trace;
+        Trace::Buffer *previous_buffer;
+        const char *previous_gadget;
+    };
+
+    /**
+     * Records the time from construction to destruction. name and category must be string literals or interned,
+     * and the span must end on the thread it started on.
+     */
+    class EXPORTGADGETRONLOG Span {
+    public:
+        explicit Span(const char *name, const char *category = "gadget", int64_t message = -1);
+        ~Span();
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+    private:
+        Trace::Buffer *buffer;
+        Event event;
+    };
+
+    /// Records a span on this thread, if a trace is installed. The name is interned.
+    EXPORTGADGETRONLOG void record(const std::string &name, const char *category, uint64_t begin, uint64_t end,
+                                   int64_t message = -1);
+}}
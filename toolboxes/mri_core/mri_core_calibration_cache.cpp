@@ -0,0 +1,26 @@
+/** \file   mri_core_calibration_cache.cpp
+    \brief  Process wide cache of calibration results, keyed by content.
+*/
+
+#include "mri_core_calibration_cache.h"
+
+#include <cstdlib>
+
+namespace Gadgetron
+{
+    namespace
+    {
+        size_t default_budget()
+        {
+            const char* megabytes = std::getenv("GADGETRON_CALIBRATION_CACHE_MB");
+            if (megabytes) return size_t(std::strtoull(megabytes, nullptr, 10)) << 20;
+            return size_t(512) << 20;
+        }
+    }
+
+    CalibrationCache& CalibrationCache::instance()
+    {
+        static CalibrationCache cache(default_budget());
+        return cache;
+    }
+}
@@ -0,0 +1,29 @@
+/** \file   mri_core_calibration_cache.h
+    \brief  Process wide cache of calibration results (coil maps, kernels, unmixing coefficients), keyed by content.
+
+    A CalibrationKey is a digest of everything a calibration depends on: the reference data itself, the recon size
+    and the parameters. Reference data that is sent again unchanged (repeated measurements, separate reference scans
+    reused across series) hashes to the same key, and the calibration can be looked up instead of being recomputed.
+
+    The cache lives as long as the process. Its memory budget is GADGETRON_CALIBRATION_CACHE_MB megabytes (512 if
+    not set; 0 disables the cache).
+*/
+
+#pragma once
+
+#include "mri_core_export.h"
+#include "hoContentCache.h"
+
+namespace Gadgetron
+{
+    using CalibrationKey = ContentKey;
+
+    class EXPORTMRICORE CalibrationCache : public ContentCache
+    {
+    public:
+        using ContentCache::ContentCache;
+
+        /// the cache shared by all connections served by this process
+        static CalibrationCache& instance();
+    };
+}
@@ -32,6 +32,8 @@
 #include "hoNDArray_reductions.h"
 #include "ImageIOAnalyze.h"
 
+#include <algorithm>
+
 #ifdef USE_OMP
     #include "omp.h"
 #endif // USE_OMP
@@ -861,6 +863,75 @@ template EXPORTMRICORE void grappa2d_image_domain_unwrapping_aliased_image(const
 
 // ------------------------------------------------------------------------
 
+namespace
+{
+    // Pixels per tile. The accumulators of a tile stay in L1 while the coils are streamed through.
+    const size_t unmix_tile_size = 512;
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+    #define GADGETRON_UNMIX_TARGETS __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+    #define GADGETRON_UNMIX_TARGETS
+#endif
+
+    // Works on real and imaginary parts directly; std::complex multiplication checks for infinities and NaN,
+    // which keeps the compiler from vectorizing it.
+    template <typename R>
+    GADGETRON_UNMIX_TARGETS
+    void unmix_tile(const R* data, const R* coeff, size_t coil_stride, size_t n, size_t coils, R* out)
+    {
+        R re[unmix_tile_size], im[unmix_tile_size];
+        std::fill_n(re, n, R(0));
+        std::fill_n(im, n, R(0));
+
+        for (size_t c = 0; c < coils; c++)
+        {
+            const R* d = data + 2 * c * coil_stride;
+            const R* w = coeff + 2 * c * coil_stride;
+            for (size_t p = 0; p < n; p++)
+            {
+                R dr = d[2 * p], di = d[2 * p + 1];
+                R wr = w[2 * p], wi = w[2 * p + 1];
+                re[p] += wr * dr - wi * di;
+                im[p] += wr * di + wi * dr;
+            }
+        }
+
+        for (size_t p = 0; p < n; p++)
+        {
+            out[2 * p] = re[p];
+            out[2 * p + 1] = im[p];
+        }
+    }
+}
+
+template <typename T>
+void apply_unmix_coeff(const T* data, size_t data_batch_stride, const T* coeff, size_t coeff_batch_stride, size_t pixels, size_t coils, size_t batches, T* out)
+{
+    typedef typename realType<T>::Type R;
+
+    const long long tiles = (long long)((pixels + unmix_tile_size - 1) / unmix_tile_size);
+    const long long tasks = tiles * (long long)batches;
+
+#pragma omp parallel for schedule(static) if (pixels * coils * batches > 64 * 1024)
+    for (long long task = 0; task < tasks; task++)
+    {
+        size_t b = (size_t)(task / tiles);
+        size_t start = (size_t)(task % tiles) * unmix_tile_size;
+        size_t n = std::min(unmix_tile_size, pixels - start);
+
+        unmix_tile(reinterpret_cast<const R*>(data + b * data_batch_stride + start),
+                   reinterpret_cast<const R*>(coeff + b * coeff_batch_stride + start),
+                   pixels, n, coils,
+                   reinterpret_cast<R*>(out + b * pixels + start));
+    }
+}
+
+template EXPORTMRICORE void apply_unmix_coeff(const std::complex<float>* data, size_t data_batch_stride, const std::complex<float>* coeff, size_t coeff_batch_stride, size_t pixels, size_t coils, size_t batches, std::complex<float>* out);
+template EXPORTMRICORE void apply_unmix_coeff(const std::complex<double>* data, size_t data_batch_stride, const std::complex<double>* coeff, size_t coeff_batch_stride, size_t pixels, size_t coils, size_t batches, std::complex<double>* out);
+
+// ------------------------------------------------------------------------
+
 template <typename T>
 void apply_unmix_coeff_kspace(const hoNDArray<T>& kspace, const hoNDArray<T>& unmixCoeff, hoNDArray<T>& complexIm)
 {
@@ -870,6 +941,10 @@ void apply_unmix_coeff_kspace(const hoNDArray<T>& kspace, const hoNDArray<T>& un
         GADGET_CHECK_THROW(kspace.get_size(1) == unmixCoeff.get_size(1));
         GADGET_CHECK_THROW(kspace.get_size(2) == unmixCoeff.get_size(2));
 
+        size_t pixels = kspace.get_size(0) * kspace.get_size(1);
+        size_t srcCHA = kspace.get_size(2);
+        GADGET_CHECK_THROW(unmixCoeff.get_number_of_elements() == pixels * srcCHA);
+
         hoNDArray<T> buffer2DT(kspace);
         GADGET_CATCH_THROW(Gadgetron::hoNDFFT<typename realType<T>::Type>::instance()->ifft2c(kspace, buffer2DT));
 
@@ -882,8 +957,8 @@ void apply_unmix_coeff_kspace(const hoNDArray<T>& kspace, const hoNDArray<T>& un
             complexIm.create(&dim);
         }
 
-        Gadgetron::multiply(buffer2DT, unmixCoeff, buffer2DT);
-        Gadgetron::sum_over_dimension(buffer2DT, complexIm, 2);
+        size_t N = kspace.get_number_of_elements() / (pixels * srcCHA);
+        Gadgetron::apply_unmix_coeff(buffer2DT.begin(), pixels * srcCHA, unmixCoeff.begin(), 0, pixels, srcCHA, N, complexIm.begin());
     }
     catch (...)
     {
@@ -905,6 +980,10 @@ void apply_unmix_coeff_aliased_image(const hoNDArray<T>& aliasedIm, const hoNDAr
         GADGET_CHECK_THROW(aliasedIm.get_size(1) == unmixCoeff.get_size(1));
         GADGET_CHECK_THROW(aliasedIm.get_size(2) == unmixCoeff.get_size(2));
 
+        size_t pixels = aliasedIm.get_size(0) * aliasedIm.get_size(1);
+        size_t srcCHA = aliasedIm.get_size(2);
+        GADGET_CHECK_THROW(unmixCoeff.get_number_of_elements() == pixels * srcCHA);
+
         std::vector<size_t> dim;
         aliasedIm.get_dimensions(dim);
         dim[2] = 1;
@@ -914,10 +993,8 @@ void apply_unmix_coeff_aliased_image(const hoNDArray<T>& aliasedIm, const hoNDAr
             complexIm.create(&dim);
         }
 
-        hoNDArray<T> buffer2DT(aliasedIm);
-
-        Gadgetron::multiply(aliasedIm, unmixCoeff, buffer2DT);
-        Gadgetron::sum_over_dimension(buffer2DT, complexIm, 2);
+        size_t N = aliasedIm.get_number_of_elements() / (pixels * srcCHA);
+        Gadgetron::apply_unmix_coeff(aliasedIm.begin(), pixels * srcCHA, unmixCoeff.begin(), 0, pixels, srcCHA, N, complexIm.begin());
     }
     catch (...)
     {
@@ -1773,12 +1850,8 @@ void apply_unmix_coeff_kspace_3D(const hoNDArray<T>& kspace, const hoNDArray<T>&
         buffer.create(dim);
         Gadgetron::hoNDFFT<typename realType<T>::Type>::instance()->ifft3c(kspace, aliasedIm, buffer);
 
-        Gadgetron::multiply(aliasedIm, unmixCoeff, buffer);
-
-        hoNDArray<T> bufferIm;
-        bufferIm.create(RO, E1, E2, 1, N, complexIm.begin());
-
-        Gadgetron::sum_over_dimension(buffer, bufferIm, 3);
+        size_t pixels = RO*E1*E2;
+        Gadgetron::apply_unmix_coeff(aliasedIm.begin(), pixels*srcCHA, unmixCoeff.begin(), 0, pixels, srcCHA, N, complexIm.begin());
     }
     catch (...)
     {
@@ -1803,9 +1876,6 @@ void apply_unmix_coeff_aliased_image_3D(const hoNDArray<T>& aliasedIm, const hoN
 
         size_t N = aliasedIm.get_size(4);
 
-        std::vector<size_t> dim;
-        aliasedIm.get_dimensions(dim);
-
         GADGET_CHECK_THROW(unmixCoeff.get_size(0) == RO);
         GADGET_CHECK_THROW(unmixCoeff.get_size(1) == E1);
         GADGET_CHECK_THROW(unmixCoeff.get_size(2) == E2);
@@ -1819,15 +1889,8 @@ void apply_unmix_coeff_aliased_image_3D(const hoNDArray<T>& aliasedIm, const hoN
             complexIm.create(RO, E1, E2, N);
         }
 
-        hoNDArray<T> buffer;
-        buffer.create(dim);
-
-        Gadgetron::multiply(aliasedIm, unmixCoeff, buffer);
-
-        hoNDArray<T> bufferIm;
-        bufferIm.create(RO, E1, E2, 1, N, complexIm.begin());
-
-        Gadgetron::sum_over_dimension(buffer, bufferIm, 3);
+        size_t pixels = RO*E1*E2;
+        Gadgetron::apply_unmix_coeff(aliasedIm.begin(), pixels*srcCHA, unmixCoeff.begin(), 0, pixels, srcCHA, N, complexIm.begin());
     }
     catch (...)
     {
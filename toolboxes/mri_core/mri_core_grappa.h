@@ -58,6 +58,13 @@ namespace Gadgetron {
     /// aliasedIm : [RO E1 srcCHA ...]
     template <typename T> EXPORTMRICORE void apply_unmix_coeff_aliased_image(const hoNDArray<T>& aliasedIm, const hoNDArray<T>& unmixCoeff, hoNDArray<T>& complexIm);
 
+    /// coil weighted sum, the kernel behind the apply_unmix_coeff functions
+    /// data : [pixels coils] for each of the batches, batches spaced data_batch_stride elements apart
+    /// coeff : [pixels coils] for each of the batches, batches spaced coeff_batch_stride elements apart
+    /// out : [pixels batches], out(p, b) = sum over c of coeff(p, c, b) * data(p, c, b)
+    /// a batch stride of 0 applies the same data or coefficients to every batch
+    template <typename T> EXPORTMRICORE void apply_unmix_coeff(const T* data, size_t data_batch_stride, const T* coeff, size_t coeff_batch_stride, size_t pixels, size_t coils, size_t batches, T* out);
+
     /// ------------------------
     /// grappa 2d low level functions
     /// ------------------------
@@ -16,6 +16,7 @@
 #include <vector>
 #include <cmath>
 #include <stdexcept>
+#include <cstdlib>
 #include <boost/make_shared.hpp>
 
 #include "hoNFFT_sparseMatrix.h"
@@ -142,6 +143,34 @@ namespace Gadgetron {
 
 
 
+    namespace {
+        size_t default_cache_budget() {
+            const char* megabytes = std::getenv("GADGETRON_NFFT_CACHE_MB");
+            if (megabytes) return size_t(std::strtoull(megabytes, nullptr, 10)) << 20;
+            return size_t(256) << 20;
+        }
+
+        template<class T, unsigned int D>
+        ContentKey& add_to_key(ContentKey& key, const vector_td<T, D>& vector) {
+            return key.add(&vector[0], sizeof(vector));
+        }
+
+        template<class REAL>
+        size_t memory_size(const std::vector<NFFT_internal::NFFT_Matrix<REAL>>& matrices) {
+            size_t bytes = 0;
+            for (auto& matrix : matrices) {
+                bytes += matrix.row_offsets.size() * sizeof(size_t) + matrix.non_zeros() * (sizeof(uint32_t) + sizeof(REAL));
+            }
+            return bytes;
+        }
+    }
+
+    ContentCache& hoNFFT_cache() {
+        static ContentCache cache(default_cache_budget());
+        return cache;
+    }
+
+
     template<class REAL, unsigned int D>
     hoNFFT_plan<REAL, D>::hoNFFT_plan(
             const vector_td<size_t, D> &matrix_size,
@@ -150,13 +179,7 @@ namespace Gadgetron {
     ) : NFFT_plan<hoNDArray,REAL,D>(matrix_size,matrix_size_os,W) {
 
         this->beta = compute_beta(W,matrix_size,matrix_size_os);
-        this->deapodization_filter_IFFT = compute_deapodization_filter(this->matrix_size_os,this->beta, this->W);
-        this->deapodization_filter_FFT = deapodization_filter_IFFT;
-        FFTD<std::complex<REAL>,D>::fft(deapodization_filter_IFFT,NFFT_fft_mode::BACKWARDS,true);
-        FFTD<std::complex<REAL>,D>::fft(deapodization_filter_FFT,NFFT_fft_mode::FORWARDS,true);
-
-        boost::transform(deapodization_filter_IFFT,deapodization_filter_IFFT.begin(),[](auto val){return REAL(1)/val;});
-        boost::transform(deapodization_filter_FFT,deapodization_filter_FFT.begin(),[](auto val){return REAL(1)/val;});
+        make_deapodization(matrix_size, true);
     }
 
     template<class REAL, unsigned int D>
@@ -165,16 +188,35 @@ namespace Gadgetron {
 
 
         this->beta = compute_beta(W, matrix_size, this->matrix_size_os);
-        this->deapodization_filter_IFFT = compute_deapodization_filter(this->matrix_size_os, this->beta, this->W);
-        this->deapodization_filter_FFT = deapodization_filter_IFFT;
+        make_deapodization(matrix_size, false);
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFT_plan<REAL, D>::make_deapodization(const vector_td<size_t, D> &matrix_size, bool do_scale) {
+
+        ContentKey key;
+        key.add(std::string("hoNFFT deapodization")).add(sizeof(REAL)).add(D).add(this->W).add(do_scale);
+        add_to_key(key, matrix_size);
+        add_to_key(key, this->matrix_size_os);
+
+        deapodization = hoNFFT_cache().find<Deapodization>(key);
+        if (deapodization) return;
+
+        auto filters = std::make_shared<Deapodization>();
+        filters->filter_IFFT = compute_deapodization_filter(this->matrix_size_os, this->beta, this->W);
+        filters->filter_FFT = filters->filter_IFFT;
+
+        FFTD<std::complex<REAL>, D>::fft(filters->filter_IFFT, NFFT_fft_mode::BACKWARDS, do_scale);
+        FFTD<std::complex<REAL>, D>::fft(filters->filter_FFT, NFFT_fft_mode::FORWARDS, do_scale);
 
-        FFTD<std::complex<REAL>, D>::fft(deapodization_filter_IFFT, NFFT_fft_mode::BACKWARDS, false);
-        FFTD<std::complex<REAL>, D>::fft(deapodization_filter_FFT, NFFT_fft_mode::FORWARDS, false);
-        
-        boost::transform(deapodization_filter_IFFT, deapodization_filter_IFFT.begin(),
+        boost::transform(filters->filter_IFFT, filters->filter_IFFT.begin(),
                          [](auto val) { return REAL(1) / val; });
-        boost::transform(deapodization_filter_FFT, deapodization_filter_FFT.begin(),
+        boost::transform(filters->filter_FFT, filters->filter_FFT.begin(),
                          [](auto val) { return REAL(1) / val; });
+
+        deapodization = filters;
+        hoNFFT_cache().insert<Deapodization>(key, deapodization,
+                2 * filters->filter_FFT.get_number_of_bytes());
     }
 
 
@@ -184,23 +226,38 @@ namespace Gadgetron {
 
         GadgetronTimer timer("Preprocess");
         NFFT_plan<hoNDArray,REAL,D>::preprocess(trajectories,mode);
+
+        const bool transpose = mode == NFFT_prep_mode::ALL || mode == NFFT_prep_mode::NC2C;
+
+        ContentKey key;
+        key.add(std::string("hoNFFT convolution")).add(sizeof(REAL)).add(D).add(this->W).add(transpose);
+        add_to_key(key, this->matrix_size_os);
+        add_to_key(key, beta);
+        key.add(trajectories);
+
+        convolution = hoNFFT_cache().find<Convolution>(key);
+        if (convolution) return;
+
         auto trajectories_scaled = trajectories;
         auto matrix_size_os_real = vector_td<REAL,D>(this->matrix_size_os);
         std::transform(trajectories_scaled.begin(),trajectories_scaled.end(),trajectories_scaled.begin(),[matrix_size_os_real](auto point){
            return (point+REAL(0.5))*matrix_size_os_real;
         });
 
-        convolution_matrix.reserve(this->number_of_frames);
-        convolution_matrix_T.reserve(this->number_of_frames);
+        auto matrices = std::make_shared<Convolution>();
+        matrices->matrix.reserve(this->number_of_frames);
+        matrices->matrix_T.reserve(this->number_of_frames);
 
         for (auto traj : NDArrayViewRange<hoNDArray<vector_td<REAL,D>>>(trajectories_scaled,0)){
-            convolution_matrix.push_back(NFFT_internal::make_NFFT_matrix(traj, this->matrix_size_os, this->W, beta));
-            if (mode == NFFT_prep_mode::ALL || mode == NFFT_prep_mode::NC2C) {
-                convolution_matrix_T.push_back(NFFT_internal::transpose(convolution_matrix.back()));
+            matrices->matrix.push_back(NFFT_internal::make_NFFT_matrix(traj, this->matrix_size_os, this->W, beta));
+            if (transpose) {
+                matrices->matrix_T.push_back(NFFT_internal::transpose(matrices->matrix.back()));
             }
         }
 
-
+        convolution = matrices;
+        hoNFFT_cache().insert<Convolution>(key, convolution,
+                memory_size(matrices->matrix) + memory_size(matrices->matrix_T));
     }
 
     template<class REAL, unsigned int D>
@@ -247,12 +304,12 @@ namespace Gadgetron {
             const hoNDArray<REAL>* dcw
     ) {
         std::vector<size_t> dims = {this->number_of_samples,this->number_of_frames};
-        auto batches = in.get_number_of_elements()/(prod(this->matrix_size_os)*this->number_of_frames);
+        auto batches = in.get_number_of_elements()/(prod(this->matrix_size)*this->number_of_frames);
         dims.push_back(batches);
 
         hoNDArray<ComplexType> tmp(dims);
-        compute(in, tmp, dcw, NFFT_comp_mode::BACKWARDS_NC2C);
-        compute(tmp, out,dcw, NFFT_comp_mode::FORWARDS_C2NC);
+        compute(in, tmp, dcw, NFFT_comp_mode::FORWARDS_C2NC);
+        compute(tmp, out, dcw, NFFT_comp_mode::BACKWARDS_NC2C);
     }
 
     template<class REAL, unsigned int D>
@@ -306,9 +363,9 @@ namespace Gadgetron {
             bool fourierDomain
     ) {
         if (fourierDomain){
-            d *= deapodization_filter_FFT;
+            d *= deapodization->filter_FFT;
         } else {
-            d *= deapodization_filter_IFFT;
+            d *= deapodization->filter_IFFT;
         }
     }
         template<class REAL, unsigned int D>
@@ -323,18 +380,46 @@ namespace Gadgetron {
 
 
     namespace {
-        template<class REAL> void
-        matrix_vector_multiply(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL>& matrix, const complext<REAL>* vector, complext<REAL>* result) {
+        template<class T> void
+        interleave(const T* batches, size_t stride, size_t length, size_t channels, T* block) {
+#pragma omp parallel for
+            for (long long i = 0; i < (long long)length; i++) {
+                for (size_t c = 0; c < channels; c++) block[i * channels + c] = batches[c * stride + i];
+            }
+        }
 
-            for (size_t i = 0; i < matrix.n_cols; i++) {
-                auto &row_indices = matrix.indices[i];
-                auto &weights = matrix.weights[i];
+        /**
+            Multiplies every batch with the matrix of its frame. Batch b belongs to frame b % frames, so the
+            batches of a frame lie frames vectors apart. They are multiplied channels_per_pass at a time, with
+            their inputs gathered next to each other, in one pass over the matrix. More channels per pass save
+            reading the matrix, but spread the gathered inputs beyond the cache.
+        */
+        template<class REAL> void
+        convolve_batches(const std::vector<NFFT_internal::NFFT_Matrix<REAL>>& matrices,
+                         const std::complex<REAL>* input, std::complex<REAL>* output, size_t nbatches, bool accumulate) {
+
+            const size_t channels_per_pass = 8;
+            const size_t frames = matrices.size();
+            hoNDArray<std::complex<REAL>> block;
+
+            for (size_t frame = 0; frame < std::min(frames, nbatches); frame++) {
+                auto& matrix = matrices[frame];
+                const size_t channels = (nbatches - frame + frames - 1) / frames;
+                const size_t input_stride = frames * matrix.n_cols;
+                const size_t output_stride = frames * matrix.n_rows;
+
+                for (size_t first = 0; first < channels; first += channels_per_pass) {
+                    const size_t pass_channels = std::min(channels_per_pass, channels - first);
+                    const std::complex<REAL>* pass_input = input + frame * matrix.n_cols + first * input_stride;
+                    std::complex<REAL>* pass_output = output + frame * matrix.n_rows + first * output_stride;
+
+                    if (pass_channels > 1) {
+                        block.create(pass_channels, matrix.n_cols);
+                        interleave(pass_input, input_stride, matrix.n_cols, pass_channels, block.get_data_ptr());
+                        pass_input = block.get_data_ptr();
+                    }
 
-#ifndef WIN32
-    #pragma omp simd
-#endif // WIN32
-                for (size_t n = 0; n < row_indices.size(); n++) {
-                    result[i] += vector[row_indices[n]] * weights[n];
+                    NFFT_internal::multiply(matrix, pass_input, pass_channels, pass_output, output_stride, accumulate);
                 }
             }
         }
@@ -346,20 +431,11 @@ namespace Gadgetron {
             hoNDArray<ComplexType> &non_cartesian, bool accumulate
     ) {
 
-        size_t nbatches = cartesian.get_number_of_elements()/convolution_matrix.front().n_rows;
-        assert(nbatches == non_cartesian.get_number_of_elements()/convolution_matrix.front().n_cols);
-
-        if (!accumulate) clear(&non_cartesian);
-
-#pragma omp parallel for
-        for (int b = 0; b < (int)nbatches; b++) {
-
-            const ComplexType* cartesian_view = cartesian.get_data_ptr()+b*convolution_matrix.front().n_rows;
-            ComplexType* non_cartesian_view = non_cartesian.get_data_ptr()+b*convolution_matrix.front().n_cols;
-            size_t matrix_index = b%convolution_matrix.size();
-            matrix_vector_multiply(convolution_matrix[matrix_index],(complext<REAL>*)cartesian_view,(complext<REAL>*)non_cartesian_view);
-        }
+        auto& matrices = convolution->matrix;
+        size_t nbatches = cartesian.get_number_of_elements()/matrices.front().n_cols;
+        assert(nbatches == non_cartesian.get_number_of_elements()/matrices.front().n_rows);
 
+        convolve_batches(matrices, cartesian.get_data_ptr(), non_cartesian.get_data_ptr(), nbatches, accumulate);
     }
 
     template<class REAL, unsigned int D>
@@ -367,19 +443,12 @@ namespace Gadgetron {
             const hoNDArray<ComplexType> &non_cartesian,
             hoNDArray<ComplexType> &cartesian, bool accumulate
     ) {
-                size_t nbatches = cartesian.get_number_of_elements()/convolution_matrix.front().n_rows;
-        assert(nbatches == non_cartesian.get_number_of_elements()/convolution_matrix.front().n_cols);
+        auto& matrices = convolution->matrix;
+        size_t nbatches = cartesian.get_number_of_elements()/matrices.front().n_cols;
+        assert(nbatches == non_cartesian.get_number_of_elements()/matrices.front().n_rows);
         GadgetronTimer timer("Convolution");
-        if (!accumulate) clear(&cartesian);
-#pragma omp parallel for
-        for (int b = 0; b < (int)nbatches; b++) {
 
-            ComplexType *cartesian_view = cartesian.get_data_ptr() + b * convolution_matrix.front().n_rows;
-            const ComplexType *non_cartesian_view = non_cartesian.get_data_ptr() + b * convolution_matrix.front().n_cols;
-            size_t matrix_index = b%convolution_matrix.size();
-            matrix_vector_multiply(convolution_matrix_T[matrix_index], (complext<REAL>*)non_cartesian_view, (complext<REAL>*)cartesian_view);
-
-        }
+        convolve_batches(convolution->matrix_T, non_cartesian.get_data_ptr(), cartesian.get_data_ptr(), nbatches, accumulate);
     }
 
 
@@ -21,6 +21,9 @@
 
 #include "../nfft_export.h"
 #include "hoNFFT_sparseMatrix.h"
+#include "hoContentCache.h"
+
+#include <memory>
 
 namespace Gadgetron{
 
@@ -179,9 +182,9 @@ namespace Gadgetron{
             /**
                 Dedicated convolutions
 
-                The two methods below are entirely symmetric in 
-                thier implementation. They could probably be
-                combined for conciseness.
+                Both multiply the batches of each frame by the
+                convolution matrix of the frame, or its transpose,
+                several coils per pass over the matrix.
             */
 
             void convolve_NFFT_C2NC(
@@ -197,6 +200,23 @@ namespace Gadgetron{
 
             static vector_td<REAL,D> compute_beta(REAL W, const vector_td<size_t,D>& matrix_size, const vector_td<size_t,D>& matrix_size_os);
 
+            /**
+                Convolution matrices and deapodization filters are
+                shared, through hoNFFT_cache(), by all plans with the
+                same trajectory and sizes.
+            */
+            struct Convolution {
+                std::vector<NFFT_internal::NFFT_Matrix<REAL>> matrix;
+                std::vector<NFFT_internal::NFFT_Matrix<REAL>> matrix_T;
+            };
+
+            struct Deapodization {
+                hoNDArray<ComplexType> filter_IFFT;
+                hoNDArray<ComplexType> filter_FFT;
+            };
+
+            void make_deapodization(const vector_td<size_t,D>& matrix_size, bool do_scale);
+
 
         /** 
             Implementation variables
@@ -205,15 +225,26 @@ namespace Gadgetron{
         private:
 
         vector_td<REAL,D> beta;
-        std::vector<NFFT_internal::NFFT_Matrix<REAL>> convolution_matrix;
-        std::vector<NFFT_internal::NFFT_Matrix<REAL>> convolution_matrix_T;
-
-        hoNDArray<ComplexType> deapodization_filter_IFFT;
-        hoNDArray<ComplexType> deapodization_filter_FFT;
+        std::shared_ptr<const Convolution> convolution;
+        std::shared_ptr<const Deapodization> deapodization;
 
     };
 
 
+    /**
+        Process wide cache of the preprocessed state of CPU NFFT plans:
+        the convolution matrices of a trajectory, keyed by the
+        trajectory, matrix sizes, kernel width and preprocessing mode,
+        and the deapodization filters, keyed by matrix sizes and kernel
+        width. Plans made for the same trajectory, whether for the next
+        frame or the next connection, skip preprocessing.
+
+        The memory budget is GADGETRON_NFFT_CACHE_MB megabytes (256 if
+        not set; 0 disables the cache).
+    */
+    EXPORTNFFT ContentCache& hoNFFT_cache();
+
+
     template<class REAL, unsigned int D> struct NFFT<hoNDArray,REAL,D>{
 
         using NFFT_plan = hoNFFT_plan<REAL,D>;
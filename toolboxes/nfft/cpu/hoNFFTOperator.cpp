@@ -1,9 +1,131 @@
 #include "nfft_export.h"
 #include "hoNDArray_math.h"
+#include "hoNDArray_utils.h"
 #include "hoNFFT.h"
+#include "hoNFFTOperator.h"
+#include "vector_td_utilities.h"
 #include "../NFFTOperator.hpp"
 
+#include <stdexcept>
+
 namespace Gadgetron{
+
+    template<class REAL, unsigned int D>
+    hoNFFTOperator<REAL, D>::hoNFFTOperator() : NFFTOperator<hoNDArray, REAL, D>(), toeplitz_(false), W_(0) {
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::set_toeplitz(bool toeplitz) {
+        toeplitz_ = toeplitz;
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::set_dcw(boost::shared_ptr<hoNDArray<REAL>> dcw) {
+        NFFTOperator<hoNDArray, REAL, D>::set_dcw(dcw);
+        kernel_.reset();
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::setup(typename uint64d<D>::Type matrix_size, typename uint64d<D>::Type matrix_size_os,
+                                        REAL W) {
+        NFFTOperator<hoNDArray, REAL, D>::setup(matrix_size, matrix_size_os, W);
+        matrix_size_ = matrix_size;
+        matrix_size_os_ = matrix_size_os;
+        W_ = W;
+        kernel_.reset();
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::preprocess(const hoNDArray<typename reald<REAL, D>::Type>& trajectory) {
+        NFFTOperator<hoNDArray, REAL, D>::preprocess(trajectory);
+        trajectory_ = trajectory;
+        kernel_.reset();
+    }
+
+    template<class REAL, unsigned int D>
+    void hoNFFTOperator<REAL, D>::mult_MH_M(hoNDArray<complext<REAL>>* in, hoNDArray<complext<REAL>>* out,
+                                            bool accumulate) {
+        if (!toeplitz_) {
+            NFFTOperator<hoNDArray, REAL, D>::mult_MH_M(in, out, accumulate);
+            return;
+        }
+
+        if (!in || !out) {
+            throw std::runtime_error("hoNFFTOperator::mult_MH_M : 0x0 input/output not accepted");
+        }
+
+        auto kernel = toeplitz_kernel();
+
+        auto padded_dims = to_std_vector(matrix_size_ * size_t(2));
+        for (size_t d = D; d < in->get_number_of_dimensions(); d++) padded_dims.push_back(in->get_size(d));
+
+        hoNDArray<complext<REAL>> padded(padded_dims);
+        pad<complext<REAL>, D>(*in, padded);
+
+        this->plan_->fft(padded, NFFT_fft_mode::FORWARDS);
+        padded *= *kernel;
+        this->plan_->fft(padded, NFFT_fft_mode::BACKWARDS);
+
+        const auto offset = matrix_size_ / size_t(2);
+        if (accumulate) {
+            hoNDArray<complext<REAL>> cropped(out->get_dimensions());
+            crop<complext<REAL>, D>(offset, matrix_size_, padded, cropped);
+            *out += cropped;
+        } else {
+            crop<complext<REAL>, D>(offset, matrix_size_, padded, *out);
+        }
+    }
+
+    template<class REAL, unsigned int D>
+    std::shared_ptr<const hoNDArray<complext<REAL>>> hoNFFTOperator<REAL, D>::toeplitz_kernel() {
+        if (kernel_) return kernel_;
+
+        if (!this->plan_ || trajectory_.get_number_of_elements() == 0) {
+            throw std::runtime_error("hoNFFTOperator : setup and preprocess must be called before mult_MH_M");
+        }
+
+        auto& dcw = this->dcw_;
+        if (dcw && dcw->get_number_of_elements() != trajectory_.get_number_of_elements()) {
+            throw std::runtime_error("hoNFFTOperator : density compensation weights do not match the trajectory");
+        }
+
+        ContentKey key;
+        key.add(std::string("hoNFFT Toeplitz kernel")).add(sizeof(REAL)).add(D).add(W_);
+        key.add(&matrix_size_[0], sizeof(matrix_size_)).add(&matrix_size_os_[0], sizeof(matrix_size_os_));
+        key.add(trajectory_).add(bool(dcw));
+        if (dcw) key.add(*dcw);
+
+        kernel_ = hoNFFT_cache().find<hoNDArray<complext<REAL>>>(key);
+        if (kernel_) return kernel_;
+
+        // mult_M weighs the samples with dcw, and so does mult_MH; the normal operator weighs them with its square.
+        hoNDArray<complext<REAL>> weights(trajectory_.dimensions());
+        for (size_t i = 0; i < weights.get_number_of_elements(); i++) {
+            weights[i] = complext<REAL>(dcw ? (*dcw)[i] * (*dcw)[i] : REAL(1));
+        }
+
+        // The point spread function covers every difference of two image positions.
+        const auto kernel_size = matrix_size_ * size_t(2);
+        hoNFFT_plan<REAL, D> plan(kernel_size, matrix_size_os_ * size_t(2), W_);
+        plan.preprocess(trajectory_, NFFT_prep_mode::NC2C);
+
+        auto kernel_dims = to_std_vector(kernel_size);
+        kernel_dims.push_back(trajectory_.get_number_of_elements() / trajectory_.get_size(0));
+
+        auto kernel = std::make_shared<hoNDArray<complext<REAL>>>(kernel_dims);
+        plan.compute(weights, *kernel, nullptr, NFFT_comp_mode::BACKWARDS_NC2C);
+        plan.fft(*kernel, NFFT_fft_mode::FORWARDS);
+
+        // The plans scale the point spread function the same way as mult_MH scales an image, so only the FFT
+        // convolution theorem is left: the product of two unitary FFTs needs the square root of the grid size.
+        const REAL scale = std::sqrt(REAL(prod(kernel_size)));
+        *kernel *= scale;
+
+        kernel_ = kernel;
+        hoNFFT_cache().insert<hoNDArray<complext<REAL>>>(key, kernel_, kernel->get_number_of_bytes());
+        return kernel_;
+    }
+
     template EXPORTNFFT class NFFTOperator<hoNDArray,float,1>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,float,2>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,float,3>;
@@ -11,5 +133,12 @@ namespace Gadgetron{
     template EXPORTNFFT class NFFTOperator<hoNDArray,double,1>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,double,2>;
     template EXPORTNFFT class NFFTOperator<hoNDArray,double,3>;
-}
 
+    template EXPORTNFFT class hoNFFTOperator<float,1>;
+    template EXPORTNFFT class hoNFFTOperator<float,2>;
+    template EXPORTNFFT class hoNFFTOperator<float,3>;
+
+    template EXPORTNFFT class hoNFFTOperator<double,1>;
+    template EXPORTNFFT class hoNFFTOperator<double,2>;
+    template EXPORTNFFT class hoNFFTOperator<double,3>;
+}
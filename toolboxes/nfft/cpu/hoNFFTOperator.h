@@ -0,0 +1,54 @@
+/**
+    \brief NFFT encoding operator on the CPU, with an optional Toeplitz embedded normal operator
+
+    With Toeplitz mode on, mult_MH_M does not grid and degrid. It pads the image to twice the matrix size,
+    multiplies its FFT with the FFT of the point spread function of the trajectory, and crops the inverse FFT.
+    The point spread function is computed by one adjoint NFFT of the (squared) density compensation weights on
+    the doubled grid, once per trajectory and weights, and is kept in hoNFFT_cache().
+
+    mult_M and mult_MH are the same in both modes.
+*/
+
+#pragma once
+
+#include "hoNDArray_math.h"
+#include "hoNFFT.h"
+#include "../NFFTOperator.h"
+
+#include <memory>
+
+namespace Gadgetron {
+
+    template<class REAL, unsigned int D>
+    class EXPORTNFFT hoNFFTOperator : public NFFTOperator<hoNDArray, REAL, D> {
+    public:
+
+        hoNFFTOperator();
+
+        virtual ~hoNFFTOperator() {}
+
+        void set_toeplitz(bool toeplitz);
+        bool get_toeplitz() const { return toeplitz_; }
+
+        virtual void set_dcw(boost::shared_ptr<hoNDArray<REAL>> dcw) override;
+
+        virtual void setup(typename uint64d<D>::Type matrix_size, typename uint64d<D>::Type matrix_size_os, REAL W) override;
+        virtual void preprocess(const hoNDArray<typename reald<REAL, D>::Type>& trajectory) override;
+
+        virtual void mult_MH_M(hoNDArray<complext<REAL>>* in, hoNDArray<complext<REAL>>* out, bool accumulate = false) override;
+
+    protected:
+
+        /// The FFT of the point spread function, on twice the matrix size, for each frame of the trajectory.
+        std::shared_ptr<const hoNDArray<complext<REAL>>> toeplitz_kernel();
+
+        bool toeplitz_;
+
+        typename uint64d<D>::Type matrix_size_;
+        typename uint64d<D>::Type matrix_size_os_;
+        REAL W_;
+
+        hoNDArray<typename reald<REAL, D>::Type> trajectory_;
+        std::shared_ptr<const hoNDArray<complext<REAL>>> kernel_;
+    };
+}
@@ -3,11 +3,13 @@
 //
 
 #include <GadgetronTimer.h>
+#include <algorithm>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
 #include "hoNFFT_sparseMatrix.h"
 #include "KaiserBessel_kernel.h"
 #include "vector_td_utilities.h"
-#include <boost/range/irange.hpp>
 
 namespace {
     using namespace Gadgetron;
@@ -24,21 +26,21 @@ namespace {
     template<class REAL, unsigned int D>
     void iterate_body(const vector_td<REAL, D> &point,
                       const vector_td<size_t, D> &matrix_size, REAL W, const vector_td<REAL, D> &beta,
-                      std::vector<size_t> &indices,
-                      std::vector<REAL> &weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<-1>) {
+                      uint32_t *&indices,
+                      REAL *&weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<-1>) {
 
-        indices.push_back(index);
-        weights.push_back(KaiserBessel(abs(image_point - point), vector_td<REAL,D>(matrix_size), REAL(1) / W, beta));
+        *indices++ = uint32_t(index);
+        *weights++ = KaiserBessel(abs(image_point - point), vector_td<REAL,D>(matrix_size), REAL(1) / W, beta);
 
     }
 
     template<class REAL, unsigned int D, int N>
     void iterate_body(const vector_td<REAL, D> &point,
                       const vector_td<size_t, D> &matrix_size, REAL W, const vector_td<REAL, D> &beta,
-                      std::vector<size_t> &indices,
-                      std::vector<REAL> &weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<N>) {
+                      uint32_t *&indices,
+                      REAL *&weights, vector_td<REAL, D> &image_point, size_t index, iteration_counter<N>) {
 
-        size_t frame_offset = std::accumulate(&matrix_size[0], &matrix_size[N], 1, std::multiplies<size_t>());
+        size_t frame_offset = std::accumulate(&matrix_size[0], &matrix_size[N], size_t(1), std::multiplies<size_t>());
 
         for (int i = std::ceil(point[N] - W * 0.5); i <= std::floor(point[N] + W * 0.5); i++) {
             auto wrapped_i = (i + matrix_size[N]) % matrix_size[N];
@@ -49,24 +51,31 @@ namespace {
         }
     }
 
+    // The number of grid points iterate_body visits for point.
     template<class REAL, unsigned int D>
-    std::tuple<std::vector<size_t>, std::vector<REAL>>
-    get_indices(const vector_td<REAL, D> &point, const vector_td<size_t, D> &matrix_size,
-                REAL W, const vector_td<REAL, D> &beta) {
-
-        std::vector<size_t> indices;
-        indices.reserve(size_t(std::pow(std::ceil(W), D)));
+    size_t number_of_indices(const vector_td<REAL, D> &point, REAL W) {
+        size_t count = 1;
+        for (unsigned int d = 0; d < D; d++) {
+            int first = std::ceil(point[d] - W * 0.5);
+            int last = std::floor(point[d] + W * 0.5);
+            count *= size_t(std::max(last - first + 1, 0));
+        }
+        return count;
+    }
 
-        std::vector<REAL> weights;
-        weights.reserve(size_t(std::pow(std::ceil(W), D)));
+    template<class REAL, unsigned int D>
+    void get_indices(const vector_td<REAL, D> &point, const vector_td<size_t, D> &matrix_size,
+                     REAL W, const vector_td<REAL, D> &beta, uint32_t *indices, REAL *weights) {
 
         vector_td<REAL, D> image_point;
         size_t index = 0;
         iterate_body(point, matrix_size, W, beta, indices, weights, image_point, index, iteration_counter<D - 1>());
-
-        return std::make_tuple(std::move(indices), std::move(weights));
     }
 
+    void check_column_count(size_t columns) {
+        if (columns > size_t(std::numeric_limits<uint32_t>::max()))
+            throw std::runtime_error("NFFT matrix has too many columns for 32 bit indices");
+    }
 
 }
 
@@ -77,19 +86,24 @@ Gadgetron::NFFT_internal::make_NFFT_matrix(const Gadgetron::hoNDArray<Gadgetron:
                                   const Gadgetron::vector_td<size_t, D> &image_dims, REAL W,
                                   const Gadgetron::vector_td<REAL, D> &beta) {
     GadgetronTimer timer("Make NFFT");
-//    std::vector<std::vector<size_t>> rowind;
-//    rowind.reserve(trajectories.get_number_of_elements() * std::ceil(std::pow(W, 3)));
 
-//    std::vector<size_t> colptr;
-//    colptr.reserve(trajectories.get_number_of_elements() + 1);
+    check_column_count(prod(image_dims));
+    NFFT_Matrix<REAL> matrix(trajectories.get_number_of_elements(), prod(image_dims));
+    const long long rows = (long long)matrix.n_rows;
 
-//    std::vector<std::vector<REAL>> weights;
-//    weights.reserve(trajectories.get_number_of_elements() * std::ceil(std::pow(W, 3)));
+#pragma omp parallel for
+    for (long long i = 0; i < rows; i++) {
+        matrix.row_offsets[i + 1] = number_of_indices(trajectories[i], W);
+    }
+    std::partial_sum(matrix.row_offsets.begin(), matrix.row_offsets.end(), matrix.row_offsets.begin());
+
+    matrix.column_indices.resize(matrix.non_zeros());
+    matrix.weights.resize(matrix.non_zeros());
 
-    NFFT_Matrix<REAL> matrix(trajectories.get_number_of_elements(),prod(image_dims));
-#pragma omp parallel for 
-    for (int i = 0; i < (int)trajectories.get_number_of_elements(); i++) {
-        std::tie(matrix.indices[i], matrix.weights[i]) = get_indices(trajectories[i], image_dims, W, beta);
+#pragma omp parallel for
+    for (long long i = 0; i < rows; i++) {
+        get_indices(trajectories[i], image_dims, W, beta, matrix.column_indices.data() + matrix.row_offsets[i],
+                    matrix.weights.data() + matrix.row_offsets[i]);
     }
     return matrix;
 }
@@ -101,36 +115,90 @@ Gadgetron::NFFT_internal::NFFT_Matrix<REAL>
 Gadgetron::NFFT_internal::transpose(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL> &matrix) {
     GadgetronTimer timer("Transpose");
 
-    auto work_index = boost::irange(size_t(0),matrix.n_cols);
+    check_column_count(matrix.n_rows);
+    NFFT_Matrix<REAL> transposed(matrix.n_cols, matrix.n_rows);
 
-    NFFT_Matrix<REAL> transposed(matrix.n_rows, matrix.n_cols);
+    for (auto column : matrix.column_indices) {
+        transposed.row_offsets[column + 1]++;
+    }
+    std::partial_sum(transposed.row_offsets.begin(), transposed.row_offsets.end(), transposed.row_offsets.begin());
+
+    transposed.column_indices.resize(transposed.non_zeros());
+    transposed.weights.resize(transposed.non_zeros());
+
+    // Rows are visited in order, so the entries of each transposed row end up sorted by column.
+    std::vector<size_t> next(transposed.row_offsets.begin(), transposed.row_offsets.end() - 1);
+    for (size_t i = 0; i < matrix.n_rows; i++) {
+        for (size_t k = matrix.row_offsets[i]; k < matrix.row_offsets[i + 1]; k++) {
+            auto position = next[matrix.column_indices[k]]++;
+            transposed.column_indices[position] = uint32_t(i);
+            transposed.weights[position] = matrix.weights[k];
+        }
+    }
+
+    return transposed;
+}
 
-    std::vector<int> counts(matrix.n_rows, 0);
 
+namespace {
 
-    for (size_t i : work_index) {
-        auto &rows = matrix.indices[i];
-        for (auto &row : rows) {
-            counts[row]++;
+    /**
+     * Adds row i of the matrix times CHANNELS channels of block to the same channels of result, starting at channel
+     * first. The sums are kept in registers for the whole row.
+     */
+    template<size_t CHANNELS, class REAL>
+    void multiply_row(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL> &matrix, size_t i, const REAL *block,
+                      size_t block_width, REAL *result, size_t result_stride, size_t first, bool accumulate) {
+
+        REAL sums[2 * CHANNELS];
+        for (size_t c = 0; c < CHANNELS; c++) {
+            REAL *value = result + 2 * ((first + c) * result_stride + i);
+            sums[2 * c] = accumulate ? value[0] : REAL(0);
+            sums[2 * c + 1] = accumulate ? value[1] : REAL(0);
         }
-    }
 
-    for (size_t i = 0; i < counts.size(); i++) {
-        transposed.indices[i].reserve(counts[i]);
-        transposed.weights[i].reserve(counts[i]);
-    }
+        for (size_t k = matrix.row_offsets[i]; k < matrix.row_offsets[i + 1]; k++) {
+            const REAL weight = matrix.weights[k];
+            const REAL *input = block + size_t(matrix.column_indices[k]) * block_width + 2 * first;
 
+#ifndef WIN32
+    #pragma omp simd
+#endif // WIN32
+            for (size_t n = 0; n < 2 * CHANNELS; n++) {
+                sums[n] += input[n] * weight;
+            }
+        }
 
-    for (size_t i : work_index ) {
-        auto &rows = matrix.indices[i];
-        auto &weights = matrix.weights[i];
-        for (size_t n = 0; n < rows.size(); n++) {
-            transposed.indices[rows[n]].push_back(i);
-            transposed.weights[rows[n]].push_back(weights[n]);
+        for (size_t c = 0; c < CHANNELS; c++) {
+            REAL *value = result + 2 * ((first + c) * result_stride + i);
+            value[0] = sums[2 * c];
+            value[1] = sums[2 * c + 1];
         }
     }
+}
 
-    return transposed;
+
+template<class REAL>
+void Gadgetron::NFFT_internal::multiply(const Gadgetron::NFFT_internal::NFFT_Matrix<REAL> &matrix,
+                                        const std::complex<REAL> *block, size_t channels,
+                                        std::complex<REAL> *result, size_t result_stride, bool accumulate) {
+
+    // A complex value is two REALs; the channels of a row of block are 2*channels consecutive REALs.
+    const size_t block_width = 2 * channels;
+    const REAL *input = reinterpret_cast<const REAL *>(block);
+    REAL *output = reinterpret_cast<REAL *>(result);
+    const long long rows = (long long)matrix.n_rows;
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long long i = 0; i < rows; i++) {
+        size_t c = 0;
+        for (; c + 8 <= channels; c += 8)
+            multiply_row<8>(matrix, i, input, block_width, output, result_stride, c, accumulate);
+        for (; c + 4 <= channels; c += 4)
+            multiply_row<4>(matrix, i, input, block_width, output, result_stride, c, accumulate);
+        for (; c < channels; c++)
+            multiply_row<1>(matrix, i, input, block_width, output, result_stride, c, accumulate);
+    }
 }
 
 
@@ -163,4 +231,11 @@ template Gadgetron::NFFT_internal::NFFT_Matrix<double> Gadgetron::NFFT_internal:
 template Gadgetron::NFFT_internal::NFFT_Matrix<float> Gadgetron::NFFT_internal::transpose(
         const Gadgetron::NFFT_internal::NFFT_Matrix<float> &matrix);
 template Gadgetron::NFFT_internal::NFFT_Matrix<double> Gadgetron::NFFT_internal::transpose(
-        const Gadgetron::NFFT_internal::NFFT_Matrix<double> &matrix);
\ No newline at end of file
+        const Gadgetron::NFFT_internal::NFFT_Matrix<double> &matrix);
+
+template void Gadgetron::NFFT_internal::multiply(const Gadgetron::NFFT_internal::NFFT_Matrix<float> &matrix,
+        const std::complex<float> *block, size_t channels, std::complex<float> *result, size_t result_stride,
+        bool accumulate);
+template void Gadgetron::NFFT_internal::multiply(const Gadgetron::NFFT_internal::NFFT_Matrix<double> &matrix,
+        const std::complex<double> *block, size_t channels, std::complex<double> *result, size_t result_stride,
+        bool accumulate);
\ No newline at end of file
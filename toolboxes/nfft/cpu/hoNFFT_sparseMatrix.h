@@ -4,29 +4,49 @@
 #include "hoNDArray.h"
 #include "vector_td.h"
 
+#include <complex>
+#include <cstdint>
+
 namespace Gadgetron {
     namespace NFFT_internal {
 
+        /**
+         * Sparse matrix in compressed sparse row form. The entries of row i are weights[k] at column_indices[k], for
+         * k in [row_offsets[i], row_offsets[i+1]). Column indices are 32 bit, which bounds the number of columns.
+         */
         template<class REAL> struct NFFT_Matrix {
 
-            NFFT_Matrix(size_t cols, size_t rows) : n_cols(cols),n_rows(rows) {
-                weights = std::vector<std::vector<REAL>>(n_cols);
-                indices = std::vector<std::vector<size_t>>(n_cols);
-            }
-            NFFT_Matrix(){}
-            std::vector<std::vector<REAL>> weights;
-            std::vector<std::vector<size_t>> indices;
-            size_t n_cols, n_rows;
+            NFFT_Matrix(size_t rows, size_t cols) : row_offsets(rows + 1, 0), n_rows(rows), n_cols(cols) {}
+            NFFT_Matrix() : row_offsets(1, 0), n_rows(0), n_cols(0) {}
+
+            size_t non_zeros() const { return row_offsets.back(); }
+
+            std::vector<size_t> row_offsets;
+            std::vector<uint32_t> column_indices;
+            std::vector<REAL> weights;
+            size_t n_rows, n_cols;
         };
 
 
         template<class REAL> NFFT_Matrix<REAL> transpose(const NFFT_Matrix<REAL>& matrix);
 
+        /**
+         * The convolution of the non-Cartesian samples with the kernel. Row i holds the weights of sample i on the
+         * Cartesian grid of image_dims.
+         */
         template<class REAL, unsigned int D>
         NFFT_Matrix<REAL>
         make_NFFT_matrix(const hoNDArray<vector_td<REAL, D>> trajectories, const vector_td<size_t, D> &image_dims,
                          REAL W, const vector_td<REAL, D> &beta);
+
+        /**
+         * result = matrix * block, or result += matrix * block if accumulate is set, for all channels at once.
+         *
+         * block holds n_cols rows of channels values each, the channels of a row next to each other. Channel c of
+         * result is the n_rows values starting at result + c*result_stride. The matrix is read once for all channels.
+         */
+        template<class REAL>
+        void multiply(const NFFT_Matrix<REAL>& matrix, const std::complex<REAL>* block, size_t channels,
+                      std::complex<REAL>* result, size_t result_stride, bool accumulate);
     }
 }
-
-
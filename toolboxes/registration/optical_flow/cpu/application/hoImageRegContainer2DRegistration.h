@@ -188,9 +188,13 @@ namespace Gadgetron {
         /// register two images
         /// transform or deform can contain the initial transformation or deformation
         /// if warped == NULL, warped images will not be computed
+        /// if targetPyramid != NULL, it is used as the resolution pyramid of target instead of creating one
         virtual bool registerTwoImagesParametric(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, TransformationParametricType& transform);
-        virtual bool registerTwoImagesDeformationField(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform);
-        virtual bool registerTwoImagesDeformationFieldBidirectional(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform, DeformationFieldType** deformInv);
+        virtual bool registerTwoImagesDeformationField(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform, std::vector<TargetType>* targetPyramid=NULL);
+        virtual bool registerTwoImagesDeformationFieldBidirectional(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform, DeformationFieldType** deformInv, std::vector<TargetType>* targetPyramid=NULL);
+
+        /// create the resolution pyramid of target, as the deformation field registration does
+        virtual bool createTargetPyramid(const TargetType& target, std::vector<TargetType>& pyramid);
 
         /// if warped is true, the warped images will be computed; if initial is true, the registration will be initialized by deformation_field_ and deformation_field_inverse_
         virtual bool registerOverContainer2DPairWise(TargetContinerType& targetContainer, SourceContinerType& sourceContainer, bool warped, bool initial = false);
@@ -552,7 +556,7 @@ namespace Gadgetron {
 
     template<typename TargetType, typename SourceType, typename CoordType> 
     bool hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::
-    registerTwoImagesDeformationField(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform)
+    registerTwoImagesDeformationField(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform, std::vector<TargetType>* targetPyramid)
     {
         try
         {
@@ -585,6 +589,11 @@ namespace Gadgetron {
             reg.setTarget( const_cast<TargetType&>(target) );
             reg.setSource( const_cast<TargetType&>(source) );
 
+            if ( targetPyramid != NULL )
+            {
+                reg.setTargetPyramid(*targetPyramid);
+            }
+
             if ( verbose_ )
             {
                 std::ostringstream outs;
@@ -651,7 +660,7 @@ namespace Gadgetron {
 
     template<typename TargetType, typename SourceType, typename CoordType> 
     bool hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::
-    registerTwoImagesDeformationFieldBidirectional(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform, DeformationFieldType** deformInv)
+    registerTwoImagesDeformationFieldBidirectional(const TargetType& target, const SourceType& source, bool initial, TargetType* warped, DeformationFieldType** deform, DeformationFieldType** deformInv, std::vector<TargetType>* targetPyramid)
     {
         try
         {
@@ -688,6 +697,11 @@ namespace Gadgetron {
             reg.setTarget( const_cast<TargetType&>(target) );
             reg.setSource( const_cast<SourceType&>(source) );
 
+            if ( targetPyramid != NULL )
+            {
+                reg.setTargetPyramid(*targetPyramid);
+            }
+
             if ( verbose_ )
             {
                 Gadgetron::printInfo(reg);
@@ -755,6 +769,28 @@ namespace Gadgetron {
         return true;
     }
 
+    template<typename TargetType, typename SourceType, typename CoordType> 
+    bool hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::
+    createTargetPyramid(const TargetType& target, std::vector<TargetType>& pyramid)
+    {
+        try
+        {
+            // the pyramid parameters are the defaults of the deformation field registration, for both directions
+            hoImageRegDeformationFieldRegister<TargetType, CoordType> reg(resolution_pyramid_levels_, use_world_coordinates_, bg_value_);
+            GADGET_CHECK_RETURN_FALSE(reg.setDefaultParameters(resolution_pyramid_levels_, use_world_coordinates_));
+
+            reg.setTarget( const_cast<TargetType&>(target) );
+            GADGET_CHECK_RETURN_FALSE(reg.createTargetPyramid(pyramid));
+        }
+        catch(...)
+        {
+            GERROR_STREAM("Error happened in hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::createTargetPyramid(...) ... ");
+            return false;
+        }
+
+        return true;
+    }
+
     template<typename TargetType, typename SourceType, typename CoordType> 
     bool hoImageRegContainer2DRegistration<TargetType, SourceType, CoordType>::
     initialize(const TargetContinerType& targetContainer, bool warped)
@@ -988,6 +1024,7 @@ namespace Gadgetron {
 
             // fill in the reference frames
             std::vector<TargetType*> targetImages(numOfImages, NULL);
+            std::vector<size_t> targetRows(numOfImages, 0);
 
             size_t ind=0;
             for ( r=0; r<row; r++ )
@@ -997,6 +1034,7 @@ namespace Gadgetron {
                 for ( c=0; c<col[r]; c++ )
                 {
                     targetImages[ind] = &ref;
+                    targetRows[ind] = r;
                     ind++;
                 }
             }
@@ -1023,6 +1061,17 @@ namespace Gadgetron {
             numOfThreads = (numOfImages>numOfProcs) ? numOfProcs : numOfImages;
 #endif // USE_OMP
 
+            // every frame of a row is registered to the same reference frame, whose pyramid is created once and shared
+            std::vector< std::vector<TargetType> > targetPyramids(row);
+            if ( container_reg_transformation_ == GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD 
+                || container_reg_transformation_ == GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD_BIDIRECTIONAL )
+            {
+                for ( r=0; r<row; r++ )
+                {
+                    GADGET_CHECK_RETURN_FALSE(this->createTargetPyramid(imageContainer(r, referenceFrame[r]), targetPyramids[r]));
+                }
+            }
+
             if ( container_reg_transformation_ == GT_IMAGE_REG_TRANSFORMATION_DEFORMATION_FIELD )
             {
                 std::vector< std::vector<DeformationFieldType*> > deform(DIn);
@@ -1032,11 +1081,11 @@ namespace Gadgetron {
                     deformation_field_[ii].get_all_images(deform[ii]);
                 }
 
-                #pragma omp parallel default(none) private(n, ii) shared(numOfImages, initial, targetImages, sourceImages, deform, warpedImages) num_threads(numOfThreads)
+                #pragma omp parallel default(none) private(n, ii) shared(numOfImages, initial, targetImages, targetRows, targetPyramids, sourceImages, deform, warpedImages) num_threads(numOfThreads)
                 {
                     DeformationFieldType* deformCurr[DIn];
 
-                    #pragma omp for 
+                    #pragma omp for schedule(dynamic, 1)
                     for ( n=0; n<numOfImages; n++ )
                     {
                         if ( targetImages[n] == sourceImages[n] )
@@ -1063,7 +1112,7 @@ namespace Gadgetron {
                             deformCurr[ii] = deform[ii][n];
                         }
 
-                        registerTwoImagesDeformationField(target, source, initial, warpedImages[n], deformCurr);
+                        registerTwoImagesDeformationField(target, source, initial, warpedImages[n], deformCurr, &targetPyramids[targetRows[n]]);
                     }
                 }
             }
@@ -1078,12 +1127,12 @@ namespace Gadgetron {
                     deformation_field_inverse_[ii].get_all_images(deformInv[ii]);
                 }
 
-                #pragma omp parallel default(none) private(n, ii) shared(numOfImages, initial, targetImages, sourceImages, deform, deformInv, warpedImages) num_threads(numOfThreads)
+                #pragma omp parallel default(none) private(n, ii) shared(numOfImages, initial, targetImages, targetRows, targetPyramids, sourceImages, deform, deformInv, warpedImages) num_threads(numOfThreads)
                 {
                     DeformationFieldType* deformCurr[DIn];
                     DeformationFieldType* deformInvCurr[DIn];
 
-                    #pragma omp for 
+                    #pragma omp for schedule(dynamic, 1)
                     for ( n=0; n<numOfImages; n++ )
                     {
                         if ( targetImages[n] == sourceImages[n] )
@@ -1114,7 +1163,7 @@ namespace Gadgetron {
                             deformInvCurr[ii] = deformInv[ii][n];
                         }
 
-                        registerTwoImagesDeformationFieldBidirectional(target, source, initial, warpedImages[n], deformCurr, deformInvCurr);
+                        registerTwoImagesDeformationFieldBidirectional(target, source, initial, warpedImages[n], deformCurr, deformInvCurr, &targetPyramids[targetRows[n]]);
                     }
                 }
             }
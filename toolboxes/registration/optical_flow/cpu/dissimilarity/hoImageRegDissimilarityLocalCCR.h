@@ -88,6 +88,11 @@ namespace Gadgetron {
         hoNDArray<computing_value_type> v2; computing_value_type* p_v2;
         hoNDArray<computing_value_type> v12; computing_value_type* p_v12;
 
+        /// the local mean (mu1) and local second moment (v1_target_) of the target do not depend on the warped image
+        /// they are smoothed once at the first evaluation after initialize
+        hoNDArray<computing_value_type> v1_target_; computing_value_type* p_v1_target_;
+        bool target_smoothed_;
+
         //hoNDArray<computing_value_type> vv1; computing_value_type* p_vv1;
         //hoNDArray<computing_value_type> vv2; computing_value_type* p_vv2;
         //hoNDArray<computing_value_type> vv12; computing_value_type* p_vv12;
@@ -137,6 +142,9 @@ namespace Gadgetron {
         v2.create(image_dim_); p_v2 = v2.begin();
         v12.create(image_dim_); p_v12 = v12.begin();
 
+        v1_target_.create(image_dim_); p_v1_target_ = v1_target_.begin();
+        target_smoothed_ = false;
+
         //vv1.create(image_dim_); p_vv1 = vv1.begin();
         //vv2.create(image_dim_); p_vv2 = vv2.begin();
         //vv12.create(image_dim_); p_vv12 = vv12.begin();
@@ -220,22 +228,34 @@ namespace Gadgetron {
             ValueType* pT = target.begin();
             ValueType* pW = warped.begin();
 
+            if ( !target_smoothed_ )
+            {
+                for ( n=0; n<N; ++n )
+                {
+                    const computing_value_type v1 = (computing_value_type)pT[n];
+
+                    p_mu1[n] = v1;
+                    p_v1_target_[n] = v1*v1;
+                }
+
+                Gadgetron::filterGaussian(mu1, sigmaArg_, mem_.begin());
+                Gadgetron::filterGaussian(v1_target_, sigmaArg_, mem_.begin());
+
+                target_smoothed_ = true;
+            }
+
             for ( n=0; n<N; ++n )
             {
                 const computing_value_type v1 = (computing_value_type)pT[n];
                 const computing_value_type v2 = (computing_value_type)pW[n];
 
-                p_mu1[n] = v1;
                 p_mu2[n] = v2;
-                p_v1[n] = v1*v1;
                 p_v2[n] = v2*v2;
                 p_v12[n] = v1*v2;
             }
 
                 //#ifdef WIN32
-                    Gadgetron::filterGaussian(mu1, sigmaArg_, mem_.begin());
                     Gadgetron::filterGaussian(mu2, sigmaArg_, mem_.begin());
-                    Gadgetron::filterGaussian(v1, sigmaArg_, mem_.begin());
                     Gadgetron::filterGaussian(v2, sigmaArg_, mem_.begin());
                     Gadgetron::filterGaussian(v12, sigmaArg_, mem_.begin());
                 //#else
@@ -298,7 +318,7 @@ namespace Gadgetron {
                 const computing_value_type u1 = p_mu1[n];
                 const computing_value_type u2 = p_mu2[n];
 
-                const computing_value_type vv1 = p_v1[n] - u1 * u1;
+                const computing_value_type vv1 = p_v1_target_[n] - u1 * u1;
                 const computing_value_type vv2 = p_v2[n] - u2 * u2;
                 const computing_value_type vv12 = p_v12[n] - u1 * u2;
 
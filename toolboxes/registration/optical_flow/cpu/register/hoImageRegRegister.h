@@ -108,6 +108,13 @@ namespace Gadgetron {
         virtual void setTarget(TargetType& target);
         virtual void setSource(SourceType& source);
 
+        /// create the multi-resolution pyramid of the target with the current parameters
+        bool createTargetPyramid(std::vector<TargetType>& pyramid);
+
+        /// use a target pyramid created beforehand by createTargetPyramid, e.g. shared by all registrations to the same key frame
+        /// the pyramid images are used in place, not copied, so they must outlive the registration
+        void setTargetPyramid(std::vector<TargetType>& pyramid);
+
         /// create dissimilarity measures
         DissimilarityType* createDissimilarity(GT_IMAGE_DISSIMILARITY v, unsigned int level);
 
@@ -199,6 +206,13 @@ namespace Gadgetron {
         std::vector<TargetType> target_pyramid_;
         std::vector<TargetType> source_pyramid_;
 
+        /// target pyramid set by setTargetPyramid, if any
+        std::vector<TargetType>* target_pyramid_preset_;
+
+        /// downsample image level by level into pyramid, pyramid[0] is a copy of image
+        template <typename ImageType, unsigned int DImage>
+        bool createPyramid(const ImageType& image, hoNDBoundaryHandler<ImageType>& bh, hoNDInterpolator<ImageType>& interp, std::vector<ImageType>& pyramid);
+
         /// store the boundary handler and interpolator for warpers
         std::vector<BoundaryHandlerTargetType*> target_bh_warper_;
         std::vector<InterpTargetType*> target_interp_warper_;
@@ -267,6 +281,8 @@ namespace Gadgetron {
         source_bh_pyramid_construction_ = NULL;
         source_interp_pyramid_construction_ = NULL;
 
+        target_pyramid_preset_ = NULL;
+
         dissimilarity_pyramid_.resize(resolution_pyramid_levels_, NULL);
         dissimilarity_pyramid_inverse_.resize(resolution_pyramid_levels_, NULL);
 
@@ -382,11 +398,7 @@ namespace Gadgetron {
             GADGET_CHECK_RETURN_FALSE(dissimilarity_type_.size()==resolution_pyramid_levels_);
             GADGET_CHECK_RETURN_FALSE(solver_type_.size()==resolution_pyramid_levels_);
 
-            target_pyramid_.resize(resolution_pyramid_levels_);
-            source_pyramid_.resize(resolution_pyramid_levels_);
-
-            target_pyramid_[0] = *target_;
-            source_pyramid_[0] = *source_;
+            unsigned int ii;
 
             target_bh_pyramid_construction_ = createBoundaryHandler<TargetType>(boundary_handler_type_pyramid_construction_);
             target_interp_pyramid_construction_ = createInterpolator<TargetType, DOut>(interp_type_pyramid_construction_);
@@ -396,114 +408,38 @@ namespace Gadgetron {
             source_interp_pyramid_construction_ = createInterpolator<SourceType, DIn>(interp_type_pyramid_construction_);
             source_interp_pyramid_construction_->setBoundaryHandler(*source_bh_pyramid_construction_);
 
-            /// allocate all objects
-            unsigned int ii, jj;
-            for ( ii=0; ii<resolution_pyramid_levels_-1; ii++ )
+            // create pyramid
+            if ( target_pyramid_preset_ != NULL )
             {
-                // create pyramid
-                target_bh_pyramid_construction_->setArray(target_pyramid_[ii]);
-                target_interp_pyramid_construction_->setArray(target_pyramid_[ii]);
-
-                if ( use_world_coordinates_ )
-                {
-                    if ( resolution_pyramid_divided_by_2_ )
-                    {
-                        Gadgetron::downsampleImageBy2WithAveraging(target_pyramid_[ii], *target_bh_pyramid_construction_, target_pyramid_[ii+1]);
-                    }
-                    else
-                    {
-                        std::vector<float> ratio = resolution_pyramid_downsample_ratio_[ii];
-                        Gadgetron::downsampleImage(target_pyramid_[ii], *target_interp_pyramid_construction_, target_pyramid_[ii+1], &ratio[0]);
-
-                        std::vector<float> sigma = resolution_pyramid_blurring_sigma_[ii+1];
-                        for ( jj=0; jj<DOut; jj++ )
-                        {
-                            sigma[jj] /= target_pyramid_[ii+1].get_pixel_size(jj); // world to pixel
-                        }
+                GADGET_CHECK_RETURN_FALSE(target_pyramid_preset_->size()==resolution_pyramid_levels_);
+                GADGET_CHECK_RETURN_FALSE((*target_pyramid_preset_)[0].dimensions_equal(*target_));
 
-                        Gadgetron::filterGaussian(target_pyramid_[ii+1], &sigma[0]);
-                    }
-                }
-                else
-                {
-                    std::vector<float> ratio = resolution_pyramid_downsample_ratio_[ii];
+                target_pyramid_.resize(resolution_pyramid_levels_);
 
-                    bool downsampledBy2 = true;
-                    for ( jj=0; jj<DOut; jj++ )
-                    {
-                        if ( std::abs(ratio[jj]-2.0f) > FLT_EPSILON )
-                        {
-                            downsampledBy2 = false;
-                            break;
-                        }
-                    }
+                std::vector<size_t> dim;
+                std::vector<typename TargetType::coord_type> pixelSize, origin;
+                typename TargetType::axis_type axis;
 
-                    if ( downsampledBy2 )
-                    {
-                        Gadgetron::downsampleImageBy2WithAveraging(target_pyramid_[ii], *target_bh_pyramid_construction_, target_pyramid_[ii+1]);
-                        // Gadgetron::downsampleImage(target_pyramid_[ii], *target_interp_pyramid_construction_, target_pyramid_[ii+1], &ratio[0]);
-                    }
-                    else
-                    {
-                        Gadgetron::downsampleImage(target_pyramid_[ii], *target_interp_pyramid_construction_, target_pyramid_[ii+1], &ratio[0]);
-                        std::vector<float> sigma = resolution_pyramid_blurring_sigma_[ii+1];
-                        Gadgetron::filterGaussian(target_pyramid_[ii+1], &sigma[0]);
-                    }
-                }
-
-                // source
-
-                source_bh_pyramid_construction_->setArray(source_pyramid_[ii]);
-                source_interp_pyramid_construction_->setArray(source_pyramid_[ii]);
-
-                if ( use_world_coordinates_ )
-                {
-                    if ( resolution_pyramid_divided_by_2_ )
-                    {
-                        Gadgetron::downsampleImageBy2WithAveraging(source_pyramid_[ii], *source_bh_pyramid_construction_, source_pyramid_[ii+1]);
-                    }
-                    else
-                    {
-                        std::vector<float> ratio = resolution_pyramid_downsample_ratio_[ii];
-                        Gadgetron::downsampleImage(source_pyramid_[ii], *source_interp_pyramid_construction_, source_pyramid_[ii+1], &ratio[0]);
-
-                        std::vector<float> sigma = resolution_pyramid_blurring_sigma_[ii+1];
-                        for ( jj=0; jj<DOut; jj++ )
-                        {
-                            sigma[jj] /= source_pyramid_[ii+1].get_pixel_size(jj); // world to pixel
-                        }
-
-                        Gadgetron::filterGaussian(source_pyramid_[ii+1], &sigma[0]);
-                    }
-                }
-                else
+                for ( ii=0; ii<resolution_pyramid_levels_; ii++ )
                 {
-                    std::vector<float> ratio = resolution_pyramid_downsample_ratio_[ii];
+                    TargetType& level = (*target_pyramid_preset_)[ii];
 
-                    bool downsampledBy2 = true;
-                    for ( jj=0; jj<DOut; jj++ )
-                    {
-                        if ( std::abs(ratio[jj]-2.0f) > FLT_EPSILON )
-                        {
-                            downsampledBy2 = false;
-                            break;
-                        }
-                    }
+                    level.get_dimensions(dim);
+                    level.get_pixel_size(pixelSize);
+                    level.get_origin(origin);
+                    level.get_axis(axis);
 
-                    if ( downsampledBy2 )
-                    {
-                        Gadgetron::downsampleImageBy2WithAveraging(source_pyramid_[ii], *source_bh_pyramid_construction_, source_pyramid_[ii+1]);
-                        //Gadgetron::downsampleImage(source_pyramid_[ii], *source_interp_pyramid_construction_, source_pyramid_[ii+1], &ratio[0]);
-                    }
-                    else
-                    {
-                        Gadgetron::downsampleImage(source_pyramid_[ii], *source_interp_pyramid_construction_, source_pyramid_[ii+1], &ratio[0]);
-                        std::vector<float> sigma = resolution_pyramid_blurring_sigma_[ii+1];
-                        Gadgetron::filterGaussian(source_pyramid_[ii+1], &sigma[0]);
-                    }
+                    target_pyramid_[ii].create(dim, pixelSize, origin, axis, level.begin(), false);
                 }
             }
+            else
+            {
+                GADGET_CHECK_RETURN_FALSE((this->template createPyramid<TargetType, DOut>(*target_, *target_bh_pyramid_construction_, *target_interp_pyramid_construction_, target_pyramid_)));
+            }
+
+            GADGET_CHECK_RETURN_FALSE((this->template createPyramid<SourceType, DOut>(*source_, *source_bh_pyramid_construction_, *source_interp_pyramid_construction_, source_pyramid_)));
 
+            /// allocate all objects
             for ( ii=0; ii<resolution_pyramid_levels_; ii++ )
             {
                 target_bh_warper_[ii] = createBoundaryHandler<TargetType>(boundary_handler_type_warper_[ii]);
@@ -565,6 +501,104 @@ namespace Gadgetron {
         source_ = &source;
     }
 
+    template<typename TargetType, typename SourceType, typename CoordType> 
+    inline void hoImageRegRegister<TargetType, SourceType, CoordType>::setTargetPyramid(std::vector<TargetType>& pyramid)
+    {
+        target_pyramid_preset_ = &pyramid;
+    }
+
+    template<typename TargetType, typename SourceType, typename CoordType> 
+    bool hoImageRegRegister<TargetType, SourceType, CoordType>::createTargetPyramid(std::vector<TargetType>& pyramid)
+    {
+        GADGET_CHECK_RETURN_FALSE(target_!=NULL);
+        GADGET_CHECK_RETURN_FALSE(resolution_pyramid_downsample_ratio_.size()==resolution_pyramid_levels_-1);
+        GADGET_CHECK_RETURN_FALSE(resolution_pyramid_blurring_sigma_.size()==resolution_pyramid_levels_);
+
+        BoundaryHandlerTargetType* bh = createBoundaryHandler<TargetType>(boundary_handler_type_pyramid_construction_);
+        InterpTargetType* interp = createInterpolator<TargetType, DOut>(interp_type_pyramid_construction_);
+        interp->setBoundaryHandler(*bh);
+
+        bool res = this->template createPyramid<TargetType, DOut>(*target_, *bh, *interp, pyramid);
+
+        delete interp;
+        delete bh;
+
+        return res;
+    }
+
+    template<typename TargetType, typename SourceType, typename CoordType> 
+    template <typename ImageType, unsigned int DImage>
+    bool hoImageRegRegister<TargetType, SourceType, CoordType>::
+    createPyramid(const ImageType& image, hoNDBoundaryHandler<ImageType>& bh, hoNDInterpolator<ImageType>& interp, std::vector<ImageType>& pyramid)
+    {
+        try
+        {
+            pyramid.resize(resolution_pyramid_levels_);
+            pyramid[0] = image;
+
+            unsigned int ii, jj;
+            for ( ii=0; ii<resolution_pyramid_levels_-1; ii++ )
+            {
+                bh.setArray(pyramid[ii]);
+                interp.setArray(pyramid[ii]);
+
+                if ( use_world_coordinates_ )
+                {
+                    if ( resolution_pyramid_divided_by_2_ )
+                    {
+                        Gadgetron::downsampleImageBy2WithAveraging(pyramid[ii], bh, pyramid[ii+1]);
+                    }
+                    else
+                    {
+                        std::vector<float> ratio = resolution_pyramid_downsample_ratio_[ii];
+                        Gadgetron::downsampleImage(pyramid[ii], interp, pyramid[ii+1], &ratio[0]);
+
+                        std::vector<float> sigma = resolution_pyramid_blurring_sigma_[ii+1];
+                        for ( jj=0; jj<DImage; jj++ )
+                        {
+                            sigma[jj] /= pyramid[ii+1].get_pixel_size(jj); // world to pixel
+                        }
+
+                        Gadgetron::filterGaussian(pyramid[ii+1], &sigma[0]);
+                    }
+                }
+                else
+                {
+                    std::vector<float> ratio = resolution_pyramid_downsample_ratio_[ii];
+
+                    bool downsampledBy2 = true;
+                    for ( jj=0; jj<DImage; jj++ )
+                    {
+                        if ( std::abs(ratio[jj]-2.0f) > FLT_EPSILON )
+                        {
+                            downsampledBy2 = false;
+                            break;
+                        }
+                    }
+
+                    if ( downsampledBy2 )
+                    {
+                        Gadgetron::downsampleImageBy2WithAveraging(pyramid[ii], bh, pyramid[ii+1]);
+                        // Gadgetron::downsampleImage(pyramid[ii], interp, pyramid[ii+1], &ratio[0]);
+                    }
+                    else
+                    {
+                        Gadgetron::downsampleImage(pyramid[ii], interp, pyramid[ii+1], &ratio[0]);
+                        std::vector<float> sigma = resolution_pyramid_blurring_sigma_[ii+1];
+                        Gadgetron::filterGaussian(pyramid[ii+1], &sigma[0]);
+                    }
+                }
+            }
+        }
+        catch(...)
+        {
+            GERROR_STREAM("Errors happened in hoImageRegRegister<TargetType, SourceType, CoordType>::createPyramid(...) ... ");
+            return false;
+        }
+
+        return true;
+    }
+
     template<typename TargetType, typename SourceType, typename CoordType> 
     void hoImageRegRegister<TargetType, SourceType, CoordType>::printContent(std::ostream& os) const
     {
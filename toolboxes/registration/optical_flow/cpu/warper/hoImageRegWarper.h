@@ -84,6 +84,11 @@ namespace Gadgetron {
         /// the deformation field grid should be the same as the target images
         virtual bool warpWithDeformationFieldWorldCoordinate(const TargetType& target, const SourceType& source, TargetType& warped);
 
+        /// 2D warp in image coordinates with the DeformationField transformation and linear interpolation
+        /// the transformation and interpolation are inlined, row by row; only pixels mapped outside the source go through the boundary handler
+        /// the deformation field grid should be the same as the target images
+        bool warpLinearWithDeformationField2D(const TargetType& target, const SourceType& source, DeformTransformationType& transform, hoNDInterpolatorLinear<SourceType>& interp, TargetType& warped);
+
         virtual void print(std::ostream& os) const;
 
         // ----------------------------------
@@ -165,6 +170,18 @@ namespace Gadgetron {
 
             warped = target;
 
+            if ( DIn==2 && DOut==2 && !useWorldCoordinate )
+            {
+                DeformTransformationType* transformDeformField = dynamic_cast<DeformTransformationType*>(transform_);
+                hoNDInterpolatorLinear<SourceType>* interpLinear = dynamic_cast<hoNDInterpolatorLinear<SourceType>*>(interp_);
+
+                if ( transformDeformField != NULL && interpLinear != NULL
+                    && transformDeformField->getDeformationField(0).dimensions_equal(target) )
+                {
+                    return this->warpLinearWithDeformationField2D(target, source, *transformDeformField, *interpLinear, warped);
+                }
+            }
+
             if ( DIn==2 && DOut==2 )
             {
                 size_t sx = target.get_size(0);
@@ -372,6 +389,82 @@ namespace Gadgetron {
         return true;
     }
 
+    template<typename TargetType, typename SourceType, typename CoordType> 
+    bool hoImageRegWarper<TargetType, SourceType, CoordType>::
+    warpLinearWithDeformationField2D(const TargetType& target, const SourceType& source, DeformTransformationType& transform, hoNDInterpolatorLinear<SourceType>& interp, TargetType& warped)
+    {
+        try
+        {
+            typedef typename TargetType::coord_type coord_type_image;
+
+            long long sx = (long long)target.get_size(0);
+            long long sy = (long long)target.get_size(1);
+
+            long long sx_source = (long long)source.get_size(0);
+            long long sy_source = (long long)source.get_size(1);
+
+            const ValueType* pTarget = target.begin();
+            const ValueType* pSource = source.begin();
+            ValueType* pWarped = warped.begin();
+
+            const CoordType* pDx = transform.getDeformationField(0).begin();
+            const CoordType* pDy = transform.getDeformationField(1).begin();
+
+            std::vector<coord_type_image> x_source(sx), y_source(sx);
+
+            long long x, y;
+            for ( y=0; y<sy; y++ )
+            {
+                const CoordType* dx = pDx + y*sx;
+                const CoordType* dy = pDy + y*sx;
+
+                // transform the points of the row
+                for ( x=0; x<sx; x++ )
+                {
+                    x_source[x] = x + dx[x];
+                    y_source[x] = y + dy[x];
+                }
+
+                // interpolate the source
+                for ( x=0; x<sx; x++ )
+                {
+                    size_t offset = x + y*sx;
+
+                    if ( pTarget[offset] == bg_value_ ) continue;
+
+                    long long ix = static_cast<long long>(std::floor(x_source[x]));
+                    long long iy = static_cast<long long>(std::floor(y_source[x]));
+
+                    if ( ix>=0 && ix<sx_source-1 && iy>=0 && iy<sy_source-1 )
+                    {
+                        coord_type_image wx = x_source[x] - ix;
+                        coord_type_image wx_prime = coord_type_image(1.0) - wx;
+                        coord_type_image wy = y_source[x] - iy;
+                        coord_type_image wy_prime = coord_type_image(1.0) - wy;
+
+                        const ValueType* data = pSource + ix + iy*sx_source;
+
+                        pWarped[offset] = (    (data[0]             *   wx_prime    *wy_prime
+                                            +   data[1]             *   wx          *wy_prime)
+                                            +   (data[sx_source]    *   wx_prime    *wy
+                                            +   data[sx_source+1]   *   wx          *wy) );
+                    }
+                    else
+                    {
+                        pWarped[offset] = interp(x_source[x], y_source[x]);
+                    }
+                }
+            }
+        }
+        catch(...)
+        {
+            GERROR_STREAM("Errors happened in hoImageRegWarper<TargetType, SourceType, CoordType>::warpLinearWithDeformationField2D(...) ... ");
+            return false;
+        }
+
+        return true;
+    }
+
     template<typename TargetType, typename SourceType, typename CoordType> 
     bool hoImageRegWarper<TargetType, SourceType, CoordType>::
     warpWithDeformationFieldWorldCoordinate(const TargetType& target, const SourceType& source, TargetType& warped)
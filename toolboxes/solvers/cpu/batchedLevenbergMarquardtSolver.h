@@ -0,0 +1,426 @@
+/** \file       batchedLevenbergMarquardtSolver.h
+    \brief      Levenberg-Marquardt least squares fitting of many small curve fitting problems at once
+
+                Every problem (e.g. one pixel of a parametric map) shares the sampling points x, and has its own
+                measurements y and parameters b. Problems are processed in blocks of `lanes` problems, stored
+                structure-of-arrays, so that the loops over a block map onto SIMD registers. A problem stops
+                iterating once it has converged; a block stops when all of its problems have.
+
+                The signal models mirror twoParaExpRecoveryOperator, twoParaExpDecayOperator and
+                threeParaExpRecoveryOperator, but evaluate value and gradient together, for one sampling point.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+    #define GADGETRON_BATCHED_LM_TARGETS __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+    #define GADGETRON_BATCHED_LM_TARGETS
+#endif
+
+namespace Gadgetron {
+
+namespace batched_fitting {
+
+    /// exp(v) without a libm call, so that loops calling it vectorize
+    /// accurate to a few ulp; arguments are clamped to keep the result a normal number
+    template <typename T>
+    inline T exp(T v)
+    {
+        static_assert(std::is_floating_point<T>::value, "batched_fitting::exp needs a floating point type");
+
+        constexpr bool is_float = sizeof(T) == sizeof(float);
+        constexpr T limit = is_float ? T(80) : T(700);
+
+        // clamped with arithmetic rather than std::min/max, which the compiler turns into branches for floating point
+        T below = T(v < -limit);
+        T above = T(v > limit);
+        v = v * (T(1) - below - above) - limit * below + limit * above;
+
+        // v = k*ln2 + r, |r| <= ln2/2
+        T kf = v * T(1.44269504088896340736) + T(0.5);
+        kf = T(static_cast<int>(kf)) - T(kf < T(static_cast<int>(kf)));
+        T r = v - kf * T(0.693145751953125) - kf * T(1.42860682030941723212e-6);
+
+        // Taylor series of exp(r), long enough for the precision of T
+        T p;
+        if (is_float)
+        {
+            p = T(1.0 / 5040);
+            p = p * r + T(1.0 / 720);
+            p = p * r + T(1.0 / 120);
+        }
+        else
+        {
+            p = T(1.0 / 479001600);
+            p = p * r + T(1.0 / 39916800);
+            p = p * r + T(1.0 / 3628800);
+            p = p * r + T(1.0 / 362880);
+            p = p * r + T(1.0 / 40320);
+            p = p * r + T(1.0 / 5040);
+            p = p * r + T(1.0 / 720);
+            p = p * r + T(1.0 / 120);
+        }
+        p = p * r + T(1.0 / 24);
+        p = p * r + T(1.0 / 6);
+        p = p * r + T(0.5);
+        p = p * r + T(1);
+        p = p * r + T(1);
+
+        // 2^k, built from the exponent bits
+        using Bits = typename std::conditional<is_float, std::int32_t, std::int64_t>::type;
+        constexpr int mantissa = std::numeric_limits<T>::digits - 1;
+        constexpr Bits bias = std::numeric_limits<T>::max_exponent - 1;
+
+        Bits bits = (static_cast<Bits>(kf) + bias) << mantissa;
+        T scale;
+        std::memcpy(&scale, &bits, sizeof(T));
+
+        return p * scale;
+    }
+
+    /// 1/b, with |b| kept away from zero in the same way as the curve fitting operators
+    template <typename T>
+    inline T reciprocal(T b)
+    {
+        T sign = (b < T(0)) ? T(-1) : T(1);
+        return T(1) / ((std::abs(b) < T(FLT_EPSILON)) ? sign * T(FLT_EPSILON) : b);
+    }
+
+    /// y = b[0] - b[0] * exp(-x/b[1])
+    template <typename T>
+    struct twoParaExpRecovery
+    {
+        static constexpr size_t num_paras = 2;
+
+        static inline T value(T x, const T* b)
+        {
+            T rb = reciprocal(b[1]);
+            return b[0] - b[0] * exp(-x * rb);
+        }
+
+        static inline T value(T x, const T* b, T* grad)
+        {
+            T rb = reciprocal(b[1]);
+            T e = exp(-x * rb);
+            grad[0] = T(1) - e;
+            grad[1] = -b[0] * e * x * rb * rb;
+            return b[0] - b[0] * e;
+        }
+    };
+
+    /// y = b[0] * exp(-x/b[1])
+    template <typename T>
+    struct twoParaExpDecay
+    {
+        static constexpr size_t num_paras = 2;
+
+        static inline T value(T x, const T* b)
+        {
+            T rb = reciprocal(b[1]);
+            return b[0] * exp(-x * rb);
+        }
+
+        static inline T value(T x, const T* b, T* grad)
+        {
+            T rb = reciprocal(b[1]);
+            T e = exp(-x * rb);
+            grad[0] = e;
+            grad[1] = b[0] * e * x * rb * rb;
+            return b[0] * e;
+        }
+    };
+
+    /// y = b[0] - b[1] * exp(-x/b[2])
+    template <typename T>
+    struct threeParaExpRecovery
+    {
+        static constexpr size_t num_paras = 3;
+
+        static inline T value(T x, const T* b)
+        {
+            T rb = reciprocal(b[2]);
+            return b[0] - b[1] * exp(-x * rb);
+        }
+
+        static inline T value(T x, const T* b, T* grad)
+        {
+            T rb = reciprocal(b[2]);
+            T e = exp(-x * rb);
+            grad[0] = T(1);
+            grad[1] = -e;
+            grad[2] = -b[1] * e * x * rb * rb;
+            return b[0] - b[1] * e;
+        }
+    };
+}
+
+/// Model provides num_paras, and value(x, b) and value(x, b, grad) for a single sampling point x
+template <typename T, typename Model>
+class batchedLevenbergMarquardtSolver
+{
+public:
+
+    static constexpr size_t num_paras = Model::num_paras;
+
+    /// number of problems processed together, one 512 bit register worth
+    static constexpr size_t lanes = 64 / sizeof(T);
+
+    batchedLevenbergMarquardtSolver(double thres_x=1e-6, double thres_fun=1e-4, size_t maxIter=150)
+        : thres_x_(thres_x), thres_fun_(thres_fun), max_iter_(maxIter), lambda_init_(1e-3), lambda_max_(1e8)
+    {
+    }
+
+    /// x: [num], the sampling points shared by all problems
+    /// y: [num count], y[n*count + i] is the n-th measurement of problem i
+    /// b: [num_paras count], the initial guess on input and the fitted parameters on output
+    /// cost: if not null, [count], the final sum of squared residuals
+    /// Blocks of problems are independent; callers parallelize over ranges of problems.
+    void solve(const T* x, size_t num, const T* y, size_t count, T* b, T* cost = nullptr) const
+    {
+        std::vector<T> y_block(num * lanes);
+        T b_block[num_paras][lanes];
+        T cost_block[lanes];
+
+        for (size_t start = 0; start < count; start += lanes)
+        {
+            size_t used = std::min(lanes, count - start);
+
+            // unused lanes repeat the last problem, so that they converge along with it
+            for (size_t n = 0; n < num; n++)
+            {
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    y_block[n*lanes + l] = y[n*count + start + std::min(l, used - 1)];
+                }
+            }
+
+            for (size_t k = 0; k < num_paras; k++)
+            {
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    b_block[k][l] = b[k*count + start + std::min(l, used - 1)];
+                }
+            }
+
+            this->solve_block(x, num, y_block.data(), b_block, cost_block);
+
+            for (size_t k = 0; k < num_paras; k++)
+            {
+                for (size_t l = 0; l < used; l++)
+                {
+                    b[k*count + start + l] = b_block[k][l];
+                }
+            }
+
+            if (cost != nullptr)
+            {
+                for (size_t l = 0; l < used; l++)
+                {
+                    cost[start + l] = cost_block[l];
+                }
+            }
+        }
+    }
+
+    /// convergence when every parameter changes by less than thres_x_, relative to its magnitude
+    double thres_x_;
+    /// convergence when the cost decreases by less than thres_fun_, relative to the cost
+    double thres_fun_;
+    /// maximal number of iterations
+    size_t max_iter_;
+    /// initial damping, relative to the diagonal of the normal matrix
+    double lambda_init_;
+    /// a problem whose damping grows beyond this cannot make progress any more and is stopped
+    double lambda_max_;
+
+protected:
+
+    /// fits one block of problems; y: [num lanes]
+    GADGETRON_BATCHED_LM_TARGETS
+    void solve_block(const T* x, size_t num, const T* y, T (&b)[num_paras][lanes], T (&cost)[lanes]) const
+    {
+        constexpr size_t NP = num_paras;
+
+        T bt[NP][lanes];
+        T cost_try[lanes];
+        T lambda[lanes];
+        T active[lanes];
+
+        T H[NP][NP][lanes];
+        T g[NP][lanes];
+        T delta[NP][lanes];
+
+        const T thres_x = T(thres_x_);
+        const T thres_fun = T(thres_fun_);
+        const T lambda_max = T(lambda_max_);
+
+        this->evaluate_cost(x, num, y, b, cost);
+
+        for (size_t l = 0; l < lanes; l++)
+        {
+            lambda[l] = T(lambda_init_);
+            active[l] = T(1);
+        }
+
+        for (size_t iter = 0; iter < max_iter_; iter++)
+        {
+            // normal equations, J'J and J'r
+            for (size_t r = 0; r < NP; r++)
+            {
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    g[r][l] = 0;
+                    for (size_t c = 0; c < NP; c++) H[r][c][l] = 0;
+                }
+            }
+
+            for (size_t n = 0; n < num; n++)
+            {
+                const T xn = x[n];
+                const T* yn = y + n*lanes;
+
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    T bl[NP], grad[NP];
+                    for (size_t k = 0; k < NP; k++) bl[k] = b[k][l];
+
+                    T res = yn[l] - Model::value(xn, bl, grad);
+
+                    for (size_t r = 0; r < NP; r++)
+                    {
+                        g[r][l] += grad[r] * res;
+                        for (size_t c = 0; c < NP; c++) H[r][c][l] += grad[r] * grad[c];
+                    }
+                }
+            }
+
+            // damped step, (J'J + lambda*diag(J'J)) delta = J'r
+            for (size_t l = 0; l < lanes; l++)
+            {
+                T A[NP][NP], rhs[NP], d[NP];
+                for (size_t r = 0; r < NP; r++)
+                {
+                    for (size_t c = 0; c < NP; c++) A[r][c] = H[r][c][l];
+                    A[r][r] += lambda[l] * H[r][r][l] + T(FLT_MIN);
+                    rhs[r] = g[r][l];
+                }
+
+                solve_normal_equations(A, rhs, d);
+
+                for (size_t k = 0; k < NP; k++)
+                {
+                    delta[k][l] = d[k];
+                    bt[k][l] = b[k][l] + d[k];
+                }
+            }
+
+            this->evaluate_cost(x, num, y, bt, cost_try);
+
+            // accept or reject the step of every lane, and retire the lanes that have converged
+            // (written with selects rather than branches, so that the loop vectorizes)
+            T still_active = 0;
+            for (size_t l = 0; l < lanes; l++)
+            {
+                bool improved = (cost_try[l] < cost[l]);
+                bool accept = (active[l] > T(0)) & improved;
+
+                T step = 0;
+                for (size_t k = 0; k < NP; k++)
+                {
+                    T s = std::abs(delta[k][l]) / (std::abs(b[k][l]) + thres_x);
+                    step = (s > step) ? s : step;
+                }
+
+                bool small_step = (step <= thres_x);
+                bool small_decrease = (cost[l] - cost_try[l] <= thres_fun * cost[l]);
+
+                for (size_t k = 0; k < NP; k++) b[k][l] = accept ? bt[k][l] : b[k][l];
+                cost[l] = accept ? cost_try[l] : cost[l];
+
+                T lambda_down = lambda[l] * T(0.1);
+                lambda_down = (lambda_down < T(1e-12)) ? T(1e-12) : lambda_down;
+                lambda[l] = improved ? lambda_down : lambda[l] * T(10);
+
+                bool rejected = !improved;
+                bool done = (improved & small_decrease & small_step) | (rejected & (small_step | (lambda[l] > lambda_max)));
+                active[l] = done ? T(0) : active[l];
+                still_active += active[l];
+            }
+
+            if (still_active == T(0)) break;
+        }
+    }
+
+    /// solves A d = rhs for a small symmetric positive definite A, by cofactors
+    /// a singular A gives a non-finite d, which evaluate_cost then rejects
+    static inline void solve_normal_equations(const T (&A)[num_paras][num_paras], const T (&rhs)[num_paras], T (&d)[num_paras])
+    {
+        static_assert(num_paras >= 1 && num_paras <= 3, "batchedLevenbergMarquardtSolver supports models with one to three parameters");
+
+        if constexpr (num_paras == 1)
+        {
+            d[0] = rhs[0] / A[0][0];
+        }
+        else if constexpr (num_paras == 2)
+        {
+            T rdet = T(1) / (A[0][0] * A[1][1] - A[0][1] * A[1][0]);
+            d[0] = (A[1][1] * rhs[0] - A[0][1] * rhs[1]) * rdet;
+            d[1] = (A[0][0] * rhs[1] - A[1][0] * rhs[0]) * rdet;
+        }
+        else
+        {
+            T c00 = A[1][1] * A[2][2] - A[1][2] * A[2][1];
+            T c01 = A[1][2] * A[2][0] - A[1][0] * A[2][2];
+            T c02 = A[1][0] * A[2][1] - A[1][1] * A[2][0];
+
+            T rdet = T(1) / (A[0][0] * c00 + A[0][1] * c01 + A[0][2] * c02);
+
+            T c11 = A[0][0] * A[2][2] - A[0][2] * A[2][0];
+            T c12 = A[0][1] * A[2][0] - A[0][0] * A[2][1];
+            T c22 = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+
+            // A is symmetric, and so is its inverse
+            d[0] = (c00 * rhs[0] + c01 * rhs[1] + c02 * rhs[2]) * rdet;
+            d[1] = (c01 * rhs[0] + c11 * rhs[1] + c12 * rhs[2]) * rdet;
+            d[2] = (c02 * rhs[0] + c12 * rhs[1] + c22 * rhs[2]) * rdet;
+        }
+    }
+
+    /// sum of squared residuals of every lane
+    void evaluate_cost(const T* x, size_t num, const T* y, const T (&b)[num_paras][lanes], T (&cost)[lanes]) const
+    {
+        for (size_t l = 0; l < lanes; l++) cost[l] = 0;
+
+        for (size_t n = 0; n < num; n++)
+        {
+            const T xn = x[n];
+            const T* yn = y + n*lanes;
+
+            for (size_t l = 0; l < lanes; l++)
+            {
+                T bl[num_paras];
+                for (size_t k = 0; k < num_paras; k++) bl[k] = b[k][l];
+
+                T res = yn[l] - Model::value(xn, bl);
+                cost[l] += res * res;
+            }
+        }
+
+        // a step into overflow must never look like an improvement
+        for (size_t l = 0; l < lanes; l++)
+        {
+            cost[l] = (cost[l] == cost[l]) ? cost[l] : std::numeric_limits<T>::max();
+        }
+    }
+};
+}